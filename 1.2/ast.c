@@ -1,916 +1,1499 @@
-/**
- * AST implementation for Topo Programming Language
- */
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <stdbool.h>
-#include "ast.h"
-
-// ================ AST CREATION FUNCTIONS ================
-
-ASTNode* create_program_node(ASTNode* statements) {
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
-    if (!node) return NULL;
-    
-    node->type = NODE_PROGRAM;
-    node->block.statements = statements;
-    
-    return node;
-}
-
-ASTNode* create_block_node(ASTNode* statements, int line, int column) {
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
-    if (!node) return NULL;
-    
-    node->type = NODE_BLOCK;
-    node->line = line;
-    node->column = column;
-    node->block.statements = statements;
-    
-    return node;
-}
-
-ASTNode* create_var_decl_node(char* name, ASTNode* value, bool is_const, int line, int column) {
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
-    if (!node) return NULL;
-    
-    node->type = is_const ? NODE_CONST_DECL : NODE_VAR_DECL;
-    node->line = line;
-    node->column = column;
-    node->name = name ? strdup(name) : NULL;
-    node->decl.value = value;
-    node->decl.is_const = is_const;
-    node->decl.data_type = TYPE_ANY;
-    
-    return node;
-}
-
-ASTNode* create_func_decl_node(char* name, FunctionParam* params, ASTNode* body, DataType return_type, int line, int column) {
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
-    if (!node) return NULL;
-    
-    node->type = NODE_FUNC_DECL;
-    node->line = line;
-    node->column = column;
-    node->name = name ? strdup(name) : NULL;
-    node->func.params = params;
-    node->func.body = body;
-    node->func.return_type = return_type;
-    
-    return node;
-}
-
-ASTNode* create_if_node(ASTNode* condition, ASTNode* then_branch, ASTNode* else_branch, int line, int column) {
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
-    if (!node) return NULL;
-    
-    node->type = NODE_IF_STMT;
-    node->line = line;
-    node->column = column;
-    node->flow.condition = condition;
-    node->flow.then_branch = then_branch;
-    node->flow.else_branch = else_branch;
-    node->flow.elif_branches = NULL;
-    
-    return node;
-}
-
-ASTNode* create_elif_node(ASTNode* condition, ASTNode* then_branch, int line, int column) {
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
-    if (!node) return NULL;
-    
-    node->type = NODE_ELIF_STMT;
-    node->line = line;
-    node->column = column;
-    node->flow.condition = condition;
-    node->flow.then_branch = then_branch;
-    
-    return node;
-}
-
-ASTNode* create_while_node(ASTNode* condition, ASTNode* body, int line, int column) {
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
-    if (!node) return NULL;
-    
-    node->type = NODE_WHILE_STMT;
-    node->line = line;
-    node->column = column;
-    node->flow.condition = condition;
-    node->flow.then_branch = body;
-    
-    return node;
-}
-
-ASTNode* create_for_node(char* iterator, ASTNode* iterable, ASTNode* body, int line, int column) {
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
-    if (!node) return NULL;
-    
-    node->type = NODE_FOR_STMT;
-    node->line = line;
-    node->column = column;
-    node->name = iterator ? strdup(iterator) : NULL;
-    node->loop.iterable = iterable;
-    node->loop.body = body;
-    
-    return node;
-}
-
-ASTNode* create_return_node(ASTNode* value, int line, int column) {
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
-    if (!node) return NULL;
-    
-    node->type = NODE_RETURN_STMT;
-    node->line = line;
-    node->column = column;
-    node->ret.value = value;
-    
-    return node;
-}
-
-ASTNode* create_break_node(int line, int column) {
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
-    if (!node) return NULL;
-    
-    node->type = NODE_BREAK_STMT;
-    node->line = line;
-    node->column = column;
-    
-    return node;
-}
-
-ASTNode* create_continue_node(int line, int column) {
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
-    if (!node) return NULL;
-    
-    node->type = NODE_CONTINUE_STMT;
-    node->line = line;
-    node->column = column;
-    
-    return node;
-}
-
-ASTNode* create_expr_stmt_node(ASTNode* expr, int line, int column) {
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
-    if (!node) return NULL;
-    
-    node->type = NODE_EXPR_STMT;
-    node->line = line;
-    node->column = column;
-    node->expr.binary.left = expr; // Reusing binary.left for expression
-    
-    return node;
-}
-
-ASTNode* create_from_import_node(char* module_name, char** imports, int import_count, bool import_all, int line, int column) {
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
-    if (!node) return NULL;
-    
-    node->type = NODE_FROM_IMPORT;
-    node->line = line;
-    node->column = column;
-    node->name = module_name ? strdup(module_name) : NULL;
-    node->import.imports = imports;
-    node->import.import_count = import_count;
-    node->import.import_all = import_all;
-    
-    return node;
-}
-
-// Expression nodes
-ASTNode* create_binary_expr_node(char* op, ASTNode* left, ASTNode* right, int line, int column) {
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
-    if (!node) return NULL;
-    
-    node->type = NODE_BINARY_EXPR;
-    node->line = line;
-    node->column = column;
-    node->expr.binary.op = op ? strdup(op) : NULL;
-    node->expr.binary.left = left;
-    node->expr.binary.right = right;
-    
-    return node;
-}
-
-ASTNode* create_unary_expr_node(char* op, ASTNode* operand, int line, int column) {
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
-    if (!node) return NULL;
-    
-    node->type = NODE_UNARY_EXPR;
-    node->line = line;
-    node->column = column;
-    node->expr.unary.op = op ? strdup(op) : NULL;
-    node->expr.unary.operand = operand;
-    
-    return node;
-}
-
-ASTNode* create_literal_node_int(long value, int line, int column) {
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
-    if (!node) return NULL;
-    
-    node->type = NODE_LITERAL;
-    node->line = line;
-    node->column = column;
-    node->expr.literal.value.int_val = value;
-    node->expr.literal.data_type = TYPE_INT;
-    
-    return node;
-}
-
-ASTNode* create_literal_node_float(double value, int line, int column) {
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
-    if (!node) return NULL;
-    
-    node->type = NODE_LITERAL;
-    node->line = line;
-    node->column = column;
-    node->expr.literal.value.float_val = value;
-    node->expr.literal.data_type = TYPE_FLOAT;
-    
-    return node;
-}
-
-ASTNode* create_literal_node_string(char* value, int line, int column) {
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
-    if (!node) return NULL;
-    
-    node->type = NODE_LITERAL;
-    node->line = line;
-    node->column = column;
-    node->expr.literal.value.string_val = value ? strdup(value) : NULL;
-    node->expr.literal.data_type = TYPE_STRING;
-    
-    return node;
-}
-
-ASTNode* create_literal_node_bool(bool value, int line, int column) {
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
-    if (!node) return NULL;
-    
-    node->type = NODE_LITERAL;
-    node->line = line;
-    node->column = column;
-    node->expr.literal.value.bool_val = value;
-    node->expr.literal.data_type = TYPE_BOOL;
-    
-    return node;
-}
-
-ASTNode* create_literal_node_null(int line, int column) {
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
-    if (!node) return NULL;
-    
-    node->type = NODE_LITERAL;
-    node->line = line;
-    node->column = column;
-    node->expr.literal.data_type = TYPE_NULL;
-    
-    return node;
-}
-
-ASTNode* create_identifier_node(char* name, int line, int column) {
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
-    if (!node) return NULL;
-    
-    node->type = NODE_IDENTIFIER;
-    node->line = line;
-    node->column = column;
-    node->expr.identifier.identifier = name ? strdup(name) : NULL;
-    
-    return node;
-}
-
-ASTNode* create_assignment_node(ASTNode* target, ASTNode* value, int line, int column) {
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
-    if (!node) return NULL;
-    
-    node->type = NODE_ASSIGNMENT;
-    node->line = line;
-    node->column = column;
-    node->expr.assign.target = target;
-    node->expr.assign.value = value;
-    
-    return node;
-}
-
-ASTNode* create_call_expr_node(ASTNode* callee, ASTNode* arguments, int arg_count, int line, int column) {
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
-    if (!node) return NULL;
-    
-    node->type = NODE_CALL_EXPR;
-    node->line = line;
-    node->column = column;
-    node->expr.call.callee = callee;
-    node->expr.call.arguments = arguments;
-    node->expr.call.arg_count = arg_count;
-    
-    return node;
-}
-
-ASTNode* create_array_literal_node(ASTNode* elements, int element_count, int line, int column) {
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
-    if (!node) return NULL;
-    
-    node->type = NODE_ARRAY_LITERAL;
-    node->line = line;
-    node->column = column;
-    node->expr.array.elements = elements;
-    node->expr.array.element_count = element_count;
-    
-    return node;
-}
-
-ASTNode* create_dict_literal_node(char** keys, ASTNode* values, int pair_count, int line, int column) {
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
-    if (!node) return NULL;
-    
-    node->type = NODE_DICT_LITERAL;
-    node->line = line;
-    node->column = column;
-    node->expr.dict.keys = keys;
-    node->expr.dict.values = values;
-    node->expr.dict.pair_count = pair_count;
-    
-    return node;
-}
-
-ASTNode* create_member_access_node(ASTNode* object, char* member, int line, int column) {
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
-    if (!node) return NULL;
-    
-    node->type = NODE_MEMBER_ACCESS;
-    node->line = line;
-    node->column = column;
-    node->expr.member.object = object;
-    node->expr.member.member = member ? strdup(member) : NULL;
-    
-    return node;
-}
-
-ASTNode* create_index_access_node(ASTNode* array, ASTNode* index, int line, int column) {
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
-    if (!node) return NULL;
-    
-    node->type = NODE_INDEX_ACCESS;
-    node->line = line;
-    node->column = column;
-    node->expr.index.array = array;
-    node->expr.index.index = index;
-    
-    return node;
-}
-
-ASTNode* create_range_node(ASTNode* start, ASTNode* end, ASTNode* step, int line, int column) {
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
-    if (!node) return NULL;
-    
-    node->type = NODE_RANGE_EXPR;
-    node->line = line;
-    node->column = column;
-    node->expr.range.start = start;
-    node->expr.range.end = end;
-    node->expr.range.step = step;
-    
-    return node;
-}
-
-// ================ UTILITY FUNCTIONS ================
-
-FunctionParam* create_function_param(char* name, DataType type) {
-    FunctionParam* param = (FunctionParam*)calloc(1, sizeof(FunctionParam));
-    if (!param) return NULL;
-    
-    param->name = name ? strdup(name) : NULL;
-    param->type = type;
-    param->next = NULL;
-    
-    return param;
-}
-
-void add_statement_to_block(ASTNode* block, ASTNode* statement) {
-    if (!block || block->type != NODE_BLOCK || !statement) return;
-    
-    if (!block->block.statements) {
-        block->block.statements = statement;
-    } else {
-        ASTNode* current = block->block.statements;
-        while (current->next) {
-            current = current->next;
-        }
-        current->next = statement;
-    }
-}
-
-void add_elif_branch(ASTNode* if_node, ASTNode* elif_node) {
-    if (!if_node || if_node->type != NODE_IF_STMT || !elif_node || elif_node->type != NODE_ELIF_STMT) return;
-    
-    if (!if_node->flow.elif_branches) {
-        if_node->flow.elif_branches = elif_node;
-    } else {
-        ASTNode* current = if_node->flow.elif_branches;
-        while (current->next) {
-            current = current->next;
-        }
-        current->next = elif_node;
-    }
-}
-
-void add_next_statement(ASTNode* current, ASTNode* next) {
-    if (!current || !next) return;
-    current->next = next;
-}
-
-void add_argument_to_call(ASTNode* call_node, ASTNode* argument) {
-    if (!call_node || call_node->type != NODE_CALL_EXPR || !argument) return;
-    
-    if (!call_node->expr.call.arguments) {
-        call_node->expr.call.arguments = argument;
-    } else {
-        ASTNode* current = call_node->expr.call.arguments;
-        while (current->next) {
-            current = current->next;
-        }
-        current->next = argument;
-    }
-    call_node->expr.call.arg_count++;
-}
-
-void add_element_to_array(ASTNode* array_node, ASTNode* element) {
-    if (!array_node || array_node->type != NODE_ARRAY_LITERAL || !element) return;
-    
-    if (!array_node->expr.array.elements) {
-        array_node->expr.array.elements = element;
-    } else {
-        ASTNode* current = array_node->expr.array.elements;
-        while (current->next) {
-            current = current->next;
-        }
-        current->next = element;
-    }
-    array_node->expr.array.element_count++;
-}
-
-void add_pair_to_dict(ASTNode* dict_node, char* key, ASTNode* value) {
-    if (!dict_node || dict_node->type != NODE_DICT_LITERAL || !key || !value) return;
-    
-    int new_count = dict_node->expr.dict.pair_count + 1;
-    
-    // Reallocate keys array
-    char** new_keys = (char**)realloc(dict_node->expr.dict.keys, new_count * sizeof(char*));
-    if (!new_keys) return;
-    
-    dict_node->expr.dict.keys = new_keys;
-    dict_node->expr.dict.keys[new_count - 1] = strdup(key);
-    
-    // Add value to linked list
-    if (!dict_node->expr.dict.values) {
-        dict_node->expr.dict.values = value;
-    } else {
-        ASTNode* current = dict_node->expr.dict.values;
-        while (current->next) {
-            current = current->next;
-        }
-        current->next = value;
-    }
-    
-    dict_node->expr.dict.pair_count = new_count;
-}
-
-// ================ MEMORY MANAGEMENT ================
-
-void free_function_params(FunctionParam* params) {
-    while (params) {
-        FunctionParam* next = params->next;
-        if (params->name) free(params->name);
-        free(params);
-        params = next;
-    }
-}
-
-void free_ast_node(ASTNode* node) {
-    if (!node) return;
-    
-    // Free name if present
-    if (node->name) {
-        free(node->name);
-    }
-    
-    // Free based on node type
-    switch (node->type) {
-        case NODE_PROGRAM:
-        case NODE_BLOCK:
-            if (node->block.statements) {
-                ASTNode* stmt = node->block.statements;
-                while (stmt) {
-                    ASTNode* next = stmt->next;
-                    free_ast_node(stmt);
-                    stmt = next;
-                }
-            }
-            break;
-            
-        case NODE_VAR_DECL:
-        case NODE_CONST_DECL:
-            if (node->decl.value) free_ast_node(node->decl.value);
-            break;
-            
-        case NODE_FUNC_DECL:
-            free_function_params(node->func.params);
-            if (node->func.body) free_ast_node(node->func.body);
-            break;
-            
-        case NODE_IF_STMT:
-            if (node->flow.condition) free_ast_node(node->flow.condition);
-            if (node->flow.then_branch) free_ast_node(node->flow.then_branch);
-            if (node->flow.else_branch) free_ast_node(node->flow.else_branch);
-            if (node->flow.elif_branches) free_ast_node(node->flow.elif_branches);
-            break;
-            
-        case NODE_ELIF_STMT:
-            if (node->flow.condition) free_ast_node(node->flow.condition);
-            if (node->flow.then_branch) free_ast_node(node->flow.then_branch);
-            break;
-            
-        case NODE_WHILE_STMT:
-            if (node->flow.condition) free_ast_node(node->flow.condition);
-            if (node->flow.then_branch) free_ast_node(node->flow.then_branch);
-            break;
-            
-        case NODE_FOR_STMT:
-            if (node->loop.iterable) free_ast_node(node->loop.iterable);
-            if (node->loop.body) free_ast_node(node->loop.body);
-            break;
-            
-        case NODE_RETURN_STMT:
-            if (node->ret.value) free_ast_node(node->ret.value);
-            break;
-            
-        case NODE_EXPR_STMT:
-            if (node->expr.binary.left) free_ast_node(node->expr.binary.left);
-            break;
-            
-        case NODE_FROM_IMPORT:
-            if (node->import.imports) {
-                for (int i = 0; i < node->import.import_count; i++) {
-                    if (node->import.imports[i]) free(node->import.imports[i]);
-                }
-                free(node->import.imports);
-            }
-            break;
-            
-        case NODE_BINARY_EXPR:
-            if (node->expr.binary.op) free(node->expr.binary.op);
-            if (node->expr.binary.left) free_ast_node(node->expr.binary.left);
-            if (node->expr.binary.right) free_ast_node(node->expr.binary.right);
-            break;
-            
-        case NODE_UNARY_EXPR:
-            if (node->expr.unary.op) free(node->expr.unary.op);
-            if (node->expr.unary.operand) free_ast_node(node->expr.unary.operand);
-            break;
-            
-        case NODE_LITERAL:
-            if (node->expr.literal.data_type == TYPE_STRING && 
-                node->expr.literal.value.string_val) {
-                free(node->expr.literal.value.string_val);
-            }
-            break;
-            
-        case NODE_IDENTIFIER:
-            if (node->expr.identifier.identifier) free(node->expr.identifier.identifier);
-            break;
-            
-        case NODE_ASSIGNMENT:
-            if (node->expr.assign.target) free_ast_node(node->expr.assign.target);
-            if (node->expr.assign.value) free_ast_node(node->expr.assign.value);
-            break;
-            
-        case NODE_CALL_EXPR:
-            if (node->expr.call.callee) free_ast_node(node->expr.call.callee);
-            if (node->expr.call.arguments) {
-                ASTNode* arg = node->expr.call.arguments;
-                while (arg) {
-                    ASTNode* next = arg->next;
-                    free_ast_node(arg);
-                    arg = next;
-                }
-            }
-            break;
-            
-        case NODE_ARRAY_LITERAL:
-            if (node->expr.array.elements) {
-                ASTNode* elem = node->expr.array.elements;
-                while (elem) {
-                    ASTNode* next = elem->next;
-                    free_ast_node(elem);
-                    elem = next;
-                }
-            }
-            break;
-            
-        case NODE_DICT_LITERAL:
-            if (node->expr.dict.keys) {
-                for (int i = 0; i < node->expr.dict.pair_count; i++) {
-                    if (node->expr.dict.keys[i]) free(node->expr.dict.keys[i]);
-                }
-                free(node->expr.dict.keys);
-            }
-            if (node->expr.dict.values) {
-                ASTNode* val = node->expr.dict.values;
-                while (val) {
-                    ASTNode* next = val->next;
-                    free_ast_node(val);
-                    val = next;
-                }
-            }
-            break;
-            
-        case NODE_MEMBER_ACCESS:
-            if (node->expr.member.object) free_ast_node(node->expr.member.object);
-            if (node->expr.member.member) free(node->expr.member.member);
-            break;
-            
-        case NODE_INDEX_ACCESS:
-            if (node->expr.index.array) free_ast_node(node->expr.index.array);
-            if (node->expr.index.index) free_ast_node(node->expr.index.index);
-            break;
-            
-        case NODE_RANGE_EXPR:
-            if (node->expr.range.start) free_ast_node(node->expr.range.start);
-            if (node->expr.range.end) free_ast_node(node->expr.range.end);
-            if (node->expr.range.step) free_ast_node(node->expr.range.step);
-            break;
-            
-        default:
-            break;
-    }
-    
-    // Free next node in linked list
-    if (node->next) {
-        free_ast_node(node->next);
-    }
-    
-    free(node);
-}
-
-// ================ DEBUG/PRINT FUNCTIONS ================
-
-const char* node_type_to_string(NodeType type) {
-    switch (type) {
-        case NODE_PROGRAM: return "PROGRAM";
-        case NODE_BLOCK: return "BLOCK";
-        case NODE_VAR_DECL: return "VAR_DECL";
-        case NODE_CONST_DECL: return "CONST_DECL";
-        case NODE_FUNC_DECL: return "FUNC_DECL";
-        case NODE_IF_STMT: return "IF_STMT";
-        case NODE_ELIF_STMT: return "ELIF_STMT";
-        case NODE_ELSE_STMT: return "ELSE_STMT";
-        case NODE_WHILE_STMT: return "WHILE_STMT";
-        case NODE_FOR_STMT: return "FOR_STMT";
-        case NODE_RETURN_STMT: return "RETURN_STMT";
-        case NODE_BREAK_STMT: return "BREAK_STMT";
-        case NODE_CONTINUE_STMT: return "CONTINUE_STMT";
-        case NODE_EXPR_STMT: return "EXPR_STMT";
-        case NODE_FROM_IMPORT: return "FROM_IMPORT";
-        case NODE_BINARY_EXPR: return "BINARY_EXPR";
-        case NODE_UNARY_EXPR: return "UNARY_EXPR";
-        case NODE_LITERAL: return "LITERAL";
-        case NODE_IDENTIFIER: return "IDENTIFIER";
-        case NODE_ASSIGNMENT: return "ASSIGNMENT";
-        case NODE_CALL_EXPR: return "CALL_EXPR";
-        case NODE_ARRAY_LITERAL: return "ARRAY_LITERAL";
-        case NODE_DICT_LITERAL: return "DICT_LITERAL";
-        case NODE_MEMBER_ACCESS: return "MEMBER_ACCESS";
-        case NODE_INDEX_ACCESS: return "INDEX_ACCESS";
-        case NODE_RANGE_EXPR: return "RANGE_EXPR";
-        case NODE_TYPE_ANNOTATION: return "TYPE_ANNOTATION";
-        default: return "UNKNOWN";
-    }
-}
-
-const char* data_type_to_string(DataType type) {
-    switch (type) {
-        case TYPE_INT: return "int";
-        case TYPE_FLOAT: return "float";
-        case TYPE_STRING: return "string";
-        case TYPE_BOOL: return "bool";
-        case TYPE_ARRAY: return "array";
-        case TYPE_DICT: return "dict";
-        case TYPE_FUNCTION: return "function";
-        case TYPE_NULL: return "null";
-        case TYPE_ANY: return "any";
-        default: return "unknown";
-    }
-}
-
-void print_indent(int indent) {
-    for (int i = 0; i < indent; i++) {
-        printf("  ");
-    }
-}
-
-void print_ast(ASTNode* node, int indent) {
-    if (!node) return;
-    
-    print_indent(indent);
-    printf("%s", node_type_to_string(node->type));
-    
-    // Print node-specific information
-    switch (node->type) {
-        case NODE_PROGRAM:
-            printf(":\n");
-            if (node->block.statements) {
-                print_ast(node->block.statements, indent + 1);
-            }
-            break;
-            
-        case NODE_BLOCK:
-            printf(" (%d statements):\n", node->block.statements ? 1 : 0);
-            if (node->block.statements) {
-                ASTNode* stmt = node->block.statements;
-                while (stmt) {
-                    print_ast(stmt, indent + 1);
-                    stmt = stmt->next;
-                }
-            }
-            break;
-            
-        case NODE_VAR_DECL:
-        case NODE_CONST_DECL:
-            printf(" %s", node->name ? node->name : "<unnamed>");
-            if (node->decl.data_type != TYPE_ANY) {
-                printf(": %s", data_type_to_string(node->decl.data_type));
-            }
-            printf("\n");
-            if (node->decl.value) {
-                print_indent(indent + 1);
-                printf("value:\n");
-                print_ast(node->decl.value, indent + 2);
-            }
-            break;
-            
-        case NODE_FUNC_DECL:
-            printf(" %s", node->name ? node->name : "<unnamed>");
-            printf(" -> %s\n", data_type_to_string(node->func.return_type));
-            if (node->func.body) {
-                print_indent(indent + 1);
-                printf("body:\n");
-                print_ast(node->func.body, indent + 2);
-            }
-            break;
-            
-        case NODE_IF_STMT:
-            printf(":\n");
-            print_indent(indent + 1);
-            printf("condition:\n");
-            if (node->flow.condition) print_ast(node->flow.condition, indent + 2);
-            print_indent(indent + 1);
-            printf("then:\n");
-            if (node->flow.then_branch) print_ast(node->flow.then_branch, indent + 2);
-            if (node->flow.else_branch) {
-                print_indent(indent + 1);
-                printf("else:\n");
-                print_ast(node->flow.else_branch, indent + 2);
-            }
-            break;
-            
-        case NODE_WHILE_STMT:
-            printf(":\n");
-            print_indent(indent + 1);
-            printf("condition:\n");
-            if (node->flow.condition) print_ast(node->flow.condition, indent + 2);
-            print_indent(indent + 1);
-            printf("body:\n");
-            if (node->flow.then_branch) print_ast(node->flow.then_branch, indent + 2);
-            break;
-            
-        case NODE_FOR_STMT:
-            printf(" %s in:\n", node->name ? node->name : "<iterator>");
-            print_indent(indent + 1);
-            printf("iterable:\n");
-            if (node->loop.iterable) print_ast(node->loop.iterable, indent + 2);
-            print_indent(indent + 1);
-            printf("body:\n");
-            if (node->loop.body) print_ast(node->loop.body, indent + 2);
-            break;
-            
-        case NODE_RETURN_STMT:
-            printf("\n");
-            if (node->ret.value) {
-                print_indent(indent + 1);
-                printf("value:\n");
-                print_ast(node->ret.value, indent + 2);
-            }
-            break;
-            
-        case NODE_EXPR_STMT:
-            printf(":\n");
-            if (node->expr.binary.left) print_ast(node->expr.binary.left, indent + 1);
-            break;
-            
-        case NODE_FROM_IMPORT:
-            printf(" from %s", node->name ? node->name : "<module>");
-            if (node->import.import_all) {
-                printf(" import *\n");
-            } else {
-                printf(" import:\n");
-                for (int i = 0; i < node->import.import_count; i++) {
-                    print_indent(indent + 1);
-                    printf("%s\n", node->import.imports[i]);
-                }
-            }
-            break;
-            
-        case NODE_BINARY_EXPR:
-            printf(" %s\n", node->expr.binary.op ? node->expr.binary.op : "<op>");
-            print_indent(indent + 1);
-            printf("left:\n");
-            if (node->expr.binary.left) print_ast(node->expr.binary.left, indent + 2);
-            print_indent(indent + 1);
-            printf("right:\n");
-            if (node->expr.binary.right) print_ast(node->expr.binary.right, indent + 2);
-            break;
-            
-        case NODE_UNARY_EXPR:
-            printf(" %s\n", node->expr.unary.op ? node->expr.unary.op : "<op>");
-            print_indent(indent + 1);
-            printf("operand:\n");
-            if (node->expr.unary.operand) print_ast(node->expr.unary.operand, indent + 2);
-            break;
-            
-        case NODE_LITERAL:
-            switch (node->expr.literal.data_type) {
-                case TYPE_INT:
-                    printf(" int: %ld\n", node->expr.literal.value.int_val);
-                    break;
-                case TYPE_FLOAT:
-                    printf(" float: %g\n", node->expr.literal.value.float_val);
-                    break;
-                case TYPE_STRING:
-                    printf(" string: \"%s\"\n", node->expr.literal.value.string_val);
-                    break;
-                case TYPE_BOOL:
-                    printf(" bool: %s\n", node->expr.literal.value.bool_val ? "true" : "false");
-                    break;
-                case TYPE_NULL:
-                    printf(" null\n");
-                    break;
-                default:
-                    printf(" <unknown>\n");
-                    break;
-            }
-            break;
-            
-        case NODE_IDENTIFIER:
-            printf(" %s\n", node->expr.identifier.identifier ? node->expr.identifier.identifier : "<unnamed>");
-            break;
-            
-        case NODE_ASSIGNMENT:
-            printf(":\n");
-            print_indent(indent + 1);
-            printf("target:\n");
-            if (node->expr.assign.target) print_ast(node->expr.assign.target, indent + 2);
-            print_indent(indent + 1);
-            printf("value:\n");
-            if (node->expr.assign.value) print_ast(node->expr.assign.value, indent + 2);
-            break;
-            
-        case NODE_CALL_EXPR:
-            printf(" (%d args):\n", node->expr.call.arg_count);
-            print_indent(indent + 1);
-            printf("callee:\n");
-            if (node->expr.call.callee) print_ast(node->expr.call.callee, indent + 2);
-            if (node->expr.call.arg_count > 0) {
-                print_indent(indent + 1);
-                printf("arguments:\n");
-                ASTNode* arg = node->expr.call.arguments;
-                while (arg) {
-                    print_ast(arg, indent + 2);
-                    arg = arg->next;
-                }
-            }
-            break;
-            
-        case NODE_ARRAY_LITERAL:
-            printf(" (%d elements):\n", node->expr.array.element_count);
-            if (node->expr.array.element_count > 0) {
-                ASTNode* elem = node->expr.array.elements;
-                while (elem) {
-                    print_ast(elem, indent + 1);
-                    elem = elem->next;
-                }
-            }
-            break;
-            
-        default:
-            printf("\n");
-            break;
-    }
-    
-    // Print next node in linked list
-    if (node->next) {
-        print_ast(node->next, indent);
-    }
+/**
+ * AST implementation for Topo Programming Language
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "ast.h"
+#include "numfmt.h"
+#include "region.h"
+
+// ================ NODE ALLOCATION ================
+// Nodes and their strings come from the heap, or from a region when one
+// is installed (see ast_use_region). Region memory is never freed one
+// piece at a time, so every release goes through ast_release. Each thread
+// installs its own region, so threads can build ASTs side by side.
+
+static _Thread_local Region* ast_region = NULL;
+
+// Nodes allocated on this thread since ast_set_node_budget, and the limit
+static _Thread_local long ast_node_budget = 0;
+static _Thread_local long ast_nodes_made = 0;
+
+Region* ast_use_region(Region* region) {
+    Region* previous = ast_region;
+    ast_region = region;
+    return previous;
+}
+
+void ast_set_node_budget(long budget) {
+    ast_node_budget = budget;
+    ast_nodes_made = 0;
+}
+
+bool ast_over_budget(void) {
+    return ast_node_budget > 0 && ast_nodes_made > ast_node_budget;
+}
+
+long ast_nodes_allocated(void) {
+    return ast_nodes_made;
+}
+
+ASTNode* ast_new_node(void) {
+    ast_nodes_made++;
+    if (ast_region) {
+        ASTNode* node = (ASTNode*)region_alloc(ast_region, sizeof(ASTNode));
+        if (node) return node;
+    }
+    return (ASTNode*)calloc(1, sizeof(ASTNode));
+}
+
+char* ast_strdup(const char* text) {
+    if (ast_region) {
+        char* copy = region_strdup(ast_region, text);
+        if (copy) return copy;
+    }
+    return strdup(text);
+}
+
+char* ast_strndup(const char* text, size_t length) {
+    char* copy = ast_region ? (char*)region_alloc(ast_region, length + 1) : NULL;
+    if (!copy) copy = (char*)malloc(length + 1);
+    if (!copy) return NULL;
+    
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+static void ast_release(void* pointer) {
+    if (!region_contains(ast_region, pointer)) free(pointer);
+}
+
+void ast_free_string(char* text) {
+    ast_release(text);
+}
+
+// ================ AST CREATION FUNCTIONS ================
+
+ASTNode* create_program_node(ASTNode* statements) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_PROGRAM;
+    node->block.statements = statements;
+    
+    return node;
+}
+
+ASTNode* create_block_node(ASTNode* statements, int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_BLOCK;
+    node->line = line;
+    node->column = column;
+    node->block.statements = statements;
+    
+    return node;
+}
+
+ASTNode* create_var_decl_node(char* name, ASTNode* value, bool is_const, int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = is_const ? NODE_CONST_DECL : NODE_VAR_DECL;
+    node->line = line;
+    node->column = column;
+    node->name = name ? ast_strdup(name) : NULL;
+    node->decl.value = value;
+    node->decl.is_const = is_const;
+    node->decl.data_type = TYPE_ANY;
+    
+    return node;
+}
+
+ASTNode* create_func_decl_node(char* name, FunctionParam* params, ASTNode* body, DataType return_type, int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_FUNC_DECL;
+    node->line = line;
+    node->column = column;
+    node->name = name ? ast_strdup(name) : NULL;
+    node->func.params = params;
+    node->func.body = body;
+    node->func.return_type = return_type;
+    
+    return node;
+}
+
+ASTNode* create_if_node(ASTNode* condition, ASTNode* then_branch, ASTNode* else_branch, int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_IF_STMT;
+    node->line = line;
+    node->column = column;
+    node->flow.condition = condition;
+    node->flow.then_branch = then_branch;
+    node->flow.else_branch = else_branch;
+    node->flow.elif_branches = NULL;
+    
+    return node;
+}
+
+ASTNode* create_elif_node(ASTNode* condition, ASTNode* then_branch, int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_ELIF_STMT;
+    node->line = line;
+    node->column = column;
+    node->flow.condition = condition;
+    node->flow.then_branch = then_branch;
+    
+    return node;
+}
+
+ASTNode* create_while_node(ASTNode* condition, ASTNode* body, int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_WHILE_STMT;
+    node->line = line;
+    node->column = column;
+    node->flow.condition = condition;
+    node->flow.then_branch = body;
+    
+    return node;
+}
+
+ASTNode* create_for_node(char* iterator, ASTNode* iterable, ASTNode* body, int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_FOR_STMT;
+    node->line = line;
+    node->column = column;
+    node->name = iterator ? ast_strdup(iterator) : NULL;
+    node->loop.iterable = iterable;
+    node->loop.body = body;
+    
+    return node;
+}
+
+ASTNode* create_return_node(ASTNode* value, int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_RETURN_STMT;
+    node->line = line;
+    node->column = column;
+    node->ret.value = value;
+    
+    return node;
+}
+
+ASTNode* create_break_node(int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_BREAK_STMT;
+    node->line = line;
+    node->column = column;
+    
+    return node;
+}
+
+ASTNode* create_continue_node(int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_CONTINUE_STMT;
+    node->line = line;
+    node->column = column;
+    
+    return node;
+}
+
+ASTNode* create_expr_stmt_node(ASTNode* expr, int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_EXPR_STMT;
+    node->line = line;
+    node->column = column;
+    node->expr.binary.left = expr; // Reusing binary.left for expression
+    
+    return node;
+}
+
+ASTNode* create_from_import_node(char* module_name, char** imports, int import_count, bool import_all, int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_FROM_IMPORT;
+    node->line = line;
+    node->column = column;
+    node->name = module_name ? ast_strdup(module_name) : NULL;
+    node->import.imports = imports;
+    node->import.import_count = import_count;
+    node->import.import_all = import_all;
+    
+    return node;
+}
+
+// Expression nodes
+ASTNode* create_binary_expr_node(char* op, ASTNode* left, ASTNode* right, int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_BINARY_EXPR;
+    node->line = line;
+    node->column = column;
+    node->expr.binary.op = op ? ast_strdup(op) : NULL;
+    node->expr.binary.left = left;
+    node->expr.binary.right = right;
+    
+    return node;
+}
+
+ASTNode* create_unary_expr_node(char* op, ASTNode* operand, int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_UNARY_EXPR;
+    node->line = line;
+    node->column = column;
+    node->expr.unary.op = op ? ast_strdup(op) : NULL;
+    node->expr.unary.operand = operand;
+    
+    return node;
+}
+
+ASTNode* create_literal_node_int(long value, int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_LITERAL;
+    node->line = line;
+    node->column = column;
+    node->expr.literal.value.int_val = value;
+    node->expr.literal.data_type = TYPE_INT;
+    
+    return node;
+}
+
+ASTNode* create_literal_node_float(double value, int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_LITERAL;
+    node->line = line;
+    node->column = column;
+    node->expr.literal.value.float_val = value;
+    node->expr.literal.data_type = TYPE_FLOAT;
+    
+    return node;
+}
+
+ASTNode* create_literal_node_string(char* value, int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_LITERAL;
+    node->line = line;
+    node->column = column;
+    node->expr.literal.value.string_val = value ? ast_strdup(value) : NULL;
+    node->expr.literal.data_type = TYPE_STRING;
+    
+    return node;
+}
+
+// Integer literal too large for a long, kept as its decimal digits
+ASTNode* create_literal_node_bignum(char* digits, int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_LITERAL;
+    node->line = line;
+    node->column = column;
+    node->expr.literal.value.bignum_val = digits ? ast_strdup(digits) : NULL;
+    node->expr.literal.data_type = TYPE_BIGINT;
+    
+    return node;
+}
+
+ASTNode* create_literal_node_bool(bool value, int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_LITERAL;
+    node->line = line;
+    node->column = column;
+    node->expr.literal.value.bool_val = value;
+    node->expr.literal.data_type = TYPE_BOOL;
+    
+    return node;
+}
+
+ASTNode* create_literal_node_null(int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_LITERAL;
+    node->line = line;
+    node->column = column;
+    node->expr.literal.data_type = TYPE_NULL;
+    
+    return node;
+}
+
+ASTNode* create_identifier_node(char* name, int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_IDENTIFIER;
+    node->line = line;
+    node->column = column;
+    node->expr.identifier.identifier = name ? ast_strdup(name) : NULL;
+    
+    return node;
+}
+
+ASTNode* create_assignment_node(ASTNode* target, ASTNode* value, int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_ASSIGNMENT;
+    node->line = line;
+    node->column = column;
+    node->expr.assign.target = target;
+    node->expr.assign.value = value;
+    
+    return node;
+}
+
+// In-place update (x += v): the target is evaluated only once
+ASTNode* create_compound_assignment_node(char* op, ASTNode* target, ASTNode* value, int line, int column) {
+    ASTNode* node = create_assignment_node(target, value, line, column);
+    if (!node) return NULL;
+    
+    node->expr.assign.op = op ? ast_strdup(op) : NULL;
+    
+    return node;
+}
+
+ASTNode* create_call_expr_node(ASTNode* callee, ASTNode* arguments, int arg_count, int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_CALL_EXPR;
+    node->line = line;
+    node->column = column;
+    node->expr.call.callee = callee;
+    node->expr.call.arguments = arguments;
+    node->expr.call.arg_count = arg_count;
+    
+    return node;
+}
+
+ASTNode* create_array_literal_node(ASTNode* elements, int element_count, int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_ARRAY_LITERAL;
+    node->line = line;
+    node->column = column;
+    node->expr.array.elements = elements;
+    node->expr.array.element_count = element_count;
+    
+    return node;
+}
+
+ASTNode* create_dict_literal_node(char** keys, ASTNode* values, int pair_count, int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_DICT_LITERAL;
+    node->line = line;
+    node->column = column;
+    node->expr.dict.keys = keys;
+    node->expr.dict.values = values;
+    node->expr.dict.pair_count = pair_count;
+    
+    return node;
+}
+
+ASTNode* create_member_access_node(ASTNode* object, char* member, int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_MEMBER_ACCESS;
+    node->line = line;
+    node->column = column;
+    node->expr.member.object = object;
+    node->expr.member.member = member ? ast_strdup(member) : NULL;
+    
+    return node;
+}
+
+ASTNode* create_index_access_node(ASTNode* array, ASTNode* index, int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_INDEX_ACCESS;
+    node->line = line;
+    node->column = column;
+    node->expr.index.array = array;
+    node->expr.index.index = index;
+    
+    return node;
+}
+
+// Slices are views: they share the parent's buffer at run time
+ASTNode* create_slice_node(ASTNode* object, ASTNode* start, ASTNode* end, int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_SLICE_EXPR;
+    node->line = line;
+    node->column = column;
+    node->expr.slice.object = object;
+    node->expr.slice.start = start;
+    node->expr.slice.end = end;
+    
+    return node;
+}
+
+ASTNode* create_range_node(ASTNode* start, ASTNode* end, ASTNode* step, int line, int column) {
+    ASTNode* node = ast_new_node();
+    if (!node) return NULL;
+    
+    node->type = NODE_RANGE_EXPR;
+    node->line = line;
+    node->column = column;
+    node->expr.range.start = start;
+    node->expr.range.end = end;
+    node->expr.range.step = step;
+    
+    return node;
+}
+
+// ================ SHARED DICT KEYS ================
+// Cloned dict literals share one key array, copy-on-write: key_shares
+// counts the extra owners, and a node copies the keys for itself only
+// when it is about to change them while they are shared.
+
+static char** dict_copy_keys(char** keys, int count) {
+    char** copy = (char**)malloc((count ? count : 1) * sizeof(char*));
+    if (!copy) return NULL;
+    
+    for (int i = 0; i < count; i++) {
+        copy[i] = keys[i] ? strdup(keys[i]) : NULL;
+    }
+    return copy;
+}
+
+static void dict_share_keys(ASTNode* source, ASTNode* copy) {
+    copy->expr.dict.keys = NULL;
+    copy->expr.dict.key_shares = NULL;
+    if (!source->expr.dict.keys) return;
+    
+    if (!source->expr.dict.key_shares) {
+        source->expr.dict.key_shares = (int*)calloc(1, sizeof(int));
+        if (!source->expr.dict.key_shares) {
+            copy->expr.dict.keys = dict_copy_keys(source->expr.dict.keys, source->expr.dict.pair_count);
+            return;
+        }
+    }
+    
+    (*source->expr.dict.key_shares)++;
+    copy->expr.dict.keys = source->expr.dict.keys;
+    copy->expr.dict.key_shares = source->expr.dict.key_shares;
+}
+
+static void dict_release_keys(ASTNode* dict_node) {
+    int* shares = dict_node->expr.dict.key_shares;
+    char** keys = dict_node->expr.dict.keys;
+    
+    dict_node->expr.dict.keys = NULL;
+    dict_node->expr.dict.key_shares = NULL;
+    
+    // Another owner keeps the keys
+    if (shares && *shares > 0) {
+        (*shares)--;
+        return;
+    }
+    
+    if (keys) {
+        for (int i = 0; i < dict_node->expr.dict.pair_count; i++) {
+            free(keys[i]);
+        }
+        free(keys);
+    }
+    free(shares);
+}
+
+bool dict_unshare_keys(ASTNode* dict_node) {
+    if (!dict_node || dict_node->type != NODE_DICT_LITERAL) return false;
+    
+    int* shares = dict_node->expr.dict.key_shares;
+    if (!shares || *shares == 0) return true;
+    
+    char** keys = dict_copy_keys(dict_node->expr.dict.keys, dict_node->expr.dict.pair_count);
+    if (!keys) return false;
+    
+    (*shares)--;
+    dict_node->expr.dict.keys = keys;
+    dict_node->expr.dict.key_shares = NULL;
+    return true;
+}
+
+// ================ UTILITY FUNCTIONS ================
+
+FunctionParam* create_function_param(char* name, DataType type) {
+    FunctionParam* param = (FunctionParam*)calloc(1, sizeof(FunctionParam));
+    if (!param) return NULL;
+    
+    param->name = name ? strdup(name) : NULL;
+    param->type = type;
+    param->next = NULL;
+    
+    return param;
+}
+
+void add_statement_to_block(ASTNode* block, ASTNode* statement) {
+    if (!block || block->type != NODE_BLOCK || !statement) return;
+    
+    if (!block->block.statements) {
+        block->block.statements = statement;
+    } else {
+        ASTNode* current = block->block.statements;
+        while (current->next) {
+            current = current->next;
+        }
+        current->next = statement;
+    }
+}
+
+void add_elif_branch(ASTNode* if_node, ASTNode* elif_node) {
+    if (!if_node || if_node->type != NODE_IF_STMT || !elif_node || elif_node->type != NODE_ELIF_STMT) return;
+    
+    if (!if_node->flow.elif_branches) {
+        if_node->flow.elif_branches = elif_node;
+    } else {
+        ASTNode* current = if_node->flow.elif_branches;
+        while (current->next) {
+            current = current->next;
+        }
+        current->next = elif_node;
+    }
+}
+
+void add_next_statement(ASTNode* current, ASTNode* next) {
+    if (!current || !next) return;
+    current->next = next;
+}
+
+void add_argument_to_call(ASTNode* call_node, ASTNode* argument) {
+    if (!call_node || call_node->type != NODE_CALL_EXPR || !argument) return;
+    
+    if (!call_node->expr.call.arguments) {
+        call_node->expr.call.arguments = argument;
+    } else {
+        ASTNode* current = call_node->expr.call.arguments;
+        while (current->next) {
+            current = current->next;
+        }
+        current->next = argument;
+    }
+    call_node->expr.call.arg_count++;
+}
+
+void add_element_to_array(ASTNode* array_node, ASTNode* element) {
+    if (!array_node || array_node->type != NODE_ARRAY_LITERAL || !element) return;
+    
+    if (!array_node->expr.array.elements) {
+        array_node->expr.array.elements = element;
+    } else {
+        ASTNode* current = array_node->expr.array.elements;
+        while (current->next) {
+            current = current->next;
+        }
+        current->next = element;
+    }
+    array_node->expr.array.element_count++;
+}
+
+void add_pair_to_dict(ASTNode* dict_node, char* key, ASTNode* value) {
+    if (!dict_node || dict_node->type != NODE_DICT_LITERAL || !key || !value) return;
+    if (!dict_unshare_keys(dict_node)) return;
+    
+    int new_count = dict_node->expr.dict.pair_count + 1;
+    
+    // Reallocate keys array
+    char** new_keys = (char**)realloc(dict_node->expr.dict.keys, new_count * sizeof(char*));
+    if (!new_keys) return;
+    
+    dict_node->expr.dict.keys = new_keys;
+    dict_node->expr.dict.keys[new_count - 1] = strdup(key);
+    
+    // Add value to linked list
+    if (!dict_node->expr.dict.values) {
+        dict_node->expr.dict.values = value;
+    } else {
+        ASTNode* current = dict_node->expr.dict.values;
+        while (current->next) {
+            current = current->next;
+        }
+        current->next = value;
+    }
+    
+    dict_node->expr.dict.pair_count = new_count;
+}
+
+// ================ MEMORY MANAGEMENT ================
+
+void free_function_params(FunctionParam* params) {
+    while (params) {
+        FunctionParam* next = params->next;
+        if (params->name) free(params->name);
+        free(params);
+        params = next;
+    }
+}
+
+void free_ast_node(ASTNode* node) {
+    if (!node) return;
+    
+    // Shared subtrees belong to the subtree store
+    if (node->share != SHARE_NONE) return;
+    
+    // Free name if present
+    if (node->name) {
+        ast_release(node->name);
+    }
+    
+    // Free based on node type
+    switch (node->type) {
+        case NODE_PROGRAM:
+        case NODE_BLOCK:
+            if (node->block.statements) {
+                ASTNode* stmt = node->block.statements;
+                while (stmt) {
+                    ASTNode* next = stmt->next;
+                    free_ast_node(stmt);
+                    stmt = next;
+                }
+            }
+            break;
+            
+        case NODE_VAR_DECL:
+        case NODE_CONST_DECL:
+            if (node->decl.value) free_ast_node(node->decl.value);
+            break;
+            
+        case NODE_FUNC_DECL:
+            free_function_params(node->func.params);
+            if (node->func.body) free_ast_node(node->func.body);
+            if (node->func.skimmed) ast_release(node->func.skimmed);
+            break;
+            
+        case NODE_IF_STMT:
+            if (node->flow.condition) free_ast_node(node->flow.condition);
+            if (node->flow.then_branch) free_ast_node(node->flow.then_branch);
+            if (node->flow.else_branch) free_ast_node(node->flow.else_branch);
+            if (node->flow.elif_branches) {
+                ASTNode* elif = node->flow.elif_branches;
+                while (elif) {
+                    ASTNode* next = elif->next;
+                    free_ast_node(elif);
+                    elif = next;
+                }
+            }
+            if (node->flow.subject) free_ast_node(node->flow.subject);
+            dispatch_destroy(node->flow.dispatch);
+            break;
+            
+        case NODE_ELIF_STMT:
+            if (node->flow.condition) free_ast_node(node->flow.condition);
+            if (node->flow.then_branch) free_ast_node(node->flow.then_branch);
+            break;
+            
+        case NODE_WHILE_STMT:
+            if (node->flow.condition) free_ast_node(node->flow.condition);
+            if (node->flow.then_branch) free_ast_node(node->flow.then_branch);
+            break;
+            
+        case NODE_FOR_STMT:
+            if (node->loop.iterable) free_ast_node(node->loop.iterable);
+            if (node->loop.body) free_ast_node(node->loop.body);
+            break;
+            
+        case NODE_RETURN_STMT:
+            if (node->ret.value) free_ast_node(node->ret.value);
+            break;
+            
+        case NODE_EXPR_STMT:
+            if (node->expr.binary.left) free_ast_node(node->expr.binary.left);
+            break;
+            
+        case NODE_FROM_IMPORT:
+            if (node->import.imports) {
+                for (int i = 0; i < node->import.import_count; i++) {
+                    if (node->import.imports[i]) free(node->import.imports[i]);
+                }
+                free(node->import.imports);
+            }
+            break;
+            
+        case NODE_BINARY_EXPR:
+            if (node->expr.binary.op) ast_release(node->expr.binary.op);
+            if (node->expr.binary.left) free_ast_node(node->expr.binary.left);
+            if (node->expr.binary.right) free_ast_node(node->expr.binary.right);
+            break;
+            
+        case NODE_UNARY_EXPR:
+            if (node->expr.unary.op) ast_release(node->expr.unary.op);
+            if (node->expr.unary.operand) free_ast_node(node->expr.unary.operand);
+            break;
+            
+        case NODE_LITERAL:
+            if (node->expr.literal.data_type == TYPE_STRING && 
+                node->expr.literal.value.string_val) {
+                ast_release(node->expr.literal.value.string_val);
+            }
+            if (node->expr.literal.data_type == TYPE_BIGINT &&
+                node->expr.literal.value.bignum_val) {
+                ast_release(node->expr.literal.value.bignum_val);
+            }
+            break;
+            
+        case NODE_IDENTIFIER:
+            if (node->expr.identifier.identifier) ast_release(node->expr.identifier.identifier);
+            break;
+            
+        case NODE_ASSIGNMENT:
+            if (node->expr.assign.op) ast_release(node->expr.assign.op);
+            if (node->expr.assign.target) free_ast_node(node->expr.assign.target);
+            if (node->expr.assign.value) free_ast_node(node->expr.assign.value);
+            break;
+            
+        case NODE_CALL_EXPR:
+            if (node->expr.call.callee) free_ast_node(node->expr.call.callee);
+            if (node->expr.call.arguments) {
+                ASTNode* arg = node->expr.call.arguments;
+                while (arg) {
+                    ASTNode* next = arg->next;
+                    free_ast_node(arg);
+                    arg = next;
+                }
+            }
+            break;
+            
+        case NODE_ARRAY_LITERAL:
+            if (node->expr.array.elements) {
+                ASTNode* elem = node->expr.array.elements;
+                while (elem) {
+                    ASTNode* next = elem->next;
+                    free_ast_node(elem);
+                    elem = next;
+                }
+            }
+            break;
+            
+        case NODE_DICT_LITERAL:
+            dict_release_keys(node);
+            phash_destroy(node->expr.dict.phash);
+            if (node->expr.dict.values) {
+                ASTNode* val = node->expr.dict.values;
+                while (val) {
+                    ASTNode* next = val->next;
+                    free_ast_node(val);
+                    val = next;
+                }
+            }
+            break;
+            
+        case NODE_MEMBER_ACCESS:
+            if (node->expr.member.object) free_ast_node(node->expr.member.object);
+            if (node->expr.member.member) ast_release(node->expr.member.member);
+            break;
+            
+        case NODE_INDEX_ACCESS:
+            if (node->expr.index.array) free_ast_node(node->expr.index.array);
+            if (node->expr.index.index) free_ast_node(node->expr.index.index);
+            break;
+            
+        case NODE_SLICE_EXPR:
+            if (node->expr.slice.object) free_ast_node(node->expr.slice.object);
+            if (node->expr.slice.start) free_ast_node(node->expr.slice.start);
+            if (node->expr.slice.end) free_ast_node(node->expr.slice.end);
+            break;
+            
+        case NODE_RANGE_EXPR:
+            if (node->expr.range.start) free_ast_node(node->expr.range.start);
+            if (node->expr.range.end) free_ast_node(node->expr.range.end);
+            if (node->expr.range.step) free_ast_node(node->expr.range.step);
+            break;
+            
+        default:
+            break;
+    }
+    
+    // Linked lists are freed by their owner, not through node->next
+    ast_release(node);
+}
+
+// ================ COPYING AND TRAVERSAL ================
+
+FunctionParam* clone_function_params(const FunctionParam* params) {
+    FunctionParam* head = NULL;
+    FunctionParam* last = NULL;
+    
+    for (; params; params = params->next) {
+        FunctionParam* param = create_function_param(params->name, params->type);
+        if (!head) {
+            head = param;
+        } else {
+            last->next = param;
+        }
+        last = param;
+    }
+    
+    return head;
+}
+
+static ASTNode* copy_ast_list(const ASTNode* head, ASTChildCopier copy_child) {
+    ASTNode* result = NULL;
+    ASTNode* last = NULL;
+    
+    for (; head; head = head->next) {
+        ASTNode* node = copy_child(head);
+        if (!result) {
+            result = node;
+        } else {
+            last->next = node;
+        }
+        last = node;
+    }
+    
+    return result;
+}
+
+ASTNode* clone_ast_list(const ASTNode* head) {
+    return copy_ast_list(head, clone_ast_node);
+}
+
+// Deep copy of a single node (its 'next' link is not followed)
+ASTNode* clone_ast_node(const ASTNode* node) {
+    return copy_ast_node(node, clone_ast_node);
+}
+
+// Copy of a single node and what it owns, with the copies of its children
+// made by 'copy_child' (which may hand back a child itself, if shared)
+ASTNode* copy_ast_node(const ASTNode* node, ASTChildCopier copy_child) {
+    if (!node) return NULL;
+    
+    ASTNode* copy = ast_new_node();
+    if (!copy) return NULL;
+    
+    *copy = *node;
+    copy->next = NULL;
+    copy->share = SHARE_NONE;
+    copy->name = node->name ? ast_strdup(node->name) : NULL;
+    
+    switch (node->type) {
+        case NODE_PROGRAM:
+        case NODE_BLOCK:
+            copy->block.statements = copy_ast_list(node->block.statements, copy_child);
+            break;
+            
+        case NODE_VAR_DECL:
+        case NODE_CONST_DECL:
+            copy->decl.value = copy_child(node->decl.value);
+            break;
+            
+        case NODE_FUNC_DECL:
+            copy->func.params = clone_function_params(node->func.params);
+            copy->func.body = copy_child(node->func.body);
+            copy->func.skimmed = node->func.skimmed ? ast_strdup(node->func.skimmed) : NULL;
+            break;
+            
+        case NODE_IF_STMT:
+        case NODE_ELIF_STMT:
+        case NODE_WHILE_STMT:
+            copy->flow.condition = copy_child(node->flow.condition);
+            copy->flow.then_branch = copy_child(node->flow.then_branch);
+            copy->flow.else_branch = copy_child(node->flow.else_branch);
+            copy->flow.elif_branches = copy_ast_list(node->flow.elif_branches, copy_child);
+            copy->flow.subject = copy_child(node->flow.subject);
+            copy->flow.dispatch = dispatch_share(node->flow.dispatch);
+            break;
+            
+        case NODE_FOR_STMT:
+            copy->loop.iterable = copy_child(node->loop.iterable);
+            copy->loop.body = copy_child(node->loop.body);
+            break;
+            
+        case NODE_RETURN_STMT:
+            copy->ret.value = copy_child(node->ret.value);
+            break;
+            
+        case NODE_EXPR_STMT:
+            copy->expr.binary.left = copy_child(node->expr.binary.left);
+            break;
+            
+        case NODE_FROM_IMPORT:
+            if (node->import.imports) {
+                copy->import.imports = (char**)malloc(node->import.import_count * sizeof(char*));
+                for (int i = 0; i < node->import.import_count; i++) {
+                    copy->import.imports[i] = strdup(node->import.imports[i]);
+                }
+            }
+            break;
+            
+        case NODE_BINARY_EXPR:
+            copy->expr.binary.op = node->expr.binary.op ? ast_strdup(node->expr.binary.op) : NULL;
+            copy->expr.binary.left = copy_child(node->expr.binary.left);
+            copy->expr.binary.right = copy_child(node->expr.binary.right);
+            break;
+            
+        case NODE_UNARY_EXPR:
+            copy->expr.unary.op = node->expr.unary.op ? ast_strdup(node->expr.unary.op) : NULL;
+            copy->expr.unary.operand = copy_child(node->expr.unary.operand);
+            break;
+            
+        case NODE_LITERAL:
+            if (node->expr.literal.data_type == TYPE_STRING &&
+                node->expr.literal.value.string_val) {
+                copy->expr.literal.value.string_val = ast_strdup(node->expr.literal.value.string_val);
+            }
+            if (node->expr.literal.data_type == TYPE_BIGINT &&
+                node->expr.literal.value.bignum_val) {
+                copy->expr.literal.value.bignum_val = ast_strdup(node->expr.literal.value.bignum_val);
+            }
+            break;
+            
+        case NODE_IDENTIFIER:
+            copy->expr.identifier.identifier = node->expr.identifier.identifier ?
+                ast_strdup(node->expr.identifier.identifier) : NULL;
+            break;
+            
+        case NODE_ASSIGNMENT:
+            copy->expr.assign.op = node->expr.assign.op ? ast_strdup(node->expr.assign.op) : NULL;
+            copy->expr.assign.target = copy_child(node->expr.assign.target);
+            copy->expr.assign.value = copy_child(node->expr.assign.value);
+            break;
+            
+        case NODE_CALL_EXPR:
+            copy->expr.call.callee = copy_child(node->expr.call.callee);
+            copy->expr.call.arguments = copy_ast_list(node->expr.call.arguments, copy_child);
+            break;
+            
+        case NODE_ARRAY_LITERAL:
+            copy->expr.array.elements = copy_ast_list(node->expr.array.elements, copy_child);
+            break;
+            
+        case NODE_DICT_LITERAL:
+            dict_share_keys((ASTNode*)node, copy);
+            copy->expr.dict.values = copy_ast_list(node->expr.dict.values, copy_child);
+            copy->expr.dict.phash = phash_share(node->expr.dict.phash);
+            break;
+            
+        case NODE_MEMBER_ACCESS:
+            copy->expr.member.object = copy_child(node->expr.member.object);
+            copy->expr.member.member = node->expr.member.member ? ast_strdup(node->expr.member.member) : NULL;
+            break;
+            
+        case NODE_INDEX_ACCESS:
+            copy->expr.index.array = copy_child(node->expr.index.array);
+            copy->expr.index.index = copy_child(node->expr.index.index);
+            break;
+            
+        case NODE_SLICE_EXPR:
+            copy->expr.slice.object = copy_child(node->expr.slice.object);
+            copy->expr.slice.start = copy_child(node->expr.slice.start);
+            copy->expr.slice.end = copy_child(node->expr.slice.end);
+            break;
+            
+        case NODE_RANGE_EXPR:
+            copy->expr.range.start = copy_child(node->expr.range.start);
+            copy->expr.range.end = copy_child(node->expr.range.end);
+            copy->expr.range.step = copy_child(node->expr.range.step);
+            break;
+            
+        default:
+            break;
+    }
+    
+    return copy;
+}
+
+static void visit_list(ASTNode** head, ASTChildVisitor visit, void* data) {
+    for (ASTNode** slot = head; *slot; slot = &(*slot)->next) {
+        visit(slot, data);
+    }
+}
+
+static void visit_slot(ASTNode** slot, ASTChildVisitor visit, void* data) {
+    if (*slot) visit(slot, data);
+}
+
+// Call 'visit' for every direct child of a node
+void ast_for_each_child(ASTNode* node, ASTChildVisitor visit, void* data) {
+    if (!node) return;
+    
+    switch (node->type) {
+        case NODE_PROGRAM:
+        case NODE_BLOCK:
+            visit_list(&node->block.statements, visit, data);
+            break;
+            
+        case NODE_VAR_DECL:
+        case NODE_CONST_DECL:
+            visit_slot(&node->decl.value, visit, data);
+            break;
+            
+        case NODE_FUNC_DECL:
+            visit_slot(&node->func.body, visit, data);
+            break;
+            
+        case NODE_IF_STMT:
+            visit_slot(&node->flow.condition, visit, data);
+            visit_slot(&node->flow.then_branch, visit, data);
+            visit_list(&node->flow.elif_branches, visit, data);
+            visit_slot(&node->flow.else_branch, visit, data);
+            visit_slot(&node->flow.subject, visit, data);
+            break;
+            
+        case NODE_ELIF_STMT:
+        case NODE_WHILE_STMT:
+            visit_slot(&node->flow.condition, visit, data);
+            visit_slot(&node->flow.then_branch, visit, data);
+            break;
+            
+        case NODE_FOR_STMT:
+            visit_slot(&node->loop.iterable, visit, data);
+            visit_slot(&node->loop.body, visit, data);
+            break;
+            
+        case NODE_RETURN_STMT:
+            visit_slot(&node->ret.value, visit, data);
+            break;
+            
+        case NODE_EXPR_STMT:
+            visit_slot(&node->expr.binary.left, visit, data);
+            break;
+            
+        case NODE_BINARY_EXPR:
+            visit_slot(&node->expr.binary.left, visit, data);
+            visit_slot(&node->expr.binary.right, visit, data);
+            break;
+            
+        case NODE_UNARY_EXPR:
+            visit_slot(&node->expr.unary.operand, visit, data);
+            break;
+            
+        case NODE_ASSIGNMENT:
+            visit_slot(&node->expr.assign.target, visit, data);
+            visit_slot(&node->expr.assign.value, visit, data);
+            break;
+            
+        case NODE_CALL_EXPR:
+            visit_slot(&node->expr.call.callee, visit, data);
+            visit_list(&node->expr.call.arguments, visit, data);
+            break;
+            
+        case NODE_ARRAY_LITERAL:
+            visit_list(&node->expr.array.elements, visit, data);
+            break;
+            
+        case NODE_DICT_LITERAL:
+            visit_list(&node->expr.dict.values, visit, data);
+            break;
+            
+        case NODE_MEMBER_ACCESS:
+            visit_slot(&node->expr.member.object, visit, data);
+            break;
+            
+        case NODE_INDEX_ACCESS:
+            visit_slot(&node->expr.index.array, visit, data);
+            visit_slot(&node->expr.index.index, visit, data);
+            break;
+            
+        case NODE_SLICE_EXPR:
+            visit_slot(&node->expr.slice.object, visit, data);
+            visit_slot(&node->expr.slice.start, visit, data);
+            visit_slot(&node->expr.slice.end, visit, data);
+            break;
+            
+        case NODE_RANGE_EXPR:
+            visit_slot(&node->expr.range.start, visit, data);
+            visit_slot(&node->expr.range.end, visit, data);
+            visit_slot(&node->expr.range.step, visit, data);
+            break;
+            
+        default:
+            break;
+    }
+}
+
+static void count_visitor(ASTNode** slot, void* data) {
+    *(int*)data += ast_node_count(*slot);
+}
+
+// Number of nodes in a subtree (used as a size metric by the optimizer)
+int ast_node_count(ASTNode* node) {
+    if (!node) return 0;
+    
+    int count = 1;
+    ast_for_each_child(node, count_visitor, &count);
+    return count;
+}
+
+// ================ DEBUG/PRINT FUNCTIONS ================
+
+const char* node_type_to_string(NodeType type) {
+    switch (type) {
+        case NODE_PROGRAM: return "PROGRAM";
+        case NODE_BLOCK: return "BLOCK";
+        case NODE_VAR_DECL: return "VAR_DECL";
+        case NODE_CONST_DECL: return "CONST_DECL";
+        case NODE_FUNC_DECL: return "FUNC_DECL";
+        case NODE_IF_STMT: return "IF_STMT";
+        case NODE_ELIF_STMT: return "ELIF_STMT";
+        case NODE_ELSE_STMT: return "ELSE_STMT";
+        case NODE_WHILE_STMT: return "WHILE_STMT";
+        case NODE_FOR_STMT: return "FOR_STMT";
+        case NODE_RETURN_STMT: return "RETURN_STMT";
+        case NODE_BREAK_STMT: return "BREAK_STMT";
+        case NODE_CONTINUE_STMT: return "CONTINUE_STMT";
+        case NODE_EXPR_STMT: return "EXPR_STMT";
+        case NODE_FROM_IMPORT: return "FROM_IMPORT";
+        case NODE_BINARY_EXPR: return "BINARY_EXPR";
+        case NODE_UNARY_EXPR: return "UNARY_EXPR";
+        case NODE_LITERAL: return "LITERAL";
+        case NODE_IDENTIFIER: return "IDENTIFIER";
+        case NODE_ASSIGNMENT: return "ASSIGNMENT";
+        case NODE_CALL_EXPR: return "CALL_EXPR";
+        case NODE_ARRAY_LITERAL: return "ARRAY_LITERAL";
+        case NODE_DICT_LITERAL: return "DICT_LITERAL";
+        case NODE_MEMBER_ACCESS: return "MEMBER_ACCESS";
+        case NODE_INDEX_ACCESS: return "INDEX_ACCESS";
+        case NODE_SLICE_EXPR: return "SLICE_EXPR";
+        case NODE_RANGE_EXPR: return "RANGE_EXPR";
+        case NODE_TYPE_ANNOTATION: return "TYPE_ANNOTATION";
+        default: return "UNKNOWN";
+    }
+}
+
+const char* data_type_to_string(DataType type) {
+    switch (type) {
+        case TYPE_INT: return "int";
+        case TYPE_BIGINT: return "bigint";
+        case TYPE_FLOAT: return "float";
+        case TYPE_STRING: return "string";
+        case TYPE_BOOL: return "bool";
+        case TYPE_ARRAY: return "array";
+        case TYPE_DICT: return "dict";
+        case TYPE_FUNCTION: return "function";
+        case TYPE_NULL: return "null";
+        case TYPE_ANY: return "any";
+        default: return "unknown";
+    }
+}
+
+void print_indent(int indent) {
+    for (int i = 0; i < indent; i++) {
+        printf("  ");
+    }
+}
+
+void print_ast(ASTNode* node, int indent) {
+    if (!node) return;
+    
+    print_indent(indent);
+    printf("%s", node_type_to_string(node->type));
+    
+    // Print node-specific information
+    switch (node->type) {
+        case NODE_PROGRAM:
+            printf(":\n");
+            for (ASTNode* stmt = node->block.statements; stmt; stmt = stmt->next) {
+                print_ast(stmt, indent + 1);
+            }
+            break;
+            
+        case NODE_BLOCK:
+            printf(" (%d statements):\n", node->block.statements ? 1 : 0);
+            if (node->block.statements) {
+                ASTNode* stmt = node->block.statements;
+                while (stmt) {
+                    print_ast(stmt, indent + 1);
+                    stmt = stmt->next;
+                }
+            }
+            break;
+            
+        case NODE_VAR_DECL:
+        case NODE_CONST_DECL:
+            printf(" %s", node->name ? node->name : "<unnamed>");
+            if (node->decl.data_type != TYPE_ANY) {
+                printf(": %s", data_type_to_string(node->decl.data_type));
+            }
+            printf("\n");
+            if (node->decl.value) {
+                print_indent(indent + 1);
+                printf("value:\n");
+                print_ast(node->decl.value, indent + 2);
+            }
+            break;
+            
+        case NODE_FUNC_DECL:
+            printf(" %s(", node->name ? node->name : "<unnamed>");
+            for (FunctionParam* param = node->func.params; param; param = param->next) {
+                printf("%s%s", param->name, param->next ? ", " : "");
+            }
+            printf(") -> %s\n", data_type_to_string(node->func.return_type));
+            if (node->func.body) {
+                print_indent(indent + 1);
+                printf("body:\n");
+                print_ast(node->func.body, indent + 2);
+            } else if (node->func.skimmed) {
+                print_indent(indent + 1);
+                printf("body: not parsed yet (%zu bytes)\n", strlen(node->func.skimmed));
+            }
+            break;
+            
+        case NODE_IF_STMT:
+            printf(":\n");
+            if (node->flow.dispatch) {
+                print_indent(indent + 1);
+                printf("dispatch (%s, %d labels) on:\n",
+                       dispatch_kind_name(node->flow.dispatch->kind), node->flow.dispatch->label_count);
+                if (node->flow.subject) print_ast(node->flow.subject, indent + 2);
+            }
+            print_indent(indent + 1);
+            printf("condition:\n");
+            if (node->flow.condition) print_ast(node->flow.condition, indent + 2);
+            print_indent(indent + 1);
+            printf("then:\n");
+            if (node->flow.then_branch) print_ast(node->flow.then_branch, indent + 2);
+            for (ASTNode* elif = node->flow.elif_branches; elif; elif = elif->next) {
+                print_ast(elif, indent + 1);
+            }
+            if (node->flow.else_branch) {
+                print_indent(indent + 1);
+                printf("else:\n");
+                print_ast(node->flow.else_branch, indent + 2);
+            }
+            break;
+            
+        case NODE_ELIF_STMT:
+            printf(":\n");
+            print_indent(indent + 1);
+            printf("condition:\n");
+            if (node->flow.condition) print_ast(node->flow.condition, indent + 2);
+            print_indent(indent + 1);
+            printf("then:\n");
+            if (node->flow.then_branch) print_ast(node->flow.then_branch, indent + 2);
+            break;
+            
+        case NODE_WHILE_STMT:
+            printf(":\n");
+            print_indent(indent + 1);
+            printf("condition:\n");
+            if (node->flow.condition) print_ast(node->flow.condition, indent + 2);
+            print_indent(indent + 1);
+            printf("body:\n");
+            if (node->flow.then_branch) print_ast(node->flow.then_branch, indent + 2);
+            break;
+            
+        case NODE_FOR_STMT:
+            printf(" %s in%s:\n", node->name ? node->name : "<iterator>",
+                   node->loop.view == VIEW_KEYS ? " [keys view]" :
+                   node->loop.view == VIEW_VALUES ? " [values view]" : "");
+            print_indent(indent + 1);
+            printf("iterable:\n");
+            if (node->loop.iterable) print_ast(node->loop.iterable, indent + 2);
+            print_indent(indent + 1);
+            printf("body:\n");
+            if (node->loop.body) print_ast(node->loop.body, indent + 2);
+            break;
+            
+        case NODE_RETURN_STMT:
+            printf("\n");
+            if (node->ret.value) {
+                print_indent(indent + 1);
+                printf("value:\n");
+                print_ast(node->ret.value, indent + 2);
+            }
+            break;
+            
+        case NODE_EXPR_STMT:
+            printf(":\n");
+            if (node->expr.binary.left) print_ast(node->expr.binary.left, indent + 1);
+            break;
+            
+        case NODE_FROM_IMPORT:
+            printf(" from %s", node->name ? node->name : "<module>");
+            if (node->import.import_all) {
+                printf(" import *\n");
+            } else {
+                printf(" import:\n");
+                for (int i = 0; i < node->import.import_count; i++) {
+                    print_indent(indent + 1);
+                    printf("%s\n", node->import.imports[i]);
+                }
+            }
+            break;
+            
+        case NODE_BINARY_EXPR:
+            printf(" %s%s\n", node->expr.binary.op ? node->expr.binary.op : "<op>",
+                   node->expr.binary.branch ? " [branch]" : "");
+            print_indent(indent + 1);
+            printf("left:\n");
+            if (node->expr.binary.left) print_ast(node->expr.binary.left, indent + 2);
+            print_indent(indent + 1);
+            printf("right:\n");
+            if (node->expr.binary.right) print_ast(node->expr.binary.right, indent + 2);
+            break;
+            
+        case NODE_UNARY_EXPR:
+            printf(" %s\n", node->expr.unary.op ? node->expr.unary.op : "<op>");
+            print_indent(indent + 1);
+            printf("operand:\n");
+            if (node->expr.unary.operand) print_ast(node->expr.unary.operand, indent + 2);
+            break;
+            
+        case NODE_LITERAL: {
+            char number[NUMFMT_BUFFER_SIZE];
+            switch (node->expr.literal.data_type) {
+                case TYPE_INT:
+                    numfmt_long(node->expr.literal.value.int_val, number);
+                    printf(" int: %s\n", number);
+                    break;
+                case TYPE_BIGINT:
+                    printf(" bigint: %s\n", node->expr.literal.value.bignum_val);
+                    break;
+                case TYPE_FLOAT:
+                    numfmt_double(node->expr.literal.value.float_val, number);
+                    printf(" float: %s\n", number);
+                    break;
+                case TYPE_STRING:
+                    printf(" string: \"%s\"\n", node->expr.literal.value.string_val);
+                    break;
+                case TYPE_BOOL:
+                    printf(" bool: %s\n", node->expr.literal.value.bool_val ? "true" : "false");
+                    break;
+                case TYPE_NULL:
+                    printf(" null\n");
+                    break;
+                default:
+                    printf(" <unknown>\n");
+                    break;
+            }
+            break;
+        }
+            
+        case NODE_IDENTIFIER:
+            printf(" %s\n", node->expr.identifier.identifier ? node->expr.identifier.identifier : "<unnamed>");
+            break;
+            
+        case NODE_ASSIGNMENT:
+            printf("%s%s:\n", node->expr.assign.op ? " " : "",
+                   node->expr.assign.op ? node->expr.assign.op : "");
+            print_indent(indent + 1);
+            printf("target:\n");
+            if (node->expr.assign.target) print_ast(node->expr.assign.target, indent + 2);
+            print_indent(indent + 1);
+            printf("value:\n");
+            if (node->expr.assign.value) print_ast(node->expr.assign.value, indent + 2);
+            break;
+            
+        case NODE_CALL_EXPR:
+            printf(" (%d args):\n", node->expr.call.arg_count);
+            print_indent(indent + 1);
+            printf("callee:\n");
+            if (node->expr.call.callee) print_ast(node->expr.call.callee, indent + 2);
+            if (node->expr.call.arg_count > 0) {
+                print_indent(indent + 1);
+                printf("arguments:\n");
+                ASTNode* arg = node->expr.call.arguments;
+                while (arg) {
+                    print_ast(arg, indent + 2);
+                    arg = arg->next;
+                }
+            }
+            break;
+            
+        case NODE_ARRAY_LITERAL:
+            printf(" (%d elements)%s:\n", node->expr.array.element_count,
+                   node->expr.array.no_escape ? " [no escape]" : "");
+            if (node->expr.array.element_count > 0) {
+                ASTNode* elem = node->expr.array.elements;
+                while (elem) {
+                    print_ast(elem, indent + 1);
+                    elem = elem->next;
+                }
+            }
+            break;
+            
+        case NODE_DICT_LITERAL: {
+            printf(" (%d pairs)%s%s:\n", node->expr.dict.pair_count,
+                   node->expr.dict.no_escape ? " [no escape]" : "",
+                   node->expr.dict.phash ? " [perfect hash]" : "");
+            ASTNode* value = node->expr.dict.values;
+            for (int i = 0; i < node->expr.dict.pair_count && value; i++) {
+                print_indent(indent + 1);
+                printf("%s:\n", node->expr.dict.keys[i]);
+                print_ast(value, indent + 2);
+                value = value->next;
+            }
+            break;
+        }
+            
+        case NODE_MEMBER_ACCESS:
+            printf(" .%s\n", node->expr.member.member ? node->expr.member.member : "<member>");
+            print_indent(indent + 1);
+            printf("object:\n");
+            if (node->expr.member.object) print_ast(node->expr.member.object, indent + 2);
+            break;
+            
+        case NODE_INDEX_ACCESS:
+            printf("%s:\n", node->expr.index.unchecked ? " [unchecked]" : "");
+            print_indent(indent + 1);
+            printf("array:\n");
+            if (node->expr.index.array) print_ast(node->expr.index.array, indent + 2);
+            print_indent(indent + 1);
+            printf("index:\n");
+            if (node->expr.index.index) print_ast(node->expr.index.index, indent + 2);
+            break;
+            
+        case NODE_SLICE_EXPR:
+            printf(":\n");
+            print_indent(indent + 1);
+            printf("object:\n");
+            if (node->expr.slice.object) print_ast(node->expr.slice.object, indent + 2);
+            if (node->expr.slice.start) {
+                print_indent(indent + 1);
+                printf("start:\n");
+                print_ast(node->expr.slice.start, indent + 2);
+            }
+            if (node->expr.slice.end) {
+                print_indent(indent + 1);
+                printf("end:\n");
+                print_ast(node->expr.slice.end, indent + 2);
+            }
+            break;
+            
+        default:
+            printf("\n");
+            break;
+    }
 }
\ No newline at end of file
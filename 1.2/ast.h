@@ -1,258 +1,343 @@
-#ifndef AST_H
-#define AST_H
-
-#include <stdbool.h>
-
-// ================ AST NODE TYPES ================
-typedef enum {
-    // Statements
-    NODE_PROGRAM,
-    NODE_BLOCK,
-    NODE_VAR_DECL,
-    NODE_CONST_DECL,
-    NODE_FUNC_DECL,
-    NODE_IF_STMT,
-    NODE_ELIF_STMT,
-    NODE_ELSE_STMT,
-    NODE_WHILE_STMT,
-    NODE_FOR_STMT,
-    NODE_RETURN_STMT,
-    NODE_BREAK_STMT,
-    NODE_CONTINUE_STMT,
-    NODE_EXPR_STMT,
-    NODE_FROM_IMPORT,
-    
-    // Expressions
-    NODE_BINARY_EXPR,
-    NODE_UNARY_EXPR,
-    NODE_LITERAL,
-    NODE_IDENTIFIER,
-    NODE_ASSIGNMENT,
-    NODE_CALL_EXPR,
-    NODE_ARRAY_LITERAL,
-    NODE_DICT_LITERAL,
-    NODE_MEMBER_ACCESS,
-    NODE_INDEX_ACCESS,
-    NODE_RANGE_EXPR,
-    
-    // Types
-    NODE_TYPE_ANNOTATION
-} NodeType;
-
-// ================ DATA TYPES ================
-typedef enum {
-    TYPE_INT,
-    TYPE_FLOAT,
-    TYPE_STRING,
-    TYPE_BOOL,
-    TYPE_ARRAY,
-    TYPE_DICT,
-    TYPE_FUNCTION,
-    TYPE_NULL,
-    TYPE_ANY
-} DataType;
-
-// ================ LITERAL VALUE ================
-typedef union {
-    long int_val;
-    double float_val;
-    char* string_val;
-    bool bool_val;
-} LiteralValue;
-
-// ================ AST NODE STRUCTURE ================
-typedef struct ASTNode ASTNode;
-typedef struct FunctionParam FunctionParam;
-
-struct FunctionParam {
-    char* name;
-    DataType type;
-    FunctionParam* next;
-};
-
-struct ASTNode {
-    NodeType type;
-    int line;
-    int column;
-    
-    // Common fields
-    char* name;
-    ASTNode* next; // For linked lists (statements, parameters)
-    
-    // Statement fields
-    union {
-        // Variable/Constant declaration
-        struct {
-            DataType data_type;
-            ASTNode* value;
-            bool is_const;
-        } decl;
-        
-        // Function declaration
-        struct {
-            FunctionParam* params;
-            ASTNode* body;
-            DataType return_type;
-        } func;
-        
-        // Control flow
-        struct {
-            ASTNode* condition;
-            ASTNode* then_branch;
-            ASTNode* else_branch;
-            ASTNode* elif_branches; // Linked list of ELIF nodes
-        } flow;
-        
-        // Loops
-        struct {
-            ASTNode* init;
-            ASTNode* condition;
-            ASTNode* update;
-            ASTNode* body;
-            char* iterator;
-            ASTNode* iterable;
-        } loop;
-        
-        // Return statement
-        struct {
-            ASTNode* value;
-        } ret;
-        
-        // Block
-        struct {
-            ASTNode* statements;
-        } block;
-        
-        // From import
-        struct {
-            char* module_name;
-            char** imports;
-            int import_count;
-            bool import_all;
-        } import;
-        
-        // Expression fields
-        union {
-            // Binary expression
-            struct {
-                char* op;
-                ASTNode* left;
-                ASTNode* right;
-            } binary;
-            
-            // Unary expression
-            struct {
-                char* op;
-                ASTNode* operand;
-            } unary;
-            
-            // Literal
-            struct {
-                LiteralValue value;
-                DataType data_type;
-            } literal;
-            
-            // Identifier
-            struct {
-                char* identifier;
-            } identifier;
-            
-            // Assignment
-            struct {
-                ASTNode* target;
-                ASTNode* value;
-            } assign;
-            
-            // Function call
-            struct {
-                ASTNode* callee;
-                ASTNode* arguments;
-                int arg_count;
-            } call;
-            
-            // Array literal
-            struct {
-                ASTNode* elements;
-                int element_count;
-            } array;
-            
-            // Dictionary literal
-            struct {
-                char** keys;
-                ASTNode* values;
-                int pair_count;
-            } dict;
-            
-            // Member access (obj.property)
-            struct {
-                ASTNode* object;
-                char* member;
-            } member;
-            
-            // Index access (array[index])
-            struct {
-                ASTNode* array;
-                ASTNode* index;
-            } index;
-            
-            // Range expression
-            struct {
-                ASTNode* start;
-                ASTNode* end;
-                ASTNode* step;
-            } range;
-        } expr;
-    };
-};
-
-// ================ AST CREATION FUNCTIONS ================
-ASTNode* create_program_node(ASTNode* statements);
-ASTNode* create_block_node(ASTNode* statements, int line, int column);
-ASTNode* create_var_decl_node(char* name, ASTNode* value, bool is_const, int line, int column);
-ASTNode* create_func_decl_node(char* name, FunctionParam* params, ASTNode* body, DataType return_type, int line, int column);
-ASTNode* create_if_node(ASTNode* condition, ASTNode* then_branch, ASTNode* else_branch, int line, int column);
-ASTNode* create_elif_node(ASTNode* condition, ASTNode* then_branch, int line, int column);
-ASTNode* create_while_node(ASTNode* condition, ASTNode* body, int line, int column);
-ASTNode* create_for_node(char* iterator, ASTNode* iterable, ASTNode* body, int line, int column);
-ASTNode* create_return_node(ASTNode* value, int line, int column);
-ASTNode* create_break_node(int line, int column);
-ASTNode* create_continue_node(int line, int column);
-ASTNode* create_expr_stmt_node(ASTNode* expr, int line, int column);
-ASTNode* create_from_import_node(char* module_name, char** imports, int import_count, bool import_all, int line, int column);
-
-// Expression nodes
-ASTNode* create_binary_expr_node(char* op, ASTNode* left, ASTNode* right, int line, int column);
-ASTNode* create_unary_expr_node(char* op, ASTNode* operand, int line, int column);
-ASTNode* create_literal_node_int(long value, int line, int column);
-ASTNode* create_literal_node_float(double value, int line, int column);
-ASTNode* create_literal_node_string(char* value, int line, int column);
-ASTNode* create_literal_node_bool(bool value, int line, int column);
-ASTNode* create_literal_node_null(int line, int column);
-ASTNode* create_identifier_node(char* name, int line, int column);
-ASTNode* create_assignment_node(ASTNode* target, ASTNode* value, int line, int column);
-ASTNode* create_call_expr_node(ASTNode* callee, ASTNode* arguments, int arg_count, int line, int column);
-ASTNode* create_array_literal_node(ASTNode* elements, int element_count, int line, int column);
-ASTNode* create_dict_literal_node(char** keys, ASTNode* values, int pair_count, int line, int column);
-ASTNode* create_member_access_node(ASTNode* object, char* member, int line, int column);
-ASTNode* create_index_access_node(ASTNode* array, ASTNode* index, int line, int column);
-ASTNode* create_range_node(ASTNode* start, ASTNode* end, ASTNode* step, int line, int column);
-
-// Utility functions
-FunctionParam* create_function_param(char* name, DataType type);
-void add_statement_to_block(ASTNode* block, ASTNode* statement);
-void add_elif_branch(ASTNode* if_node, ASTNode* elif_node);
-void add_next_statement(ASTNode* current, ASTNode* next);
-void add_argument_to_call(ASTNode* call_node, ASTNode* argument);
-void add_element_to_array(ASTNode* array_node, ASTNode* element);
-void add_pair_to_dict(ASTNode* dict_node, char* key, ASTNode* value);
-
-// Memory management
-void free_ast_node(ASTNode* node);
-void free_function_params(FunctionParam* params);
-
-// Debug/Print functions
-void print_ast(ASTNode* node, int indent);
-const char* node_type_to_string(NodeType type);
-const char* data_type_to_string(DataType type);
-
+#ifndef AST_H
+#define AST_H
+
+#include <stdbool.h>
+#include "phash.h"
+#include "dispatch.h"
+#include "region.h"
+
+// ================ AST NODE TYPES ================
+typedef enum {
+    // Statements
+    NODE_PROGRAM,
+    NODE_BLOCK,
+    NODE_VAR_DECL,
+    NODE_CONST_DECL,
+    NODE_FUNC_DECL,
+    NODE_IF_STMT,
+    NODE_ELIF_STMT,
+    NODE_ELSE_STMT,
+    NODE_WHILE_STMT,
+    NODE_FOR_STMT,
+    NODE_RETURN_STMT,
+    NODE_BREAK_STMT,
+    NODE_CONTINUE_STMT,
+    NODE_EXPR_STMT,
+    NODE_FROM_IMPORT,
+    
+    // Expressions
+    NODE_BINARY_EXPR,
+    NODE_UNARY_EXPR,
+    NODE_LITERAL,
+    NODE_IDENTIFIER,
+    NODE_ASSIGNMENT,
+    NODE_CALL_EXPR,
+    NODE_ARRAY_LITERAL,
+    NODE_DICT_LITERAL,
+    NODE_MEMBER_ACCESS,
+    NODE_INDEX_ACCESS,
+    NODE_SLICE_EXPR,
+    NODE_RANGE_EXPR,
+    
+    // Types
+    NODE_TYPE_ANNOTATION
+} NodeType;
+
+// ================ DATA TYPES ================
+typedef enum {
+    TYPE_INT,
+    TYPE_BIGINT,    // Integer beyond the range of long
+    TYPE_FLOAT,
+    TYPE_STRING,
+    TYPE_BOOL,
+    TYPE_ARRAY,
+    TYPE_DICT,
+    TYPE_FUNCTION,
+    TYPE_NULL,
+    TYPE_ANY
+} DataType;
+
+// ================ LITERAL VALUE ================
+typedef union {
+    long int_val;
+    double float_val;
+    char* string_val;
+    char* bignum_val;   // Decimal digits, with '-' if negative
+    bool bool_val;
+} LiteralValue;
+
+// ================ ITERATION VIEWS ================
+// How a for loop walks a dict that it iterates in place
+typedef enum {
+    VIEW_NONE,      // Plain iterable
+    VIEW_KEYS,      // keys(d), without copying them into an array
+    VIEW_VALUES     // values(d), likewise
+} IterationView;
+
+// ================ SHARED SUBTREES ================
+// Nodes held by the subtree store (see subtree.h) belong to it and are
+// shared between ASTs; they never change and free_ast_node leaves them
+typedef enum {
+    SHARE_NONE,     // Owned by one AST
+    SHARE_INNER,    // Inside a stored subtree
+    SHARE_ROOT      // Root of a stored subtree
+} ShareState;
+
+// ================ AST NODE STRUCTURE ================
+typedef struct ASTNode ASTNode;
+typedef struct FunctionParam FunctionParam;
+
+struct FunctionParam {
+    char* name;
+    DataType type;
+    FunctionParam* next;
+};
+
+struct ASTNode {
+    NodeType type;
+    int line;
+    int column;
+    ShareState share;   // Set by the subtree store only
+    
+    // Common fields
+    char* name;
+    ASTNode* next; // For linked lists (statements, parameters)
+    
+    // Statement fields
+    union {
+        // Variable/Constant declaration
+        struct {
+            DataType data_type;
+            ASTNode* value;
+            bool is_const;
+        } decl;
+        
+        // Function declaration
+        struct {
+            FunctionParam* params;
+            ASTNode* body;
+            DataType return_type;
+            char* skimmed;      // Body source, '{' to '}', until parsed (see parse_source_lazy)
+            int skimmed_line;   // Position of its '{'
+            int skimmed_column;
+        } func;
+        
+        // Control flow
+        struct {
+            ASTNode* condition;
+            ASTNode* then_branch;
+            ASTNode* else_branch;
+            ASTNode* elif_branches; // Linked list of ELIF nodes
+            ASTNode* subject;       // Value every arm compares with (dispatched chains)
+            DispatchTable* dispatch; // Literal -> arm (0 = then, 1.. = elifs)
+        } flow;
+        
+        // Loops
+        struct {
+            ASTNode* init;
+            ASTNode* condition;
+            ASTNode* update;
+            ASTNode* body;
+            char* iterator;
+            ASTNode* iterable;
+            IterationView view; // The iterable is the dict itself, walked in place
+        } loop;
+        
+        // Return statement
+        struct {
+            ASTNode* value;
+        } ret;
+        
+        // Block
+        struct {
+            ASTNode* statements;
+        } block;
+        
+        // From import
+        struct {
+            char* module_name;
+            char** imports;
+            int import_count;
+            bool import_all;
+        } import;
+        
+        // Expression fields
+        union {
+            // Binary expression
+            struct {
+                char* op;
+                ASTNode* left;
+                ASTNode* right;
+                bool branch;    // and/or in a condition: jumps only, no boolean result
+            } binary;
+            
+            // Unary expression
+            struct {
+                char* op;
+                ASTNode* operand;
+            } unary;
+            
+            // Literal
+            struct {
+                LiteralValue value;
+                DataType data_type;
+            } literal;
+            
+            // Identifier
+            struct {
+                char* identifier;
+            } identifier;
+            
+            // Assignment
+            struct {
+                char* op;   // Compound operator ("+=", "-=", ...), NULL for '='
+                ASTNode* target;
+                ASTNode* value;
+            } assign;
+            
+            // Function call
+            struct {
+                ASTNode* callee;
+                ASTNode* arguments;
+                int arg_count;
+            } call;
+            
+            // Array literal
+            struct {
+                ASTNode* elements;
+                int element_count;
+                bool no_escape; // Never leaves its function (stack allocation)
+            } array;
+            
+            // Dictionary literal
+            struct {
+                char** keys;
+                int* key_shares;    // Owners of 'keys' beyond the first (NULL: never shared)
+                ASTNode* values;
+                int pair_count;
+                bool no_escape; // Never leaves its function (stack allocation)
+                PerfectHash* phash; // Key table built at compile time (constant dicts)
+            } dict;
+            
+            // Member access (obj.property)
+            struct {
+                ASTNode* object;
+                char* member;
+            } member;
+            
+            // Index access (array[index])
+            struct {
+                ASTNode* array;
+                ASTNode* index;
+                bool unchecked; // Index proven in bounds (no runtime check)
+            } index;
+            
+            // Slice (object[start:end]), either bound may be NULL
+            struct {
+                ASTNode* object;
+                ASTNode* start;
+                ASTNode* end;
+            } slice;
+            
+            // Range expression
+            struct {
+                ASTNode* start;
+                ASTNode* end;
+                ASTNode* step;
+            } range;
+        } expr;
+    };
+};
+
+// ================ AST CREATION FUNCTIONS ================
+ASTNode* create_program_node(ASTNode* statements);
+ASTNode* create_block_node(ASTNode* statements, int line, int column);
+ASTNode* create_var_decl_node(char* name, ASTNode* value, bool is_const, int line, int column);
+ASTNode* create_func_decl_node(char* name, FunctionParam* params, ASTNode* body, DataType return_type, int line, int column);
+ASTNode* create_if_node(ASTNode* condition, ASTNode* then_branch, ASTNode* else_branch, int line, int column);
+ASTNode* create_elif_node(ASTNode* condition, ASTNode* then_branch, int line, int column);
+ASTNode* create_while_node(ASTNode* condition, ASTNode* body, int line, int column);
+ASTNode* create_for_node(char* iterator, ASTNode* iterable, ASTNode* body, int line, int column);
+ASTNode* create_return_node(ASTNode* value, int line, int column);
+ASTNode* create_break_node(int line, int column);
+ASTNode* create_continue_node(int line, int column);
+ASTNode* create_expr_stmt_node(ASTNode* expr, int line, int column);
+ASTNode* create_from_import_node(char* module_name, char** imports, int import_count, bool import_all, int line, int column);
+
+// Expression nodes
+ASTNode* create_binary_expr_node(char* op, ASTNode* left, ASTNode* right, int line, int column);
+ASTNode* create_unary_expr_node(char* op, ASTNode* operand, int line, int column);
+ASTNode* create_literal_node_int(long value, int line, int column);
+ASTNode* create_literal_node_float(double value, int line, int column);
+ASTNode* create_literal_node_string(char* value, int line, int column);
+ASTNode* create_literal_node_bignum(char* digits, int line, int column);
+ASTNode* create_literal_node_bool(bool value, int line, int column);
+ASTNode* create_literal_node_null(int line, int column);
+ASTNode* create_identifier_node(char* name, int line, int column);
+ASTNode* create_assignment_node(ASTNode* target, ASTNode* value, int line, int column);
+ASTNode* create_compound_assignment_node(char* op, ASTNode* target, ASTNode* value, int line, int column);
+ASTNode* create_call_expr_node(ASTNode* callee, ASTNode* arguments, int arg_count, int line, int column);
+ASTNode* create_array_literal_node(ASTNode* elements, int element_count, int line, int column);
+ASTNode* create_dict_literal_node(char** keys, ASTNode* values, int pair_count, int line, int column);
+ASTNode* create_member_access_node(ASTNode* object, char* member, int line, int column);
+ASTNode* create_index_access_node(ASTNode* array, ASTNode* index, int line, int column);
+ASTNode* create_slice_node(ASTNode* object, ASTNode* start, ASTNode* end, int line, int column);
+ASTNode* create_range_node(ASTNode* start, ASTNode* end, ASTNode* step, int line, int column);
+
+// Utility functions
+FunctionParam* create_function_param(char* name, DataType type);
+void add_statement_to_block(ASTNode* block, ASTNode* statement);
+void add_elif_branch(ASTNode* if_node, ASTNode* elif_node);
+void add_next_statement(ASTNode* current, ASTNode* next);
+void add_argument_to_call(ASTNode* call_node, ASTNode* argument);
+void add_element_to_array(ASTNode* array_node, ASTNode* element);
+void add_pair_to_dict(ASTNode* dict_node, char* key, ASTNode* value);
+
+// Give a dict literal its own copy of keys shared with clones (call
+// before changing them; false if out of memory)
+bool dict_unshare_keys(ASTNode* dict_node);
+
+// Memory management
+void free_ast_node(ASTNode* node);
+void free_function_params(FunctionParam* params);
+void ast_free_string(char* text);   // Free a string owned by a node
+
+// Allocate nodes and their strings from a region (NULL: the heap again),
+// on the calling thread only; returns the region used until now.
+// Region nodes are still released with free_ast_node, which leaves their
+// memory to the region.
+Region* ast_use_region(Region* region);
+
+// Count the nodes the calling thread allocates from now on. Once more
+// than 'budget' (0: no limit) are made, ast_over_budget turns true and
+// the parser stops where it is, failing the parse.
+void ast_set_node_budget(long budget);
+bool ast_over_budget(void);
+long ast_nodes_allocated(void);   // Since ast_set_node_budget
+
+// A zeroed node and a string copy, allocated as the create functions do
+ASTNode* ast_new_node(void);
+char* ast_strdup(const char* text);
+char* ast_strndup(const char* text, size_t length);
+
+// Copying and traversal
+// The visitor receives the address of each child pointer, so passes can
+// replace a child in place (keeping its 'next' link for list elements).
+typedef void (*ASTChildVisitor)(ASTNode** slot, void* data);
+
+// Makes the copy of each child for copy_ast_node
+typedef ASTNode* (*ASTChildCopier)(const ASTNode* child);
+
+ASTNode* clone_ast_node(const ASTNode* node);
+ASTNode* clone_ast_list(const ASTNode* head);
+ASTNode* copy_ast_node(const ASTNode* node, ASTChildCopier copy_child);
+FunctionParam* clone_function_params(const FunctionParam* params);
+void ast_for_each_child(ASTNode* node, ASTChildVisitor visit, void* data);
+int ast_node_count(ASTNode* node);
+
+// Debug/Print functions
+void print_ast(ASTNode* node, int indent);
+const char* node_type_to_string(NodeType type);
+const char* data_type_to_string(DataType type);
+
 #endif // AST_H
\ No newline at end of file
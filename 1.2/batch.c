@@ -0,0 +1,305 @@
+/**
+ * Batch processing for Topo Programming Language
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include "batch.h"
+#include "ast.h"
+#include "parser.h"
+#include "optimizer.h"
+#include "region.h"
+#include "subtree.h"
+
+#if !defined(_WIN32) && !defined(BATCH_NO_THREADS)
+#include <pthread.h>
+#include <unistd.h>
+#define BATCH_HAVE_THREADS 1
+#endif
+
+static double batch_now(void) {
+#if defined(CLOCK_MONOTONIC)
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+#else
+    return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+const char* batch_status_name(BatchStatus status) {
+    switch (status) {
+        case BATCH_PENDING: return "pending";
+        case BATCH_OK: return "ok";
+        case BATCH_READ_ERROR: return "read error";
+        case BATCH_PARSE_ERROR: return "parse error";
+        case BATCH_OVER_BUDGET: return "over budget";
+        case BATCH_OPTIMIZE_ERROR: return "optimize error";
+        default: return "unknown";
+    }
+}
+
+// ================ TASKS ================
+
+static char* batch_read_file(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+    
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    
+    char* text = size >= 0 ? (char*)malloc((size_t)size + 1) : NULL;
+    if (text) {
+        size = (long)fread(text, 1, (size_t)size, file);
+        text[size] = '\0';
+    }
+    fclose(file);
+    return text;
+}
+
+// Everything the task allocates for its AST comes from its own region
+// (or the heap past the region's cap), and is gone when the task returns
+static void batch_run_task(BatchTask* task, int node_budget, bool lazy, bool optimize, bool share) {
+    double start = batch_now();
+    
+    char* source = batch_read_file(task->path);
+    if (!source) {
+        task->status = BATCH_READ_ERROR;
+        task->seconds = batch_now() - start;
+        return;
+    }
+    
+    Region* region = region_create(REGION_DEFAULT_CAP);
+    ast_use_region(region);
+    
+    // The parser stops as soon as the budget runs out, so an oversized
+    // file costs about as much as one that just fits
+    ast_set_node_budget(node_budget);
+    
+    // Skimmed bodies are only parsed if something needs the whole tree
+    ASTNode* ast = lazy ? parse_source_lazy(source, task->path) : parse_source(source, task->path);
+    bool parsed = ast && (!lazy || !(optimize || share) || parse_function_bodies(ast));
+    if (ast_over_budget()) {
+        task->nodes = (int)ast_nodes_allocated();
+        task->status = BATCH_OVER_BUDGET;
+    } else if (!parsed) {
+        task->status = BATCH_PARSE_ERROR;
+    } else {
+        task->nodes = ast_node_count(ast);
+        if (task->nodes > node_budget) {
+            task->status = BATCH_OVER_BUDGET;
+        } else if (optimize && !optimize_program(ast)) {
+            task->status = BATCH_OPTIMIZE_ERROR;
+        } else {
+            if (optimize) task->nodes = ast_node_count(ast);
+            if (share) subtree_share(&ast);
+            task->status = BATCH_OK;
+        }
+    }
+    ast_set_node_budget(0);
+    
+    // Frees what spilled to the heap; region memory goes with the region,
+    // and stored subtrees stay in the store
+    free_ast_node(ast);
+    ast_use_region(NULL);
+    region_destroy(region);
+    free(source);
+    
+    task->seconds = batch_now() - start;
+}
+
+// ================ RUN QUEUES ================
+// Tasks are dealt round-robin to the workers' queues up front. A worker
+// takes from the back of its own queue and, once that is empty, steals
+// from the front of the others'. Nothing is queued after the start, so a
+// worker that finds every queue empty is done.
+
+typedef struct {
+    int* items;         // Task indices
+    int head;           // Next to steal
+    int tail;           // One past the next to take locally
+#if defined(BATCH_HAVE_THREADS)
+    pthread_mutex_t lock;
+#endif
+} BatchQueue;
+
+typedef struct {
+    BatchTask* tasks;
+    BatchQueue* queues;
+    int worker_count;
+    int node_budget;
+    bool lazy;
+    bool optimize;
+    bool share;
+} BatchPool;
+
+typedef struct {
+    BatchPool* pool;
+    int index;
+    long steals;
+} BatchWorker;
+
+static void batch_queue_lock(BatchQueue* queue) {
+#if defined(BATCH_HAVE_THREADS)
+    pthread_mutex_lock(&queue->lock);
+#else
+    (void)queue;
+#endif
+}
+
+static void batch_queue_unlock(BatchQueue* queue) {
+#if defined(BATCH_HAVE_THREADS)
+    pthread_mutex_unlock(&queue->lock);
+#else
+    (void)queue;
+#endif
+}
+
+static int batch_take(BatchQueue* queue, bool steal) {
+    int task = -1;
+    
+    batch_queue_lock(queue);
+    if (queue->head < queue->tail) {
+        task = steal ? queue->items[queue->head++] : queue->items[--queue->tail];
+    }
+    batch_queue_unlock(queue);
+    
+    return task;
+}
+
+static void batch_worker_run(BatchWorker* worker) {
+    BatchPool* pool = worker->pool;
+    
+    for (;;) {
+        int task = batch_take(&pool->queues[worker->index], false);
+        
+        // Own queue empty: try the others, starting with the next worker
+        for (int i = 1; task < 0 && i < pool->worker_count; i++) {
+            task = batch_take(&pool->queues[(worker->index + i) % pool->worker_count], true);
+            if (task >= 0) worker->steals++;
+        }
+        if (task < 0) return;
+        
+        pool->tasks[task].worker = worker->index;
+        batch_run_task(&pool->tasks[task], pool->node_budget, pool->lazy, pool->optimize, pool->share);
+    }
+}
+
+#if defined(BATCH_HAVE_THREADS)
+static void* batch_thread_main(void* worker) {
+    batch_worker_run((BatchWorker*)worker);
+    return NULL;
+}
+#endif
+
+static int batch_worker_count(const BatchOptions* options, int count) {
+    int workers = options->workers;
+#if defined(BATCH_HAVE_THREADS)
+    if (workers <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = cpus > 1 ? (int)cpus : 1;
+    }
+#else
+    workers = 1;
+#endif
+    if (workers > BATCH_MAX_WORKERS) workers = BATCH_MAX_WORKERS;
+    if (workers > count) workers = count;
+    return workers > 1 ? workers : 1;
+}
+
+// ================ BATCH ================
+
+BatchResult batch_run(BatchTask* tasks, int count, const BatchOptions* options) {
+    BatchResult result = {0, 0, 0, 0.0};
+    if (count <= 0) return result;
+    
+    double start = batch_now();
+    
+    for (int i = 0; i < count; i++) {
+        tasks[i].status = BATCH_PENDING;
+        tasks[i].nodes = 0;
+        tasks[i].seconds = 0.0;
+        tasks[i].worker = -1;
+    }
+    
+    BatchPool pool;
+    pool.tasks = tasks;
+    pool.worker_count = batch_worker_count(options, count);
+    pool.node_budget = options->node_budget > 0 ? options->node_budget : BATCH_DEFAULT_BUDGET;
+    pool.lazy = options->lazy;
+    pool.optimize = options->optimize;
+    pool.share = options->share;
+    pool.queues = (BatchQueue*)calloc((size_t)pool.worker_count, sizeof(BatchQueue));
+    int* items = (int*)malloc((size_t)count * sizeof(int));
+    
+    if (!pool.queues || !items) {
+        // Out of memory: run everything on the calling thread
+        free(pool.queues);
+        free(items);
+        for (int i = 0; i < count; i++) {
+            tasks[i].worker = 0;
+            batch_run_task(&tasks[i], pool.node_budget, pool.lazy, pool.optimize, pool.share);
+            if (tasks[i].status != BATCH_OK) result.failed++;
+        }
+        result.workers = 1;
+        result.seconds = batch_now() - start;
+        return result;
+    }
+    
+    // Deal the tasks out: queue w holds tasks w, w + workers, ...
+    int next = 0;
+    for (int w = 0; w < pool.worker_count; w++) {
+        BatchQueue* queue = &pool.queues[w];
+        queue->items = items + next;
+        for (int i = w; i < count; i += pool.worker_count) {
+            items[next++] = i;
+        }
+        queue->tail = (int)(items + next - queue->items);
+#if defined(BATCH_HAVE_THREADS)
+        pthread_mutex_init(&queue->lock, NULL);
+#endif
+    }
+    
+    BatchWorker workers[BATCH_MAX_WORKERS];
+    for (int w = 0; w < pool.worker_count; w++) {
+        workers[w].pool = &pool;
+        workers[w].index = w;
+        workers[w].steals = 0;
+    }
+
+#if defined(BATCH_HAVE_THREADS)
+    // The calling thread is worker 0
+    pthread_t threads[BATCH_MAX_WORKERS];
+    bool started[BATCH_MAX_WORKERS] = {false};
+    for (int w = 1; w < pool.worker_count; w++) {
+        started[w] = pthread_create(&threads[w], NULL, batch_thread_main, &workers[w]) == 0;
+    }
+    batch_worker_run(&workers[0]);
+    for (int w = 1; w < pool.worker_count; w++) {
+        if (started[w]) pthread_join(threads[w], NULL);
+    }
+#else
+    batch_worker_run(&workers[0]);
+#endif
+
+    for (int w = 0; w < pool.worker_count; w++) {
+        result.steals += workers[w].steals;
+#if defined(BATCH_HAVE_THREADS)
+        pthread_mutex_destroy(&pool.queues[w].lock);
+#endif
+    }
+    for (int i = 0; i < count; i++) {
+        if (tasks[i].status != BATCH_OK) result.failed++;
+    }
+    
+    free(items);
+    free(pool.queues);
+    
+    result.workers = pool.worker_count;
+    result.seconds = batch_now() - start;
+    return result;
+}
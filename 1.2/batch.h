@@ -0,0 +1,56 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdbool.h>
+
+// ================ BATCH PROCESSING ================
+// Parses (and optionally optimizes) many files on a fixed pool of worker
+// threads. Every worker has its own run queue and steals from the others
+// once it runs dry, so one large file holds up only its own worker. Each
+// task allocates its AST from a region of its own, released in one piece
+// when the task ends, and has a node budget: the parse stops as soon as
+// it has made more nodes than that, and the file is reported as over
+// budget rather than optimized. With 'share', each finished AST goes
+// through the subtree store, which keeps what repeats across the files.
+// With 'lazy', function bodies are skimmed (parse_source_lazy) unless the
+// AST is optimized or shared, which needs them all.
+
+#define BATCH_MAX_WORKERS 64
+#define BATCH_DEFAULT_BUDGET 1000000    // AST nodes per task
+
+typedef enum {
+    BATCH_PENDING,
+    BATCH_OK,
+    BATCH_READ_ERROR,
+    BATCH_PARSE_ERROR,
+    BATCH_OVER_BUDGET,
+    BATCH_OPTIMIZE_ERROR
+} BatchStatus;
+
+typedef struct {
+    const char* path;
+    BatchStatus status;
+    int nodes;          // AST size when the task finished (nodes made, if over budget)
+    double seconds;     // Wall time from start to finish
+    int worker;         // Worker that ran the task
+} BatchTask;
+
+typedef struct {
+    int workers;        // 0: one per CPU
+    int node_budget;    // 0: BATCH_DEFAULT_BUDGET
+    bool lazy;          // Skim function bodies
+    bool optimize;
+    bool share;         // Share subtrees through the store (subtree.h)
+} BatchOptions;
+
+typedef struct {
+    int workers;        // Workers actually started
+    int failed;         // Tasks not BATCH_OK
+    long steals;        // Tasks taken from another worker's queue
+    double seconds;     // Wall time for the whole batch
+} BatchResult;
+
+BatchResult batch_run(BatchTask* tasks, int count, const BatchOptions* options);
+const char* batch_status_name(BatchStatus status);
+
+#endif // BATCH_H
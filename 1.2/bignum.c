@@ -0,0 +1,339 @@
+/**
+ * Arbitrary-precision integers for Topo Programming Language
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <limits.h>
+#include "bignum.h"
+
+// ================ MAGNITUDE HELPERS ================
+// Operate on bare limb arrays; lengths exclude leading zero limbs.
+
+static int mag_trim(const uint32_t* limbs, int length) {
+    while (length > 0 && limbs[length - 1] == 0) {
+        length--;
+    }
+    return length;
+}
+
+static int mag_compare(const uint32_t* a, int la, const uint32_t* b, int lb) {
+    if (la != lb) return la < lb ? -1 : 1;
+    for (int i = la - 1; i >= 0; i--) {
+        if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+// out = a + b, out has room for max(la, lb) + 1 limbs (may alias a)
+static int mag_add(const uint32_t* a, int la, const uint32_t* b, int lb, uint32_t* out) {
+    if (la < lb) {
+        const uint32_t* t = a; a = b; b = t;
+        int tl = la; la = lb; lb = tl;
+    }
+    
+    uint32_t carry = 0;
+    for (int i = 0; i < la; i++) {
+        uint32_t sum = a[i] + (i < lb ? b[i] : 0) + carry;
+        carry = sum >= BIGNUM_BASE;
+        out[i] = carry ? sum - BIGNUM_BASE : sum;
+    }
+    out[la] = carry;
+    return mag_trim(out, la + 1);
+}
+
+// out = a - b for a >= b, out has room for la limbs (may alias a)
+static int mag_sub(const uint32_t* a, int la, const uint32_t* b, int lb, uint32_t* out) {
+    uint32_t borrow = 0;
+    for (int i = 0; i < la; i++) {
+        uint32_t sub = (i < lb ? b[i] : 0) + borrow;
+        borrow = a[i] < sub;
+        out[i] = borrow ? a[i] + BIGNUM_BASE - sub : a[i] - sub;
+    }
+    return mag_trim(out, la);
+}
+
+// out += a * b (schoolbook), out has room for la + lb limbs
+static void mag_mul_schoolbook(const uint32_t* a, int la, const uint32_t* b, int lb, uint32_t* out) {
+    for (int i = 0; i < la; i++) {
+        uint64_t carry = 0;
+        for (int j = 0; j < lb; j++) {
+            uint64_t cur = out[i + j] + (uint64_t)a[i] * b[j] + carry;
+            out[i + j] = (uint32_t)(cur % BIGNUM_BASE);
+            carry = cur / BIGNUM_BASE;
+        }
+        
+        // Propagate, earlier rows may have left this limb non-zero
+        for (int k = i + lb; carry; k++) {
+            uint64_t cur = out[k] + carry;
+            out[k] = (uint32_t)(cur % BIGNUM_BASE);
+            carry = cur / BIGNUM_BASE;
+        }
+    }
+}
+
+// out += value << (shift limbs), out has room for the result
+static void mag_add_shifted(uint32_t* out, const uint32_t* value, int length, int shift) {
+    uint32_t carry = 0;
+    int i;
+    for (i = 0; i < length; i++) {
+        uint32_t sum = out[shift + i] + value[i] + carry;
+        carry = sum >= BIGNUM_BASE;
+        out[shift + i] = carry ? sum - BIGNUM_BASE : sum;
+    }
+    for (i += shift; carry; i++) {
+        uint32_t sum = out[i] + carry;
+        carry = sum >= BIGNUM_BASE;
+        out[i] = carry ? sum - BIGNUM_BASE : sum;
+    }
+}
+
+// out = a * b, out zeroed with room for la + lb limbs
+static bool mag_mul(const uint32_t* a, int la, const uint32_t* b, int lb, uint32_t* out) {
+    if (la < lb) {
+        const uint32_t* t = a; a = b; b = t;
+        int tl = la; la = lb; lb = tl;
+    }
+    
+    int half = la / 2;
+    if (lb < BIGNUM_KARATSUBA_CUTOFF || lb <= half) {
+        mag_mul_schoolbook(a, la, b, lb, out);
+        return true;
+    }
+    
+    // Karatsuba: a = a1*B^h + a0, b = b1*B^h + b0
+    //   a*b = z2*B^2h + (z1 - z2 - z0)*B^h + z0, z1 = (a0 + a1)(b0 + b1)
+    int la0 = mag_trim(a, half), lb0 = mag_trim(b, half);
+    const uint32_t* a1 = a + half;
+    const uint32_t* b1 = b + half;
+    int la1 = la - half, lb1 = lb - half;
+    
+    int sum_size = la1 + 2;
+    uint32_t* sa = (uint32_t*)calloc(sum_size, sizeof(uint32_t));
+    uint32_t* sb = (uint32_t*)calloc(sum_size, sizeof(uint32_t));
+    uint32_t* z0 = (uint32_t*)calloc(2 * half + 1, sizeof(uint32_t));
+    uint32_t* z1 = (uint32_t*)calloc(2 * sum_size + 1, sizeof(uint32_t));
+    uint32_t* z2 = (uint32_t*)calloc(la1 + lb1 + 1, sizeof(uint32_t));
+    bool ok = sa && sb && z0 && z1 && z2;
+    
+    if (ok) {
+        int lsa = mag_add(a, la0, a1, la1, sa);
+        int lsb = mag_add(b, lb0, b1, lb1, sb);
+        
+        ok = mag_mul(a, la0, b, lb0, z0) &&
+             mag_mul(a1, la1, b1, lb1, z2) &&
+             mag_mul(sa, lsa, sb, lsb, z1);
+    }
+    
+    if (ok) {
+        int lz0 = mag_trim(z0, 2 * half + 1);
+        int lz2 = mag_trim(z2, la1 + lb1 + 1);
+        int lz1 = mag_trim(z1, 2 * sum_size + 1);
+        lz1 = mag_sub(z1, lz1, z0, lz0, z1);
+        lz1 = mag_sub(z1, lz1, z2, lz2, z1);
+        
+        mag_add_shifted(out, z0, lz0, 0);
+        mag_add_shifted(out, z1, lz1, half);
+        mag_add_shifted(out, z2, lz2, 2 * half);
+    }
+    
+    free(sa);
+    free(sb);
+    free(z0);
+    free(z1);
+    free(z2);
+    return ok;
+}
+
+// ================ CREATION ================
+
+static BigNum* bignum_alloc(int capacity) {
+    BigNum* num = (BigNum*)calloc(1, sizeof(BigNum));
+    if (!num) return NULL;
+    
+    num->limbs = (uint32_t*)calloc(capacity > 0 ? capacity : 1, sizeof(uint32_t));
+    if (!num->limbs) {
+        free(num);
+        return NULL;
+    }
+    
+    return num;
+}
+
+BigNum* bignum_from_string(const char* text) {
+    if (!text) return NULL;
+    
+    bool negative = *text == '-';
+    if (negative) text++;
+    
+    int digits = (int)strlen(text);
+    if (digits == 0) return NULL;
+    for (int i = 0; i < digits; i++) {
+        if (!isdigit((unsigned char)text[i])) return NULL;
+    }
+    
+    BigNum* num = bignum_alloc((digits + BIGNUM_BASE_DIGITS - 1) / BIGNUM_BASE_DIGITS);
+    if (!num) return NULL;
+    
+    // Nine digits per limb, starting from the least significant end
+    int length = 0;
+    for (int end = digits; end > 0; end -= BIGNUM_BASE_DIGITS) {
+        int start = end > BIGNUM_BASE_DIGITS ? end - BIGNUM_BASE_DIGITS : 0;
+        uint32_t limb = 0;
+        for (int i = start; i < end; i++) {
+            limb = limb * 10 + (uint32_t)(text[i] - '0');
+        }
+        num->limbs[length++] = limb;
+    }
+    
+    num->length = mag_trim(num->limbs, length);
+    num->negative = negative && num->length > 0;
+    return num;
+}
+
+BigNum* bignum_from_long(long value) {
+    BigNum* num = bignum_alloc(3);
+    if (!num) return NULL;
+    
+    // Unsigned, so that -LONG_MIN does not overflow
+    unsigned long magnitude = value < 0 ? 0ul - (unsigned long)value : (unsigned long)value;
+    while (magnitude > 0) {
+        num->limbs[num->length++] = (uint32_t)(magnitude % BIGNUM_BASE);
+        magnitude /= BIGNUM_BASE;
+    }
+    num->negative = value < 0;
+    
+    return num;
+}
+
+// ================ CONVERSION ================
+
+bool bignum_to_long(const BigNum* num, long* value) {
+    if (!num) return false;
+    
+    unsigned long magnitude = 0;
+    for (int i = num->length - 1; i >= 0; i--) {
+        if (__builtin_mul_overflow(magnitude, BIGNUM_BASE, &magnitude) ||
+            __builtin_add_overflow(magnitude, num->limbs[i], &magnitude)) {
+            return false;
+        }
+    }
+    
+    // LONG_MIN has no positive counterpart
+    unsigned long limit = num->negative ? (unsigned long)LONG_MAX + 1 : (unsigned long)LONG_MAX;
+    if (magnitude > limit) return false;
+    
+    if (value) *value = num->negative ? (long)(0ul - magnitude) : (long)magnitude;
+    return true;
+}
+
+char* bignum_to_string(const BigNum* num) {
+    if (!num) return NULL;
+    
+    size_t size = (size_t)(num->length > 0 ? num->length : 1) * BIGNUM_BASE_DIGITS + 2;
+    char* text = (char*)malloc(size);
+    if (!text) return NULL;
+    
+    if (num->length == 0) {
+        strcpy(text, "0");
+        return text;
+    }
+    
+    // Leading limb without padding, the rest as nine digits each
+    char* p = text;
+    if (num->negative) *p++ = '-';
+    p += sprintf(p, "%u", num->limbs[num->length - 1]);
+    for (int i = num->length - 2; i >= 0; i--) {
+        uint32_t limb = num->limbs[i];
+        for (int digit = BIGNUM_BASE_DIGITS - 1; digit >= 0; digit--) {
+            p[digit] = (char)('0' + limb % 10);
+            limb /= 10;
+        }
+        p += BIGNUM_BASE_DIGITS;
+    }
+    *p = '\0';
+    
+    return text;
+}
+
+// ================ ARITHMETIC ================
+
+// a + b with the signs given explicitly (b_negative flips for subtraction)
+static BigNum* bignum_add_signed(const BigNum* a, const BigNum* b, bool b_negative) {
+    if (!a || !b) return NULL;
+    
+    int length = (a->length > b->length ? a->length : b->length) + 1;
+    BigNum* result = bignum_alloc(length);
+    if (!result) return NULL;
+    
+    if (a->negative == b_negative) {
+        result->length = mag_add(a->limbs, a->length, b->limbs, b->length, result->limbs);
+        result->negative = a->negative;
+    } else if (mag_compare(a->limbs, a->length, b->limbs, b->length) >= 0) {
+        result->length = mag_sub(a->limbs, a->length, b->limbs, b->length, result->limbs);
+        result->negative = a->negative;
+    } else {
+        result->length = mag_sub(b->limbs, b->length, a->limbs, a->length, result->limbs);
+        result->negative = b_negative;
+    }
+    
+    if (result->length == 0) result->negative = false;
+    return result;
+}
+
+BigNum* bignum_add(const BigNum* a, const BigNum* b) {
+    return b ? bignum_add_signed(a, b, b->negative) : NULL;
+}
+
+BigNum* bignum_sub(const BigNum* a, const BigNum* b) {
+    return b ? bignum_add_signed(a, b, !b->negative) : NULL;
+}
+
+BigNum* bignum_mul(const BigNum* a, const BigNum* b) {
+    if (!a || !b) return NULL;
+    
+    BigNum* result = bignum_alloc(a->length + b->length);
+    if (!result) return NULL;
+    
+    if (a->length > 0 && b->length > 0) {
+        if (!mag_mul(a->limbs, a->length, b->limbs, b->length, result->limbs)) {
+            bignum_destroy(result);
+            return NULL;
+        }
+        result->length = mag_trim(result->limbs, a->length + b->length);
+        result->negative = a->negative != b->negative;
+    }
+    
+    return result;
+}
+
+BigNum* bignum_negate(const BigNum* num) {
+    if (!num) return NULL;
+    
+    BigNum* result = bignum_alloc(num->length);
+    if (!result) return NULL;
+    
+    memcpy(result->limbs, num->limbs, num->length * sizeof(uint32_t));
+    result->length = num->length;
+    result->negative = num->length > 0 && !num->negative;
+    return result;
+}
+
+int bignum_compare(const BigNum* a, const BigNum* b) {
+    if (a->negative != b->negative) return a->negative ? -1 : 1;
+    
+    int order = mag_compare(a->limbs, a->length, b->limbs, b->length);
+    return a->negative ? -order : order;
+}
+
+// ================ MEMORY MANAGEMENT ================
+
+void bignum_destroy(BigNum* num) {
+    if (!num) return;
+    
+    free(num->limbs);
+    free(num);
+}
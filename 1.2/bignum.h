@@ -0,0 +1,37 @@
+#ifndef BIGNUM_H
+#define BIGNUM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ================ ARBITRARY-PRECISION INTEGERS ================
+// Sign and magnitude, the magnitude in base 10^9 limbs (least
+// significant first), which makes decimal conversion linear.
+typedef struct {
+    bool negative;
+    int length;           // Limbs in use (0 for zero)
+    uint32_t* limbs;
+} BigNum;
+
+#define BIGNUM_BASE 1000000000u
+#define BIGNUM_BASE_DIGITS 9
+#define BIGNUM_KARATSUBA_CUTOFF 32  // Limbs below which schoolbook multiplication wins
+
+// Creation (NULL on bad input or allocation failure)
+BigNum* bignum_from_string(const char* text);   // Decimal, optional leading '-'
+BigNum* bignum_from_long(long value);
+
+// Conversion
+bool bignum_to_long(const BigNum* num, long* value);  // False if out of range
+char* bignum_to_string(const BigNum* num);            // Caller frees
+
+// Arithmetic (results are new numbers)
+BigNum* bignum_add(const BigNum* a, const BigNum* b);
+BigNum* bignum_sub(const BigNum* a, const BigNum* b);
+BigNum* bignum_mul(const BigNum* a, const BigNum* b);
+BigNum* bignum_negate(const BigNum* num);
+int bignum_compare(const BigNum* a, const BigNum* b);
+
+void bignum_destroy(BigNum* num);
+
+#endif // BIGNUM_H
@@ -0,0 +1,384 @@
+/**
+ * CSV reader for Topo Programming Language
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include "csv.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define CSV_HAVE_MMAP 1
+#endif
+
+// ================ INPUT ================
+
+static CsvReader* csv_create(const char* data, size_t length, char delimiter) {
+    CsvReader* reader = (CsvReader*)calloc(1, sizeof(CsvReader));
+    if (!reader) return NULL;
+    
+    reader->data = data;
+    reader->length = length;
+    reader->delimiter = delimiter ? delimiter : ',';
+    
+    // Skip a UTF-8 byte order mark
+    if (length >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0) {
+        reader->position = 3;
+    }
+    
+    return reader;
+}
+
+CsvReader* csv_open_buffer(const char* data, size_t length, char delimiter) {
+    if (!data) return NULL;
+    return csv_create(data, length, delimiter);
+}
+
+CsvReader* csv_open(const char* path, char delimiter) {
+    if (!path) return NULL;
+    
+#if defined(CSV_HAVE_MMAP)
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0) {
+        struct stat info;
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+            void* map = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (map == MAP_FAILED) return NULL;
+            
+            madvise(map, (size_t)info.st_size, MADV_SEQUENTIAL);
+            CsvReader* reader = csv_create((const char*)map, (size_t)info.st_size, delimiter);
+            if (!reader) {
+                munmap(map, (size_t)info.st_size);
+                return NULL;
+            }
+            reader->mapped = true;
+            reader->owned = true;
+            return reader;
+        }
+        close(fd);
+    }
+#endif
+    
+    // Fallback: read the whole file (pipes, empty files, no mmap)
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+    
+    size_t capacity = 1 << 16;
+    size_t length = 0;
+    char* data = (char*)malloc(capacity);
+    while (data) {
+        length += fread(data + length, 1, capacity - length, file);
+        if (length < capacity) break;
+        
+        char* grown = (char*)realloc(data, capacity * 2);
+        if (!grown) {
+            free(data);
+            data = NULL;
+            break;
+        }
+        data = grown;
+        capacity *= 2;
+    }
+    fclose(file);
+    if (!data) return NULL;
+    
+    CsvReader* reader = csv_create(data, length, delimiter);
+    if (!reader) {
+        free(data);
+        return NULL;
+    }
+    reader->owned = true;
+    return reader;
+}
+
+void csv_close(CsvReader* reader) {
+    if (!reader) return;
+    
+#if defined(CSV_HAVE_MMAP)
+    if (reader->mapped) {
+        munmap((void*)reader->data, reader->length);
+    } else
+#endif
+    if (reader->owned) {
+        free((void*)reader->data);
+    }
+    
+    free(reader->fields);
+    free(reader);
+}
+
+// ================ SCANNING ================
+
+// Offset of the next delimiter, quote or line break at or after 'pos'
+static size_t csv_find_special(const char* data, size_t pos, size_t length, char delimiter) {
+#if defined(__SSE2__)
+    const __m128i delim = _mm_set1_epi8(delimiter);
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    while (pos + 16 <= length) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(data + pos));
+        __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, delim), _mm_cmpeq_epi8(chunk, quote)),
+                                    _mm_or_si128(_mm_cmpeq_epi8(chunk, lf), _mm_cmpeq_epi8(chunk, cr)));
+        int mask = _mm_movemask_epi8(hits);
+        if (mask) return pos + __builtin_ctz(mask);
+        pos += 16;
+    }
+#endif
+    while (pos < length) {
+        char c = data[pos];
+        if (c == delimiter || c == '"' || c == '\n' || c == '\r') break;
+        pos++;
+    }
+    return pos;
+}
+
+static bool csv_add_field(CsvReader* reader, const char* data, size_t length, bool quoted, size_t tail) {
+    if (reader->field_count >= reader->field_capacity) {
+        int capacity = reader->field_capacity ? reader->field_capacity * 2 : 16;
+        CsvField* fields = (CsvField*)realloc(reader->fields, capacity * sizeof(CsvField));
+        if (!fields) return false;
+        reader->fields = fields;
+        reader->field_capacity = capacity;
+    }
+    
+    CsvField* field = &reader->fields[reader->field_count++];
+    field->data = data;
+    field->length = length;
+    field->quoted = quoted;
+    field->tail = tail;
+    return true;
+}
+
+bool csv_next_row(CsvReader* reader) {
+    if (!reader || reader->position >= reader->length) return false;
+    
+    const char* data = reader->data;
+    size_t length = reader->length;
+    size_t pos = reader->position;
+    reader->field_count = 0;
+    
+    // A blank line is a row without fields
+    if (data[pos] == '\r' || data[pos] == '\n') {
+        if (data[pos] == '\r') pos++;
+        if (pos < length && data[pos] == '\n') pos++;
+        reader->position = pos;
+        reader->row++;
+        return true;
+    }
+    
+    for (;;) {
+        if (pos < length && data[pos] == '"') {
+            // Quoted field: runs to a quote that is not doubled
+            size_t start = ++pos;
+            bool doubled = false;
+            for (;;) {
+                const char* quote = (const char*)memchr(data + pos, '"', length - pos);
+                if (!quote) {
+                    pos = length;   // Unterminated, take the rest
+                    break;
+                }
+                pos = quote - data;
+                if (pos + 1 < length && data[pos + 1] == '"') {
+                    doubled = true;
+                    pos += 2;
+                    continue;
+                }
+                break;
+            }
+            
+            size_t end = pos;
+            if (pos < length) pos++; // Closing quote
+            
+            // Text up to the next separator joins the field, quotes and all
+            size_t after = pos;
+            while (pos < length && data[pos] != reader->delimiter && data[pos] != '\n' && data[pos] != '\r') {
+                pos = csv_find_special(data, pos + (data[pos] == '"'), length, reader->delimiter);
+            }
+            size_t tail = pos - after;
+            
+            if (!csv_add_field(reader, data + start, (tail ? pos : end) - start, doubled || tail, tail)) {
+                return false;
+            }
+        } else {
+            size_t start = pos;
+            pos = csv_find_special(data, pos, length, reader->delimiter);
+            
+            // A stray quote inside an unquoted field is plain text
+            while (pos < length && data[pos] == '"') {
+                pos = csv_find_special(data, pos + 1, length, reader->delimiter);
+            }
+            if (!csv_add_field(reader, data + start, pos - start, false, 0)) return false;
+        }
+        
+        if (pos < length && data[pos] == reader->delimiter) {
+            pos++;
+            continue;
+        }
+        break;
+    }
+    
+    // Line break: \n, \r\n or \r
+    if (pos < length && data[pos] == '\r') pos++;
+    if (pos < length && data[pos] == '\n') pos++;
+    
+    reader->position = pos;
+    reader->row++;
+    return true;
+}
+
+// ================ FIELD CONVERSION ================
+
+// A field split by its closing quote ("1"2) as one plain field, whose
+// text the caller frees
+static bool csv_field_join(const CsvField* field, CsvField* joined) {
+    char* text = csv_field_copy(field);
+    if (!text) return false;
+    
+    joined->data = text;
+    joined->length = strlen(text);
+    joined->quoted = false;
+    joined->tail = 0;
+    return true;
+}
+
+bool csv_field_long(const CsvField* field, long* value) {
+    if (!field || field->length == 0) return false;
+    if (field->tail) {
+        CsvField joined;
+        if (!csv_field_join(field, &joined)) return false;
+        bool converted = csv_field_long(&joined, value);
+        free((char*)joined.data);
+        return converted;
+    }
+    
+    const char* p = field->data;
+    const char* end = p + field->length;
+    bool negative = *p == '-';
+    if (*p == '-' || *p == '+') p++;
+    if (p == end) return false;
+    
+    // Accumulate as a negative number, which also reaches LONG_MIN
+    long result = 0;
+    for (; p < end; p++) {
+        if (*p < '0' || *p > '9') return false;
+        if (__builtin_mul_overflow(result, 10, &result) ||
+            __builtin_sub_overflow(result, *p - '0', &result)) {
+            return false;
+        }
+    }
+    if (!negative && __builtin_mul_overflow(result, -1, &result)) return false;
+    
+    *value = result;
+    return true;
+}
+
+bool csv_field_double(const CsvField* field, double* value) {
+    if (!field || field->length == 0) return false;
+    if (field->tail) {
+        CsvField joined;
+        if (!csv_field_join(field, &joined)) return false;
+        bool converted = csv_field_double(&joined, value);
+        free((char*)joined.data);
+        return converted;
+    }
+    
+    // Integers are exact up to 2^53 and skip strtod
+    long integer;
+    if (field->length < 16 && csv_field_long(field, &integer)) {
+        *value = (double)integer;
+        return true;
+    }
+    
+    // strtod needs a terminated copy
+    char buffer[64];
+    if (field->length >= sizeof(buffer)) return false;
+    memcpy(buffer, field->data, field->length);
+    buffer[field->length] = '\0';
+    
+    char* end = NULL;
+    *value = strtod(buffer, &end);
+    return end == buffer + field->length;
+}
+
+char* csv_field_copy(const CsvField* field) {
+    if (!field) return NULL;
+    
+    char* copy = (char*)malloc(field->length + 1);
+    if (!copy) return NULL;
+    
+    if (!field->quoted) {
+        memcpy(copy, field->data, field->length);
+        copy[field->length] = '\0';
+        return copy;
+    }
+    
+    // Undouble "" inside the quotes, then drop the closing quote before a tail
+    size_t quoted = field->tail ? field->length - field->tail - 1 : field->length;
+    size_t out = 0;
+    for (size_t i = 0; i < quoted; i++) {
+        copy[out++] = field->data[i];
+        if (field->data[i] == '"' && i + 1 < quoted && field->data[i + 1] == '"') i++;
+    }
+    memcpy(copy + out, field->data + field->length - field->tail, field->tail);
+    copy[out + field->tail] = '\0';
+    return copy;
+}
+
+// ================ TYPED COLUMNS ================
+
+double* csv_read_column(CsvReader* reader, int column, size_t* count) {
+    if (!reader || column < 0 || !count) return NULL;
+    
+    // Pre-size from an estimate of the row count (average row of the
+    // first few KB), then grow geometrically
+    size_t capacity = 1024;
+    size_t remaining = reader->length - reader->position;
+    size_t sample = reader->position;
+    int sample_rows = 0;
+    while (sample < reader->length && sample - reader->position < 4096) {
+        const char* line = (const char*)memchr(reader->data + sample, '\n', reader->length - sample);
+        if (!line) break;
+        sample = line - reader->data + 1;
+        sample_rows++;
+    }
+    if (sample_rows > 0) {
+        capacity = remaining / ((sample - reader->position) / sample_rows + 1) + 16;
+    }
+    
+    double* values = (double*)malloc(capacity * sizeof(double));
+    size_t used = 0;
+    
+    while (values && csv_next_row(reader)) {
+        if (reader->field_count == 0) continue;
+        if (used >= capacity) {
+            double* grown = (double*)realloc(values, capacity * 2 * sizeof(double));
+            if (!grown) {
+                free(values);
+                return NULL;
+            }
+            values = grown;
+            capacity *= 2;
+        }
+        
+        double value;
+        if (column >= reader->field_count || !csv_field_double(&reader->fields[column], &value)) {
+            value = NAN;
+        }
+        values[used++] = value;
+    }
+    
+    *count = used;
+    return values;
+}
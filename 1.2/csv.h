@@ -0,0 +1,55 @@
+#ifndef CSV_H
+#define CSV_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// ================ CSV READER ================
+// Rows are read straight from the input buffer (memory-mapped when the
+// platform allows): fields are views into it, valid until the reader is
+// closed. Quoted fields are views of the text between the quotes; when
+// they contain doubled quotes, csv_field_copy undoubles them.
+//
+// Rows are split as Python's csv module does by default: text after a
+// closing quote joins the field ("a"x is ax), a stray quote inside an
+// unquoted field is plain text, and a blank line is a row with no fields.
+
+typedef struct {
+    const char* data;
+    size_t length;
+    bool quoted;          // Not the text as is: "" inside, or a tail (see csv_field_copy)
+    size_t tail;          // Text after the closing quote, which the view then spans
+} CsvField;
+
+typedef struct {
+    const char* data;     // Whole input
+    size_t length;
+    size_t position;      // Start of the next row
+    bool mapped;          // data is a file mapping, not a heap buffer
+    bool owned;           // data is released by csv_close
+    char delimiter;
+    CsvField* fields;     // Fields of the current row
+    int field_count;
+    int field_capacity;
+    long row;             // Rows read so far
+} CsvReader;
+
+// Open a file / wrap a buffer (the buffer must outlive the reader)
+CsvReader* csv_open(const char* path, char delimiter);
+CsvReader* csv_open_buffer(const char* data, size_t length, char delimiter);
+void csv_close(CsvReader* reader);
+
+// Read the next row into reader->fields, false at end of input
+bool csv_next_row(CsvReader* reader);
+
+// Field conversion (false if the field is not a complete number)
+bool csv_field_long(const CsvField* field, long* value);
+bool csv_field_double(const CsvField* field, double* value);
+char* csv_field_copy(const CsvField* field);  // Caller frees
+
+// Typed-column mode: read every remaining row and collect one numeric
+// column (rows where it is missing or not a number get NaN, blank lines
+// nothing)
+double* csv_read_column(CsvReader* reader, int column, size_t* count);
+
+#endif // CSV_H
@@ -0,0 +1,185 @@
+/**
+ * Dispatch tables for Topo Programming Language
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "dispatch.h"
+
+// ================ BUILDING ================
+
+typedef struct {
+    long value;
+    int arm;
+} DispatchLabel;
+
+static int dispatch_label_compare(const void* a, const void* b) {
+    const DispatchLabel* x = (const DispatchLabel*)a;
+    const DispatchLabel* y = (const DispatchLabel*)b;
+    return (x->value > y->value) - (x->value < y->value);
+}
+
+DispatchTable* dispatch_build_int(const long* values, const int* arms, int count) {
+    if (!values || !arms || count <= 0) return NULL;
+    
+    DispatchLabel* labels = (DispatchLabel*)malloc(count * sizeof(DispatchLabel));
+    DispatchTable* table = (DispatchTable*)calloc(1, sizeof(DispatchTable));
+    if (!labels || !table) {
+        free(labels);
+        free(table);
+        return NULL;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        labels[i].value = values[i];
+        labels[i].arm = arms[i];
+    }
+    qsort(labels, count, sizeof(DispatchLabel), dispatch_label_compare);
+    
+    table->label_count = count;
+    long min = labels[0].value;
+    long max = labels[count - 1].value;
+    
+    // Unsigned, since the span may not fit in a long
+    unsigned long span = (unsigned long)max - (unsigned long)min;
+    bool dense = span < DISPATCH_MAX_RANGE &&
+                 span < (unsigned long)count * DISPATCH_DENSE_FACTOR;
+    
+    if (dense) {
+        table->kind = DISPATCH_DENSE;
+        table->min_value = min;
+        table->range = (int)span + 1;
+        table->arms = (int*)malloc(table->range * sizeof(int));
+        if (table->arms) {
+            for (int i = 0; i < table->range; i++) {
+                table->arms[i] = -1;
+            }
+            for (int i = 0; i < count; i++) {
+                table->arms[(unsigned long)labels[i].value - (unsigned long)min] = labels[i].arm;
+            }
+        }
+    } else {
+        table->kind = DISPATCH_SORTED;
+        table->arms = (int*)malloc(count * sizeof(int));
+        table->values = (long*)malloc(count * sizeof(long));
+        if (table->arms && table->values) {
+            for (int i = 0; i < count; i++) {
+                table->values[i] = labels[i].value;
+                table->arms[i] = labels[i].arm;
+            }
+        }
+    }
+    
+    free(labels);
+    if (!table->arms || (table->kind == DISPATCH_SORTED && !table->values)) {
+        dispatch_destroy(table);
+        return NULL;
+    }
+    
+    return table;
+}
+
+DispatchTable* dispatch_build_string(char** keys, const int* arms, int count) {
+    if (!keys || !arms || count <= 0) return NULL;
+    
+    DispatchTable* table = (DispatchTable*)calloc(1, sizeof(DispatchTable));
+    if (!table) return NULL;
+    
+    table->kind = DISPATCH_HASHED;
+    table->label_count = count;
+    table->arms = (int*)malloc(count * sizeof(int));
+    table->keys = (char**)calloc(count, sizeof(char*));
+    if (!table->arms || !table->keys) {
+        dispatch_destroy(table);
+        return NULL;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        table->keys[i] = strdup(keys[i]);
+        table->arms[i] = arms[i];
+        if (!table->keys[i]) {
+            dispatch_destroy(table);
+            return NULL;
+        }
+    }
+    
+    table->phash = phash_build(table->keys, count);
+    if (!table->phash) {
+        dispatch_destroy(table);
+        return NULL;
+    }
+    
+    return table;
+}
+
+// ================ LOOKUP ================
+
+int dispatch_lookup_int(const DispatchTable* table, long value) {
+    if (!table) return -1;
+    
+    if (table->kind == DISPATCH_DENSE) {
+        // Unsigned compare also rejects values below min_value
+        unsigned long offset = (unsigned long)value - (unsigned long)table->min_value;
+        return offset < (unsigned long)table->range ? table->arms[offset] : -1;
+    }
+    
+    if (table->kind == DISPATCH_SORTED) {
+        int low = 0;
+        int high = table->label_count - 1;
+        while (low <= high) {
+            int mid = low + (high - low) / 2;
+            if (table->values[mid] == value) return table->arms[mid];
+            if (table->values[mid] < value) {
+                low = mid + 1;
+            } else {
+                high = mid - 1;
+            }
+        }
+    }
+    
+    return -1;
+}
+
+int dispatch_lookup_string(const DispatchTable* table, const char* key) {
+    if (!table || table->kind != DISPATCH_HASHED) return -1;
+    
+    int index = phash_lookup(table->phash, table->keys, key);
+    return index >= 0 ? table->arms[index] : -1;
+}
+
+// ================ MEMORY MANAGEMENT ================
+
+DispatchTable* dispatch_share(DispatchTable* table) {
+    if (table) table->shares++;
+    return table;
+}
+
+void dispatch_destroy(DispatchTable* table) {
+    if (!table) return;
+    if (table->shares > 0) {
+        table->shares--;
+        return;
+    }
+    
+    if (table->keys) {
+        for (int i = 0; i < table->label_count; i++) {
+            free(table->keys[i]);
+        }
+        free(table->keys);
+    }
+    free(table->arms);
+    free(table->values);
+    phash_destroy(table->phash);
+    free(table);
+}
+
+const char* dispatch_kind_name(DispatchKind kind) {
+    switch (kind) {
+        case DISPATCH_DENSE: return "jump table";
+        case DISPATCH_SORTED: return "sorted table";
+        case DISPATCH_HASHED: return "hash table";
+        default: return "table";
+    }
+}
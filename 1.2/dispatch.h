@@ -0,0 +1,46 @@
+#ifndef DISPATCH_H
+#define DISPATCH_H
+
+#include "phash.h"
+
+// ================ DISPATCH TABLES ================
+// Map the literal labels of a multi-way branch to the index of the arm
+// that handles them (-1: none, take the default). Integer labels use a
+// dense jump table when they are close together and a sorted table
+// otherwise; string labels use a perfect hash.
+typedef enum {
+    DISPATCH_DENSE,
+    DISPATCH_SORTED,
+    DISPATCH_HASHED
+} DispatchKind;
+
+typedef struct {
+    DispatchKind kind;
+    int label_count;
+    int* arms;            // Arm per slot (DENSE: per value from min_value, else per label)
+    long min_value;       // DENSE: label of arms[0]
+    int range;            // DENSE: number of slots
+    long* values;         // SORTED: labels in ascending order
+    char** keys;          // HASHED: labels
+    PerfectHash* phash;   // HASHED: index into keys
+    int shares;           // Owners beyond the first (see dispatch_share)
+} DispatchTable;
+
+#define DISPATCH_MAX_RANGE 4096     // Largest dense jump table
+#define DISPATCH_DENSE_FACTOR 2     // Max slots per label for a dense table
+
+// Build from distinct labels, each with the arm it selects
+DispatchTable* dispatch_build_int(const long* values, const int* arms, int count);
+DispatchTable* dispatch_build_string(char** keys, const int* arms, int count);
+
+// Arm for a value, or -1 if no label matches
+int dispatch_lookup_int(const DispatchTable* table, long value);
+int dispatch_lookup_string(const DispatchTable* table, const char* key);
+
+// Shared like PerfectHash: dispatch_share adds an owner, dispatch_destroy
+// drops one
+DispatchTable* dispatch_share(DispatchTable* table);
+void dispatch_destroy(DispatchTable* table);
+const char* dispatch_kind_name(DispatchKind kind);
+
+#endif // DISPATCH_H
@@ -0,0 +1,712 @@
+/**
+ * JSON reader and writer for Topo Programming Language
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "json.h"
+#include "numfmt.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// ================ STAGE 1: STRUCTURAL INDEX ================
+//
+// One pass over the text records the offset of every structural
+// character, string and scalar, and for each '{' / '[' the number of
+// elements it holds, so that stage 2 can size containers up front.
+// String bodies, which make up most of a typical document, are skipped
+// 16 bytes at a time.
+
+typedef struct {
+    uint32_t* offsets;    // Offset of each structural token
+    int* counts;          // Element count, for '{' and '[' entries
+    int count;
+    int capacity;
+} JsonIndex;
+
+// Offset of the next '"', '\\' or control character (which JSON does not
+// allow raw inside strings) at or after 'pos' (length if none)
+static size_t json_skip_string(const char* text, size_t pos, size_t length) {
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    while (pos + 16 <= length) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(text + pos));
+        __m128i special = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash));
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(_mm_min_epu8(chunk, control), chunk));
+        int mask = _mm_movemask_epi8(special);
+        if (mask) return pos + __builtin_ctz(mask);
+        pos += 16;
+    }
+#endif
+    while (pos < length && text[pos] != '"' && text[pos] != '\\' && (unsigned char)text[pos] >= 0x20) {
+        pos++;
+    }
+    return pos;
+}
+
+// Copy of text[0..size) (strndup is missing on some platforms)
+static char* json_copy(const char* text, size_t size) {
+    char* copy = (char*)malloc(size + 1);
+    if (!copy) return NULL;
+    memcpy(copy, text, size);
+    copy[size] = '\0';
+    return copy;
+}
+
+static bool json_is_space(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static bool json_is_delimiter(char c) {
+    return json_is_space(c) || c == ',' || c == ':' || c == ']' || c == '}' || c == '"' ||
+           c == '[' || c == '{';
+}
+
+static bool json_index_push(JsonIndex* index, size_t offset) {
+    if (index->count >= index->capacity) {
+        int capacity = index->capacity ? index->capacity * 2 : 256;
+        uint32_t* offsets = (uint32_t*)realloc(index->offsets, capacity * sizeof(uint32_t));
+        if (!offsets) return false;
+        index->offsets = offsets;
+        int* counts = (int*)realloc(index->counts, capacity * sizeof(int));
+        if (!counts) return false;
+        index->counts = counts;
+        index->capacity = capacity;
+    }
+    
+    index->offsets[index->count] = (uint32_t)offset;
+    index->counts[index->count] = 0;
+    index->count++;
+    return true;
+}
+
+static bool json_build_index(const char* text, size_t length, JsonIndex* index, const char** error) {
+    int open[JSON_MAX_DEPTH];     // Index entries of the enclosing containers
+    bool empty[JSON_MAX_DEPTH];   // No element seen yet
+    int depth = 0;
+    size_t pos = 0;
+    
+    if (length > UINT32_MAX) {
+        *error = "Document too large";
+        return false;
+    }
+    
+    while (pos < length) {
+        char c = text[pos];
+        
+        if (json_is_space(c)) {
+            pos++;
+            continue;
+        }
+        
+        if (!json_index_push(index, pos)) {
+            *error = "Out of memory";
+            return false;
+        }
+        
+        if (depth > 0 && c != ']' && c != '}' && c != ',' && c != ':') {
+            empty[depth - 1] = false;
+        }
+        
+        switch (c) {
+            case '{':
+            case '[':
+                if (depth >= JSON_MAX_DEPTH) {
+                    *error = "Nesting too deep";
+                    return false;
+                }
+                open[depth] = index->count - 1;
+                empty[depth] = true;
+                depth++;
+                pos++;
+                break;
+                
+            case '}':
+            case ']':
+                if (depth == 0) {
+                    *error = "Unbalanced brackets";
+                    return false;
+                }
+                depth--;
+                if (!empty[depth]) index->counts[open[depth]]++;
+                pos++;
+                break;
+                
+            case ',':
+                if (depth > 0) index->counts[open[depth - 1]]++;
+                pos++;
+                break;
+                
+            case ':':
+                pos++;
+                break;
+                
+            case '"':
+                pos++;
+                for (;;) {
+                    pos = json_skip_string(text, pos, length);
+                    if (pos >= length) {
+                        *error = "Unterminated string";
+                        return false;
+                    }
+                    if (text[pos] == '"') break;
+                    if (text[pos] != '\\') {
+                        *error = "Control character in string";
+                        return false;
+                    }
+                    pos += 2; // Escape sequence
+                }
+                pos++;
+                break;
+                
+            default:
+                // Scalar (number, true, false, null), validated in stage 2
+                while (pos < length && !json_is_delimiter(text[pos])) {
+                    pos++;
+                }
+                break;
+        }
+    }
+    
+    if (depth != 0) {
+        *error = "Unbalanced brackets";
+        return false;
+    }
+    
+    return true;
+}
+
+// ================ STAGE 2: TREE BUILDING ================
+
+typedef struct {
+    const char* text;
+    size_t length;
+    JsonIndex* index;
+    int next;             // Next index entry
+    const char* error;
+    size_t error_offset;
+} JsonParser;
+
+static void json_fail(JsonParser* parser, const char* message, int entry) {
+    if (parser->error) return;
+    parser->error = message;
+    parser->error_offset = entry < parser->index->count ? parser->index->offsets[entry] : parser->length;
+}
+
+static char json_char_at(JsonParser* parser, int entry) {
+    return entry < parser->index->count ? parser->text[parser->index->offsets[entry]] : '\0';
+}
+
+static int json_hex4(const char* p) {
+    int value = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        value <<= 4;
+        if (c >= '0' && c <= '9') value |= c - '0';
+        else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+        else return -1;
+    }
+    return value;
+}
+
+static int json_utf8_encode(uint32_t code, char* out) {
+    if (code < 0x80) {
+        out[0] = (char)code;
+        return 1;
+    }
+    if (code < 0x800) {
+        out[0] = (char)(0xC0 | (code >> 6));
+        out[1] = (char)(0x80 | (code & 0x3F));
+        return 2;
+    }
+    if (code < 0x10000) {
+        out[0] = (char)(0xE0 | (code >> 12));
+        out[1] = (char)(0x80 | ((code >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (code & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (code >> 18));
+    out[1] = (char)(0x80 | ((code >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((code >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (code & 0x3F));
+    return 4;
+}
+
+// Decode the string starting at entry (a '"'), NULL on bad escapes, lone
+// surrogates and raw control characters. Every read stays below length:
+// the text need not be NUL-terminated.
+static char* json_parse_string(JsonParser* parser, int entry) {
+    const char* limit = parser->text + parser->length;
+    const char* start = parser->text + parser->index->offsets[entry] + 1;
+    const char* end = parser->text + json_skip_string(parser->text, start - parser->text, parser->length);
+    if (end >= limit) return NULL;
+    
+    // Fast path: no escapes, one copy
+    if (*end == '"') return json_copy(start, end - start);
+    
+    // Escapes never grow the text (\uXXXX is 6 bytes for at most 4)
+    char* result = (char*)malloc(parser->length - (start - parser->text) + 1);
+    if (!result) return NULL;
+    
+    char* out = result;
+    const char* p = start;
+    while (p < limit && *p != '"') {
+        if ((unsigned char)*p < 0x20) break;
+        if (*p != '\\') {
+            *out++ = *p++;
+            continue;
+        }
+        
+        if (++p >= limit) break;
+        switch (*p) {
+            case '"': *out++ = '"'; break;
+            case '\\': *out++ = '\\'; break;
+            case '/': *out++ = '/'; break;
+            case 'b': *out++ = '\b'; break;
+            case 'f': *out++ = '\f'; break;
+            case 'n': *out++ = '\n'; break;
+            case 'r': *out++ = '\r'; break;
+            case 't': *out++ = '\t'; break;
+            case 'u': {
+                int code = (limit - p > 4) ? json_hex4(p + 1) : -1;
+                p += 4;
+                
+                // A high surrogate must be followed by an escaped low one
+                uint32_t codepoint = (uint32_t)code;
+                if (code >= 0xD800 && code <= 0xDBFF) {
+                    int low = (limit - p > 6 && p[1] == '\\' && p[2] == 'u') ? json_hex4(p + 3) : -1;
+                    if (low >= 0xDC00 && low <= 0xDFFF) {
+                        codepoint = 0x10000 + (((uint32_t)code - 0xD800) << 10) + ((uint32_t)low - 0xDC00);
+                        p += 6;
+                    } else {
+                        code = -1;
+                    }
+                } else if (code >= 0xDC00 && code <= 0xDFFF) {
+                    code = -1;
+                }
+                if (code < 0) {
+                    free(result);
+                    return NULL;
+                }
+                out += json_utf8_encode(codepoint, out);
+                break;
+            }
+            default:
+                free(result);
+                return NULL;
+        }
+        p++;
+    }
+    
+    if (p >= limit || *p != '"') {
+        free(result);
+        return NULL;
+    }
+    *out = '\0';
+    return result;
+}
+
+static bool json_scalar_is(JsonParser* parser, int entry, const char* word) {
+    size_t offset = parser->index->offsets[entry];
+    size_t size = strlen(word);
+    return offset + size <= parser->length &&
+           strncmp(parser->text + offset, word, size) == 0 &&
+           (offset + size == parser->length || json_is_delimiter(parser->text[offset + size]));
+}
+
+static const char* json_skip_digits(const char* p, const char* limit) {
+    while (p < limit && *p >= '0' && *p <= '9') p++;
+    return p;
+}
+
+// Number at entry, NULL if malformed (including leading zeros). Reads stop
+// at length, so strtod gets a terminated copy.
+static ASTNode* json_parse_number(JsonParser* parser, int entry) {
+    const char* limit = parser->text + parser->length;
+    const char* start = parser->text + parser->index->offsets[entry];
+    const char* p = start;
+    bool is_float = false;
+    
+    if (p < limit && *p == '-') p++;
+    const char* integer = p;
+    p = json_skip_digits(p, limit);
+    if (p == integer || (*integer == '0' && p - integer > 1)) return NULL;
+    if (p < limit && *p == '.') {
+        is_float = true;
+        const char* fraction = ++p;
+        p = json_skip_digits(p, limit);
+        if (p == fraction) return NULL;
+    }
+    if (p < limit && (*p == 'e' || *p == 'E')) {
+        is_float = true;
+        p++;
+        if (p < limit && (*p == '+' || *p == '-')) p++;
+        const char* exponent = p;
+        p = json_skip_digits(p, limit);
+        if (p == exponent) return NULL;
+    }
+    if (p < limit && !json_is_delimiter(*p)) return NULL;
+    
+    if (is_float) {
+        char buffer[64];
+        size_t size = p - start;
+        char* copy = size < sizeof(buffer) ? buffer : json_copy(start, size);
+        if (!copy) return NULL;
+        if (copy == buffer) {
+            memcpy(buffer, start, size);
+            buffer[size] = '\0';
+        }
+        double value = strtod(copy, NULL);
+        if (copy != buffer) free(copy);
+        return create_literal_node_float(value, 0, (int)(start - parser->text) + 1);
+    }
+    
+    // Integers accumulate as negatives, which also covers LONG_MIN
+    bool negative = *start == '-';
+    long value = 0;
+    bool overflow = false;
+    for (const char* d = start + negative; d < p && !overflow; d++) {
+        overflow = __builtin_mul_overflow(value, 10, &value) ||
+                   __builtin_sub_overflow(value, *d - '0', &value);
+    }
+    if (!negative && !overflow) overflow = __builtin_mul_overflow(value, -1, &value);
+    
+    if (overflow) {
+        char* digits = json_copy(start, p - start);
+        ASTNode* node = create_literal_node_bignum(digits, 0, (int)(start - parser->text) + 1);
+        free(digits);
+        return node;
+    }
+    return create_literal_node_int(value, 0, (int)(start - parser->text) + 1);
+}
+
+static ASTNode* json_parse_value(JsonParser* parser);
+
+static ASTNode* json_parse_array(JsonParser* parser, int entry) {
+    int column = (int)parser->index->offsets[entry] + 1;
+    ASTNode* head = NULL;
+    ASTNode* tail = NULL;
+    int count = 0;
+    
+    if (json_char_at(parser, parser->next) == ']') {
+        parser->next++;
+        return create_array_literal_node(NULL, 0, 0, column);
+    }
+    
+    for (;;) {
+        ASTNode* element = json_parse_value(parser);
+        if (!element) break;
+        
+        if (tail) {
+            tail->next = element;
+        } else {
+            head = element;
+        }
+        tail = element;
+        count++;
+        
+        char c = json_char_at(parser, parser->next++);
+        if (c == ']') return create_array_literal_node(head, count, 0, column);
+        if (c != ',') {
+            json_fail(parser, "Expected ',' or ']' in array", parser->next - 1);
+            break;
+        }
+    }
+    
+    while (head) {
+        ASTNode* next = head->next;
+        free_ast_node(head);
+        head = next;
+    }
+    return NULL;
+}
+
+static ASTNode* json_parse_object(JsonParser* parser, int entry) {
+    int column = (int)parser->index->offsets[entry] + 1;
+    int capacity = parser->index->counts[entry];
+    
+    // Sized from the stage 1 element count
+    char** keys = (char**)calloc(capacity > 0 ? capacity : 1, sizeof(char*));
+    ASTNode* head = NULL;
+    ASTNode* tail = NULL;
+    int count = 0;
+    
+    if (!keys) {
+        json_fail(parser, "Out of memory", entry);
+        return NULL;
+    }
+    
+    if (json_char_at(parser, parser->next) == '}') {
+        parser->next++;
+        return create_dict_literal_node(keys, NULL, 0, 0, column);
+    }
+    
+    for (;;) {
+        int key_entry = parser->next++;
+        if (json_char_at(parser, key_entry) != '"' || count >= capacity) {
+            json_fail(parser, "Expected string key in object", key_entry);
+            break;
+        }
+        
+        char* key = json_parse_string(parser, key_entry);
+        if (!key) {
+            json_fail(parser, "Invalid string escape", key_entry);
+            break;
+        }
+        keys[count] = key;
+        
+        if (json_char_at(parser, parser->next++) != ':') {
+            json_fail(parser, "Expected ':' after key", parser->next - 1);
+            free(key);
+            keys[count] = NULL;
+            break;
+        }
+        
+        ASTNode* value = json_parse_value(parser);
+        if (!value) {
+            free(key);
+            keys[count] = NULL;
+            break;
+        }
+        
+        if (tail) {
+            tail->next = value;
+        } else {
+            head = value;
+        }
+        tail = value;
+        count++;
+        
+        char c = json_char_at(parser, parser->next++);
+        if (c == '}') return create_dict_literal_node(keys, head, count, 0, column);
+        if (c != ',') {
+            json_fail(parser, "Expected ',' or '}' in object", parser->next - 1);
+            break;
+        }
+    }
+    
+    for (int i = 0; i < count; i++) {
+        free(keys[i]);
+    }
+    free(keys);
+    while (head) {
+        ASTNode* next = head->next;
+        free_ast_node(head);
+        head = next;
+    }
+    return NULL;
+}
+
+static ASTNode* json_parse_value(JsonParser* parser) {
+    int entry = parser->next++;
+    if (entry >= parser->index->count) {
+        json_fail(parser, "Unexpected end of input", entry);
+        return NULL;
+    }
+    
+    int column = (int)parser->index->offsets[entry] + 1;
+    ASTNode* node = NULL;
+    
+    switch (json_char_at(parser, entry)) {
+        case '{':
+            return json_parse_object(parser, entry);
+            
+        case '[':
+            return json_parse_array(parser, entry);
+            
+        case '"': {
+            char* value = json_parse_string(parser, entry);
+            if (!value) break;
+            node = create_literal_node_string(value, 0, column);
+            free(value);
+            return node;
+        }
+            
+        case 't':
+            if (json_scalar_is(parser, entry, "true")) return create_literal_node_bool(true, 0, column);
+            break;
+            
+        case 'f':
+            if (json_scalar_is(parser, entry, "false")) return create_literal_node_bool(false, 0, column);
+            break;
+            
+        case 'n':
+            if (json_scalar_is(parser, entry, "null")) return create_literal_node_null(0, column);
+            break;
+            
+        default:
+            node = json_parse_number(parser, entry);
+            if (node) return node;
+            break;
+    }
+    
+    json_fail(parser, "Invalid value", entry);
+    return NULL;
+}
+
+ASTNode* json_parse(const char* text, size_t length, char* error, size_t error_size) {
+    JsonIndex index;
+    memset(&index, 0, sizeof(index));
+    
+    JsonParser parser;
+    memset(&parser, 0, sizeof(parser));
+    parser.text = text;
+    parser.length = length;
+    parser.index = &index;
+    
+    ASTNode* root = NULL;
+    if (!json_build_index(text, length, &index, &parser.error)) {
+        parser.error_offset = index.count > 0 ? index.offsets[index.count - 1] : 0;
+    } else {
+        root = json_parse_value(&parser);
+        if (root && parser.next < index.count) {
+            json_fail(&parser, "Unexpected data after document", parser.next);
+            free_ast_node(root);
+            root = NULL;
+        }
+    }
+    
+    if (!root && error && error_size > 0) {
+        snprintf(error, error_size, "%s at offset %zu",
+                 parser.error ? parser.error : "Invalid document", parser.error_offset);
+    }
+    
+    free(index.offsets);
+    free(index.counts);
+    return root;
+}
+
+// ================ SERIALIZATION ================
+
+static bool json_reserve(JsonBuffer* buffer, size_t extra) {
+    if (buffer->length + extra + 1 <= buffer->capacity) return true;
+    
+    size_t capacity = buffer->capacity ? buffer->capacity : 256;
+    while (capacity < buffer->length + extra + 1) {
+        capacity *= 2;
+    }
+    
+    char* data = (char*)realloc(buffer->data, capacity);
+    if (!data) return false;
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return true;
+}
+
+static bool json_append(JsonBuffer* buffer, const char* text, size_t size) {
+    if (!json_reserve(buffer, size)) return false;
+    memcpy(buffer->data + buffer->length, text, size);
+    buffer->length += size;
+    buffer->data[buffer->length] = '\0';
+    return true;
+}
+
+static bool json_append_string(JsonBuffer* buffer, const char* text) {
+    // Worst case every byte becomes \u00XX
+    size_t size = strlen(text);
+    if (!json_reserve(buffer, size * 6 + 2)) return false;
+    
+    char* out = buffer->data + buffer->length;
+    *out++ = '"';
+    for (const unsigned char* p = (const unsigned char*)text; *p; p++) {
+        switch (*p) {
+            case '"': *out++ = '\\'; *out++ = '"'; break;
+            case '\\': *out++ = '\\'; *out++ = '\\'; break;
+            case '\n': *out++ = '\\'; *out++ = 'n'; break;
+            case '\r': *out++ = '\\'; *out++ = 'r'; break;
+            case '\t': *out++ = '\\'; *out++ = 't'; break;
+            case '\b': *out++ = '\\'; *out++ = 'b'; break;
+            case '\f': *out++ = '\\'; *out++ = 'f'; break;
+            default:
+                if (*p < 0x20) {
+                    out += sprintf(out, "\\u%04x", *p);
+                } else {
+                    *out++ = (char)*p;
+                }
+                break;
+        }
+    }
+    *out++ = '"';
+    
+    buffer->length = out - buffer->data;
+    buffer->data[buffer->length] = '\0';
+    return true;
+}
+
+bool json_serialize(const ASTNode* node, JsonBuffer* buffer) {
+    if (!node || !buffer) return false;
+    
+    char number[NUMFMT_BUFFER_SIZE];
+    
+    switch (node->type) {
+        case NODE_LITERAL:
+            switch (node->expr.literal.data_type) {
+                case TYPE_INT:
+                    return json_append(buffer, number, numfmt_long(node->expr.literal.value.int_val, number));
+                case TYPE_BIGINT:
+                    return json_append(buffer, node->expr.literal.value.bignum_val,
+                                       strlen(node->expr.literal.value.bignum_val));
+                case TYPE_FLOAT: {
+                    // JSON has no NaN or infinity
+                    int size = numfmt_double(node->expr.literal.value.float_val, number);
+                    if (number[0] == 'n' || number[0] == 'i' || number[1] == 'i') {
+                        return json_append(buffer, "null", 4);
+                    }
+                    return json_append(buffer, number, size);
+                }
+                case TYPE_STRING:
+                    return json_append_string(buffer, node->expr.literal.value.string_val ?
+                                              node->expr.literal.value.string_val : "");
+                case TYPE_BOOL:
+                    return node->expr.literal.value.bool_val ? json_append(buffer, "true", 4)
+                                                             : json_append(buffer, "false", 5);
+                case TYPE_NULL:
+                    return json_append(buffer, "null", 4);
+                default:
+                    return false;
+            }
+            
+        case NODE_ARRAY_LITERAL: {
+            if (!json_append(buffer, "[", 1)) return false;
+            for (ASTNode* element = node->expr.array.elements; element; element = element->next) {
+                if (element != node->expr.array.elements && !json_append(buffer, ",", 1)) return false;
+                if (!json_serialize(element, buffer)) return false;
+            }
+            return json_append(buffer, "]", 1);
+        }
+            
+        case NODE_DICT_LITERAL: {
+            if (!json_append(buffer, "{", 1)) return false;
+            ASTNode* value = node->expr.dict.values;
+            for (int i = 0; i < node->expr.dict.pair_count && value; i++, value = value->next) {
+                if (i > 0 && !json_append(buffer, ",", 1)) return false;
+                if (!json_append_string(buffer, node->expr.dict.keys[i]) ||
+                    !json_append(buffer, ":", 1) ||
+                    !json_serialize(value, buffer)) {
+                    return false;
+                }
+            }
+            return json_append(buffer, "}", 1);
+        }
+            
+        default:
+            return false;
+    }
+}
+
+void json_buffer_free(JsonBuffer* buffer) {
+    if (!buffer) return;
+    
+    free(buffer->data);
+    buffer->data = NULL;
+    buffer->length = 0;
+    buffer->capacity = 0;
+}
@@ -0,0 +1,30 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "ast.h"
+
+// ================ JSON ================
+// JSON text <-> literal AST nodes (dict, array, int, bigint, float,
+// string, bool, null).
+
+#define JSON_MAX_DEPTH 512      // Deepest nesting accepted by the parser
+
+// Growable output buffer
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+} JsonBuffer;
+
+// Parse a complete JSON document; on failure returns NULL and writes a
+// message to 'error' (if given)
+ASTNode* json_parse(const char* text, size_t length, char* error, size_t error_size);
+
+// Append the JSON text of a literal tree (false for non-literal nodes)
+bool json_serialize(const ASTNode* node, JsonBuffer* buffer);
+
+void json_buffer_free(JsonBuffer* buffer);
+
+#endif // JSON_H
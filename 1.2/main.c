@@ -1,136 +1,1539 @@
-/**
- * Main test program for Topo Language Parser
- */
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <locale.h>
-#include "ast.c"    // AST implementation
-#include "parser.c" // Parser implementation
-
-// Test function
-void test_parser() {
-    printf("=== Topo Language Parser Test 1.3.0 ===\n\n");
-    
-    // Test code
-    const char* test_code = 
-        "var x = 10\n"
-        "const y = 20\n"
-        "\n"
-        "if (x > 5) {\n"
-        "    console(\"x is greater than 5\")\n"
-        "} else {\n"
-        "    console(\"x is 5 or less\")\n"
-        "}\n"
-        "\n"
-        "for i in range(10) {\n"
-        "    console(i)\n"
-        "}\n"
-        "\n"
-        "from math using sin, cos\n";
-    
-    printf("Source code:\n");
-    printf("------------\n%s\n------------\n\n", test_code);
-    
-    // Parse the code
-    ASTNode* ast = parse_source(test_code, "test.topo");
-    
-    if (ast) {
-        printf("Parsing successful!\n");
-        printf("\nAST Structure:\n");
-        printf("--------------\n");
-        print_ast(ast, 0);
-        
-        // Cleanup
-        free_ast_node(ast);
-    } else {
-        printf("Parsing failed!\n");
-    }
-}
-
-// Main function
-int main(int argc, char* argv[]) {
-    setlocale(LC_ALL, "en_US.UTF-8");
-    
-    if (argc < 2) {
-        printf("Topo Language Parser 1.3.0\n");
-        printf("Author: Dmitry, Republic of Sakha (Yakutia)\n");
-        printf("Created for Topo Programming Language project\n\n");
-        
-        printf("Usage:\n");
-        printf("  %s test          # run parser tests\n", argv[0]);
-        printf("  %s file.topo     # parse file\n", argv[0]);
-        printf("  %s -e \"code\"     # parse code from command line\n\n", argv[0]);
-        
-        test_parser();
-        return 0;
-    }
-    
-    if (strcmp(argv[1], "test") == 0) {
-        test_parser();
-        return 0;
-    }
-    
-    if (strcmp(argv[1], "-e") == 0 && argc >= 3) {
-        printf("=== Parsing code from command line ===\n\n");
-        
-        ASTNode* ast = parse_source(argv[2], "<command-line>");
-        
-        if (ast) {
-            printf("Parsing successful!\n");
-            printf("\nAST Structure:\n");
-            printf("--------------\n");
-            print_ast(ast, 0);
-            
-            free_ast_node(ast);
-        } else {
-            printf("Parsing failed!\n");
-        }
-        
-        return 0;
-    }
-    
-    // Read from file
-    FILE* file = fopen(argv[1], "rb");
-    if (!file) {
-        fprintf(stderr, "Error: cannot open file '%s'\n", argv[1]);
-        return 1;
-    }
-    
-    // Determine file size
-    fseek(file, 0, SEEK_END);
-    long file_size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-    
-    // Read file
-    char* source = (char*)malloc(file_size + 1);
-    if (!source) {
-        fclose(file);
-        fprintf(stderr, "Error: cannot allocate memory\n");
-        return 1;
-    }
-    
-    fread(source, 1, file_size, file);
-    source[file_size] = '\0';
-    fclose(file);
-    
-    printf("=== Parsing file: %s ===\n\n", argv[1]);
-    
-    ASTNode* ast = parse_source(source, argv[1]);
-    
-    if (ast) {
-        printf("Parsing successful!\n");
-        printf("\nAST Structure:\n");
-        printf("--------------\n");
-        print_ast(ast, 0);
-        
-        free_ast_node(ast);
-    } else {
-        printf("Parsing failed!\n");
-    }
-    
-    free(source);
-    
-    return 0;
+/**
+ * Main test program for Topo Language Parser
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <locale.h>
+#include <limits.h>
+#include "region.c" // Region allocation
+#include "ast.c"    // AST implementation
+#include "phash.c"  // Perfect hash tables
+#include "dispatch.c" // Dispatch tables
+#include "bignum.c"   // Arbitrary-precision integers
+#include "numfmt.c"   // Number formatting
+#include "json.c"     // JSON reader and writer
+#include "csv.c"      // CSV reader
+#include "strops.c"   // String operations
+#include "sort.c"     // Sorting
+#include "regex.c"    // Regular expressions
+#include "parser.c" // Parser implementation
+#include "optimizer.c" // AST optimization passes
+#include "subtree.c"  // Subtree hashing and sharing
+#include "batch.c"    // Batch processing on worker threads
+#include "topoc.c"    // Precompiled AST files
+
+// Read a whole file into a NUL-terminated buffer (caller frees)
+static char* read_source_file(const char* path, long* size) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "Error: cannot open file '%s'\n", path);
+        return NULL;
+    }
+    
+    // Determine file size
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    
+    // Read file
+    char* source = (char*)malloc(file_size + 1);
+    if (!source) {
+        fclose(file);
+        fprintf(stderr, "Error: cannot allocate memory\n");
+        return NULL;
+    }
+    
+    file_size = (long)fread(source, 1, file_size, file);
+    source[file_size] = '\0';
+    fclose(file);
+    
+    if (size) *size = file_size;
+    return source;
+}
+
+// AST region (--region-heap), NULL when nodes come from the heap
+static Region* ast_heap_region = NULL;
+
+// Free an AST; region nodes go all at once with the region at exit
+static void release_ast(ASTNode* ast) {
+    if (!ast_heap_region) free_ast_node(ast);
+}
+
+static void release_region(void) {
+    ast_use_region(NULL);
+    region_destroy(ast_heap_region);
+    ast_heap_region = NULL;
+}
+
+// Test function
+void test_parser() {
+    printf("=== Topo Language Parser Test 1.3.0 ===\n\n");
+    
+    // Test code
+    const char* test_code = 
+        "var x = 10\n"
+        "const y = 20\n"
+        "\n"
+        "if (x > 5) {\n"
+        "    console(\"x is greater than 5\")\n"
+        "} else {\n"
+        "    console(\"x is 5 or less\")\n"
+        "}\n"
+        "\n"
+        "for i in range(10) {\n"
+        "    console(i)\n"
+        "}\n"
+        "\n"
+        "from math using sin, cos\n";
+    
+    printf("Source code:\n");
+    printf("------------\n%s\n------------\n\n", test_code);
+    
+    // Parse the code
+    ASTNode* ast = parse_source(test_code, "test.topo");
+    
+    if (ast) {
+        printf("Parsing successful!\n");
+        printf("\nAST Structure:\n");
+        printf("--------------\n");
+        print_ast(ast, 0);
+        
+        // Cleanup
+        release_ast(ast);
+    } else {
+        printf("Parsing failed!\n");
+    }
+}
+
+// ================ CHECKS ================
+// Focused checks of the optimizer passes and the library modules, run by
+// 'test' after the parser demo. Only failures are printed.
+
+static int checks_run = 0;
+static int checks_failed = 0;
+
+#define CHECK(condition) check_result((condition), #condition, __LINE__)
+
+static void check_result(bool passed, const char* what, int line) {
+    checks_run++;
+    if (!passed) {
+        checks_failed++;
+        printf("FAILED [main.c:%d]: %s\n", line, what);
+    }
+}
+
+// Parse a snippet, optimized if asked; NULL if it does not parse
+static ASTNode* check_parse(const char* source, bool optimize) {
+    ASTNode* ast = parse_source(source, "check.topo");
+    if (ast && optimize && !optimize_program(ast)) {
+        release_ast(ast);
+        ast = NULL;
+    }
+    return ast;
+}
+
+typedef struct {
+    NodeType type;
+    const char* name;   // NULL: any
+    int count;
+    ASTNode* first;
+} CheckFinder;
+
+// Identifier, callee or declared name
+static const char* check_node_name(const ASTNode* node) {
+    if (node->type == NODE_IDENTIFIER) return node->expr.identifier.identifier;
+    if (node->type == NODE_CALL_EXPR) {
+        const ASTNode* callee = node->expr.call.callee;
+        return callee && callee->type == NODE_IDENTIFIER ? callee->expr.identifier.identifier : NULL;
+    }
+    return node->name;
+}
+
+static void check_find_visitor(ASTNode** slot, void* data) {
+    CheckFinder* finder = (CheckFinder*)data;
+    ASTNode* node = *slot;
+    
+    if (node->type == finder->type) {
+        const char* name = check_node_name(node);
+        if (!finder->name || (name && strcmp(name, finder->name) == 0)) {
+            if (finder->count++ == 0) finder->first = node;
+        }
+    }
+    ast_for_each_child(node, check_find_visitor, data);
+}
+
+// Nodes of 'type' named 'name' (any name if NULL); the first goes to 'first'
+static int check_count(ASTNode* ast, NodeType type, const char* name, ASTNode** first) {
+    CheckFinder finder = {type, name, 0, NULL};
+    if (ast) check_find_visitor(&ast, &finder);
+    if (first) *first = finder.first;
+    return finder.count;
+}
+
+static void check_inlining(void) {
+    ASTNode* ast = check_parse("func sq(a) { return a * a }\nvar y = sq(3)\n", true);
+    CHECK(ast && check_count(ast, NODE_CALL_EXPR, "sq", NULL) == 0);
+    release_ast(ast);
+    
+    // The loop variable and the block's 'x' shadow the global 'f' reads
+    ast = check_parse("var x = 1\nfunc f() { console(x) }\nfor x in range(3) { f() }\n", true);
+    CHECK(ast && check_count(ast, NODE_CALL_EXPR, "f", NULL) == 1);
+    release_ast(ast);
+    
+    ast = check_parse("var x = 1\nfunc f() { console(x) }\nif (x > 0) {\n var x = 2\n f()\n}\n", true);
+    CHECK(ast && check_count(ast, NODE_CALL_EXPR, "f", NULL) == 1);
+    release_ast(ast);
+    
+    ast = check_parse("var x = 1\nfunc f() { console(x) }\nfor i in range(3) { f() }\n", true);
+    CHECK(ast && check_count(ast, NODE_CALL_EXPR, "f", NULL) == 0);
+    release_ast(ast);
+    
+    ast = check_parse("func r(n) { return r(n - 1) }\nconsole(r(3))\n", true);
+    CHECK(ast && check_count(ast, NODE_CALL_EXPR, "r", NULL) == 2);
+    release_ast(ast);
+    
+    // 'x' is read before bump() changes it, unless it is a local bump() cannot see
+    const char* bump = "var x = 1\nfunc bump() {\n x = x + 10\n return 0\n}\nfunc f(a) { return bump() + a }\n";
+    char source[256];
+    snprintf(source, sizeof(source), "%sconsole(f(x))\n", bump);
+    ast = check_parse(source, true);
+    CHECK(ast && check_count(ast, NODE_CALL_EXPR, "f", NULL) == 1);
+    release_ast(ast);
+    
+    snprintf(source, sizeof(source), "%sfunc g() {\n var y = 2\n return f(y)\n}\nconsole(g())\n", bump);
+    ast = check_parse(source, true);
+    CHECK(ast && check_count(ast, NODE_CALL_EXPR, "f", NULL) == 0);
+    release_ast(ast);
+    
+    // An argument that may fault is neither dropped, nor evaluated twice
+    ast = check_parse("func g(n) { return n }\nfunc k(a) { return 1 }\nfunc d(a) { return a * a }\n"
+                      "console(k(g(0) / 0), d(g(0) / 0))\n", true);
+    CHECK(ast && check_count(ast, NODE_CALL_EXPR, "k", NULL) == 1 &&
+          check_count(ast, NODE_CALL_EXPR, "d", NULL) == 1);
+    release_ast(ast);
+    
+    ast = check_parse("func g(n) { return n }\nfunc h(a) { return a + 1 }\nconsole(h(g(5) / 2))\n", true);
+    CHECK(ast && check_count(ast, NODE_CALL_EXPR, "h", NULL) == 0);
+    release_ast(ast);
+}
+
+static void check_escape_analysis(void) {
+    // Constant indices only: one scalar per element
+    ASTNode* ast = check_parse("var p = [1, 2]\nconsole(p[0] + p[1])\n"
+                               "var d = {\"x\": 1, \"y\": 2}\nconsole(d.x + d[\"y\"])\n", true);
+    CHECK(ast && check_count(ast, NODE_VAR_DECL, "p$1", NULL) == 1 &&
+          check_count(ast, NODE_VAR_DECL, "d$y", NULL) == 1);
+    CHECK(ast && check_count(ast, NODE_ARRAY_LITERAL, NULL, NULL) == 0 &&
+          check_count(ast, NODE_DICT_LITERAL, NULL, NULL) == 0);
+    release_ast(ast);
+    
+    // A computed index keeps the array, on the stack
+    ASTNode* decl = NULL;
+    ast = check_parse("var q = [1, 2]\nconsole(q[len(q) - 1])\n", true);
+    CHECK(ast && check_count(ast, NODE_VAR_DECL, "q", &decl) == 1 && decl->decl.value->expr.array.no_escape);
+    release_ast(ast);
+    
+    // Passed on or returned: escapes
+    ast = check_parse("var r = [1]\nconsole(r)\n", true);
+    CHECK(ast && check_count(ast, NODE_VAR_DECL, "r", &decl) == 1 && !decl->decl.value->expr.array.no_escape);
+    release_ast(ast);
+    
+    ast = check_parse("func f() {\n var e = {\"k\": 1}\n return e\n}\n", true);
+    CHECK(ast && check_count(ast, NODE_VAR_DECL, "e", &decl) == 1 && !decl->decl.value->expr.dict.no_escape);
+    release_ast(ast);
+}
+
+// Operator of the only assignment in 'source' ("" for plain '=')
+static bool check_assignment_op(const char* source, bool optimize, const char* op) {
+    ASTNode* ast = check_parse(source, optimize);
+    ASTNode* assignment = NULL;
+    bool same = ast && check_count(ast, NODE_ASSIGNMENT, NULL, &assignment) == 1 &&
+                strcmp(assignment->expr.assign.op ? assignment->expr.assign.op : "", op) == 0;
+    release_ast(ast);
+    return same;
+}
+
+static void check_compound_assignment(void) {
+    CHECK(check_assignment_op("var a = 1\na -= 2\n", false, "-="));
+    CHECK(check_assignment_op("var a = 1\na %= 2\n", false, "%="));
+    
+    // x = x op y becomes x op= y; the operand order of - and / must stay
+    CHECK(check_assignment_op("var a = 1\na = a + 2\n", true, "+="));
+    CHECK(check_assignment_op("var a = 1\na = a / 2\n", true, "/="));
+    CHECK(check_assignment_op("var a = 1\na = 2 - a\n", true, ""));
+    CHECK(check_assignment_op("var a = 1\nvar b = 2\na = b * 2\n", true, ""));
+}
+
+// Whether the only a[i] in a counted loop over 'source' loses its check
+static bool check_unchecked_index(const char* source) {
+    ASTNode* ast = check_parse(source, true);
+    ASTNode* index = NULL;
+    bool unchecked = ast && check_count(ast, NODE_INDEX_ACCESS, NULL, &index) == 1 &&
+                     index->expr.index.unchecked;
+    release_ast(ast);
+    return unchecked;
+}
+
+static void check_bounds(void) {
+    CHECK(check_unchecked_index("var a = [1, 2, 3]\nfor i in range(len(a)) { console(a[i]) }\n"));
+    CHECK(check_unchecked_index("var a = [1, 2, 3]\nfor i in range(1, len(a)) { console(a[i]) }\n"));
+    
+    // Dicts and strings have a len, but their [i] is not an array index
+    CHECK(!check_unchecked_index("var d = {\"k\": 1}\nfor j in range(len(d)) { console(d[j]) }\n"));
+    CHECK(!check_unchecked_index("var s = \"abc\"\nfor k in range(len(s)) { console(s[k]) }\n"));
+    CHECK(!check_unchecked_index("var a = [1, 2]\na = \"xy\"\nfor i in range(len(a)) { console(a[i]) }\n"));
+    CHECK(!check_unchecked_index("func f(a) {\n for i in range(len(a)) { console(a[i]) }\n}\n"));
+    CHECK(!check_unchecked_index("var a = [1, 2]\nfor i in range(len(a)) { a.push(i)\n console(a[i]) }\n"));
+}
+
+static void check_slices(void) {
+    ASTNode* ast = check_parse("var s = \"hello\"\nconsole(s[1:3], s[:2], s[1:], s[1])\n", false);
+    ASTNode* slice = NULL;
+    CHECK(ast && check_count(ast, NODE_SLICE_EXPR, NULL, &slice) == 3 &&
+          slice->expr.slice.start && slice->expr.slice.end);
+    CHECK(slice && !slice->next->expr.slice.start && slice->next->expr.slice.end);
+    CHECK(slice && slice->next->next->expr.slice.start && !slice->next->next->expr.slice.end);
+    CHECK(ast && check_count(ast, NODE_INDEX_ACCESS, NULL, NULL) == 1);
+    release_ast(ast);
+    
+    // Token text is sliced out of the source; lexer_next hands it over
+    Lexer* lexer = lexer_create("name_1 += \"a\\tb\"", "check.topo");
+    Token name = lexer_next(lexer);
+    CHECK(name.type == TOKEN_IDENTIFIER && strcmp(name.value, "name_1") == 0);
+    Token op = lexer_next(lexer);
+    CHECK(op.type == TOKEN_OPERATOR && strcmp(op.value, "+=") == 0);
+    Token text = lexer_next(lexer);
+    CHECK(text.type == TOKEN_STRING && strcmp(text.value, "a\tb") == 0);
+    free(name.value);
+    free(op.value);
+    free(text.value);
+    lexer_destroy(lexer);
+}
+
+static void check_perfect_hash(void) {
+    char* keys[200];
+    char names[200][16];
+    for (int i = 0; i < 200; i++) {
+        snprintf(names[i], sizeof(names[i]), "k%d", i);
+        keys[i] = names[i];
+    }
+    
+    PerfectHash* table = phash_build(keys, 200);
+    CHECK(table != NULL);
+    int misplaced = 0;
+    for (int i = 0; table && i < 200; i++) {
+        if (phash_lookup(table, keys, names[i]) != i) misplaced++;
+    }
+    CHECK(misplaced == 0);
+    CHECK(table && phash_lookup(table, keys, "k200") == -1 && phash_lookup(table, keys, "") == -1);
+    phash_destroy(table);
+    
+    // Repeated keys have no perfect hash
+    char* repeated[] = {"a", "b", "a"};
+    CHECK(phash_build(repeated, 3) == NULL);
+    
+    // A const dict read at run-time keys gets its table
+    ASTNode* ast = check_parse("const d = {\"a\": 1, \"b\": 2, \"c\": 3, \"d\": 4}\n"
+                               "var k = \"c\"\nconsole(d[k])\n", true);
+    ASTNode* dict = NULL;
+    CHECK(ast && check_count(ast, NODE_DICT_LITERAL, NULL, &dict) == 1 && dict->expr.dict.phash &&
+          phash_lookup(dict->expr.dict.phash, dict->expr.dict.keys, "c") == 2);
+    release_ast(ast);
+}
+
+static void check_dispatch(void) {
+    long close[] = {3, 1, 2, 5};
+    long spread[] = {1000000, -7, 42, 99999};
+    int arms[] = {0, 1, 2, 3};
+    
+    DispatchTable* dense = dispatch_build_int(close, arms, 4);
+    CHECK(dense && dense->kind == DISPATCH_DENSE);
+    CHECK(dense && dispatch_lookup_int(dense, 5) == 3 && dispatch_lookup_int(dense, 4) == -1 &&
+          dispatch_lookup_int(dense, 0) == -1 && dispatch_lookup_int(dense, 6) == -1);
+    dispatch_destroy(dense);
+    
+    DispatchTable* sorted = dispatch_build_int(spread, arms, 4);
+    CHECK(sorted && sorted->kind == DISPATCH_SORTED);
+    CHECK(sorted && dispatch_lookup_int(sorted, -7) == 1 && dispatch_lookup_int(sorted, 99999) == 3 &&
+          dispatch_lookup_int(sorted, 43) == -1);
+    dispatch_destroy(sorted);
+    
+    char* keys[] = {"get", "put", "post", "delete"};
+    DispatchTable* hashed = dispatch_build_string(keys, arms, 4);
+    CHECK(hashed && hashed->kind == DISPATCH_HASHED);
+    CHECK(hashed && dispatch_lookup_string(hashed, "post") == 2 && dispatch_lookup_string(hashed, "patch") == -1);
+    dispatch_destroy(hashed);
+    
+    // Only chains of DISPATCH_MIN_ARMS or more over one subject
+    ASTNode* chain = NULL;
+    ASTNode* ast = check_parse("var n = 2\nif (n == 1) { console(1) } elif (n == 2) { console(2) } "
+                               "elif (n == 3) { console(3) } elif (n == 4) { console(4) }\n", true);
+    CHECK(ast && check_count(ast, NODE_IF_STMT, NULL, &chain) == 1 && chain->flow.dispatch &&
+          dispatch_lookup_int(chain->flow.dispatch, 3) == 2);
+    release_ast(ast);
+    
+    ast = check_parse("var n = 2\nvar m = 1\nif (n == 1) { console(1) } elif (n == 2) { console(2) } "
+                      "elif (m == 3) { console(3) } elif (n == 4) { console(4) }\n", true);
+    CHECK(ast && check_count(ast, NODE_IF_STMT, NULL, &chain) == 1 && !chain->flow.dispatch);
+    release_ast(ast);
+}
+
+// Condition of the first if in 'source' after -O
+static ASTNode* check_lowered_condition(const char* source, ASTNode** ast) {
+    ASTNode* branch = NULL;
+    *ast = check_parse(source, true);
+    if (!*ast || check_count(*ast, NODE_IF_STMT, NULL, &branch) == 0) return NULL;
+    return branch->flow.condition;
+}
+
+static bool check_binary_op(const ASTNode* node, const char* op) {
+    return node && node->type == NODE_BINARY_EXPR && strcmp(node->expr.binary.op, op) == 0;
+}
+
+static void check_condition_lowering(void) {
+    ASTNode* ast = NULL;
+    ASTNode* condition = check_lowered_condition(
+        "var a = 1\nvar b = 2\nif (a > 0 and not (b < 0 or a == b)) { console(1) }\n", &ast);
+    CHECK(check_binary_op(condition, "and") && condition->expr.binary.branch);
+    
+    // not (x or y) => not x and not y, not (a == b) => a != b
+    ASTNode* right = condition ? condition->expr.binary.right : NULL;
+    CHECK(check_binary_op(right, "and") && right->expr.binary.branch);
+    CHECK(right && is_not_expr(right->expr.binary.left) && check_binary_op(right->expr.binary.right, "!="));
+    release_ast(ast);
+    
+    condition = check_lowered_condition("var a = 1\nif (true and a > 0) { console(1) }\n", &ast);
+    CHECK(check_binary_op(condition, ">"));
+    release_ast(ast);
+    
+    // if not c with an else swaps its branches
+    ASTNode* literal = NULL;
+    condition = check_lowered_condition("var a = 1\nif (not (a > 0)) { console(1) } else { console(2) }\n", &ast);
+    CHECK(check_binary_op(condition, ">"));
+    ASTNode* branch = NULL;
+    check_count(ast, NODE_IF_STMT, NULL, &branch);
+    CHECK(branch && check_count(branch->flow.then_branch, NODE_LITERAL, NULL, &literal) == 1 &&
+          literal->expr.literal.value.int_val == 2);
+    release_ast(ast);
+    
+    // Values outside conditions stay booleans
+    ASTNode* value = NULL;
+    ast = check_parse("var a = 1\nvar c = a > 0 and a < 5\n", true);
+    CHECK(ast && check_count(ast, NODE_VAR_DECL, "c", &value) == 1 &&
+          check_binary_op(value->decl.value, "and") && !value->decl.value->expr.binary.branch);
+    release_ast(ast);
+}
+
+// Value of 'name' after -O, as digits ("" if it did not fold to a literal)
+static bool check_folded_value(const char* source, const char* name, const char* expected) {
+    ASTNode* ast = check_parse(source, true);
+    ASTNode* decl = NULL;
+    char text[NUMFMT_BUFFER_SIZE] = "";
+    const char* digits = text;
+    if (ast && check_count(ast, NODE_VAR_DECL, name, &decl) == 1 && decl->decl.value->type == NODE_LITERAL) {
+        const ASTNode* literal = decl->decl.value;
+        if (literal->expr.literal.data_type == TYPE_INT) numfmt_long(literal->expr.literal.value.int_val, text);
+        if (literal->expr.literal.data_type == TYPE_BIGINT) digits = literal->expr.literal.value.bignum_val;
+    }
+    bool same = strcmp(digits, expected) == 0;
+    release_ast(ast);
+    return same;
+}
+
+static void check_overflow(void) {
+    // Results that overflow a long turn into bigints, and back once they fit
+    CHECK(check_folded_value("var a = 9223372036854775807 + 1\n", "a", "9223372036854775808"));
+    CHECK(check_folded_value("var b = 9223372036854775808 - 1\n", "b", "9223372036854775807"));
+    CHECK(check_folded_value("var c = 99999999999 * 99999999999 * 99999999999\n", "c",
+                             "999999999970000000000299999999999"));
+    CHECK(check_folded_value("var d = -9223372036854775807 - 1\n", "d", "-9223372036854775808"));
+    CHECK(check_folded_value("var e = -(-9223372036854775807 - 1)\n", "e", "9223372036854775808"));
+    
+    BigNum* a = bignum_from_string("-123456789012345678901234567890");
+    BigNum* b = bignum_from_long(LONG_MIN);
+    BigNum* product = a && b ? bignum_mul(a, b) : NULL;
+    char* digits = product ? bignum_to_string(product) : NULL;
+    CHECK(digits && strcmp(digits, "1138687895536349070124195419011280854005705605120") == 0);
+    long value = 0;
+    CHECK(b && bignum_to_long(b, &value) && value == LONG_MIN);
+    CHECK(a && !bignum_to_long(a, &value) && bignum_compare(a, b) < 0);
+    free(digits);
+    bignum_destroy(product);
+    bignum_destroy(a);
+    bignum_destroy(b);
+}
+
+// Parse JSON from an exact-size copy with no terminator after it
+static ASTNode* check_json(const char* text) {
+    size_t length = strlen(text);
+    char* exact = (char*)malloc(length ? length : 1);
+    memcpy(exact, text, length);
+    ASTNode* value = json_parse(exact, length, NULL, 0);
+    free(exact);
+    return value;
+}
+
+static bool check_json_string(const char* text, const char* expected) {
+    ASTNode* value = check_json(text);
+    bool same = value && value->type == NODE_LITERAL && value->expr.literal.data_type == TYPE_STRING &&
+                strcmp(value->expr.literal.value.string_val, expected) == 0;
+    release_ast(value);
+    return same;
+}
+
+static bool check_json_rejects(const char* text) {
+    ASTNode* value = check_json(text);
+    release_ast(value);
+    return value == NULL;
+}
+
+static void check_json_parser(void) {
+    ASTNode* value = check_json("12");
+    CHECK(value && value->expr.literal.data_type == TYPE_INT && value->expr.literal.value.int_val == 12);
+    release_ast(value);
+    
+    value = check_json("-2.5e1");
+    CHECK(value && value->expr.literal.data_type == TYPE_FLOAT && value->expr.literal.value.float_val == -25.0);
+    release_ast(value);
+    
+    value = check_json("[0, -0, 0.5, 10]");
+    CHECK(value && value->type == NODE_ARRAY_LITERAL);
+    release_ast(value);
+    
+    CHECK(check_json_string("\"ab\"", "ab"));
+    CHECK(check_json_string("\"a\\u00e9\\n\"", "a\xc3\xa9\n"));
+    CHECK(check_json_string("\"\\ud83d\\ude00\"", "\xf0\x9f\x98\x80"));
+    
+    CHECK(check_json_rejects("[01]"));
+    CHECK(check_json_rejects("[00]"));
+    CHECK(check_json_rejects("-01"));
+    CHECK(check_json_rejects("1."));
+    CHECK(check_json_rejects("\"\\ud800\""));
+    CHECK(check_json_rejects("\"\\udc00\""));
+    CHECK(check_json_rejects("\"\\ud800\\u0041\""));
+    CHECK(check_json_rejects("\"\\u12\""));
+    CHECK(check_json_rejects("\"a\tb\""));
+    CHECK(check_json_rejects("[\"a\x01b\"]"));
+    CHECK(check_json_rejects("\"abc"));
+    CHECK(check_json_rejects("\"abc\\"));
+}
+
+static bool check_csv_field(const CsvReader* reader, int index, const char* expected) {
+    if (index >= reader->field_count) return false;
+    char* text = csv_field_copy(&reader->fields[index]);
+    bool same = text && strcmp(text, expected) == 0;
+    free(text);
+    return same;
+}
+
+static void check_csv_reader(void) {
+    // No terminator after the last row, and none after the buffer
+    const char* text = "a,\"b \"\"q\"\"\",3\r\n\n4,,5.5\n\"x,y\",7\nlast";
+    size_t length = strlen(text);
+    char* exact = (char*)malloc(length);
+    memcpy(exact, text, length);
+    
+    CsvReader* reader = csv_open_buffer(exact, length, ',');
+    CHECK(reader && csv_next_row(reader) && reader->field_count == 3);
+    long number = 0;
+    CHECK(reader && check_csv_field(reader, 0, "a") && check_csv_field(reader, 1, "b \"q\"") &&
+          csv_field_long(&reader->fields[2], &number) && number == 3);
+    CHECK(reader && csv_next_row(reader) && reader->field_count == 0);
+    double real = 0;
+    CHECK(reader && csv_next_row(reader) && reader->field_count == 3 && reader->fields[1].length == 0 &&
+          csv_field_double(&reader->fields[2], &real) && real == 5.5);
+    CHECK(reader && !csv_field_long(&reader->fields[2], &number) && !csv_field_long(&reader->fields[1], &number));
+    CHECK(reader && csv_next_row(reader) && reader->field_count == 2 && check_csv_field(reader, 0, "x,y"));
+    CHECK(reader && csv_next_row(reader) && reader->field_count == 1 && check_csv_field(reader, 0, "last"));
+    CHECK(reader && !csv_next_row(reader) && reader->row == 5);
+    csv_close(reader);
+    
+    // Column mode: NaN where the column is missing or not a number,
+    // nothing for the blank line
+    size_t count = 0;
+    reader = csv_open_buffer(exact, length, ',');
+    double* column = reader ? csv_read_column(reader, 2, &count) : NULL;
+    CHECK(column && count == 4 && column[0] == 3 && column[1] == 5.5 && isnan(column[2]) && isnan(column[3]));
+    free(column);
+    csv_close(reader);
+    free(exact);
+    
+    // Text after a closing quote joins the field, as in Python's csv
+    text = "\"a\"x,\"b\"\"\"y\"z,\"1\"2\r\n\r\n\"\"\n";
+    reader = csv_open_buffer(text, strlen(text), ',');
+    CHECK(reader && csv_next_row(reader) && reader->field_count == 3 && check_csv_field(reader, 0, "ax") &&
+          check_csv_field(reader, 1, "b\"y\"z") && csv_field_long(&reader->fields[2], &number) && number == 12);
+    CHECK(reader && csv_next_row(reader) && reader->field_count == 0);
+    CHECK(reader && csv_next_row(reader) && reader->field_count == 1 && check_csv_field(reader, 0, ""));
+    CHECK(reader && !csv_next_row(reader) && reader->row == 3);
+    csv_close(reader);
+}
+
+static bool check_regex_search(const char* pattern, const char* text, bool expected) {
+    Regex* regex = regex_compile(pattern, NULL, 0);
+    bool found = regex && regex_search(regex, text, strlen(text), NULL);
+    regex_free(regex);
+    return regex && found == expected;
+}
+
+static void check_regex(void) {
+    CHECK(check_regex_search("ab+c", "xxabbbcxx", true));
+    CHECK(check_regex_search("ab+c", "xxacxx", false));
+    CHECK(check_regex_search("^\\d{3}-\\d{4}$", "555-1234", true));
+    CHECK(check_regex_search("^\\d{3}-\\d{4}$", "555-12345", false));
+    CHECK(check_regex_search("[^a-z]x|y(z)?", "Ax", true));
+    CHECK(check_regex_search("colou?r", "the color red", true));
+    
+    // Anchored and full matches, and the earliest match end
+    char error[128];
+    Regex* regex = regex_compile("error: \\w+", error, sizeof(error));
+    size_t end = 0;
+    CHECK(regex && regex->prefix && strcmp(regex->prefix, "error: ") == 0 && !regex->literal);
+    CHECK(regex && regex_search(regex, "log error: disk full", 20, &end) && end == 12);
+    CHECK(regex && !regex_match(regex, "log error: disk", 15) && regex_match(regex, "error: disk", 11));
+    regex_free(regex);
+    
+    CHECK(regex_compile("a(b", error, sizeof(error)) == NULL && error[0]);
+    CHECK(regex_compile("a{2000}", error, sizeof(error)) == NULL);
+    
+    // More DFA states than the cache holds: the nth letter from the end
+    regex = regex_compile("a[ab]{9}$", NULL, 0);
+    char text[4096];
+    for (size_t i = 0; i < sizeof(text); i++) {
+        text[i] = (i * 7919 % 13) < 6 ? 'a' : 'b';
+    }
+    bool expected = text[sizeof(text) - 10] == 'a';
+    CHECK(regex && regex_search(regex, text, sizeof(text), NULL) == expected);
+    text[sizeof(text) - 10] = expected ? 'b' : 'a';
+    CHECK(regex && regex_search(regex, text, sizeof(text), NULL) == !expected);
+    regex_free(regex);
+    
+    // The cache keeps the most recently used patterns
+    RegexCache cache;
+    regex_cache_init(&cache);
+    Regex* kept = regex_cache_get(&cache, "k+", NULL, 0);
+    bool hits = kept != NULL;
+    char pattern[16];
+    for (int i = 0; i < REGEX_CACHE_SIZE * 2; i++) {
+        snprintf(pattern, sizeof(pattern), "p%d", i);
+        regex_cache_get(&cache, pattern, NULL, 0);
+        hits = hits && regex_cache_get(&cache, "k+", NULL, 0) == kept;
+    }
+    CHECK(hits && cache.count == REGEX_CACHE_SIZE);
+    regex_cache_clear(&cache);
+}
+
+static void check_string_folding(void) {
+    ASTNode* literal = NULL;
+    ASTNode* ast = check_parse("var n = count(\"banana\", \"a\")\n", true);
+    CHECK(ast && check_count(ast, NODE_CALL_EXPR, "count", NULL) == 0 &&
+          check_count(ast, NODE_LITERAL, NULL, &literal) == 1 && literal->expr.literal.value.int_val == 3);
+    release_ast(ast);
+    
+    ast = check_parse("var p = find(\"abc\", \"c\")\nvar s = split(\"a,b\", \",\")\n", true);
+    CHECK(ast && check_count(ast, NODE_CALL_EXPR, NULL, NULL) == 0);
+    release_ast(ast);
+    
+    // A declared or imported name may not be the built-in
+    ast = check_parse("var split = 0\nvar s = split(\"a,b\", \",\")\n", true);
+    CHECK(ast && check_count(ast, NODE_CALL_EXPR, "split", NULL) == 1);
+    release_ast(ast);
+    
+    ast = check_parse("from text using count\nvar n = count(\"banana\", \"a\")\n", true);
+    CHECK(ast && check_count(ast, NODE_CALL_EXPR, "count", NULL) == 1);
+    release_ast(ast);
+    
+    ast = check_parse("from text using *\nvar p = find(\"abc\", \"c\")\nvar s = sorted([3, 1, 2])\n", true);
+    CHECK(ast && check_count(ast, NODE_CALL_EXPR, "find", NULL) == 1 &&
+          check_count(ast, NODE_CALL_EXPR, "sorted", NULL) == 1);
+    release_ast(ast);
+}
+
+typedef struct {
+    int key;
+    int order;          // Position before sorting
+} CheckRecord;
+
+static int64_t check_record_key(const void* element, void* data) {
+    (void)data;
+    return ((const CheckRecord*)element)->key;
+}
+
+static int check_long_compare(const void* a, const void* b, void* data) {
+    (void)data;
+    long x = *(const long*)a;
+    long y = *(const long*)b;
+    return (x > y) - (x < y);
+}
+
+static bool check_longs_sorted(const long* values, size_t count) {
+    for (size_t i = 1; i < count; i++) {
+        if (values[i - 1] > values[i]) return false;
+    }
+    return true;
+}
+
+static void check_sorting(void) {
+    // Random, sorted, reversed and organ-pipe inputs, on both sides of the
+    // radix and parallel thresholds
+    size_t sizes[] = {10, 1000, SORT_PARALLEL_THRESHOLD + 1000};
+    uint64_t state = 88172645463325252ull;
+    for (int s = 0; s < 3; s++) {
+        size_t count = sizes[s];
+        long* values = (long*)malloc(count * sizeof(long));
+        long* copy = (long*)malloc(count * sizeof(long));
+        if (!values || !copy) {
+            free(values);
+            free(copy);
+            continue;
+        }
+        bool sorted = true;
+        for (int pattern = 0; pattern < 4; pattern++) {
+            for (size_t i = 0; i < count; i++) {
+                state ^= state << 13;
+                state ^= state >> 7;
+                state ^= state << 17;
+                long v = pattern == 0 ? (long)state : pattern == 1 ? (long)i : pattern == 2 ? -(long)i :
+                         (long)(i < count / 2 ? i : count - i);
+                values[i] = copy[i] = v;
+            }
+            sort_longs(values, count);
+            sort_values(copy, count, sizeof(long), check_long_compare, NULL);
+            sorted = sorted && check_longs_sorted(values, count) && check_longs_sorted(copy, count) &&
+                     memcmp(values, copy, count * sizeof(long)) == 0;
+        }
+        CHECK(sorted);
+        free(values);
+        free(copy);
+    }
+    
+    double doubles[] = {3.5, -0.0, NAN, -1e300, 0.0, INFINITY, -INFINITY, 2.0};
+    sort_doubles(doubles, 8);
+    CHECK(doubles[0] == -INFINITY && doubles[1] == -1e300 && signbit(doubles[2]) && doubles[3] == 0 &&
+          !signbit(doubles[3]) && doubles[6] == INFINITY && isnan(doubles[7]));
+    
+    // sort_by_key is stable, below and above the radix threshold
+    for (int count = 100; count <= 3000; count += 2900) {
+        CheckRecord* records = (CheckRecord*)malloc(count * sizeof(CheckRecord));
+        if (!records) continue;
+        for (int i = 0; i < count; i++) {
+            records[i].key = (i * 7) % 5 - 2;
+            records[i].order = i;
+        }
+        bool stable = sort_by_key(records, count, sizeof(CheckRecord), check_record_key, NULL);
+        for (int i = 1; stable && i < count; i++) {
+            stable = records[i - 1].key < records[i].key ||
+                     (records[i - 1].key == records[i].key && records[i - 1].order < records[i].order);
+        }
+        CHECK(stable);
+        free(records);
+    }
+    
+    // sorted() of a literal array is done by -O
+    ASTNode* array = NULL;
+    ASTNode* ast = check_parse("console(sorted([3, -1, 2]))\n", true);
+    CHECK(ast && check_count(ast, NODE_CALL_EXPR, "sorted", NULL) == 0 &&
+          check_count(ast, NODE_ARRAY_LITERAL, NULL, &array) == 1 &&
+          array->expr.array.elements->expr.literal.value.int_val == -1 &&
+          array->expr.array.elements->next->next->expr.literal.value.int_val == 3);
+    release_ast(ast);
+}
+
+// View of the only for loop in 'source' after -O
+static IterationView check_loop_view(const char* source) {
+    ASTNode* ast = check_parse(source, true);
+    ASTNode* loop = NULL;
+    IterationView view = VIEW_NONE;
+    if (ast && check_count(ast, NODE_FOR_STMT, NULL, &loop) == 1) view = loop->loop.view;
+    release_ast(ast);
+    return view;
+}
+
+static void check_dict_views(void) {
+    CHECK(check_loop_view("var d = {\"a\": 1}\nfor k in keys(d) { console(k, d[k]) }\n") == VIEW_KEYS);
+    CHECK(check_loop_view("var d = {\"a\": 1}\nfor v in values(d) { console(v) }\n") == VIEW_VALUES);
+    
+    // Writes, aliases and user functions keep the copy
+    CHECK(check_loop_view("var d = {\"a\": 1}\nfor k in keys(d) { d[\"z\"] = 1 }\n") == VIEW_NONE);
+    CHECK(check_loop_view("var d = {\"a\": 1}\nfor k in keys(d) {\n var e = d\n}\n") == VIEW_NONE);
+    CHECK(check_loop_view("var d = {\"a\": 1}\nfunc r(n) { return r(n) }\nfor k in keys(d) { r(1) }\n") == VIEW_NONE);
+    
+    // len(keys(d)) => len(d)
+    ASTNode* ast = check_parse("var d = {\"a\": 1}\nconsole(len(keys(d)))\n", true);
+    CHECK(ast && check_count(ast, NODE_CALL_EXPR, "keys", NULL) == 0 &&
+          check_count(ast, NODE_CALL_EXPR, "len", NULL) == 1);
+    release_ast(ast);
+}
+
+static void check_shared_keys(void) {
+    ASTNode* ast = check_parse("var d = {\"a\": 1, \"b\": 2}\n", false);
+    ASTNode* dict = NULL;
+    CHECK(ast && check_count(ast, NODE_DICT_LITERAL, NULL, &dict) == 1);
+    if (!dict) {
+        release_ast(ast);
+        return;
+    }
+    
+    // A clone shares the key array until one side writes
+    ASTNode* copy = clone_ast_node(dict);
+    CHECK(copy && copy->expr.dict.keys == dict->expr.dict.keys &&
+          dict->expr.dict.key_shares && *dict->expr.dict.key_shares == 1);
+    
+    add_pair_to_dict(copy, "c", create_literal_node_int(3, 1, 1));
+    CHECK(copy && copy->expr.dict.keys != dict->expr.dict.keys && copy->expr.dict.pair_count == 3 &&
+          dict->expr.dict.pair_count == 2 && *dict->expr.dict.key_shares == 0);
+    free_ast_node(copy);
+    
+    // Freeing a sharing clone leaves the original's keys alive
+    copy = clone_ast_node(dict);
+    free_ast_node(copy);
+    CHECK(strcmp(dict->expr.dict.keys[0], "a") == 0 && strcmp(dict->expr.dict.keys[1], "b") == 0);
+    release_ast(ast);
+}
+
+static void check_region(void) {
+    Region* region = region_create(4096);
+    CHECK(region != NULL);
+    if (!region) return;
+    
+    char* a = (char*)region_alloc(region, 3);
+    char* b = (char*)region_alloc(region, 5);
+    CHECK(a && b && b - a == REGION_ALIGNMENT && ((size_t)b % REGION_ALIGNMENT) == 0 && b[4] == 0);
+    CHECK(region_contains(region, a) && !region_contains(region, &region));
+    
+    // Past the cap the request fails, and callers use the heap
+    CHECK(region_alloc(region, 8192) == NULL && region->fallbacks == 1);
+    
+    // A program larger than the region ends up half on the heap;
+    // free_ast_node, called while the region is in use, frees only that half
+    ast_use_region(region);
+    ASTNode* ast = check_parse("var s = 0\nfor i in range(10) {\n s += i * 2\n if (s > 5) { console(s) }\n}\n"
+                               "func f(x) { return x + 1 }\nconsole(f(s), [1, 2], {\"k\": s})\n", true);
+    CHECK(ast && region_contains(region, ast->block.statements) && !region_contains(region, ast) &&
+          region->fallbacks > 1);
+    release_ast(ast);
+    ast_use_region(NULL);
+    region_destroy(region);
+}
+
+static bool check_double_text(double value, const char* expected) {
+    char text[NUMFMT_BUFFER_SIZE];
+    numfmt_double(value, text);
+    return strcmp(text, expected) == 0;
+}
+
+static void check_number_format(void) {
+    CHECK(check_double_text(0.1, "0.1"));
+    CHECK(check_double_text(0.30000000000000004, "0.30000000000000004"));
+    CHECK(check_double_text(-0.0001234, "-0.0001234"));
+    CHECK(check_double_text(1.5e-5, "1.5e-05"));
+    CHECK(check_double_text(1e21, "1e+21"));
+    CHECK(check_double_text(1234567890123456.8, "1234567890123456.8"));
+    CHECK(check_double_text(5e-324, "5e-324"));
+    CHECK(check_double_text(1.7976931348623157e308, "1.7976931348623157e+308"));
+    CHECK(check_double_text(-0.0, "-0"));
+    
+    // Random bit patterns must read back exactly, and one digit fewer
+    // must not
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    int mismatches = 0;
+    for (int i = 0; i < 200000; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        double value;
+        memcpy(&value, &state, sizeof(value));
+        if (isnan(value) || isinf(value)) continue;
+        
+        char text[NUMFMT_BUFFER_SIZE];
+        numfmt_double(value, text);
+        
+        // Significant digits, without leading and trailing zeros
+        int first = -1, last = -1, position = 0;
+        for (const char* p = text; *p && *p != 'e'; p++) {
+            if (*p < '0' || *p > '9') continue;
+            if (*p != '0') {
+                if (first < 0) first = position;
+                last = position;
+            }
+            position++;
+        }
+        int digits = last - first + 1;
+        if (strtod(text, NULL) != value || digits < 1 || digits > 17) {
+            mismatches++;
+            continue;
+        }
+        
+        char shorter[NUMFMT_BUFFER_SIZE];
+        snprintf(shorter, sizeof(shorter), "%.*e", digits - 2, value);
+        if (digits > 1 && strtod(shorter, NULL) == value) {
+            mismatches++;
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+static void check_lazy_parse(void) {
+    const char* source = "func add(a, b) {\n return a + b\n}\nconsole(add(1, 2))\n";
+    ASTNode* ast = parse_source_lazy(source, "check.topo");
+    ASTNode* func = NULL;
+    CHECK(ast && check_count(ast, NODE_FUNC_DECL, "add", &func) == 1 && func->func.skimmed && !func->func.body);
+    CHECK(ast && optimize_program(ast) && func && !func->func.skimmed);
+    release_ast(ast);
+    
+    // The skimmed body only fails once it is parsed, and then so does -O
+    ast = parse_source_lazy("func bad() {\n var = 1\n}\nconsole(1)\n", "check.topo");
+    CHECK(ast != NULL);
+    CHECK(ast && !optimize_program(ast));
+    release_ast(ast);
+}
+
+static const char* check_batch_paths[] = {
+    "check_batch_0.topo", "check_batch_1.topo", "check_batch_2.topo", "check_batch_3.topo", "check_batch_4.topo"
+};
+
+static void check_batch(void) {
+    // OK, a broken skimmed body, over budget, missing, OK
+    const char* sources[] = {
+        "var a = 1\nconsole(a)\n",
+        "func bad() {\n var = 1\n}\nconsole(1)\n",
+        "var s = 0\nfor i in range(10) {\n s += i * 2\n if (s > 5) { console(s, i, [s, i]) }\n}\n",
+        NULL,
+        "func f(x) { return x + 1 }\nconsole(f(2))\n"
+    };
+    BatchTask tasks[5];
+    for (int i = 0; i < 5; i++) {
+        remove(check_batch_paths[i]);
+        FILE* file = sources[i] ? fopen(check_batch_paths[i], "wb") : NULL;
+        if (file) {
+            fputs(sources[i], file);
+            for (int line = 0; i == 2 && line < 5000; line++) {
+                fprintf(file, "var v%d = %d * 2\n", line, line);
+            }
+            fclose(file);
+        }
+        tasks[i].path = check_batch_paths[i];
+    }
+    
+    BatchOptions options = {2, 20, true, true, false};
+    BatchResult result = batch_run(tasks, 5, &options);
+    CHECK(tasks[0].status == BATCH_OK && tasks[0].nodes > 0 && tasks[4].status == BATCH_OK);
+    CHECK(tasks[1].status == BATCH_PARSE_ERROR);
+    
+    // The parse of the oversized file stops once the budget is spent
+    CHECK(tasks[2].status == BATCH_OVER_BUDGET && tasks[2].nodes > 20 && tasks[2].nodes < 40);
+    CHECK(tasks[3].status == BATCH_READ_ERROR);
+    CHECK(result.failed == 3 && result.workers >= 1 && result.workers <= 2);
+    
+    // Every task ran exactly once, on a worker of the pool
+    bool ran = true;
+    for (int i = 0; i < 5; i++) {
+        ran = ran && tasks[i].worker >= 0 && tasks[i].worker < result.workers;
+    }
+    CHECK(ran);
+    
+    for (int i = 0; i < 5; i++) {
+        remove(check_batch_paths[i]);
+    }
+}
+
+#define CHECK_TOPOC_PATH "check.topoc"
+
+static const char* check_topoc_source =
+    "func area(w, h) { return w * h }\n"
+    "var sizes = {\"s\": 1, \"m\": 2, \"l\": 3, \"xl\": 4}\n"
+    "for n in range(4) {\n"
+    " if (n == 0) { console(\"zero\") } elif (n == 1) { console(\"one\") } "
+    "elif (n == 2) { console(\"two\") } elif (n == 3) { console(area(n, 2)) }\n"
+    "}\n"
+    "var k = \"m\"\n"
+    "if (k == \"s\") { console(1) } elif (k == \"m\") { console(2) } "
+    "elif (k == \"l\") { console(3) } elif (k == \"xl\") { console(4) }\n";
+
+// The record of the nth node of 'type' (from 0) in a file image
+static TopocNode* check_topoc_node(unsigned char* bytes, NodeType type, int nth) {
+    TopocHeader* header = (TopocHeader*)bytes;
+    TopocNode* nodes = (TopocNode*)(bytes + sizeof(TopocHeader));
+    for (uint32_t i = 0; i < header->node_count; i++) {
+        if (nodes[i].type == type && nth-- == 0) return &nodes[i];
+    }
+    return NULL;
+}
+
+static uint32_t* check_topoc_extra(unsigned char* bytes, const TopocNode* record) {
+    TopocHeader* header = (TopocHeader*)bytes;
+    return (uint32_t*)(bytes + sizeof(TopocHeader) + header->node_count * sizeof(TopocNode)) + record->extra - 1;
+}
+
+// Write a patched image back; the verifier must name 'problem'
+static bool check_topoc_rejects(const unsigned char* bytes, long size, const char* problem) {
+    FILE* file = fopen(CHECK_TOPOC_PATH, "wb");
+    if (!file) return false;
+    fwrite(bytes, 1, (size_t)size, file);
+    fclose(file);
+    
+    char error[256];
+    return !topoc_verify(CHECK_TOPOC_PATH, error, sizeof(error)) && strstr(error, problem) != NULL;
+}
+
+static void check_topoc_format(void) {
+    char error[256];
+    ASTNode* ast = check_parse(check_topoc_source, false);
+    CHECK(ast && topoc_write(ast, CHECK_TOPOC_PATH, false, error, sizeof(error)));
+    CHECK(topoc_is_file(CHECK_TOPOC_PATH));
+    
+    // An unoptimized program loads back unchanged
+    ASTNode* loaded = topoc_load(CHECK_TOPOC_PATH, error, sizeof(error));
+    CHECK(loaded && subtree_equal(ast, loaded));
+    release_ast(loaded);
+    release_ast(ast);
+    
+    long size = 0;
+    unsigned char* bytes = (unsigned char*)read_source_file(CHECK_TOPOC_PATH, &size);
+    CHECK(bytes && size > (long)sizeof(TopocHeader));
+    if (!bytes || size <= (long)sizeof(TopocHeader)) {
+        free(bytes);
+        return;
+    }
+    
+    TopocHeader* header = (TopocHeader*)bytes;
+    CHECK(memcmp(header->magic, TOPOC_MAGIC, 4) == 0 && header->version == TOPOC_VERSION);
+    CHECK(!(header->flags & TOPOC_FILE_OPTIMIZED) && header->root >= 1 && header->root <= header->node_count);
+    
+    // Cut short, or from another version
+    CHECK(check_topoc_rejects(bytes, size - 1, "truncated"));
+    header->version++;
+    CHECK(check_topoc_rejects(bytes, size, "unsupported .topoc version"));
+    CHECK(!topoc_load(CHECK_TOPOC_PATH, error, sizeof(error)));
+    
+    free(bytes);
+    remove(CHECK_TOPOC_PATH);
+}
+
+static void check_precompiled(void) {
+    char error[256];
+    ASTNode* ast = check_parse(check_topoc_source, true);
+    CHECK(ast && topoc_write(ast, CHECK_TOPOC_PATH, true, error, sizeof(error)));
+    
+    ASTNode* loaded = topoc_load(CHECK_TOPOC_PATH, error, sizeof(error));
+    CHECK(loaded && subtree_equal(ast, loaded));
+    release_ast(loaded);
+    release_ast(ast);
+    
+    long size = 0;
+    unsigned char* original = (unsigned char*)read_source_file(CHECK_TOPOC_PATH, &size);
+    unsigned char* bytes = original ? (unsigned char*)malloc((size_t)size) : NULL;
+    if (!bytes) {
+        CHECK(bytes != NULL);
+        free(original);
+        return;
+    }
+    
+    // Required slots: a binary operand and a callee
+    memcpy(bytes, original, (size_t)size);
+    TopocNode* record = check_topoc_node(bytes, NODE_BINARY_EXPR, 0);
+    CHECK(record && (record->child[0] = 0, check_topoc_rejects(bytes, size, "missing child")));
+    
+    memcpy(bytes, original, (size_t)size);
+    record = check_topoc_node(bytes, NODE_CALL_EXPR, 0);
+    CHECK(record && (record->child[0] = 0, check_topoc_rejects(bytes, size, "missing child")));
+    
+    // A string literal without its text
+    memcpy(bytes, original, (size_t)size);
+    for (int i = 0; (record = check_topoc_node(bytes, NODE_LITERAL, i)); i++) {
+        if (record->data_type == TYPE_STRING) break;
+    }
+    CHECK(record && (record->text = 0, check_topoc_rejects(bytes, size, "missing string")));
+    
+    // The same label twice, in the integer chain and in the string chain
+    for (int chain = 0; chain < 2; chain++) {
+        memcpy(bytes, original, (size_t)size);
+        int seen = 0;
+        for (int i = 0; (record = check_topoc_node(bytes, NODE_IF_STMT, i)); i++) {
+            bool strings = (record->flags & TOPOC_NODE_STRINGS) != 0;
+            if ((record->flags & TOPOC_NODE_DISPATCH) && strings == (chain == 1) && seen++ == 0) break;
+        }
+        CHECK(record && record->count >= 2);
+        if (!record || record->count < 2) continue;
+        
+        uint32_t* labels = check_topoc_extra(bytes, record);
+        uint32_t width = chain == 1 ? 2 : 3;
+        memcpy(labels + width, labels, (width - 1) * sizeof(uint32_t));
+        CHECK(check_topoc_rejects(bytes, size, "duplicate dispatch label"));
+    }
+    
+    // Untouched, the image still verifies
+    CHECK(check_topoc_rejects(original, size, "") == false);
+    
+    free(bytes);
+    free(original);
+    remove(CHECK_TOPOC_PATH);
+}
+
+// The DFA must pick what the table scans it replaced pick
+static void check_token_dfa(void) {
+    bool agree = true;
+    char text[64];
+    for (int i = 0; i < KEYWORD_COUNT; i++) {
+        const struct KeywordEntry* entry = &keyword_table[i];
+        agree = agree && lexer_find_keyword(entry->keyword, entry->length) == entry;
+        
+        // A prefix or an extension of a keyword is a name
+        snprintf(text, sizeof(text), "%s_", entry->keyword);
+        agree = agree && !lexer_find_keyword(text, entry->length + 1) && !lexer_scan_keyword(text, entry->length + 1);
+        agree = agree && lexer_find_keyword(text, entry->length - 1) == lexer_scan_keyword(text, entry->length - 1);
+    }
+    CHECK(agree);
+    
+    // Longest match over every pair of symbols, e.g. "*" "*=" or "=" "=="
+    agree = true;
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        for (int j = 0; j < SYMBOL_COUNT; j++) {
+            snprintf(text, sizeof(text), "%s%s", symbol_table[i].str, symbol_table[j].str);
+            agree = agree && lexer_find_symbol(text) == lexer_scan_symbol(text);
+        }
+    }
+    CHECK(agree);
+    CHECK(lexer_find_symbol("") == NULL && lexer_find_symbol("@") == lexer_scan_symbol("@"));
+    
+    Lexer* lexer = lexer_create("iffy if", "check.topo");
+    Token name = lexer_next(lexer);
+    Token keyword = lexer_next(lexer);
+    CHECK(name.type == TOKEN_IDENTIFIER && keyword.type == TOKEN_IF);
+    CHECK(strcmp(token_type_name(TOKEN_IF), "IF") == 0 && strcmp(token_type_name(TOKEN_EOF), "EOF") == 0);
+    free(name.value);
+    free(keyword.value);
+    lexer_destroy(lexer);
+}
+
+static void check_subtree_sharing(void) {
+    const char* boilerplate = "func total(a) {\n var s = 0\n for x in a { s += x * 2 }\n return s\n}\n";
+    char first[256], second[256];
+    snprintf(first, sizeof(first), "%sconsole(total([1, 2]))\n", boilerplate);
+    snprintf(second, sizeof(second), "var pad = 1\n\n%sconsole(total([3]))\n", boilerplate);
+    
+    // Positions do not count, anything else does
+    ASTNode* a = check_parse(first, false);
+    ASTNode* b = check_parse(second, false);
+    ASTNode* fa = NULL;
+    ASTNode* fb = NULL;
+    check_count(a, NODE_FUNC_DECL, NULL, &fa);
+    check_count(b, NODE_FUNC_DECL, NULL, &fb);
+    CHECK(fa && fb && fa->line != fb->line && subtree_hash(fa) == subtree_hash(fb) && subtree_equal(fa, fb));
+    CHECK(a && b && subtree_hash(a) != subtree_hash(b) && !subtree_equal(a, b));
+    
+    // Both programs end up with one stored copy of the function body
+    // (statements, linked to the next, stay with their program)
+    SubtreeStats before = subtree_stats();
+    if (a) subtree_share(&a);
+    if (b) subtree_share(&b);
+    SubtreeStats after = subtree_stats();
+    check_count(a, NODE_FUNC_DECL, NULL, &fa);
+    check_count(b, NODE_FUNC_DECL, NULL, &fb);
+    CHECK(fa && fb && fa != fb && fa->func.body == fb->func.body && fa->func.body->share == SHARE_ROOT);
+    CHECK(after.hits > before.hits && after.subtrees > before.subtrees);
+    
+    release_ast(a);
+    release_ast(b);
+    subtree_store_clear();
+    CHECK(subtree_stats().subtrees == 0);
+}
+
+#define CHECK_MAX_POSITIONS 1024
+
+typedef struct {
+    int count;
+    int lines[CHECK_MAX_POSITIONS];
+    int columns[CHECK_MAX_POSITIONS];
+} CheckPositions;
+
+static void check_position_visitor(ASTNode** slot, void* data) {
+    CheckPositions* positions = (CheckPositions*)data;
+    if (positions->count < CHECK_MAX_POSITIONS) {
+        positions->lines[positions->count] = (*slot)->line;
+        positions->columns[positions->count] = (*slot)->column;
+    }
+    positions->count++;
+    ast_for_each_child(*slot, check_position_visitor, data);
+}
+
+static void check_positions(void) {
+    // Long jumps back and forth need more than a byte per node
+    char source[2048];
+    int length = snprintf(source, sizeof(source), "%s", check_topoc_source);
+    for (int i = 0; i < 300; i++) source[length++] = '\n';
+    snprintf(source + length, sizeof(source) - (size_t)length, "%*sconsole(1)\nvar last = 2\n", 200, "");
+    
+    char error[256];
+    ASTNode* ast = check_parse(source, true);
+    CHECK(ast && topoc_write(ast, CHECK_TOPOC_PATH, true, error, sizeof(error)));
+    ASTNode* loaded = topoc_load(CHECK_TOPOC_PATH, error, sizeof(error));
+    
+    static CheckPositions original, reloaded;
+    original.count = reloaded.count = 0;
+    if (ast) check_position_visitor(&ast, &original);
+    if (loaded) check_position_visitor(&loaded, &reloaded);
+    CHECK(loaded && original.count == reloaded.count && original.count <= CHECK_MAX_POSITIONS &&
+          memcmp(original.lines, reloaded.lines, (size_t)original.count * sizeof(int)) == 0 &&
+          memcmp(original.columns, reloaded.columns, (size_t)original.count * sizeof(int)) == 0);
+    CHECK(original.count > 0 && original.lines[original.count - 1] > 300);
+    
+    // Mostly a byte per node, against eight for two ints
+    long size = 0;
+    TopocHeader* header = (TopocHeader*)read_source_file(CHECK_TOPOC_PATH, &size);
+    CHECK(header && size >= (long)sizeof(TopocHeader) && header->position_bytes < header->node_count * 2);
+    
+    free(header);
+    release_ast(loaded);
+    release_ast(ast);
+    remove(CHECK_TOPOC_PATH);
+}
+
+static int run_checks(void) {
+    printf("\n=== Checks ===\n\n");
+    
+    check_inlining();
+    check_escape_analysis();
+    check_compound_assignment();
+    check_bounds();
+    check_slices();
+    check_perfect_hash();
+    check_dispatch();
+    check_condition_lowering();
+    check_overflow();
+    check_string_folding();
+    check_sorting();
+    check_dict_views();
+    check_shared_keys();
+    check_region();
+    check_number_format();
+    check_json_parser();
+    check_csv_reader();
+    check_regex();
+    check_lazy_parse();
+    check_batch();
+    check_topoc_format();
+    check_precompiled();
+    check_token_dfa();
+    check_subtree_sharing();
+    check_positions();
+    
+    printf("%d checks, %d failed\n", checks_run, checks_failed);
+    return checks_failed > 0 ? 1 : 0;
+}
+
+// Main function
+int main(int argc, char* argv[]) {
+    setlocale(LC_ALL, "en_US.UTF-8");
+    
+    // Optional flags before the other arguments
+    bool optimize = false;
+    bool region_heap = false;
+    bool share = false;
+    bool lazy = false;
+    while (argc >= 2 && (strcmp(argv[1], "-O") == 0 || strcmp(argv[1], "--region-heap") == 0 ||
+                         strcmp(argv[1], "--share") == 0 || strcmp(argv[1], "--lazy") == 0)) {
+        if (argv[1][1] == 'O') optimize = true;
+        else if (strcmp(argv[1], "--share") == 0) share = true;
+        else if (strcmp(argv[1], "--lazy") == 0) lazy = true;
+        else region_heap = true;
+        argv[1] = argv[0];
+        argv++;
+        argc--;
+    }
+    
+    if (region_heap) {
+        ast_heap_region = region_create(REGION_DEFAULT_CAP);
+        if (!ast_heap_region) {
+            fprintf(stderr, "Error: cannot reserve the AST region\n");
+            return 1;
+        }
+        ast_use_region(ast_heap_region);
+        atexit(release_region);
+    }
+    
+    if (argc < 2) {
+        printf("Topo Language Parser 1.3.0\n");
+        printf("Author: Dmitry, Republic of Sakha (Yakutia)\n");
+        printf("Created for Topo Programming Language project\n\n");
+        
+        printf("Usage:\n");
+        printf("  %s test          # run parser tests and checks\n", argv[0]);
+        printf("  %s file.topo     # parse file\n", argv[0]);
+        printf("  %s -e \"code\"     # parse code from command line\n", argv[0]);
+        printf("  %s -j file.json  # parse JSON into literal nodes and write it back\n", argv[0]);
+        printf("  %s -c file.csv   # read CSV rows\n", argv[0]);
+        printf("  %s -r \"re\" file  # print lines matching a regular expression\n", argv[0]);
+        printf("  %s -s \"str\" file # benchmark string search on a file\n", argv[0]);
+        printf("  %s -b files...   # parse many files on worker threads\n", argv[0]);
+        printf("  %s -C in out     # compile a file to a precompiled .topoc file\n", argv[0]);
+        printf("  %s -V file.topoc # verify a precompiled file\n", argv[0]);
+        printf("  %s -O ...        # optimize the AST before printing\n", argv[0]);
+        printf("  %s --region-heap ... # allocate the AST from one region, freed at exit\n", argv[0]);
+        printf("  %s --share -b ...  # share identical subtrees across the batch\n", argv[0]);
+        printf("  %s --lazy ...    # skim function bodies, parsing them only when needed\n\n", argv[0]);
+        
+        test_parser();
+        return 0;
+    }
+    
+    if (strcmp(argv[1], "test") == 0) {
+        test_parser();
+        return run_checks();
+    }
+    
+    if (strcmp(argv[1], "-e") == 0 && argc >= 3) {
+        printf("=== Parsing code from command line ===\n\n");
+        
+        ASTNode* ast = parse_source(argv[2], "<command-line>");
+        if (ast && optimize && !optimize_program(ast)) {
+            release_ast(ast);
+            ast = NULL;
+        }
+        
+        if (ast) {
+            printf("Parsing successful!\n");
+            printf("\nAST Structure:\n");
+            printf("--------------\n");
+            print_ast(ast, 0);
+            
+            release_ast(ast);
+        } else {
+            printf("Parsing failed!\n");
+        }
+        
+        return 0;
+    }
+    
+    if (strcmp(argv[1], "-j") == 0 && argc >= 3) {
+        long json_size = 0;
+        char* json_text = read_source_file(argv[2], &json_size);
+        if (!json_text) return 1;
+        
+        printf("=== Parsing JSON file: %s ===\n\n", argv[2]);
+        
+        char error[128];
+        ASTNode* value = json_parse(json_text, (size_t)json_size, error, sizeof(error));
+        free(json_text);
+        
+        if (!value) {
+            printf("JSON error: %s\n", error);
+            return 1;
+        }
+        
+        print_ast(value, 0);
+        
+        JsonBuffer buffer = {0};
+        if (json_serialize(value, &buffer)) {
+            printf("\nJSON:\n%s\n", buffer.data);
+        }
+        json_buffer_free(&buffer);
+        release_ast(value);
+        return 0;
+    }
+    
+    if (strcmp(argv[1], "-c") == 0 && argc >= 3) {
+        CsvReader* reader = csv_open(argv[2], ',');
+        if (!reader) {
+            fprintf(stderr, "Error: cannot open file '%s'\n", argv[2]);
+            return 1;
+        }
+        
+        printf("=== Reading CSV file: %s ===\n\n", argv[2]);
+        
+        // Show the first rows, count the rest
+        while (csv_next_row(reader)) {
+            if (reader->row > 10) continue;
+            
+            printf("%4ld:", reader->row);
+            for (int i = 0; i < reader->field_count; i++) {
+                char* text = csv_field_copy(&reader->fields[i]);
+                printf(" [%s]", text ? text : "");
+                free(text);
+            }
+            printf("\n");
+        }
+        
+        printf("\nRows: %ld\n", reader->row);
+        csv_close(reader);
+        return 0;
+    }
+    
+    if (strcmp(argv[1], "-r") == 0 && argc >= 4) {
+        char error[128];
+        Regex* regex = regex_compile(argv[2], error, sizeof(error));
+        if (!regex) {
+            fprintf(stderr, "Regex error: %s\n", error);
+            return 1;
+        }
+        
+        long text_size = 0;
+        char* text = read_source_file(argv[3], &text_size);
+        if (!text) {
+            regex_free(regex);
+            return 1;
+        }
+        
+        // Print each line with a match, grep style
+        long line_number = 1;
+        for (char* line = text; line < text + text_size; line_number++) {
+            char* end = (char*)memchr(line, '\n', (size_t)(text + text_size - line));
+            size_t length = end ? (size_t)(end - line) : (size_t)(text + text_size - line);
+            if (length > 0 && line[length - 1] == '\r') length--;
+            
+            if (regex_search(regex, line, length, NULL)) {
+                printf("%ld: %.*s\n", line_number, (int)length, line);
+            }
+            if (!end) break;
+            line = end + 1;
+        }
+        
+        free(text);
+        regex_free(regex);
+        return 0;
+    }
+    
+    if (strcmp(argv[1], "-b") == 0 && argc >= 3) {
+        int count = argc - 2;
+        BatchTask* tasks = (BatchTask*)calloc((size_t)count, sizeof(BatchTask));
+        if (!tasks) {
+            fprintf(stderr, "Error: cannot allocate memory\n");
+            return 1;
+        }
+        for (int i = 0; i < count; i++) {
+            tasks[i].path = argv[i + 2];
+        }
+        
+        BatchOptions options = {0, 0, lazy, optimize, share};
+        BatchResult result = batch_run(tasks, count, &options);
+        
+        printf("=== Batch: %d files on %d workers ===\n\n", count, result.workers);
+        
+        double slowest = 0.0;
+        for (int i = 0; i < count; i++) {
+            printf("%-40s %-12s %8d nodes %9.3f ms  (worker %d)\n", tasks[i].path,
+                   batch_status_name(tasks[i].status), tasks[i].nodes, tasks[i].seconds * 1000.0, tasks[i].worker);
+            if (tasks[i].seconds > slowest) slowest = tasks[i].seconds;
+        }
+        
+        printf("\nFailed: %d  Steals: %ld  Slowest: %.3f ms  Total: %.3f ms\n",
+               result.failed, result.steals, slowest * 1000.0, result.seconds * 1000.0);
+        
+        if (share) {
+            SubtreeStats stats = subtree_stats();
+            printf("Shared: %d subtrees (%ld nodes)  Reused: %ld times (%ld nodes)\n",
+                   stats.subtrees, stats.nodes, stats.hits, stats.nodes_saved);
+            subtree_store_clear();
+        }
+        
+        free(tasks);
+        return result.failed > 0 ? 1 : 0;
+    }
+    
+    if (strcmp(argv[1], "-s") == 0 && argc >= 4) {
+        long text_size = 0;
+        char* text = read_source_file(argv[3], &text_size);
+        if (!text) return 1;
+        
+        printf("=== String benchmark: '%s' in %s (%ld bytes) ===\n\n", argv[2], argv[3], text_size);
+        str_benchmark(text, (size_t)text_size, argv[2], strlen(argv[2]));
+        
+        free(text);
+        return 0;
+    }
+    
+    if (strcmp(argv[1], "-C") == 0 && argc >= 4) {
+        long file_size = 0;
+        char* source = read_source_file(argv[2], &file_size);
+        if (!source) return 1;
+        
+        ASTNode* ast = parse_source(source, argv[2]);
+        free(source);
+        if (ast && optimize && !optimize_program(ast)) {
+            release_ast(ast);
+            ast = NULL;
+        }
+        if (!ast) {
+            printf("Parsing failed!\n");
+            return 1;
+        }
+        
+        char error[256];
+        bool written = topoc_write(ast, argv[3], optimize, error, sizeof(error));
+        release_ast(ast);
+        
+        if (!written) {
+            fprintf(stderr, "Error: %s\n", error);
+            return 1;
+        }
+        printf("Compiled %s -> %s\n", argv[2], argv[3]);
+        return 0;
+    }
+    
+    if (strcmp(argv[1], "-V") == 0 && argc >= 3) {
+        char error[256];
+        if (!topoc_verify(argv[2], error, sizeof(error))) {
+            fprintf(stderr, "Error: %s\n", error);
+            return 1;
+        }
+        printf("%s: verified\n", argv[2]);
+        return 0;
+    }
+    
+    // Precompiled files are loaded rather than parsed
+    if (topoc_is_file(argv[1])) {
+        printf("=== Loading precompiled file: %s ===\n\n", argv[1]);
+        
+        char error[256];
+        ASTNode* ast = topoc_load(argv[1], error, sizeof(error));
+        if (!ast) {
+            fprintf(stderr, "Error: %s\n", error);
+            return 1;
+        }
+        if (optimize && !optimize_program(ast)) {
+            fprintf(stderr, "Error: a function body does not parse\n");
+            release_ast(ast);
+            return 1;
+        }
+        
+        printf("Loading successful!\n");
+        printf("\nAST Structure:\n");
+        printf("--------------\n");
+        print_ast(ast, 0);
+        
+        release_ast(ast);
+        return 0;
+    }
+    
+    // Read from file
+    long file_size = 0;
+    char* source = read_source_file(argv[1], &file_size);
+    if (!source) return 1;
+    
+    printf("=== Parsing file: %s ===\n\n", argv[1]);
+    
+    // Optimizing needs every body, so a lazy parse only stays lazy without
+    // -O, and a body that does not parse fails the file
+    ASTNode* ast = lazy ? parse_source_lazy(source, argv[1]) : parse_source(source, argv[1]);
+    if (ast && optimize && !optimize_program(ast)) {
+        release_ast(ast);
+        ast = NULL;
+    }
+    
+    if (ast) {
+        printf("Parsing successful!\n");
+        printf("\nAST Structure:\n");
+        printf("--------------\n");
+        print_ast(ast, 0);
+        
+        release_ast(ast);
+    } else {
+        printf("Parsing failed!\n");
+    }
+    
+    free(source);
+    
+    return 0;
 }
\ No newline at end of file
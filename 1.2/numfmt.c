@@ -0,0 +1,328 @@
+/**
+ * Number formatting for Topo Programming Language
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include <float.h>
+#include "numfmt.h"
+
+// ================ INTEGERS ================
+
+static const char numfmt_digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static int numfmt_unsigned(unsigned long value, char* buffer) {
+    char digits[NUMFMT_BUFFER_SIZE];
+    char* p = digits + sizeof(digits);
+    
+    // Two digits per division, right to left
+    while (value >= 100) {
+        unsigned long pair = (value % 100) * 2;
+        value /= 100;
+        *--p = numfmt_digit_pairs[pair + 1];
+        *--p = numfmt_digit_pairs[pair];
+    }
+    if (value >= 10) {
+        *--p = numfmt_digit_pairs[value * 2 + 1];
+        *--p = numfmt_digit_pairs[value * 2];
+    } else {
+        *--p = (char)('0' + value);
+    }
+    
+    int length = (int)(digits + sizeof(digits) - p);
+    memcpy(buffer, p, length);
+    buffer[length] = '\0';
+    return length;
+}
+
+int numfmt_long(long value, char* buffer) {
+    if (value >= 0) return numfmt_unsigned((unsigned long)value, buffer);
+    
+    // Unsigned negation, so that LONG_MIN works
+    buffer[0] = '-';
+    return numfmt_unsigned(0ul - (unsigned long)value, buffer + 1) + 1;
+}
+
+// ================ FLOATING POINT ================
+//
+// Grisu3 (Loitsch, "Printing Floating-Point Numbers Quickly and
+// Accurately with Integers", PLDI 2010). The double and the two ends of
+// its rounding interval are scaled by a cached power of ten into 64-bit
+// fixed point, and digits are generated until they pin down a number
+// inside the interval. That is the shortest (and closest) for about
+// 99.5% of doubles; for the rest the error bounds are too wide to be
+// sure, and the snprintf search at the end takes over.
+
+typedef struct {
+    uint64_t f;
+    int e;              // Value is f * 2^e
+} NumfmtFp;
+
+typedef struct {
+    uint64_t f;
+    int16_t e;
+    int16_t k;          // 10^k, rounded to f * 2^e
+} NumfmtPower;
+
+// 10^-348 to 10^340 in steps of 8
+static const NumfmtPower numfmt_powers[] = {
+    {0xfa8fd5a0081c0288ull, -1220, -348}, {0xbaaee17fa23ebf76ull, -1193, -340},
+    {0x8b16fb203055ac76ull, -1166, -332}, {0xcf42894a5dce35eaull, -1140, -324},
+    {0x9a6bb0aa55653b2dull, -1113, -316}, {0xe61acf033d1a45dfull, -1087, -308},
+    {0xab70fe17c79ac6caull, -1060, -300}, {0xff77b1fcbebcdc4full, -1034, -292},
+    {0xbe5691ef416bd60cull, -1007, -284}, {0x8dd01fad907ffc3cull, -980, -276},
+    {0xd3515c2831559a83ull, -954, -268}, {0x9d71ac8fada6c9b5ull, -927, -260},
+    {0xea9c227723ee8bcbull, -901, -252}, {0xaecc49914078536dull, -874, -244},
+    {0x823c12795db6ce57ull, -847, -236}, {0xc21094364dfb5637ull, -821, -228},
+    {0x9096ea6f3848984full, -794, -220}, {0xd77485cb25823ac7ull, -768, -212},
+    {0xa086cfcd97bf97f4ull, -741, -204}, {0xef340a98172aace5ull, -715, -196},
+    {0xb23867fb2a35b28eull, -688, -188}, {0x84c8d4dfd2c63f3bull, -661, -180},
+    {0xc5dd44271ad3cdbaull, -635, -172}, {0x936b9fcebb25c996ull, -608, -164},
+    {0xdbac6c247d62a584ull, -582, -156}, {0xa3ab66580d5fdaf6ull, -555, -148},
+    {0xf3e2f893dec3f126ull, -529, -140}, {0xb5b5ada8aaff80b8ull, -502, -132},
+    {0x87625f056c7c4a8bull, -475, -124}, {0xc9bcff6034c13053ull, -449, -116},
+    {0x964e858c91ba2655ull, -422, -108}, {0xdff9772470297ebdull, -396, -100},
+    {0xa6dfbd9fb8e5b88full, -369, -92}, {0xf8a95fcf88747d94ull, -343, -84},
+    {0xb94470938fa89bcfull, -316, -76}, {0x8a08f0f8bf0f156bull, -289, -68},
+    {0xcdb02555653131b6ull, -263, -60}, {0x993fe2c6d07b7facull, -236, -52},
+    {0xe45c10c42a2b3b06ull, -210, -44}, {0xaa242499697392d3ull, -183, -36},
+    {0xfd87b5f28300ca0eull, -157, -28}, {0xbce5086492111aebull, -130, -20},
+    {0x8cbccc096f5088ccull, -103, -12}, {0xd1b71758e219652cull, -77, -4},
+    {0x9c40000000000000ull, -50, 4}, {0xe8d4a51000000000ull, -24, 12},
+    {0xad78ebc5ac620000ull, 3, 20}, {0x813f3978f8940984ull, 30, 28},
+    {0xc097ce7bc90715b3ull, 56, 36}, {0x8f7e32ce7bea5c70ull, 83, 44},
+    {0xd5d238a4abe98068ull, 109, 52}, {0x9f4f2726179a2245ull, 136, 60},
+    {0xed63a231d4c4fb27ull, 162, 68}, {0xb0de65388cc8ada8ull, 189, 76},
+    {0x83c7088e1aab65dbull, 216, 84}, {0xc45d1df942711d9aull, 242, 92},
+    {0x924d692ca61be758ull, 269, 100}, {0xda01ee641a708deaull, 295, 108},
+    {0xa26da3999aef774aull, 322, 116}, {0xf209787bb47d6b85ull, 348, 124},
+    {0xb454e4a179dd1877ull, 375, 132}, {0x865b86925b9bc5c2ull, 402, 140},
+    {0xc83553c5c8965d3dull, 428, 148}, {0x952ab45cfa97a0b3ull, 455, 156},
+    {0xde469fbd99a05fe3ull, 481, 164}, {0xa59bc234db398c25ull, 508, 172},
+    {0xf6c69a72a3989f5cull, 534, 180}, {0xb7dcbf5354e9beceull, 561, 188},
+    {0x88fcf317f22241e2ull, 588, 196}, {0xcc20ce9bd35c78a5ull, 614, 204},
+    {0x98165af37b2153dfull, 641, 212}, {0xe2a0b5dc971f303aull, 667, 220},
+    {0xa8d9d1535ce3b396ull, 694, 228}, {0xfb9b7cd9a4a7443cull, 720, 236},
+    {0xbb764c4ca7a44410ull, 747, 244}, {0x8bab8eefb6409c1aull, 774, 252},
+    {0xd01fef10a657842cull, 800, 260}, {0x9b10a4e5e9913129ull, 827, 268},
+    {0xe7109bfba19c0c9dull, 853, 276}, {0xac2820d9623bf429ull, 880, 284},
+    {0x80444b5e7aa7cf85ull, 907, 292}, {0xbf21e44003acdd2dull, 933, 300},
+    {0x8e679c2f5e44ff8full, 960, 308}, {0xd433179d9c8cb841ull, 986, 316},
+    {0x9e19db92b4e31ba9ull, 1013, 324}, {0xeb96bf6ebadf77d9ull, 1039, 332},
+    {0xaf87023b9bf0ee6bull, 1066, 340}
+};
+
+#define NUMFMT_POWER_OFFSET 348
+#define NUMFMT_POWER_STEP 8
+#define NUMFMT_TARGET_MIN (-60)   // Scaled binary exponents that leave
+#define NUMFMT_TARGET_MAX (-32)   // 32 bits for the integral digits
+
+static NumfmtFp numfmt_fp_normalize(NumfmtFp x) {
+    int shift = __builtin_clzll(x.f);
+    x.f <<= shift;
+    x.e -= shift;
+    return x;
+}
+
+// Upper 64 bits of the product, rounded
+static NumfmtFp numfmt_fp_multiply(NumfmtFp x, NumfmtFp y) {
+    const uint64_t mask = 0xFFFFFFFFu;
+    uint64_t a = x.f >> 32, b = x.f & mask;
+    uint64_t c = y.f >> 32, d = y.f & mask;
+    uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    uint64_t middle = (bd >> 32) + (ad & mask) + (bc & mask) + (1u << 31);
+    NumfmtFp product = {ac + (ad >> 32) + (bc >> 32) + (middle >> 32), x.e + y.e + 64};
+    return product;
+}
+
+// Step the last digit down while that moves closer to the value; false
+// if the result is not certain to be the closest shortest number
+static bool numfmt_round_weed(char* digits, int length, uint64_t distance_high_w, uint64_t unsafe,
+                              uint64_t rest, uint64_t ten_kappa, uint64_t unit) {
+    uint64_t small_distance = distance_high_w - unit;
+    uint64_t big_distance = distance_high_w + unit;
+    
+    while (rest < small_distance && unsafe - rest >= ten_kappa &&
+           (rest + ten_kappa < small_distance ||
+            small_distance - rest >= rest + ten_kappa - small_distance)) {
+        digits[length - 1]--;
+        rest += ten_kappa;
+    }
+    
+    if (rest < big_distance && unsafe - rest >= ten_kappa &&
+        (rest + ten_kappa < big_distance ||
+         big_distance - rest > rest + ten_kappa - big_distance)) {
+        return false;
+    }
+    return 2 * unit <= rest && rest <= unsafe - 4 * unit;
+}
+
+// Digits of high until they fall inside (low, high), widened by one
+// unit of error on each side; the value is digits * 10^kappa
+static bool numfmt_digit_gen(NumfmtFp low, NumfmtFp w, NumfmtFp high, char* digits, int* length, int* kappa) {
+    uint64_t unit = 1;
+    NumfmtFp too_low = {low.f - unit, low.e};
+    NumfmtFp too_high = {high.f + unit, high.e};
+    uint64_t unsafe = too_high.f - too_low.f;
+    int shift = -w.e;
+    uint64_t one = 1ull << shift;
+    uint32_t integrals = (uint32_t)(too_high.f >> shift);
+    uint64_t fractionals = too_high.f & (one - 1);
+    
+    uint32_t divisor = 1;
+    *kappa = 0;
+    if (integrals > 0) {
+        *kappa = 1;
+        while (divisor <= integrals / 10) {
+            divisor *= 10;
+            (*kappa)++;
+        }
+    }
+    
+    *length = 0;
+    while (*kappa > 0) {
+        digits[(*length)++] = (char)('0' + integrals / divisor);
+        integrals %= divisor;
+        (*kappa)--;
+        uint64_t rest = ((uint64_t)integrals << shift) + fractionals;
+        if (rest < unsafe) {
+            return numfmt_round_weed(digits, *length, too_high.f - w.f, unsafe, rest,
+                                     (uint64_t)divisor << shift, unit);
+        }
+        divisor /= 10;
+    }
+    
+    for (;;) {
+        fractionals *= 10;
+        unit *= 10;
+        unsafe *= 10;
+        digits[(*length)++] = (char)('0' + (fractionals >> shift));
+        fractionals &= one - 1;
+        (*kappa)--;
+        if (fractionals < unsafe) {
+            return numfmt_round_weed(digits, *length, (too_high.f - w.f) * unit, unsafe, fractionals,
+                                     one, unit);
+        }
+    }
+}
+
+// Shortest digits of a positive finite double, value = digits * 10^exponent
+static bool numfmt_grisu3(double value, char* digits, int* length, int* exponent) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    
+    const uint64_t hidden = 1ull << 52;
+    int biased = (int)(bits >> 52) & 0x7FF;
+    NumfmtFp v = {bits & (hidden - 1), -1074};
+    if (biased > 0) {
+        v.f |= hidden;
+        v.e = biased - 1075;
+    }
+    
+    // Rounding interval; it is narrower below powers of two
+    NumfmtFp high = numfmt_fp_normalize((NumfmtFp){(v.f << 1) + 1, v.e - 1});
+    NumfmtFp low = (v.f == hidden && biased > 1) ? (NumfmtFp){(v.f << 2) - 1, v.e - 2}
+                                                 : (NumfmtFp){(v.f << 1) - 1, v.e - 1};
+    low.f <<= low.e - high.e;
+    low.e = high.e;
+    NumfmtFp w = numfmt_fp_normalize(v);
+    
+    // Cached power that brings w into the target exponent range
+    int min_exponent = NUMFMT_TARGET_MIN - (w.e + 64);
+    int k = ((min_exponent + 63) * 78913 + (1 << 18) - 1) >> 18;  // ceil(x * log10(2))
+    const NumfmtPower* power = &numfmt_powers[(NUMFMT_POWER_OFFSET + k - 1) / NUMFMT_POWER_STEP + 1];
+    NumfmtFp scale = {power->f, power->e};
+    
+    int kappa;
+    bool exact = numfmt_digit_gen(numfmt_fp_multiply(low, scale), numfmt_fp_multiply(w, scale),
+                                  numfmt_fp_multiply(high, scale), digits, length, &kappa);
+    *exponent = kappa - power->k;
+    return exact;
+}
+
+int numfmt_double(double value, char* buffer) {
+    if (isnan(value)) {
+        strcpy(buffer, "nan");
+        return 3;
+    }
+    if (isinf(value)) {
+        strcpy(buffer, value < 0 ? "-inf" : "inf");
+        return value < 0 ? 4 : 3;
+    }
+    
+    // Whole numbers below 2^53 are exact, print them as integers
+    if (value > -9007199254740992.0 && value < 9007199254740992.0 && value == (double)(long)value) {
+        if (value == 0 && signbit(value)) {
+            strcpy(buffer, "-0");
+            return 2;
+        }
+        return numfmt_long((long)value, buffer);
+    }
+    
+    // The output matches the %g search below: %.15g (or the precision
+    // that first reads back, for longer or subnormal values) with the
+    // trailing zeros dropped. Any decimal with at most 15 significant
+    // digits survives the trip through a normal double, so the shortest
+    // digits are also what %.15g rounds to.
+    bool subnormal = value > -DBL_MIN && value < DBL_MIN;
+    char digits[20];
+    int count, exponent;
+    if (numfmt_grisu3(value < 0 ? -value : value, digits, &count, &exponent)) {
+        int point = count + exponent;       // Digits before the decimal point
+        int precision = (subnormal || count > 15) ? count : 15;
+        char* p = buffer;
+        if (value < 0) *p++ = '-';
+        
+        if (point - 1 < -4 || point - 1 >= precision) {
+            *p++ = digits[0];
+            if (count > 1) {
+                *p++ = '.';
+                memcpy(p, digits + 1, count - 1);
+                p += count - 1;
+            }
+            p += snprintf(p, 8, "e%c%02d", point - 1 < 0 ? '-' : '+', abs(point - 1));
+        } else if (point <= 0) {
+            *p++ = '0';
+            *p++ = '.';
+            memset(p, '0', -point);
+            p += -point;
+            memcpy(p, digits, count);
+            p += count;
+        } else {
+            for (int i = 0; i < point || i < count; i++) {
+                if (i == point) *p++ = '.';
+                *p++ = i < count ? digits[i] : '0';
+            }
+        }
+        
+        *p = '\0';
+        return (int)(p - buffer);
+    }
+    
+    // First precision that round-trips; 17 digits always do. Subnormals
+    // carry fewer bits and are searched from the start.
+    char text[NUMFMT_BUFFER_SIZE];
+    int length = 0;
+    int first = subnormal ? 1 : 15;
+    for (int precision = first; precision <= 17; precision++) {
+        length = snprintf(text, sizeof(text), "%.*g", precision, value);
+        if (strtod(text, NULL) == value) break;
+    }
+    
+    memcpy(buffer, text, (size_t)length + 1);
+    return length;
+}
@@ -0,0 +1,15 @@
+#ifndef NUMFMT_H
+#define NUMFMT_H
+
+#include <stddef.h>
+
+// ================ NUMBER FORMATTING ================
+#define NUMFMT_BUFFER_SIZE 32   // Enough for any long or double
+
+// Decimal text of a long, returns the length (buffer >= NUMFMT_BUFFER_SIZE)
+int numfmt_long(long value, char* buffer);
+
+// Shortest text that reads back as exactly the same double
+int numfmt_double(double value, char* buffer);
+
+#endif // NUMFMT_H
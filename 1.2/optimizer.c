@@ -0,0 +1,2292 @@
+/**
+ * AST optimizer for Topo Programming Language
+ * Version 1.3.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <limits.h>
+#include "ast.h"
+#include "optimizer.h"
+#include "parser.h"
+#include "bignum.h"
+#include "strops.h"
+#include "sort.h"
+
+// ================ NAME SETS ================
+
+typedef struct {
+    char** names;
+    int count;
+    int capacity;
+} NameSet;
+
+static bool name_set_contains(const NameSet* set, const char* name) {
+    if (!name) return false;
+    for (int i = 0; i < set->count; i++) {
+        if (strcmp(set->names[i], name) == 0) return true;
+    }
+    return false;
+}
+
+// Names are borrowed from the AST, the set does not own them
+static void name_set_add(NameSet* set, char* name) {
+    if (!name || name_set_contains(set, name)) return;
+    
+    if (set->count >= set->capacity) {
+        int capacity = set->capacity ? set->capacity * 2 : 16;
+        char** names = (char**)realloc(set->names, capacity * sizeof(char*));
+        if (!names) return;
+        set->names = names;
+        set->capacity = capacity;
+    }
+    set->names[set->count++] = name;
+}
+
+static void name_set_free(NameSet* set) {
+    free(set->names);
+    set->names = NULL;
+    set->count = 0;
+    set->capacity = 0;
+}
+
+// ================ HELPERS ================
+
+static const char* identifier_name(const ASTNode* node) {
+    if (!node || node->type != NODE_IDENTIFIER) return NULL;
+    return node->expr.identifier.identifier;
+}
+
+// Name of the function called by a call expression (NULL for computed callees)
+static const char* call_name(const ASTNode* call) {
+    if (!call || call->type != NODE_CALL_EXPR) return NULL;
+    return identifier_name(call->expr.call.callee);
+}
+
+typedef struct {
+    NodeType type;
+    const char* name; // For NODE_IDENTIFIER: only count this name
+    int count;
+} NodeCounter;
+
+static void node_counter_visitor(ASTNode** slot, void* data) {
+    NodeCounter* counter = (NodeCounter*)data;
+    ASTNode* node = *slot;
+    
+    if (node->type == counter->type) {
+        const char* name = identifier_name(node);
+        if (!counter->name || (name && strcmp(name, counter->name) == 0)) {
+            counter->count++;
+        }
+    }
+    ast_for_each_child(node, node_counter_visitor, data);
+}
+
+// Count nodes of a type in a subtree (the root included)
+static int count_nodes(ASTNode* node, NodeType type, const char* name) {
+    if (!node) return 0;
+    
+    NodeCounter counter = {type, name, 0};
+    ASTNode* root = node;
+    node_counter_visitor(&root, &counter);
+    return counter.count;
+}
+
+// Equal literal values (ints, strings, bools, null)
+static bool same_literal(const ASTNode* a, const ASTNode* b) {
+    if (!a || !b || a->type != NODE_LITERAL || b->type != NODE_LITERAL) return false;
+    if (a->expr.literal.data_type != b->expr.literal.data_type) return false;
+    
+    switch (a->expr.literal.data_type) {
+        case TYPE_INT:
+            return a->expr.literal.value.int_val == b->expr.literal.value.int_val;
+        case TYPE_STRING:
+            return strcmp(a->expr.literal.value.string_val, b->expr.literal.value.string_val) == 0;
+        case TYPE_BIGINT:
+            return strcmp(a->expr.literal.value.bignum_val, b->expr.literal.value.bignum_val) == 0;
+        case TYPE_BOOL:
+            return a->expr.literal.value.bool_val == b->expr.literal.value.bool_val;
+        case TYPE_NULL:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Side-effect free expression that can be duplicated or reordered
+static bool is_pure_expr(const ASTNode* node) {
+    if (!node) return true;
+    
+    switch (node->type) {
+        case NODE_LITERAL:
+        case NODE_IDENTIFIER:
+            return true;
+        case NODE_UNARY_EXPR:
+            return is_pure_expr(node->expr.unary.operand);
+        case NODE_BINARY_EXPR:
+            return is_pure_expr(node->expr.binary.left) &&
+                   is_pure_expr(node->expr.binary.right);
+        default:
+            return false;
+    }
+}
+
+static void declared_names_visitor(ASTNode** slot, void* data) {
+    ASTNode* node = *slot;
+    
+    if (node->type == NODE_VAR_DECL || node->type == NODE_CONST_DECL ||
+        node->type == NODE_FOR_STMT || node->type == NODE_FUNC_DECL) {
+        name_set_add((NameSet*)data, node->name);
+    }
+    if (node->type == NODE_FUNC_DECL) {
+        for (FunctionParam* param = node->func.params; param; param = param->next) {
+            name_set_add((NameSet*)data, param->name);
+        }
+    }
+    ast_for_each_child(node, declared_names_visitor, data);
+}
+
+// Parameters and every name declared inside a function
+static void collect_function_locals(ASTNode* func, NameSet* set) {
+    for (FunctionParam* param = func->func.params; param; param = param->next) {
+        name_set_add(set, param->name);
+    }
+    ast_for_each_child(func, declared_names_visitor, set);
+}
+
+typedef struct {
+    const NameSet* locals;
+    NameSet* free_names;
+} FreeNames;
+
+static void free_names_visitor(ASTNode** slot, void* data) {
+    FreeNames* names = (FreeNames*)data;
+    const char* name = identifier_name(*slot);
+    
+    if (name && !name_set_contains(names->locals, name)) {
+        name_set_add(names->free_names, (*slot)->expr.identifier.identifier);
+    }
+    ast_for_each_child(*slot, free_names_visitor, data);
+}
+
+// ================ FUNCTION INLINING ================
+//
+// Calls to small top-level functions are replaced by their bodies:
+//  - a body that is a single 'return expr' is substituted in expression
+//    position, with arguments replacing parameters;
+//  - other bodies are inlined at statement-level calls as a block that
+//    binds the arguments to renamed locals, with a trailing 'return'
+//    rewritten into a plain statement.
+// Recursive functions are never inlined, and inlined code is inlined
+// again at most INLINE_MAX_DEPTH times.
+
+typedef struct {
+    ASTNode* decl;
+    int param_count;
+    int call_count;
+    bool recursive;
+    bool redefined;   // Declared twice, assigned or shadowed by a variable
+} InlineCandidate;
+
+typedef struct {
+    InlineCandidate* candidates;
+    int count;
+    ASTNode* current_func;
+    NameSet locals;   // Names bound around the call site: enclosing function(s), blocks, loops
+    int loop_depth;
+    int depth;
+    int rename_counter;
+    int inlined;
+} InlineContext;
+
+static InlineCandidate* inline_find(InlineContext* ctx, const char* name) {
+    if (!name) return NULL;
+    for (int i = 0; i < ctx->count; i++) {
+        if (strcmp(ctx->candidates[i].decl->name, name) == 0) {
+            return &ctx->candidates[i];
+        }
+    }
+    return NULL;
+}
+
+static void inline_scan_visitor(ASTNode** slot, void* data) {
+    InlineContext* ctx = (InlineContext*)data;
+    ASTNode* node = *slot;
+    InlineCandidate* candidate = NULL;
+    
+    switch (node->type) {
+        case NODE_CALL_EXPR:
+            candidate = inline_find(ctx, call_name(node));
+            if (candidate) {
+                candidate->call_count++;
+                if (ctx->current_func == candidate->decl) {
+                    candidate->recursive = true;
+                }
+            }
+            break;
+            
+        case NODE_ASSIGNMENT:
+            candidate = inline_find(ctx, identifier_name(node->expr.assign.target));
+            if (candidate) candidate->redefined = true;
+            break;
+            
+        case NODE_VAR_DECL:
+        case NODE_CONST_DECL:
+        case NODE_FOR_STMT:
+        case NODE_FUNC_DECL:
+            candidate = inline_find(ctx, node->name);
+            if (candidate && candidate->decl != node) candidate->redefined = true;
+            break;
+            
+        default:
+            break;
+    }
+    
+    ASTNode* saved_func = ctx->current_func;
+    if (node->type == NODE_FUNC_DECL) ctx->current_func = node;
+    ast_for_each_child(node, inline_scan_visitor, data);
+    ctx->current_func = saved_func;
+}
+
+// Body of the form { return expr }
+static ASTNode* inline_return_expr(ASTNode* decl) {
+    ASTNode* body = decl->func.body;
+    if (!body || body->type != NODE_BLOCK) return NULL;
+    
+    ASTNode* stmt = body->block.statements;
+    if (!stmt || stmt->next || stmt->type != NODE_RETURN_STMT) return NULL;
+    return stmt->ret.value;
+}
+
+static void loose_jump_visitor(ASTNode** slot, void* data) {
+    ASTNode* node = *slot;
+    
+    if (node->type == NODE_BREAK_STMT || node->type == NODE_CONTINUE_STMT) {
+        *(bool*)data = true;
+    } else if (node->type != NODE_WHILE_STMT && node->type != NODE_FOR_STMT) {
+        ast_for_each_child(node, loose_jump_visitor, data);
+    }
+}
+
+// Body can be inlined as a statement: no 'return' except the last
+// statement, no nested functions and no break/continue outside a loop
+static bool inline_statement_form(ASTNode* decl) {
+    ASTNode* body = decl->func.body;
+    if (!body || body->type != NODE_BLOCK) return false;
+    
+    for (ASTNode* stmt = body->block.statements; stmt; stmt = stmt->next) {
+        int returns = count_nodes(stmt, NODE_RETURN_STMT, NULL);
+        if (returns > 0 && (stmt->next || stmt->type != NODE_RETURN_STMT || returns > 1)) {
+            return false;
+        }
+    }
+    
+    if (count_nodes(body, NODE_FUNC_DECL, NULL) > 0) return false;
+    
+    bool loose_jump = false;
+    ast_for_each_child(body, loose_jump_visitor, &loose_jump);
+    return !loose_jump;
+}
+
+// Every name the callee uses from the outside must mean the same thing
+// at the call site, i.e. must not be shadowed by anything bound between
+// the call and the top level
+static bool inline_names_visible(InlineContext* ctx, InlineCandidate* candidate) {
+    if (ctx->locals.count == 0) return true;
+    if (name_set_contains(&ctx->locals, candidate->decl->name)) return false;
+    
+    NameSet callee_locals = {0};
+    NameSet free_names = {0};
+    collect_function_locals(candidate->decl, &callee_locals);
+    
+    FreeNames names = {&callee_locals, &free_names};
+    ast_for_each_child(candidate->decl, free_names_visitor, &names);
+    
+    bool visible = true;
+    for (int i = 0; i < free_names.count && visible; i++) {
+        if (name_set_contains(&ctx->locals, free_names.names[i])) visible = false;
+    }
+    
+    name_set_free(&callee_locals);
+    name_set_free(&free_names);
+    return visible;
+}
+
+static bool inline_allowed(InlineContext* ctx, InlineCandidate* candidate, ASTNode* call) {
+    if (candidate->recursive || candidate->redefined) return false;
+    if (candidate->decl == ctx->current_func) return false;
+    if (call->expr.call.arg_count != candidate->param_count) return false;
+    if (!inline_names_visible(ctx, candidate)) return false;
+    
+    // Functions with a single call site are always inlined
+    if (candidate->call_count == 1) return true;
+    
+    // Call sites inside loops are assumed hot and get a larger budget
+    int limit = INLINE_MAX_SIZE;
+    if (ctx->loop_depth > 0) limit *= INLINE_HOT_FACTOR;
+    return ast_node_count(candidate->decl->func.body) <= limit;
+}
+
+typedef struct {
+    FunctionParam* params;
+    ASTNode* arguments;
+} Substitution;
+
+static void substitute_visitor(ASTNode** slot, void* data) {
+    Substitution* sub = (Substitution*)data;
+    ASTNode* node = *slot;
+    const char* name = identifier_name(node);
+    
+    if (!name) {
+        ast_for_each_child(node, substitute_visitor, data);
+        return;
+    }
+    
+    FunctionParam* param = sub->params;
+    ASTNode* arg = sub->arguments;
+    for (; param && arg; param = param->next, arg = arg->next) {
+        if (strcmp(param->name, name) == 0) {
+            ASTNode* copy = clone_ast_node(arg);
+            copy->next = node->next;
+            free_ast_node(node);
+            *slot = copy;
+            return;
+        }
+    }
+}
+
+static void short_circuit_visitor(ASTNode** slot, void* data) {
+    ASTNode* node = *slot;
+    const char* op = node->type == NODE_BINARY_EXPR ? node->expr.binary.op : NULL;
+    
+    if (op && (strcmp(op, "and") == 0 || strcmp(op, "&&") == 0 ||
+               strcmp(op, "or") == 0 || strcmp(op, "||") == 0)) {
+        *(bool*)data = true;
+    }
+    ast_for_each_child(node, short_circuit_visitor, data);
+}
+
+// f(args) where f is { return expr }  =>  expr[params := args]
+// Each argument is evaluated where its parameter is read rather than
+// before the body, so that must not change the result:
+//  - a call in the body may change what an argument reads; only literals
+//    and names local to the call site (which the callee cannot see) are
+//    passed to such a body;
+//  - any other argument may fault (a division, say), so it must be read
+//    exactly once, not under and/or, and be the only one of its kind.
+static ASTNode* inline_expression(InlineContext* ctx, InlineCandidate* candidate, ASTNode* call) {
+    ASTNode* expr = inline_return_expr(candidate->decl);
+    if (!expr || count_nodes(expr, NODE_ASSIGNMENT, NULL) > 0) return NULL;
+    
+    bool calls = count_nodes(expr, NODE_CALL_EXPR, NULL) > 0;
+    bool short_circuit = false;
+    short_circuit_visitor(&expr, &short_circuit);
+    
+    int moved = 0;
+    FunctionParam* param = candidate->decl->func.params;
+    ASTNode* arg = call->expr.call.arguments;
+    for (; param && arg; param = param->next, arg = arg->next) {
+        if (arg->type == NODE_LITERAL) continue;
+        if (arg->type == NODE_IDENTIFIER) {
+            if (calls && !name_set_contains(&ctx->locals, arg->expr.identifier.identifier)) return NULL;
+            continue;
+        }
+        if (calls || short_circuit || !is_pure_expr(arg) || moved++ > 0 ||
+            count_nodes(expr, NODE_IDENTIFIER, param->name) != 1) {
+            return NULL;
+        }
+    }
+    
+    Substitution sub = {candidate->decl->func.params, call->expr.call.arguments};
+    ASTNode* result = clone_ast_node(expr);
+    substitute_visitor(&result, &sub);
+    return result;
+}
+
+typedef struct {
+    NameSet* names;
+    int id;
+} Renaming;
+
+static char* inline_local_name(int id, const char* name) {
+    // '$' cannot appear in Topo identifiers, so the names never clash
+    size_t size = strlen(name) + 32;
+    char* result = (char*)malloc(size);
+    if (result) snprintf(result, size, "$inl%d$%s", id, name);
+    return result;
+}
+
+static void rename_field(char** field, Renaming* renaming) {
+    if (!*field || !name_set_contains(renaming->names, *field)) return;
+    
+    char* renamed = inline_local_name(renaming->id, *field);
+    if (!renamed) return;
+    ast_free_string(*field);
+    *field = renamed;
+}
+
+static void rename_visitor(ASTNode** slot, void* data) {
+    ASTNode* node = *slot;
+    
+    if (node->type == NODE_IDENTIFIER) {
+        rename_field(&node->expr.identifier.identifier, (Renaming*)data);
+    } else if (node->type == NODE_VAR_DECL || node->type == NODE_CONST_DECL ||
+               node->type == NODE_FOR_STMT) {
+        rename_field(&node->name, (Renaming*)data);
+    }
+    ast_for_each_child(node, rename_visitor, data);
+}
+
+// f(args) as a statement  =>  { var p1 = a1 ... body }
+static ASTNode* inline_statement(InlineContext* ctx, InlineCandidate* candidate, ASTNode* stmt) {
+    ASTNode* call = stmt->expr.binary.left;
+    if (!inline_statement_form(candidate->decl)) return NULL;
+    
+    NameSet callee_locals = {0};
+    collect_function_locals(candidate->decl, &callee_locals);
+    Renaming renaming = {&callee_locals, ++ctx->rename_counter};
+    
+    ASTNode* statements = NULL;
+    ASTNode* last = NULL;
+    
+    // Bind arguments first, keeping their evaluation order
+    FunctionParam* param = candidate->decl->func.params;
+    ASTNode* arg = call->expr.call.arguments;
+    while (param && arg) {
+        ASTNode* next_arg = arg->next;
+        arg->next = NULL;
+        
+        char* name = inline_local_name(renaming.id, param->name);
+        ASTNode* binding = create_var_decl_node(name, arg, false, stmt->line, stmt->column);
+        free(name);
+        
+        if (!statements) {
+            statements = binding;
+        } else {
+            last->next = binding;
+        }
+        last = binding;
+        
+        param = param->next;
+        arg = next_arg;
+    }
+    call->expr.call.arguments = NULL;
+    call->expr.call.arg_count = 0;
+    
+    ASTNode* body = clone_ast_list(candidate->decl->func.body->block.statements);
+    for (ASTNode** slot = &body; *slot; slot = &(*slot)->next) {
+        rename_visitor(slot, &renaming);
+    }
+    name_set_free(&callee_locals);
+    
+    // The result of a trailing 'return' is discarded at a statement call
+    ASTNode** tail = &body;
+    while (*tail && (*tail)->next) tail = &(*tail)->next;
+    if (*tail && (*tail)->type == NODE_RETURN_STMT) {
+        ASTNode* ret = *tail;
+        ASTNode* value = ret->ret.value;
+        ret->ret.value = NULL;
+        
+        *tail = NULL;
+        if (value && !is_pure_expr(value)) {
+            *tail = create_expr_stmt_node(value, ret->line, ret->column);
+        } else {
+            free_ast_node(value);
+        }
+        free_ast_node(ret);
+    }
+    
+    if (!statements) {
+        statements = body;
+    } else {
+        last->next = body;
+    }
+    
+    return create_block_node(statements, stmt->line, stmt->column);
+}
+
+static void inline_visitor(ASTNode** slot, void* data) {
+    InlineContext* ctx = (InlineContext*)data;
+    ASTNode* node = *slot;
+    
+    // Visit children first so that arguments are already optimized
+    ASTNode* saved_func = ctx->current_func;
+    int saved_locals = ctx->locals.count;
+    int saved_loop_depth = ctx->loop_depth;
+    
+    if (node->type == NODE_FUNC_DECL) {
+        ctx->current_func = node;
+        ctx->loop_depth = 0;
+        collect_function_locals(node, &ctx->locals);
+    } else if (node->type == NODE_WHILE_STMT || node->type == NODE_FOR_STMT) {
+        ctx->loop_depth++;
+    }
+    
+    // Blocks and loops bind names at top level too, where they shadow the
+    // globals a callee uses
+    if (node->type == NODE_FOR_STMT) {
+        name_set_add(&ctx->locals, node->name);
+    } else if (node->type == NODE_BLOCK) {
+        for (ASTNode* stmt = node->block.statements; stmt; stmt = stmt->next) {
+            if (stmt->type == NODE_VAR_DECL || stmt->type == NODE_CONST_DECL ||
+                stmt->type == NODE_FUNC_DECL) {
+                name_set_add(&ctx->locals, stmt->name);
+            }
+        }
+    }
+    
+    ast_for_each_child(node, inline_visitor, data);
+    
+    ctx->current_func = saved_func;
+    ctx->locals.count = saved_locals;
+    ctx->loop_depth = saved_loop_depth;
+    
+    ASTNode* replacement = NULL;
+    if (node->type == NODE_CALL_EXPR) {
+        InlineCandidate* candidate = inline_find(ctx, call_name(node));
+        if (candidate && inline_allowed(ctx, candidate, node)) {
+            replacement = inline_expression(ctx, candidate, node);
+        }
+    } else if (node->type == NODE_EXPR_STMT) {
+        ASTNode* call = node->expr.binary.left;
+        InlineCandidate* candidate = inline_find(ctx, call_name(call));
+        if (candidate && inline_allowed(ctx, candidate, call)) {
+            replacement = inline_statement(ctx, candidate, node);
+        }
+    }
+    
+    if (!replacement) return;
+    
+    replacement->next = node->next;
+    node->next = NULL;
+    free_ast_node(node);
+    *slot = replacement;
+    ctx->inlined++;
+    
+    // Calls that came in with the inlined body
+    if (ctx->depth < INLINE_MAX_DEPTH) {
+        ctx->depth++;
+        inline_visitor(slot, data);
+        ctx->depth--;
+    }
+}
+
+int inline_functions(ASTNode* program) {
+    if (!program || program->type != NODE_PROGRAM) return 0;
+    
+    InlineContext ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    
+    int func_count = 0;
+    for (ASTNode* stmt = program->block.statements; stmt; stmt = stmt->next) {
+        if (stmt->type == NODE_FUNC_DECL && stmt->name) func_count++;
+    }
+    if (func_count == 0) return 0;
+    
+    ctx.candidates = (InlineCandidate*)calloc(func_count, sizeof(InlineCandidate));
+    if (!ctx.candidates) return 0;
+    
+    for (ASTNode* stmt = program->block.statements; stmt; stmt = stmt->next) {
+        if (stmt->type != NODE_FUNC_DECL || !stmt->name) continue;
+        
+        InlineCandidate* existing = inline_find(&ctx, stmt->name);
+        if (existing) {
+            existing->redefined = true;
+            continue;
+        }
+        
+        InlineCandidate* candidate = &ctx.candidates[ctx.count++];
+        candidate->decl = stmt;
+        for (FunctionParam* param = stmt->func.params; param; param = param->next) {
+            candidate->param_count++;
+        }
+    }
+    
+    ast_for_each_child(program, inline_scan_visitor, &ctx);
+    ast_for_each_child(program, inline_visitor, &ctx);
+    
+    name_set_free(&ctx.locals);
+    free(ctx.candidates);
+    return ctx.inlined;
+}
+
+// ================ CONSTANT FOLDING ================
+//
+// Integer + - * and unary minus with literal operands are evaluated here
+// (unary minus of float literals too). The common case stays on longs
+// with the overflow-checking builtins; a result that overflows is
+// recomputed with bignums and kept as a bigint literal (an int literal
+// again once it fits), so folding never wraps.
+//
+// The string built-ins find, count, replace, split and join are run here
+// too when their arguments are literals, and sorted() of an array literal
+// of ints, floats or strings is sorted here, unless the program declares
+// a name that shadows them. An import may bring in a function of the same
+// name, so a program with any import keeps all of these calls.
+
+static bool is_integer_literal(const ASTNode* node) {
+    return node && node->type == NODE_LITERAL &&
+           (node->expr.literal.data_type == TYPE_INT ||
+            (node->expr.literal.data_type == TYPE_BIGINT && node->expr.literal.value.bignum_val));
+}
+
+static BigNum* literal_to_bignum(const ASTNode* literal) {
+    if (literal->expr.literal.data_type == TYPE_INT) {
+        return bignum_from_long(literal->expr.literal.value.int_val);
+    }
+    return bignum_from_string(literal->expr.literal.value.bignum_val);
+}
+
+static ASTNode* bignum_to_literal(const BigNum* num, const ASTNode* at) {
+    long value;
+    if (bignum_to_long(num, &value)) {
+        return create_literal_node_int(value, at->line, at->column);
+    }
+    
+    char* digits = bignum_to_string(num);
+    ASTNode* literal = digits ? create_literal_node_bignum(digits, at->line, at->column) : NULL;
+    free(digits);
+    return literal;
+}
+
+static ASTNode* fold_binary(const ASTNode* node) {
+    const char* op = node->expr.binary.op;
+    ASTNode* left = node->expr.binary.left;
+    ASTNode* right = node->expr.binary.right;
+    
+    if (!op || strlen(op) != 1 || !strchr("+-*", op[0])) return NULL;
+    if (!is_integer_literal(left) || !is_integer_literal(right)) return NULL;
+    
+    // Fast path
+    if (left->expr.literal.data_type == TYPE_INT && right->expr.literal.data_type == TYPE_INT) {
+        long a = left->expr.literal.value.int_val;
+        long b = right->expr.literal.value.int_val;
+        long result;
+        bool overflow;
+        
+        switch (op[0]) {
+            case '+': overflow = __builtin_add_overflow(a, b, &result); break;
+            case '-': overflow = __builtin_sub_overflow(a, b, &result); break;
+            default: overflow = __builtin_mul_overflow(a, b, &result); break;
+        }
+        if (!overflow) return create_literal_node_int(result, node->line, node->column);
+    }
+    
+    BigNum* a = literal_to_bignum(left);
+    BigNum* b = literal_to_bignum(right);
+    BigNum* result = NULL;
+    
+    if (a && b) {
+        switch (op[0]) {
+            case '+': result = bignum_add(a, b); break;
+            case '-': result = bignum_sub(a, b); break;
+            default: result = bignum_mul(a, b); break;
+        }
+    }
+    
+    ASTNode* literal = result ? bignum_to_literal(result, node) : NULL;
+    bignum_destroy(a);
+    bignum_destroy(b);
+    bignum_destroy(result);
+    return literal;
+}
+
+static ASTNode* fold_unary(const ASTNode* node) {
+    ASTNode* operand = node->expr.unary.operand;
+    if (!node->expr.unary.op || strcmp(node->expr.unary.op, "-") != 0) return NULL;
+    
+    if (operand && operand->type == NODE_LITERAL && operand->expr.literal.data_type == TYPE_FLOAT) {
+        return create_literal_node_float(-operand->expr.literal.value.float_val, node->line, node->column);
+    }
+    if (!is_integer_literal(operand)) return NULL;
+    
+    if (operand->expr.literal.data_type == TYPE_INT && operand->expr.literal.value.int_val != LONG_MIN) {
+        return create_literal_node_int(-operand->expr.literal.value.int_val, node->line, node->column);
+    }
+    
+    BigNum* value = literal_to_bignum(operand);
+    BigNum* result = bignum_negate(value);
+    ASTNode* literal = result ? bignum_to_literal(result, node) : NULL;
+    bignum_destroy(value);
+    bignum_destroy(result);
+    return literal;
+}
+
+static const char* string_literal_value(const ASTNode* node) {
+    if (!node || node->type != NODE_LITERAL || node->expr.literal.data_type != TYPE_STRING) return NULL;
+    return node->expr.literal.value.string_val;
+}
+
+static ASTNode* string_literal_from(char* text, const ASTNode* at) {
+    if (!text) return NULL;
+    
+    // Takes ownership of 'text' instead of copying it again
+    ASTNode* literal = create_literal_node_string(NULL, at->line, at->column);
+    if (!literal) {
+        free(text);
+        return NULL;
+    }
+    literal->expr.literal.value.string_val = text;
+    return literal;
+}
+
+static ASTNode* fold_split(const char* text, const char* separator, const ASTNode* at) {
+    int count = 0;
+    StrView* pieces = str_split(text, strlen(text), separator, strlen(separator), &count);
+    if (!pieces) return NULL;
+    
+    ASTNode* array = create_array_literal_node(NULL, 0, at->line, at->column);
+    for (int i = 0; array && i < count; i++) {
+        char* piece = (char*)malloc(pieces[i].length + 1);
+        if (piece) {
+            memcpy(piece, pieces[i].data, pieces[i].length);
+            piece[pieces[i].length] = '\0';
+        }
+        
+        ASTNode* element = string_literal_from(piece, at);
+        if (!element) {
+            free_ast_node(array);
+            array = NULL;
+            break;
+        }
+        add_element_to_array(array, element);
+    }
+    
+    free(pieces);
+    return array;
+}
+
+static ASTNode* fold_join(const ASTNode* array, const char* separator, const ASTNode* at) {
+    if (!array || array->type != NODE_ARRAY_LITERAL) return NULL;
+    
+    int count = 0;
+    for (const ASTNode* element = array->expr.array.elements; element; element = element->next) {
+        if (!string_literal_value(element)) return NULL;
+        count++;
+    }
+    
+    StrView* parts = (StrView*)malloc((count ? count : 1) * sizeof(StrView));
+    if (!parts) return NULL;
+    
+    int i = 0;
+    for (const ASTNode* element = array->expr.array.elements; element; element = element->next, i++) {
+        parts[i].data = string_literal_value(element);
+        parts[i].length = strlen(parts[i].data);
+    }
+    
+    char* joined = str_join(parts, count, separator, strlen(separator), NULL);
+    free(parts);
+    return string_literal_from(joined, at);
+}
+
+static ASTNode* fold_string_call(const ASTNode* node, const NameSet* declared) {
+    const char* name = call_name(node);
+    if (!name || name_set_contains(declared, name)) return NULL;
+    
+    const ASTNode* args[4] = {NULL, NULL, NULL, NULL};
+    int arg_count = 0;
+    for (const ASTNode* arg = node->expr.call.arguments; arg; arg = arg->next) {
+        if (arg_count == 4) return NULL;
+        args[arg_count++] = arg;
+    }
+    
+    const char* a = string_literal_value(args[0]);
+    const char* b = string_literal_value(args[1]);
+    const char* c = string_literal_value(args[2]);
+    
+    if (strcmp(name, "find") == 0 && arg_count == 2 && a && b) {
+        size_t position = str_find(a, strlen(a), b, strlen(b), 0);
+        long index = position == STR_NOT_FOUND ? -1 : (long)position;
+        return create_literal_node_int(index, node->line, node->column);
+    }
+    if (strcmp(name, "count") == 0 && arg_count == 2 && a && b) {
+        return create_literal_node_int((long)str_count(a, strlen(a), b, strlen(b)), node->line, node->column);
+    }
+    if (strcmp(name, "replace") == 0 && arg_count == 3 && a && b && c) {
+        return string_literal_from(str_replace(a, strlen(a), b, strlen(b), c, strlen(c), NULL), node);
+    }
+    if (strcmp(name, "split") == 0 && arg_count == 2 && a && b && *b) {
+        return fold_split(a, b, node);
+    }
+    if (strcmp(name, "join") == 0 && arg_count == 2 && b) {
+        return fold_join(args[0], b, node);
+    }
+    return NULL;
+}
+
+static int64_t literal_sort_key(const void* element, void* data) {
+    (void)data;
+    const ASTNode* literal = *(const ASTNode* const*)element;
+    if (literal->expr.literal.data_type == TYPE_FLOAT) {
+        return sort_double_key(literal->expr.literal.value.float_val);
+    }
+    return (int64_t)literal->expr.literal.value.int_val;
+}
+
+static int literal_string_compare(const void* a, const void* b, void* data) {
+    (void)data;
+    const ASTNode* x = *(const ASTNode* const*)a;
+    const ASTNode* y = *(const ASTNode* const*)b;
+    return strcmp(x->expr.literal.value.string_val, y->expr.literal.value.string_val);
+}
+
+// sorted([literals]): reorders the array's own element nodes
+static ASTNode* fold_sorted(ASTNode* node, const NameSet* declared) {
+    const char* name = call_name(node);
+    ASTNode* array = node->expr.call.arguments;
+    if (!name || strcmp(name, "sorted") != 0 || name_set_contains(declared, name)) return NULL;
+    if (!array || array->next || array->type != NODE_ARRAY_LITERAL) return NULL;
+    
+    // Elements must all be ints, all floats or all strings
+    int count = 0;
+    DataType type = TYPE_NULL;
+    for (ASTNode* element = array->expr.array.elements; element; element = element->next) {
+        if (element->type != NODE_LITERAL) return NULL;
+        
+        DataType element_type = element->expr.literal.data_type;
+        if (element_type != TYPE_INT && element_type != TYPE_FLOAT && element_type != TYPE_STRING) return NULL;
+        if (count > 0 && element_type != type) return NULL;
+        if (element_type == TYPE_STRING && !element->expr.literal.value.string_val) return NULL;
+        type = element_type;
+        count++;
+    }
+    
+    ASTNode** elements = (ASTNode**)malloc((count ? count : 1) * sizeof(ASTNode*));
+    if (!elements) return NULL;
+    
+    int i = 0;
+    for (ASTNode* element = array->expr.array.elements; element; element = element->next) {
+        elements[i++] = element;
+    }
+    
+    if (type == TYPE_STRING) {
+        sort_values(elements, count, sizeof(ASTNode*), literal_string_compare, NULL);
+    } else if (!sort_by_key(elements, count, sizeof(ASTNode*), literal_sort_key, NULL)) {
+        free(elements);
+        return NULL;
+    }
+    
+    for (i = 0; i < count; i++) {
+        elements[i]->next = i + 1 < count ? elements[i + 1] : NULL;
+    }
+    array->expr.array.elements = count ? elements[0] : NULL;
+    free(elements);
+    
+    // The array outlives the call node
+    node->expr.call.arguments = NULL;
+    node->expr.call.arg_count = 0;
+    return array;
+}
+
+typedef struct {
+    NameSet declared;   // Every name the program declares
+    bool imports;       // Imported names may shadow the built-ins too
+    int folded;
+} FoldContext;
+
+static void fold_imports_visitor(ASTNode** slot, void* data) {
+    if ((*slot)->type == NODE_FROM_IMPORT) *(bool*)data = true;
+    ast_for_each_child(*slot, fold_imports_visitor, data);
+}
+
+static void fold_visitor(ASTNode** slot, void* data) {
+    FoldContext* ctx = (FoldContext*)data;
+    ASTNode* node = *slot;
+    ast_for_each_child(node, fold_visitor, data);
+    
+    ASTNode* replacement = NULL;
+    if (node->type == NODE_BINARY_EXPR) {
+        replacement = fold_binary(node);
+    } else if (node->type == NODE_UNARY_EXPR) {
+        replacement = fold_unary(node);
+    } else if (node->type == NODE_CALL_EXPR && !ctx->imports) {
+        replacement = fold_string_call(node, &ctx->declared);
+        if (!replacement) replacement = fold_sorted(node, &ctx->declared);
+    }
+    if (!replacement) return;
+    
+    replacement->next = node->next;
+    node->next = NULL;
+    free_ast_node(node);
+    *slot = replacement;
+    ctx->folded++;
+}
+
+int fold_constants(ASTNode* program) {
+    if (!program) return 0;
+    
+    FoldContext ctx = {{0}, false, 0};
+    ast_for_each_child(program, declared_names_visitor, &ctx.declared);
+    ast_for_each_child(program, fold_imports_visitor, &ctx.imports);
+    ast_for_each_child(program, fold_visitor, &ctx);
+    name_set_free(&ctx.declared);
+    return ctx.folded;
+}
+
+// ================ ESCAPE ANALYSIS ================
+//
+// An array or dict literal bound with 'var' escapes unless every use of
+// the variable inside its function is an element read/write with
+// p.key, p[key] or len(p). Non-escaping literals are marked for stack
+// allocation; when every key is a constant that the literal defines, the
+// container is replaced by one scalar variable per element ('p$0', 'p$x').
+
+typedef struct {
+    char* name;
+    ASTNode* decl;
+    int element_count;
+    bool escapes;
+    bool scalar;
+    bool ambiguous;   // The name is declared more than once
+} EscapeCandidate;
+
+typedef struct {
+    EscapeCandidate* items;
+    int count;
+    int capacity;
+    int nested;       // Depth inside nested function declarations
+} EscapeContext;
+
+static bool is_container_literal(const ASTNode* node) {
+    return node && (node->type == NODE_ARRAY_LITERAL || node->type == NODE_DICT_LITERAL);
+}
+
+static EscapeCandidate* escape_find(EscapeContext* ctx, const char* name) {
+    if (!name) return NULL;
+    for (int i = 0; i < ctx->count; i++) {
+        if (strcmp(ctx->items[i].name, name) == 0) return &ctx->items[i];
+    }
+    return NULL;
+}
+
+static void escape_add(EscapeContext* ctx, ASTNode* decl) {
+    EscapeCandidate* existing = escape_find(ctx, decl->name);
+    if (existing) {
+        existing->ambiguous = true;
+        return;
+    }
+    
+    if (ctx->count >= ctx->capacity) {
+        int capacity = ctx->capacity ? ctx->capacity * 2 : 8;
+        EscapeCandidate* items = (EscapeCandidate*)realloc(ctx->items, capacity * sizeof(EscapeCandidate));
+        if (!items) return;
+        ctx->items = items;
+        ctx->capacity = capacity;
+    }
+    
+    EscapeCandidate* candidate = &ctx->items[ctx->count++];
+    candidate->name = strdup(decl->name);
+    candidate->decl = decl;
+    candidate->element_count = 0;
+    candidate->escapes = false;
+    candidate->scalar = true;
+    candidate->ambiguous = false;
+}
+
+// Candidates are 'var' statements directly inside a block, so that the
+// scalar replacement can splice new declarations into the list
+static void escape_collect_visitor(ASTNode** slot, void* data) {
+    ASTNode* node = *slot;
+    
+    if (node->type == NODE_FUNC_DECL) return;
+    
+    if (node->type == NODE_BLOCK || node->type == NODE_PROGRAM) {
+        for (ASTNode* stmt = node->block.statements; stmt; stmt = stmt->next) {
+            if (stmt->type == NODE_VAR_DECL && stmt->name && is_container_literal(stmt->decl.value)) {
+                escape_add((EscapeContext*)data, stmt);
+            }
+        }
+    }
+    ast_for_each_child(node, escape_collect_visitor, data);
+}
+
+static void escape_declared_visitor(ASTNode** slot, void* data) {
+    EscapeContext* ctx = (EscapeContext*)data;
+    ASTNode* node = *slot;
+    
+    if (node->type == NODE_VAR_DECL || node->type == NODE_CONST_DECL ||
+        node->type == NODE_FOR_STMT || node->type == NODE_FUNC_DECL) {
+        EscapeCandidate* candidate = escape_find(ctx, node->name);
+        if (candidate && candidate->decl != node) candidate->ambiguous = true;
+    }
+    if (node->type == NODE_FUNC_DECL) {
+        for (FunctionParam* param = node->func.params; param; param = param->next) {
+            EscapeCandidate* candidate = escape_find(ctx, param->name);
+            if (candidate) candidate->ambiguous = true;
+        }
+    }
+    ast_for_each_child(node, escape_declared_visitor, data);
+}
+
+static int literal_key_index(const ASTNode* literal, const char* key) {
+    for (int i = 0; i < literal->expr.dict.pair_count; i++) {
+        if (strcmp(literal->expr.dict.keys[i], key) == 0) return i;
+    }
+    return -1;
+}
+
+// Constant key of an element access that exists in the literal
+// (array: int index in range, dict: defined string key)
+static bool escape_constant_key(const ASTNode* literal, const ASTNode* key) {
+    if (!key || key->type != NODE_LITERAL) return false;
+    
+    if (literal->type == NODE_ARRAY_LITERAL) {
+        return key->expr.literal.data_type == TYPE_INT &&
+               key->expr.literal.value.int_val >= 0 &&
+               key->expr.literal.value.int_val < literal->expr.array.element_count;
+    }
+    return key->expr.literal.data_type == TYPE_STRING &&
+           literal_key_index(literal, key->expr.literal.value.string_val) >= 0;
+}
+
+static EscapeCandidate* escape_len_use(EscapeContext* ctx, const ASTNode* node) {
+    const char* name = call_name(node);
+    if (!name || strcmp(name, "len") != 0 || node->expr.call.arg_count != 1) return NULL;
+    return escape_find(ctx, identifier_name(node->expr.call.arguments));
+}
+
+static void escape_use_visitor(ASTNode** slot, void* data) {
+    EscapeContext* ctx = (EscapeContext*)data;
+    ASTNode* node = *slot;
+    EscapeCandidate* candidate = NULL;
+    
+    switch (node->type) {
+        case NODE_FUNC_DECL:
+            // Anything captured by a nested function escapes
+            ctx->nested++;
+            ast_for_each_child(node, escape_use_visitor, data);
+            ctx->nested--;
+            return;
+            
+        case NODE_MEMBER_ACCESS:
+            candidate = escape_find(ctx, identifier_name(node->expr.member.object));
+            if (!candidate) break;
+            if (ctx->nested > 0) {
+                candidate->escapes = true;
+            } else if (candidate->decl->decl.value->type != NODE_DICT_LITERAL ||
+                       literal_key_index(candidate->decl->decl.value, node->expr.member.member) < 0) {
+                candidate->scalar = false;
+            }
+            return;
+            
+        case NODE_INDEX_ACCESS:
+            candidate = escape_find(ctx, identifier_name(node->expr.index.array));
+            if (!candidate) break;
+            if (ctx->nested > 0) {
+                candidate->escapes = true;
+            } else if (!escape_constant_key(candidate->decl->decl.value, node->expr.index.index)) {
+                candidate->scalar = false;
+            }
+            if (node->expr.index.index) escape_use_visitor(&node->expr.index.index, data);
+            return;
+            
+        case NODE_CALL_EXPR:
+            candidate = escape_len_use(ctx, node);
+            if (!candidate) break;
+            if (ctx->nested > 0) candidate->escapes = true;
+            return;
+            
+        case NODE_IDENTIFIER:
+            // Any other use (argument, return value, copy, iteration...)
+            candidate = escape_find(ctx, identifier_name(node));
+            if (candidate) candidate->escapes = true;
+            return;
+            
+        default:
+            break;
+    }
+    
+    ast_for_each_child(node, escape_use_visitor, data);
+}
+
+static char* escape_scalar_name(const char* name, const char* key) {
+    size_t size = strlen(name) + strlen(key) + 2;
+    char* result = (char*)malloc(size);
+    if (result) snprintf(result, size, "%s$%s", name, key);
+    return result;
+}
+
+static ASTNode* escape_scalar_node(EscapeCandidate* candidate, const char* key, ASTNode* at) {
+    char* name = escape_scalar_name(candidate->name, key);
+    ASTNode* node = create_identifier_node(name, at->line, at->column);
+    free(name);
+    return node;
+}
+
+// var p = [a, b]  =>  var p$0 = a  var p$1 = b
+static ASTNode* escape_split_decl(ASTNode* decl) {
+    ASTNode* literal = decl->decl.value;
+    ASTNode* head = NULL;
+    ASTNode* last = NULL;
+    
+    bool is_array = literal->type == NODE_ARRAY_LITERAL;
+    ASTNode* value = is_array ? literal->expr.array.elements : literal->expr.dict.values;
+    
+    for (int i = 0; value; i++) {
+        ASTNode* next_value = value->next;
+        value->next = NULL;
+        
+        char index[32];
+        snprintf(index, sizeof(index), "%d", i);
+        char* name = escape_scalar_name(decl->name, is_array ? index : literal->expr.dict.keys[i]);
+        ASTNode* scalar = create_var_decl_node(name, value, false, decl->line, decl->column);
+        free(name);
+        
+        if (!head) {
+            head = scalar;
+        } else {
+            last->next = scalar;
+        }
+        last = scalar;
+        value = next_value;
+    }
+    
+    if (is_array) {
+        literal->expr.array.elements = NULL;
+    } else {
+        literal->expr.dict.values = NULL;
+    }
+    return head;
+}
+
+static void escape_rewrite_visitor(ASTNode** slot, void* data) {
+    EscapeContext* ctx = (EscapeContext*)data;
+    ASTNode* node = *slot;
+    EscapeCandidate* candidate = NULL;
+    ASTNode* replacement = NULL;
+    char index[32];
+    
+    switch (node->type) {
+        case NODE_FUNC_DECL:
+            return;
+            
+        case NODE_PROGRAM:
+        case NODE_BLOCK:
+            for (ASTNode** stmt = &node->block.statements; *stmt; ) {
+                candidate = escape_find(ctx, (*stmt)->name);
+                if ((*stmt)->type != NODE_VAR_DECL || !candidate || candidate->decl != *stmt ||
+                    !candidate->scalar) {
+                    stmt = &(*stmt)->next;
+                    continue;
+                }
+                
+                ASTNode* decl = *stmt;
+                ASTNode* scalars = escape_split_decl(decl);
+                ASTNode* tail = scalars;
+                while (tail && tail->next) tail = tail->next;
+                
+                if (tail) {
+                    tail->next = decl->next;
+                    *stmt = scalars;
+                    stmt = &tail->next;
+                } else {
+                    *stmt = decl->next;
+                }
+                decl->next = NULL;
+                candidate->decl = NULL;
+                free_ast_node(decl);
+            }
+            break;
+            
+        case NODE_MEMBER_ACCESS:
+            candidate = escape_find(ctx, identifier_name(node->expr.member.object));
+            if (candidate && candidate->scalar) {
+                replacement = escape_scalar_node(candidate, node->expr.member.member, node);
+            }
+            break;
+            
+        case NODE_INDEX_ACCESS: {
+            candidate = escape_find(ctx, identifier_name(node->expr.index.array));
+            if (!candidate || !candidate->scalar) break;
+            
+            ASTNode* key = node->expr.index.index;
+            if (key->expr.literal.data_type == TYPE_INT) {
+                snprintf(index, sizeof(index), "%ld", key->expr.literal.value.int_val);
+                replacement = escape_scalar_node(candidate, index, node);
+            } else {
+                replacement = escape_scalar_node(candidate, key->expr.literal.value.string_val, node);
+            }
+            break;
+        }
+        
+        case NODE_CALL_EXPR:
+            candidate = escape_len_use(ctx, node);
+            if (candidate && candidate->scalar) {
+                replacement = create_literal_node_int(candidate->element_count, node->line, node->column);
+            }
+            break;
+            
+        default:
+            break;
+    }
+    
+    if (replacement) {
+        replacement->next = node->next;
+        node->next = NULL;
+        free_ast_node(node);
+        *slot = replacement;
+        return;
+    }
+    ast_for_each_child(node, escape_rewrite_visitor, data);
+}
+
+// Analyze the variables of one function (or of the top level)
+static int escape_analyze_scope(ASTNode* scope) {
+    EscapeContext ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    
+    ASTNode* body = scope->type == NODE_FUNC_DECL ? scope->func.body : scope;
+    if (!body) return 0;
+    
+    ASTNode* root = body;
+    escape_collect_visitor(&root, &ctx);
+    if (ctx.count == 0) return 0;
+    
+    root = scope;
+    escape_declared_visitor(&root, &ctx);
+    ast_for_each_child(scope, escape_use_visitor, &ctx);
+    
+    int optimized = 0;
+    for (int i = 0; i < ctx.count; i++) {
+        EscapeCandidate* candidate = &ctx.items[i];
+        ASTNode* literal = candidate->decl->decl.value;
+        
+        if (candidate->ambiguous) candidate->escapes = true;
+        if (candidate->escapes) {
+            candidate->scalar = false;
+            continue;
+        }
+        
+        if (literal->type == NODE_ARRAY_LITERAL) {
+            literal->expr.array.no_escape = true;
+            candidate->element_count = literal->expr.array.element_count;
+        } else {
+            literal->expr.dict.no_escape = true;
+            candidate->element_count = literal->expr.dict.pair_count;
+            
+            // Duplicate keys would need last-write-wins ordering
+            for (int k = 0; k < literal->expr.dict.pair_count && candidate->scalar; k++) {
+                if (literal_key_index(literal, literal->expr.dict.keys[k]) != k) {
+                    candidate->scalar = false;
+                }
+            }
+        }
+        optimized++;
+    }
+    
+    // Only non-escaping variables are left for the rewrite
+    int kept = 0;
+    for (int i = 0; i < ctx.count; i++) {
+        if (ctx.items[i].escapes) {
+            free(ctx.items[i].name);
+        } else {
+            ctx.items[kept++] = ctx.items[i];
+        }
+    }
+    ctx.count = kept;
+    
+    root = body;
+    escape_rewrite_visitor(&root, &ctx);
+    
+    for (int i = 0; i < ctx.count; i++) {
+        free(ctx.items[i].name);
+    }
+    free(ctx.items);
+    return optimized;
+}
+
+static void escape_scope_visitor(ASTNode** slot, void* data) {
+    if ((*slot)->type == NODE_FUNC_DECL) {
+        *(int*)data += escape_analyze_scope(*slot);
+    }
+    ast_for_each_child(*slot, escape_scope_visitor, data);
+}
+
+int escape_analysis(ASTNode* program) {
+    if (!program || program->type != NODE_PROGRAM) return 0;
+    
+    int optimized = escape_analyze_scope(program);
+    ast_for_each_child(program, escape_scope_visitor, &optimized);
+    return optimized;
+}
+
+// ================ BOUNDS CHECK ELIMINATION ================
+//
+// In 'for i in range(len(a))' (or range(start, len(a)) with a constant
+// start >= 0) every a[i] in the body is in bounds, provided that a is an
+// array, the body never reassigns i or a, never redeclares them, and
+// cannot resize a. a counts as an array when everything in the program
+// that binds its name binds an array literal (dicts and strings have a
+// len too, but their [i] means something else). Resizing is ruled out by
+// allowing only built-in calls that do not modify their arguments;
+// append/pop or any user function call (which could reach a through an
+// alias) keep the checks.
+
+static const char* const bce_safe_builtins[] = {
+    "console", "len", "type", "int", "float", "str", "bool", "keys", "values", "range", NULL
+};
+
+typedef struct {
+    const char* iterator;
+    const char* array;
+    bool safe;
+    int marked;
+} BoundsContext;
+
+static bool bce_safe_call(const ASTNode* call) {
+    const char* name = call_name(call);
+    if (!name) return false;
+    
+    for (int i = 0; bce_safe_builtins[i]; i++) {
+        if (strcmp(bce_safe_builtins[i], name) == 0) return true;
+    }
+    return false;
+}
+
+static bool bce_names_loop_var(const BoundsContext* ctx, const char* name) {
+    return name && (strcmp(name, ctx->iterator) == 0 || strcmp(name, ctx->array) == 0);
+}
+
+static void bce_check_visitor(ASTNode** slot, void* data) {
+    BoundsContext* ctx = (BoundsContext*)data;
+    ASTNode* node = *slot;
+    
+    switch (node->type) {
+        case NODE_FUNC_DECL:
+            ctx->safe = false;
+            return;
+            
+        case NODE_CALL_EXPR:
+            if (!bce_safe_call(node)) ctx->safe = false;
+            break;
+            
+        case NODE_ASSIGNMENT:
+            if (bce_names_loop_var(ctx, identifier_name(node->expr.assign.target))) {
+                ctx->safe = false;
+            }
+            break;
+            
+        case NODE_VAR_DECL:
+        case NODE_CONST_DECL:
+        case NODE_FOR_STMT:
+            if (bce_names_loop_var(ctx, node->name)) ctx->safe = false;
+            break;
+            
+        default:
+            break;
+    }
+    
+    if (ctx->safe) ast_for_each_child(node, bce_check_visitor, data);
+}
+
+static void bce_mark_visitor(ASTNode** slot, void* data) {
+    BoundsContext* ctx = (BoundsContext*)data;
+    ASTNode* node = *slot;
+    
+    if (node->type == NODE_INDEX_ACCESS) {
+        const char* array = identifier_name(node->expr.index.array);
+        const char* index = identifier_name(node->expr.index.index);
+        if (array && index && strcmp(array, ctx->array) == 0 &&
+            strcmp(index, ctx->iterator) == 0 && !node->expr.index.unchecked) {
+            node->expr.index.unchecked = true;
+            ctx->marked++;
+        }
+    }
+    ast_for_each_child(node, bce_mark_visitor, data);
+}
+
+typedef struct {
+    const char* name;
+    int arrays;         // Bindings of an array literal
+    bool other;         // Any other binding (parameter, loop, import, ...)
+} ArrayBindings;
+
+static void bce_binding_visitor(ASTNode** slot, void* data) {
+    ArrayBindings* bindings = (ArrayBindings*)data;
+    ASTNode* node = *slot;
+    
+    switch (node->type) {
+        case NODE_VAR_DECL:
+        case NODE_CONST_DECL:
+            if (node->name && strcmp(node->name, bindings->name) == 0) {
+                if (node->decl.value && node->decl.value->type == NODE_ARRAY_LITERAL) {
+                    bindings->arrays++;
+                } else {
+                    bindings->other = true;
+                }
+            }
+            break;
+            
+        case NODE_ASSIGNMENT: {
+            const char* target = identifier_name(node->expr.assign.target);
+            if (target && strcmp(target, bindings->name) == 0) {
+                if (!node->expr.assign.op && node->expr.assign.value->type == NODE_ARRAY_LITERAL) {
+                    bindings->arrays++;
+                } else {
+                    bindings->other = true;
+                }
+            }
+            break;
+        }
+            
+        case NODE_FOR_STMT:
+            if (node->name && strcmp(node->name, bindings->name) == 0) bindings->other = true;
+            break;
+            
+        case NODE_FUNC_DECL:
+            if (node->name && strcmp(node->name, bindings->name) == 0) bindings->other = true;
+            for (FunctionParam* param = node->func.params; param; param = param->next) {
+                if (strcmp(param->name, bindings->name) == 0) bindings->other = true;
+            }
+            break;
+            
+        case NODE_FROM_IMPORT:
+            if (node->import.import_all) bindings->other = true;
+            for (int i = 0; i < node->import.import_count; i++) {
+                if (strcmp(node->import.imports[i], bindings->name) == 0) bindings->other = true;
+            }
+            break;
+            
+        default:
+            break;
+    }
+    ast_for_each_child(node, bce_binding_visitor, data);
+}
+
+static bool bce_known_array(ASTNode* program, const char* name) {
+    ArrayBindings bindings = {name, 0, false};
+    bce_binding_visitor(&program, &bindings);
+    return bindings.arrays > 0 && !bindings.other;
+}
+
+// Name of 'a' when the loop iterates over range(len(a))
+static const char* bce_counted_array(const ASTNode* loop) {
+    const ASTNode* range = loop->loop.iterable;
+    const char* name = call_name(range);
+    if (!name || strcmp(name, "range") != 0) return NULL;
+    
+    const ASTNode* end = range->expr.call.arguments;
+    if (range->expr.call.arg_count == 2) {
+        const ASTNode* start = end;
+        if (start->type != NODE_LITERAL || start->expr.literal.data_type != TYPE_INT ||
+            start->expr.literal.value.int_val < 0) {
+            return NULL;
+        }
+        end = start->next;
+    } else if (range->expr.call.arg_count != 1) {
+        return NULL;
+    }
+    
+    name = call_name(end);
+    if (!name || strcmp(name, "len") != 0 || end->expr.call.arg_count != 1) return NULL;
+    return identifier_name(end->expr.call.arguments);
+}
+
+typedef struct {
+    ASTNode* program;
+    int marked;
+} BoundsPass;
+
+static void bce_visitor(ASTNode** slot, void* data) {
+    BoundsPass* pass = (BoundsPass*)data;
+    ASTNode* node = *slot;
+    ast_for_each_child(node, bce_visitor, data);
+    
+    if (node->type != NODE_FOR_STMT || !node->name) return;
+    
+    BoundsContext ctx = {node->name, bce_counted_array(node), true, 0};
+    if (!ctx.array || strcmp(ctx.array, ctx.iterator) == 0) return;
+    
+    bce_check_visitor(&node->loop.body, &ctx);
+    if (!ctx.safe || !bce_known_array(pass->program, ctx.array)) return;
+    
+    bce_mark_visitor(&node->loop.body, &ctx);
+    pass->marked += ctx.marked;
+}
+
+int eliminate_bounds_checks(ASTNode* program) {
+    if (!program) return 0;
+    
+    BoundsPass pass = {program, 0};
+    ast_for_each_child(program, bce_visitor, &pass);
+    return pass.marked;
+}
+
+// ================ COMPOUND ASSIGNMENT FUSION ================
+//
+// 'x = x + e' is rewritten to 'x += e' (likewise for - * / %), so that
+// accumulation loops use the single in-place update. The target must be
+// side-effect free: a variable, v.field or v[k] with a constant or
+// variable key, since the fused form evaluates it only once.
+
+static bool same_target(const ASTNode* a, const ASTNode* b) {
+    if (!a || !b || a->type != b->type) return false;
+    
+    switch (a->type) {
+        case NODE_IDENTIFIER:
+            return strcmp(identifier_name(a), identifier_name(b)) == 0;
+            
+        case NODE_MEMBER_ACCESS:
+            return a->expr.member.object->type == NODE_IDENTIFIER &&
+                   same_target(a->expr.member.object, b->expr.member.object) &&
+                   strcmp(a->expr.member.member, b->expr.member.member) == 0;
+            
+        case NODE_INDEX_ACCESS:
+            return a->expr.index.array->type == NODE_IDENTIFIER &&
+                   same_target(a->expr.index.array, b->expr.index.array) &&
+                   (same_target(a->expr.index.index, b->expr.index.index) ||
+                    same_literal(a->expr.index.index, b->expr.index.index));
+                    
+        default:
+            return false;
+    }
+}
+
+static void fuse_visitor(ASTNode** slot, void* data) {
+    ASTNode* node = *slot;
+    ast_for_each_child(node, fuse_visitor, data);
+    
+    if (node->type != NODE_ASSIGNMENT || node->expr.assign.op) return;
+    
+    ASTNode* value = node->expr.assign.value;
+    if (value->type != NODE_BINARY_EXPR || !value->expr.binary.op) return;
+    
+    const char* op = value->expr.binary.op;
+    if (strlen(op) != 1 || !strchr("+-*/%", op[0])) return;
+    if (!same_target(node->expr.assign.target, value->expr.binary.left)) return;
+    
+    char compound[3] = {op[0], '=', '\0'};
+    node->expr.assign.op = ast_strdup(compound);
+    node->expr.assign.value = value->expr.binary.right;
+    
+    value->expr.binary.right = NULL;
+    free_ast_node(value);
+    (*(int*)data)++;
+}
+
+int fuse_compound_assignments(ASTNode* program) {
+    if (!program) return 0;
+    
+    int fused = 0;
+    ast_for_each_child(program, fuse_visitor, &fused);
+    return fused;
+}
+
+// ================ DICT VIEWS ================
+//
+// 'for k in keys(d)' and 'for v in values(d)' walk d's entries in place
+// instead of first copying them into a new array, when nothing in the
+// loop can change d: the body may only read d (d.key, d[key], d[i:j],
+// len/keys/values(d), nested loops over it) and may call only built-ins
+// that cannot reach it. Anything else - assigning through d, passing it
+// to a function, aliasing it, calling user functions - keeps the copy.
+// len(keys(d)) and len(values(d)) become len(d).
+
+static const char* const view_safe_builtins[] = {
+    "console", "len", "keys", "values", "type", "int", "float", "str", "bool", "range", NULL
+};
+
+typedef struct {
+    const char* dict;   // Name of the iterated dict
+    bool safe;
+} ViewCheck;
+
+static bool view_safe_builtin(const char* name) {
+    for (int i = 0; name && view_safe_builtins[i]; i++) {
+        if (strcmp(name, view_safe_builtins[i]) == 0) return true;
+    }
+    return false;
+}
+
+// keys(d) / values(d) with d a plain name: which view, else VIEW_NONE
+static IterationView view_call(const ASTNode* node) {
+    const char* name = call_name(node);
+    if (!name || node->expr.call.arg_count != 1 || !identifier_name(node->expr.call.arguments)) {
+        return VIEW_NONE;
+    }
+    if (strcmp(name, "keys") == 0) return VIEW_KEYS;
+    if (strcmp(name, "values") == 0) return VIEW_VALUES;
+    return VIEW_NONE;
+}
+
+static bool names_dict(const ViewCheck* check, const ASTNode* node) {
+    const char* name = identifier_name(node);
+    return name && strcmp(name, check->dict) == 0;
+}
+
+static void view_check_visitor(ASTNode** slot, void* data) {
+    ViewCheck* check = (ViewCheck*)data;
+    ASTNode* node = *slot;
+    if (!check->safe) return;
+    
+    switch (node->type) {
+        case NODE_VAR_DECL:
+        case NODE_CONST_DECL:
+        case NODE_FUNC_DECL:
+        case NODE_FOR_STMT:
+            // Redeclaring the name hides the dict: give up rather than track scopes
+            if (node->name && strcmp(node->name, check->dict) == 0) {
+                check->safe = false;
+                return;
+            }
+            if (node->type == NODE_FOR_STMT && names_dict(check, node->loop.iterable)) {
+                if (node->loop.body) view_check_visitor(&node->loop.body, data);
+                return;
+            }
+            break;
+            
+        case NODE_ASSIGNMENT: {
+            ASTNode* target = node->expr.assign.target;
+            while (target->type == NODE_MEMBER_ACCESS || target->type == NODE_INDEX_ACCESS) {
+                if (target->type == NODE_MEMBER_ACCESS) {
+                    target = target->expr.member.object;
+                } else {
+                    target = target->expr.index.array;
+                }
+            }
+            if (names_dict(check, target)) {
+                check->safe = false;
+                return;
+            }
+            break;
+        }
+            
+        case NODE_MEMBER_ACCESS:
+            if (names_dict(check, node->expr.member.object)) return;
+            break;
+            
+        case NODE_INDEX_ACCESS:
+            if (names_dict(check, node->expr.index.array)) {
+                if (node->expr.index.index) view_check_visitor(&node->expr.index.index, data);
+                return;
+            }
+            break;
+            
+        case NODE_SLICE_EXPR:
+            if (names_dict(check, node->expr.slice.object)) {
+                if (node->expr.slice.start) view_check_visitor(&node->expr.slice.start, data);
+                if (node->expr.slice.end) view_check_visitor(&node->expr.slice.end, data);
+                return;
+            }
+            break;
+            
+        case NODE_CALL_EXPR: {
+            const char* name = call_name(node);
+            if (!view_safe_builtin(name)) {
+                check->safe = false;
+                return;
+            }
+            if (strcmp(name, "len") == 0 || view_call(node) != VIEW_NONE) {
+                if (node->expr.call.arg_count == 1 && names_dict(check, node->expr.call.arguments)) return;
+            }
+            break;
+        }
+            
+        case NODE_IDENTIFIER:
+            // Any other use may alias or hand out the dict
+            if (names_dict(check, node)) check->safe = false;
+            return;
+            
+        default:
+            break;
+    }
+    
+    ast_for_each_child(node, view_check_visitor, data);
+}
+
+// Replace a keys(d)/values(d) call in its slot by the bare d
+static void view_unwrap_call(ASTNode** slot) {
+    ASTNode* call = *slot;
+    ASTNode* dict = call->expr.call.arguments;
+    
+    call->expr.call.arguments = NULL;
+    call->expr.call.arg_count = 0;
+    dict->next = call->next;
+    call->next = NULL;
+    free_ast_node(call);
+    *slot = dict;
+}
+
+static void view_visitor(ASTNode** slot, void* data) {
+    ASTNode* node = *slot;
+    ast_for_each_child(node, view_visitor, data);
+    
+    // len(keys(d)) -> len(d)
+    const char* name = call_name(node);
+    if (name && strcmp(name, "len") == 0 && node->expr.call.arg_count == 1 &&
+        view_call(node->expr.call.arguments) != VIEW_NONE) {
+        view_unwrap_call(&node->expr.call.arguments);
+        (*(int*)data)++;
+        return;
+    }
+    
+    if (node->type != NODE_FOR_STMT || node->loop.view != VIEW_NONE) return;
+    
+    IterationView view = view_call(node->loop.iterable);
+    if (view == VIEW_NONE) return;
+    
+    ViewCheck check = {identifier_name(node->loop.iterable->expr.call.arguments), true};
+    if (node->name && strcmp(node->name, check.dict) == 0) return;
+    if (node->loop.body) view_check_visitor(&node->loop.body, &check);
+    if (!check.safe) return;
+    
+    view_unwrap_call(&node->loop.iterable);
+    node->loop.view = view;
+    (*(int*)data)++;
+}
+
+int iterate_dict_views(ASTNode* program) {
+    if (!program) return 0;
+    
+    int rewritten = 0;
+    ast_for_each_child(program, view_visitor, &rewritten);
+    return rewritten;
+}
+
+// ================ CONSTANT DICT TABLES ================
+//
+// A dict literal bound with 'const' that is only ever read - d.key,
+// d[key], d[i:j], len/keys/values(d) or 'for k in d' - gets a minimal
+// perfect hash of its keys, built here once instead of on every run.
+// Any other use of the name (assignment through it, passing it to a
+// function, aliasing, redeclaring it) leaves the dict alone.
+
+static const char* const table_read_builtins[] = {
+    "len", "keys", "values", NULL
+};
+
+typedef struct {
+    const char* name;   // Borrowed from the declaration
+    ASTNode* literal;
+    bool mutated;
+} ConstTable;
+
+typedef struct {
+    ConstTable* items;
+    int count;
+    int capacity;
+} ConstTableContext;
+
+static ConstTable* table_find(ConstTableContext* ctx, const char* name) {
+    if (!name) return NULL;
+    for (int i = 0; i < ctx->count; i++) {
+        if (strcmp(ctx->items[i].name, name) == 0) return &ctx->items[i];
+    }
+    return NULL;
+}
+
+static void table_add(ConstTableContext* ctx, ASTNode* decl) {
+    ConstTable* existing = table_find(ctx, decl->name);
+    if (existing) {
+        existing->mutated = true;
+        return;
+    }
+    
+    if (ctx->count >= ctx->capacity) {
+        int capacity = ctx->capacity ? ctx->capacity * 2 : 8;
+        ConstTable* items = (ConstTable*)realloc(ctx->items, capacity * sizeof(ConstTable));
+        if (!items) return;
+        ctx->items = items;
+        ctx->capacity = capacity;
+    }
+    
+    ConstTable* table = &ctx->items[ctx->count++];
+    table->name = decl->name;
+    table->literal = decl->decl.value;
+    table->mutated = false;
+}
+
+static void table_collect_visitor(ASTNode** slot, void* data) {
+    ASTNode* node = *slot;
+    
+    if (node->type == NODE_CONST_DECL && node->name && node->decl.value &&
+        node->decl.value->type == NODE_DICT_LITERAL &&
+        node->decl.value->expr.dict.pair_count >= PHASH_MIN_KEYS) {
+        table_add((ConstTableContext*)data, node);
+    }
+    ast_for_each_child(node, table_collect_visitor, data);
+}
+
+static void table_mark(ConstTableContext* ctx, const char* name) {
+    ConstTable* table = table_find(ctx, name);
+    if (table) table->mutated = true;
+}
+
+static bool table_read_call(ConstTableContext* ctx, const ASTNode* call) {
+    const char* name = call_name(call);
+    if (!name || call->expr.call.arg_count != 1) return false;
+    
+    for (int i = 0; table_read_builtins[i]; i++) {
+        if (strcmp(name, table_read_builtins[i]) == 0) {
+            return table_find(ctx, identifier_name(call->expr.call.arguments)) != NULL;
+        }
+    }
+    return false;
+}
+
+static void table_use_visitor(ASTNode** slot, void* data) {
+    ConstTableContext* ctx = (ConstTableContext*)data;
+    ASTNode* node = *slot;
+    ASTNode* target = NULL;
+    
+    switch (node->type) {
+        case NODE_VAR_DECL:
+        case NODE_CONST_DECL: {
+            ConstTable* table = table_find(ctx, node->name);
+            if (table && table->literal != node->decl.value) table->mutated = true;
+            break;
+        }
+            
+        case NODE_FUNC_DECL:
+            table_mark(ctx, node->name);
+            for (FunctionParam* param = node->func.params; param; param = param->next) {
+                table_mark(ctx, param->name);
+            }
+            break;
+            
+        case NODE_FOR_STMT:
+            table_mark(ctx, node->name);
+            if (table_find(ctx, identifier_name(node->loop.iterable))) {
+                if (node->loop.body) table_use_visitor(&node->loop.body, data);
+                return;
+            }
+            break;
+            
+        case NODE_ASSIGNMENT:
+            target = node->expr.assign.target;
+            if (target->type == NODE_MEMBER_ACCESS) target = target->expr.member.object;
+            else if (target->type == NODE_INDEX_ACCESS) target = target->expr.index.array;
+            table_mark(ctx, identifier_name(target));
+            break;
+            
+        case NODE_MEMBER_ACCESS:
+            if (table_find(ctx, identifier_name(node->expr.member.object))) return;
+            break;
+            
+        case NODE_INDEX_ACCESS:
+            if (table_find(ctx, identifier_name(node->expr.index.array))) {
+                if (node->expr.index.index) table_use_visitor(&node->expr.index.index, data);
+                return;
+            }
+            break;
+            
+        case NODE_SLICE_EXPR:
+            if (table_find(ctx, identifier_name(node->expr.slice.object))) {
+                if (node->expr.slice.start) table_use_visitor(&node->expr.slice.start, data);
+                if (node->expr.slice.end) table_use_visitor(&node->expr.slice.end, data);
+                return;
+            }
+            break;
+            
+        case NODE_CALL_EXPR:
+            if (table_read_call(ctx, node)) return;
+            break;
+            
+        case NODE_IDENTIFIER:
+            table_mark(ctx, identifier_name(node));
+            return;
+            
+        default:
+            break;
+    }
+    
+    ast_for_each_child(node, table_use_visitor, data);
+}
+
+int build_constant_tables(ASTNode* program) {
+    if (!program) return 0;
+    
+    ConstTableContext ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    
+    ASTNode* root = program;
+    table_collect_visitor(&root, &ctx);
+    if (ctx.count > 0) table_use_visitor(&root, &ctx);
+    
+    int built = 0;
+    for (int i = 0; i < ctx.count; i++) {
+        ASTNode* literal = ctx.items[i].literal;
+        if (ctx.items[i].mutated || literal->expr.dict.phash) continue;
+        
+        // Fails (and leaves the dict alone) when keys repeat
+        literal->expr.dict.phash = phash_build(literal->expr.dict.keys, literal->expr.dict.pair_count);
+        if (literal->expr.dict.phash) built++;
+    }
+    
+    free(ctx.items);
+    return built;
+}
+
+// ================ IF/ELIF DISPATCH ================
+//
+// An if/elif chain whose every arm compares the same side-effect free
+// value with literals ('x == 1', '"a" == x', or several of these joined
+// by 'or') gets a table from literal to arm, so that a dispatch costs one
+// lookup instead of one test per arm. The labels must be all ints or all
+// strings; a label repeated in a later arm keeps the first arm, as the
+// chain would. The arms themselves are left in place.
+
+typedef struct {
+    const ASTNode* subject;   // Borrowed from the first comparison
+    bool is_string;
+    bool failed;
+    long* values;
+    char** keys;              // Borrowed from the literals
+    int* arms;
+    int count;
+    int capacity;
+} DispatchLabels;
+
+// Structural equality of two side-effect free expressions
+static bool same_expr(const ASTNode* a, const ASTNode* b) {
+    if (!a || !b) return a == b;
+    if (a->type != b->type) return false;
+    
+    switch (a->type) {
+        case NODE_LITERAL:
+            return same_literal(a, b);
+        case NODE_IDENTIFIER:
+            return identifier_name(a) && identifier_name(b) &&
+                   strcmp(identifier_name(a), identifier_name(b)) == 0;
+        case NODE_MEMBER_ACCESS:
+            return strcmp(a->expr.member.member, b->expr.member.member) == 0 &&
+                   same_expr(a->expr.member.object, b->expr.member.object);
+        case NODE_UNARY_EXPR:
+            return strcmp(a->expr.unary.op, b->expr.unary.op) == 0 &&
+                   same_expr(a->expr.unary.operand, b->expr.unary.operand);
+        case NODE_BINARY_EXPR:
+            return strcmp(a->expr.binary.op, b->expr.binary.op) == 0 &&
+                   same_expr(a->expr.binary.left, b->expr.binary.left) &&
+                   same_expr(a->expr.binary.right, b->expr.binary.right);
+        default:
+            return false;
+    }
+}
+
+// Field reads are fine too: the conditions run back to back, with
+// nothing in between that could change the value
+static bool dispatch_subject_ok(const ASTNode* node) {
+    if (!node || node->type == NODE_LITERAL) return false;
+    if (node->type == NODE_MEMBER_ACCESS) {
+        return node->expr.member.member &&
+               (node->expr.member.object->type == NODE_MEMBER_ACCESS ||
+                node->expr.member.object->type == NODE_IDENTIFIER) &&
+               dispatch_subject_ok(node->expr.member.object);
+    }
+    return is_pure_expr(node);
+}
+
+static bool dispatch_label_ok(const ASTNode* node) {
+    return node && node->type == NODE_LITERAL &&
+           (node->expr.literal.data_type == TYPE_INT ||
+            (node->expr.literal.data_type == TYPE_STRING && node->expr.literal.value.string_val));
+}
+
+static void dispatch_add(DispatchLabels* labels, const ASTNode* literal, int arm) {
+    bool is_string = literal->expr.literal.data_type == TYPE_STRING;
+    if (labels->count > 0 && is_string != labels->is_string) {
+        labels->failed = true;
+        return;
+    }
+    labels->is_string = is_string;
+    
+    // A repeated label is unreachable in the later arm
+    for (int i = 0; i < labels->count; i++) {
+        if (is_string ? strcmp(labels->keys[i], literal->expr.literal.value.string_val) == 0
+                      : labels->values[i] == literal->expr.literal.value.int_val) {
+            return;
+        }
+    }
+    
+    if (labels->count >= labels->capacity) {
+        int capacity = labels->capacity ? labels->capacity * 2 : 16;
+        long* values = (long*)realloc(labels->values, capacity * sizeof(long));
+        if (values) labels->values = values;
+        char** keys = (char**)realloc(labels->keys, capacity * sizeof(char*));
+        if (keys) labels->keys = keys;
+        int* arms = (int*)realloc(labels->arms, capacity * sizeof(int));
+        if (arms) labels->arms = arms;
+        if (!values || !keys || !arms) {
+            labels->failed = true;
+            return;
+        }
+        labels->capacity = capacity;
+    }
+    
+    labels->values[labels->count] = is_string ? 0 : literal->expr.literal.value.int_val;
+    labels->keys[labels->count] = is_string ? literal->expr.literal.value.string_val : NULL;
+    labels->arms[labels->count] = arm;
+    labels->count++;
+}
+
+static void dispatch_collect(DispatchLabels* labels, const ASTNode* condition, int arm) {
+    if (labels->failed) return;
+    
+    if (!condition || condition->type != NODE_BINARY_EXPR || !condition->expr.binary.op) {
+        labels->failed = true;
+        return;
+    }
+    
+    const char* op = condition->expr.binary.op;
+    if (strcmp(op, "or") == 0 || strcmp(op, "||") == 0) {
+        dispatch_collect(labels, condition->expr.binary.left, arm);
+        dispatch_collect(labels, condition->expr.binary.right, arm);
+        return;
+    }
+    
+    const ASTNode* subject = condition->expr.binary.left;
+    const ASTNode* literal = condition->expr.binary.right;
+    if (!dispatch_label_ok(literal)) {
+        subject = condition->expr.binary.right;
+        literal = condition->expr.binary.left;
+    }
+    
+    if (strcmp(op, "==") != 0 || !dispatch_label_ok(literal) ||
+        !(labels->subject ? same_expr(labels->subject, subject) : dispatch_subject_ok(subject))) {
+        labels->failed = true;
+        return;
+    }
+    
+    labels->subject = subject;
+    dispatch_add(labels, literal, arm);
+}
+
+static bool dispatch_chain(ASTNode* node) {
+    int arm_count = 1;
+    for (ASTNode* elif = node->flow.elif_branches; elif; elif = elif->next) {
+        arm_count++;
+    }
+    if (arm_count < DISPATCH_MIN_ARMS) return false;
+    
+    DispatchLabels labels;
+    memset(&labels, 0, sizeof(labels));
+    
+    dispatch_collect(&labels, node->flow.condition, 0);
+    int arm = 1;
+    for (ASTNode* elif = node->flow.elif_branches; elif; elif = elif->next) {
+        dispatch_collect(&labels, elif->flow.condition, arm++);
+    }
+    
+    if (!labels.failed) {
+        node->flow.dispatch = labels.is_string
+            ? dispatch_build_string(labels.keys, labels.arms, labels.count)
+            : dispatch_build_int(labels.values, labels.arms, labels.count);
+        if (node->flow.dispatch) node->flow.subject = clone_ast_node(labels.subject);
+    }
+    
+    free(labels.values);
+    free(labels.keys);
+    free(labels.arms);
+    return node->flow.dispatch != NULL;
+}
+
+static void dispatch_visitor(ASTNode** slot, void* data) {
+    ASTNode* node = *slot;
+    ast_for_each_child(node, dispatch_visitor, data);
+    
+    if (node->type == NODE_IF_STMT && !node->flow.dispatch && dispatch_chain(node)) {
+        (*(int*)data)++;
+    }
+}
+
+int dispatch_if_chains(ASTNode* program) {
+    if (!program) return 0;
+    
+    int built = 0;
+    ast_for_each_child(program, dispatch_visitor, &built);
+    return built;
+}
+
+// ================ CONDITION LOWERING ================
+//
+// In 'if', 'elif' and 'while' conditions only the truth of the result
+// matters, so and/or/not can become jumps instead of boolean values:
+// 'not' is pushed down to the leaves (De Morgan, '==' <-> '!=', 'not not
+// x' => x), constant operands are folded ('true and x' => x), and the
+// remaining and/or nodes are marked as branch chains. An 'if not c'
+// with an else and no elifs swaps its branches instead.
+
+static bool is_op(const char* op, const char* word, const char* symbol) {
+    return op && (strcmp(op, word) == 0 || strcmp(op, symbol) == 0);
+}
+
+static bool is_not_expr(const ASTNode* node) {
+    return node && node->type == NODE_UNARY_EXPR && is_op(node->expr.unary.op, "not", "!");
+}
+
+static bool is_logical_expr(const ASTNode* node) {
+    return node && node->type == NODE_BINARY_EXPR &&
+           (is_op(node->expr.binary.op, "and", "&&") || is_op(node->expr.binary.op, "or", "||"));
+}
+
+static bool is_bool_literal(const ASTNode* node) {
+    return node && node->type == NODE_LITERAL && node->expr.literal.data_type == TYPE_BOOL;
+}
+
+// Replace a node's operator, keeping the spelling (word or symbol)
+static void set_op(char** op, const char* word, const char* symbol) {
+    const char* replacement = isalpha((unsigned char)(*op)[0]) ? word : symbol;
+    ast_free_string(*op);
+    *op = ast_strdup(replacement);
+}
+
+// Detach the operand of a unary node and free the node
+static ASTNode* unwrap_unary(ASTNode* node) {
+    ASTNode* operand = node->expr.unary.operand;
+    node->expr.unary.operand = NULL;
+    free_ast_node(node);
+    return operand;
+}
+
+// Detach one side of a binary node and free the rest
+static ASTNode* unwrap_binary(ASTNode* node, bool keep_left) {
+    ASTNode* kept = keep_left ? node->expr.binary.left : node->expr.binary.right;
+    if (keep_left) {
+        node->expr.binary.left = NULL;
+    } else {
+        node->expr.binary.right = NULL;
+    }
+    free_ast_node(node);
+    return kept;
+}
+
+// Condition that is true when 'node' is false (takes ownership)
+static ASTNode* negate_condition(ASTNode* node, int* rewrites) {
+    if (is_not_expr(node)) {
+        (*rewrites)++;
+        return unwrap_unary(node);
+    }
+    
+    if (is_bool_literal(node)) {
+        node->expr.literal.value.bool_val = !node->expr.literal.value.bool_val;
+        (*rewrites)++;
+        return node;
+    }
+    
+    if (node->type == NODE_BINARY_EXPR && node->expr.binary.op) {
+        char** op = &node->expr.binary.op;
+        if (is_op(*op, "and", "&&") || is_op(*op, "or", "||")) {
+            if (is_op(*op, "and", "&&")) {
+                set_op(op, "or", "||");
+            } else {
+                set_op(op, "and", "&&");
+            }
+            node->expr.binary.left = negate_condition(node->expr.binary.left, rewrites);
+            node->expr.binary.right = negate_condition(node->expr.binary.right, rewrites);
+            (*rewrites)++;
+            return node;
+        }
+        
+        // Only equality: 'not (a < b)' is not 'a >= b' when a or b is NaN
+        if (strcmp(*op, "==") == 0 || strcmp(*op, "!=") == 0) {
+            const char* flipped = strcmp(*op, "==") == 0 ? "!=" : "==";
+            ast_free_string(*op);
+            *op = ast_strdup(flipped);
+            (*rewrites)++;
+            return node;
+        }
+    }
+    
+    return create_unary_expr_node("not", node, node->line, node->column);
+}
+
+// Fold a constant operand of and/or (in condition position the value
+// itself is never observed, only its truth)
+static ASTNode* fold_logical(ASTNode* node, int* rewrites) {
+    bool is_and = is_op(node->expr.binary.op, "and", "&&");
+    ASTNode* left = node->expr.binary.left;
+    ASTNode* right = node->expr.binary.right;
+    
+    if (is_bool_literal(left)) {
+        (*rewrites)++;
+        
+        // 'true and x' => x, 'false or x' => x, otherwise the literal decides
+        bool keep_right = left->expr.literal.value.bool_val == is_and;
+        return unwrap_binary(node, !keep_right);
+    }
+    
+    if (is_bool_literal(right) && right->expr.literal.value.bool_val == is_and) {
+        // 'x and true' => x, 'x or false' => x
+        (*rewrites)++;
+        return unwrap_binary(node, true);
+    }
+    
+    node->expr.binary.branch = true;
+    return node;
+}
+
+// Lower a condition (takes ownership, returns its replacement)
+static ASTNode* lower_condition(ASTNode* node, int* rewrites) {
+    if (!node) return NULL;
+    
+    if (is_not_expr(node)) {
+        ASTNode* operand = lower_condition(unwrap_unary(node), rewrites);
+        
+        // The operand is already lowered, and negating keeps it that way
+        return negate_condition(operand, rewrites);
+    }
+    
+    if (is_logical_expr(node)) {
+        node->expr.binary.left = lower_condition(node->expr.binary.left, rewrites);
+        node->expr.binary.right = lower_condition(node->expr.binary.right, rewrites);
+        return fold_logical(node, rewrites);
+    }
+    
+    return node;
+}
+
+static void lower_visitor(ASTNode** slot, void* data) {
+    ASTNode* node = *slot;
+    int* rewrites = (int*)data;
+    ast_for_each_child(node, lower_visitor, data);
+    
+    if (node->type != NODE_IF_STMT && node->type != NODE_ELIF_STMT &&
+        node->type != NODE_WHILE_STMT) {
+        return;
+    }
+    if (!node->flow.condition || node->flow.dispatch) return;
+    
+    node->flow.condition = lower_condition(node->flow.condition, rewrites);
+    
+    // if not c { A } else { B }  =>  if c { B } else { A }
+    if (node->type == NODE_IF_STMT && is_not_expr(node->flow.condition) &&
+        node->flow.else_branch && !node->flow.elif_branches) {
+        ASTNode* then_branch = node->flow.then_branch;
+        node->flow.condition = unwrap_unary(node->flow.condition);
+        node->flow.then_branch = node->flow.else_branch;
+        node->flow.else_branch = then_branch;
+        (*rewrites)++;
+    }
+}
+
+int lower_conditions(ASTNode* program) {
+    if (!program) return 0;
+    
+    int rewrites = 0;
+    ast_for_each_child(program, lower_visitor, &rewrites);
+    return rewrites;
+}
+
+// ================ PASS PIPELINE ================
+
+bool optimize_program(ASTNode* program) {
+    if (!program || program->type != NODE_PROGRAM) return true;
+    
+    // The passes reason about the whole program, skimmed bodies included
+    if (!parse_function_bodies(program)) return false;
+    
+    // Inlining runs first so that the following passes see through calls
+    inline_functions(program);
+    fold_constants(program);
+    escape_analysis(program);
+    eliminate_bounds_checks(program);
+    fuse_compound_assignments(program);
+    lower_conditions(program);
+    iterate_dict_views(program);
+    build_constant_tables(program);
+    dispatch_if_chains(program);
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "ast.h"
+
+// ================ OPTIMIZER LIMITS ================
+#define INLINE_MAX_SIZE 24      // Max body size (in nodes) for functions with several call sites
+#define INLINE_HOT_FACTOR 2     // Size limit multiplier for call sites inside loops
+#define INLINE_MAX_DEPTH 3      // Max nesting of inlined calls (guards mutual recursion)
+#define PHASH_MIN_KEYS 4        // Smallest constant dict that gets a perfect hash table
+#define DISPATCH_MIN_ARMS 4     // Shortest if/elif chain that gets a dispatch table
+
+// Run all optimization passes on a parsed program (in place); skimmed
+// function bodies are parsed first. False, with no pass run, if one of
+// them does not parse.
+bool optimize_program(ASTNode* program);
+
+// Individual passes (each returns the number of rewrites it made)
+int inline_functions(ASTNode* program);
+int fold_constants(ASTNode* program);
+int escape_analysis(ASTNode* program);
+int eliminate_bounds_checks(ASTNode* program);
+int fuse_compound_assignments(ASTNode* program);
+int lower_conditions(ASTNode* program);
+int iterate_dict_views(ASTNode* program);
+int build_constant_tables(ASTNode* program);
+int dispatch_if_chains(ASTNode* program);
+
+#endif // OPTIMIZER_H
\ No newline at end of file
@@ -1,21 +1,35 @@
-#ifndef PARSER_H
-#define PARSER_H
-
-#include "ast.h"
-
-// Парсинг целой программы
-ASTNode* parse_program(Parser* parser);
-
-// Парсинг выражений (объявим для использования в parser.c)
-ASTNode* parse_expression(Parser* parser);
-ASTNode* parse_block(Parser* parser);
-ASTNode* parse_statement(Parser* parser);
-
-// Создание парсера
-Parser* parser_create(Lexer* lexer);
-void parser_destroy(Parser* parser);
-
-// Основная функция парсинга
-ASTNode* parse_source(const char* source, const char* filename);
-
+#ifndef PARSER_H
+#define PARSER_H
+
+#include "ast.h"
+
+typedef struct Parser Parser;
+
+// Парсинг целой программы
+ASTNode* parse_program(Parser* parser);
+
+// Парсинг выражений (объявим для использования в parser.c)
+ASTNode* parse_expression(Parser* parser);
+ASTNode* parse_block(Parser* parser);
+ASTNode* parse_statement(Parser* parser);
+
+// Создание парсера
+Parser* parser_create(Lexer* lexer);
+void parser_destroy(Parser* parser);
+
+// Основная функция парсинга
+ASTNode* parse_source(const char* source, const char* filename);
+
+// Lazy parsing: function bodies are only skimmed, and each is parsed the
+// first time parse_function_body asks for it. The optimizer, the .topoc
+// writer and the subtree store parse whatever is left before they start.
+ASTNode* parse_source_lazy(const char* source, const char* filename);
+
+// The body of 'func', parsed now if it was skimmed; NULL if it does not
+// parse (the error is reported and the function is left without a body)
+ASTNode* parse_function_body(ASTNode* func);
+
+// Parse every skimmed body under 'node'; false if any of them failed
+bool parse_function_bodies(ASTNode* node);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,168 @@
+/**
+ * Minimal perfect hash tables for Topo Programming Language
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "phash.h"
+
+// ================ HASHING ================
+
+// FNV-1a, seeded so that each bucket can pick its own hash function
+static uint32_t phash_hash(const char* key, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed;
+    for (const unsigned char* p = (const unsigned char*)key; *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    
+    // Final avalanche, FNV alone mixes the low bits poorly
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    return hash;
+}
+
+// ================ BUILDING ================
+
+typedef struct {
+    int bucket;
+    int count;
+    int* keys;            // Key indices in this bucket
+} PerfectHashBucket;
+
+static int phash_bucket_compare(const void* a, const void* b) {
+    const PerfectHashBucket* x = (const PerfectHashBucket*)a;
+    const PerfectHashBucket* y = (const PerfectHashBucket*)b;
+    if (x->count != y->count) return y->count - x->count;
+    return x->bucket - y->bucket;
+}
+
+// Find a seed that sends every key of the bucket to a distinct free slot
+static bool phash_place_bucket(PerfectHash* table, char** keys, PerfectHashBucket* bucket, int* placed) {
+    for (uint32_t seed = 1; seed <= PHASH_MAX_ATTEMPTS; seed++) {
+        int k;
+        for (k = 0; k < bucket->count; k++) {
+            int slot = (int)(phash_hash(keys[bucket->keys[k]], seed) % (uint32_t)table->size);
+            if (table->slots[slot] >= 0) break;
+            
+            // Claim the slot now so that later keys of the bucket collide with it
+            table->slots[slot] = bucket->keys[k];
+            placed[k] = slot;
+        }
+        
+        if (k == bucket->count) {
+            table->seeds[bucket->bucket] = seed;
+            return true;
+        }
+        
+        while (k-- > 0) {
+            table->slots[placed[k]] = -1;
+        }
+    }
+    
+    return false;
+}
+
+PerfectHash* phash_build(char** keys, int count) {
+    if (!keys || count <= 0) return NULL;
+    
+    PerfectHash* table = (PerfectHash*)calloc(1, sizeof(PerfectHash));
+    if (!table) return NULL;
+    
+    // About four keys per bucket keeps the tables small and builds fast
+    table->size = count;
+    table->bucket_count = (count + 3) / 4;
+    table->seeds = (uint32_t*)calloc(table->bucket_count, sizeof(uint32_t));
+    table->slots = (int*)malloc(count * sizeof(int));
+    
+    PerfectHashBucket* buckets = (PerfectHashBucket*)calloc(table->bucket_count, sizeof(PerfectHashBucket));
+    int* members = (int*)malloc(count * sizeof(int));
+    int* placed = (int*)malloc(count * sizeof(int));
+    bool ok = table->seeds && table->slots && buckets && members && placed;
+    
+    if (ok) {
+        for (int i = 0; i < count; i++) {
+            table->slots[i] = -1;
+        }
+        
+        // Counting sort of the keys by bucket
+        int* bucket_of = placed;
+        for (int i = 0; i < count; i++) {
+            bucket_of[i] = (int)(phash_hash(keys[i], 0) % (uint32_t)table->bucket_count);
+            buckets[bucket_of[i]].count++;
+        }
+        
+        int offset = 0;
+        for (int b = 0; b < table->bucket_count; b++) {
+            buckets[b].bucket = b;
+            buckets[b].keys = members + offset;
+            offset += buckets[b].count;
+            buckets[b].count = 0;
+        }
+        for (int i = 0; i < count; i++) {
+            PerfectHashBucket* bucket = &buckets[bucket_of[i]];
+            
+            // Keys that hash alike are compared here, so repeats are caught
+            for (int k = 0; k < bucket->count && ok; k++) {
+                if (strcmp(keys[bucket->keys[k]], keys[i]) == 0) ok = false;
+            }
+            bucket->keys[bucket->count++] = i;
+        }
+    }
+    
+    if (ok) {
+        // Largest buckets first, while most slots are still free
+        qsort(buckets, table->bucket_count, sizeof(PerfectHashBucket), phash_bucket_compare);
+        
+        for (int b = 0; b < table->bucket_count && ok; b++) {
+            if (buckets[b].count > 0) {
+                ok = phash_place_bucket(table, keys, &buckets[b], placed);
+            }
+        }
+    }
+    
+    free(buckets);
+    free(members);
+    free(placed);
+    
+    if (!ok) {
+        phash_destroy(table);
+        return NULL;
+    }
+    
+    return table;
+}
+
+// ================ LOOKUP ================
+
+int phash_lookup(const PerfectHash* table, char** keys, const char* key) {
+    if (!table || !keys || !key) return -1;
+    
+    uint32_t bucket = phash_hash(key, 0) % (uint32_t)table->bucket_count;
+    int slot = (int)(phash_hash(key, table->seeds[bucket]) % (uint32_t)table->size);
+    int index = table->slots[slot];
+    
+    return strcmp(keys[index], key) == 0 ? index : -1;
+}
+
+// ================ MEMORY MANAGEMENT ================
+
+PerfectHash* phash_share(PerfectHash* table) {
+    if (table) table->shares++;
+    return table;
+}
+
+void phash_destroy(PerfectHash* table) {
+    if (!table) return;
+    if (table->shares > 0) {
+        table->shares--;
+        return;
+    }
+    
+    free(table->seeds);
+    free(table->slots);
+    free(table);
+}
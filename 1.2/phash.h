@@ -0,0 +1,31 @@
+#ifndef PHASH_H
+#define PHASH_H
+
+#include <stdint.h>
+
+// ================ MINIMAL PERFECT HASH ================
+// Maps a fixed set of distinct string keys to the indices 0..count-1
+// with a single probe (hash and displace). The keys themselves are not
+// stored; lookups check the candidate against the caller's key array.
+typedef struct {
+    int size;             // Number of keys (and slots)
+    int bucket_count;
+    uint32_t* seeds;      // Displacement seed per bucket
+    int* slots;           // Slot -> key index
+    int shares;           // Owners beyond the first (see phash_share)
+} PerfectHash;
+
+#define PHASH_MAX_ATTEMPTS 100000   // Seeds tried per bucket before giving up
+
+// Build a table for 'count' keys (NULL if keys repeat or building fails)
+PerfectHash* phash_build(char** keys, int count);
+
+// Index of 'key' in 'keys', or -1 if it is not one of them
+int phash_lookup(const PerfectHash* table, char** keys, const char* key);
+
+// Tables never change once built, so copies share one: phash_share adds
+// an owner in O(1), phash_destroy drops one and frees with the last.
+PerfectHash* phash_share(PerfectHash* table);
+void phash_destroy(PerfectHash* table);
+
+#endif // PHASH_H
@@ -0,0 +1,916 @@
+/**
+ * Regular expressions for Topo Programming Language
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "regex.h"
+#include "strops.h"
+
+// NFA state operations
+enum {
+    RE_CHAR,      // Consume a byte of 'set', go to 'out'
+    RE_SPLIT,     // Go to 'out' and 'out2'
+    RE_EPSILON,   // Go to 'out'
+    RE_BEGIN,     // Go to 'out' at the start of the text
+    RE_END,       // Go to 'out' at the end of the text
+    RE_MATCH
+};
+
+// ================ PATTERN PARSING ================
+// The pattern is parsed into a small tree first, so that counted
+// repetition can compile its operand several times.
+
+typedef enum {
+    RNODE_SET,
+    RNODE_CONCAT,
+    RNODE_ALTERNATE,
+    RNODE_REPEAT,
+    RNODE_BEGIN,
+    RNODE_END,
+    RNODE_EMPTY
+} RegexNodeKind;
+
+typedef struct {
+    RegexNodeKind kind;
+    int set;
+    int left;
+    int right;
+    int min;
+    int max;              // -1: unbounded
+} RegexNode;
+
+typedef struct {
+    const char* p;
+    Regex* regex;
+    RegexNode* nodes;
+    int node_count;
+    int node_capacity;
+    const char* error;
+} RegexParser;
+
+static void re_set_bit(uint32_t* bits, int c) {
+    bits[c >> 5] |= 1u << (c & 31);
+}
+
+static bool re_has_bit(const uint32_t* bits, int c) {
+    return (bits[c >> 5] >> (c & 31)) & 1;
+}
+
+static int re_add_set(RegexParser* parser, const uint32_t* bits) {
+    Regex* regex = parser->regex;
+    uint32_t (*sets)[8] = (uint32_t (*)[8])realloc(regex->sets, (regex->set_count + 1) * sizeof(*sets));
+    if (!sets) {
+        parser->error = "Out of memory";
+        return -1;
+    }
+    regex->sets = sets;
+    memcpy(regex->sets[regex->set_count], bits, sizeof(*sets));
+    return regex->set_count++;
+}
+
+static int re_node(RegexParser* parser, RegexNodeKind kind, int left, int right) {
+    if (parser->error) return -1;
+    
+    if (parser->node_count >= parser->node_capacity) {
+        int capacity = parser->node_capacity ? parser->node_capacity * 2 : 32;
+        RegexNode* nodes = (RegexNode*)realloc(parser->nodes, capacity * sizeof(RegexNode));
+        if (!nodes) {
+            parser->error = "Out of memory";
+            return -1;
+        }
+        parser->nodes = nodes;
+        parser->node_capacity = capacity;
+    }
+    
+    RegexNode* node = &parser->nodes[parser->node_count];
+    node->kind = kind;
+    node->set = -1;
+    node->left = left;
+    node->right = right;
+    node->min = 0;
+    node->max = 0;
+    return parser->node_count++;
+}
+
+static int re_set_node(RegexParser* parser, const uint32_t* bits) {
+    int set = re_add_set(parser, bits);
+    if (set < 0) return -1;
+    
+    int node = re_node(parser, RNODE_SET, -1, -1);
+    if (node >= 0) parser->nodes[node].set = set;
+    return node;
+}
+
+// \d \w \s and their complements
+static bool re_class_escape(char c, uint32_t* bits) {
+    uint32_t class_bits[8] = {0};
+    char lower = c | 0x20;
+    
+    if (lower == 'd') {
+        for (int i = '0'; i <= '9'; i++) re_set_bit(class_bits, i);
+    } else if (lower == 'w') {
+        for (int i = '0'; i <= '9'; i++) re_set_bit(class_bits, i);
+        for (int i = 'a'; i <= 'z'; i++) re_set_bit(class_bits, i);
+        for (int i = 'A'; i <= 'Z'; i++) re_set_bit(class_bits, i);
+        re_set_bit(class_bits, '_');
+    } else if (lower == 's') {
+        const char* spaces = " \t\n\r\f\v";
+        for (const char* s = spaces; *s; s++) re_set_bit(class_bits, *s);
+    } else {
+        return false;
+    }
+    
+    bool negate = c != lower;
+    for (int i = 0; i < 8; i++) {
+        bits[i] |= negate ? ~class_bits[i] : class_bits[i];
+    }
+    return true;
+}
+
+static int re_escape_char(char c) {
+    switch (c) {
+        case 'n': return '\n';
+        case 't': return '\t';
+        case 'r': return '\r';
+        case 'f': return '\f';
+        case 'v': return '\v';
+        case '0': return '\0';
+        default: return (unsigned char)c;
+    }
+}
+
+static int re_parse_class(RegexParser* parser) {
+    uint32_t bits[8] = {0};
+    bool negate = *parser->p == '^';
+    if (negate) parser->p++;
+    
+    // A ']' right after '[' or '[^' is a literal
+    bool first = true;
+    while (*parser->p && (*parser->p != ']' || first)) {
+        first = false;
+        int low;
+        
+        if (*parser->p == '\\') {
+            parser->p++;
+            if (!*parser->p) break;
+            if (re_class_escape(*parser->p, bits)) {
+                parser->p++;
+                continue;
+            }
+            low = re_escape_char(*parser->p++);
+        } else {
+            low = (unsigned char)*parser->p++;
+        }
+        
+        int high = low;
+        if (parser->p[0] == '-' && parser->p[1] && parser->p[1] != ']') {
+            parser->p++;
+            if (*parser->p == '\\' && parser->p[1]) {
+                parser->p++;
+                high = re_escape_char(*parser->p++);
+            } else {
+                high = (unsigned char)*parser->p++;
+            }
+            if (high < low) {
+                parser->error = "Invalid class range";
+                return -1;
+            }
+        }
+        for (int c = low; c <= high; c++) {
+            re_set_bit(bits, c);
+        }
+    }
+    
+    if (*parser->p != ']') {
+        parser->error = "Unterminated character class";
+        return -1;
+    }
+    parser->p++;
+    
+    if (negate) {
+        for (int i = 0; i < 8; i++) bits[i] = ~bits[i];
+    }
+    return re_set_node(parser, bits);
+}
+
+static int re_parse_alternation(RegexParser* parser);
+
+static int re_parse_atom(RegexParser* parser) {
+    uint32_t bits[8] = {0};
+    char c = *parser->p++;
+    
+    switch (c) {
+        case '(': {
+            if (parser->p[0] == '?' && parser->p[1] == ':') parser->p += 2;
+            int inner = re_parse_alternation(parser);
+            if (*parser->p != ')') {
+                if (!parser->error) parser->error = "Missing ')'";
+                return -1;
+            }
+            parser->p++;
+            return inner;
+        }
+            
+        case '[':
+            return re_parse_class(parser);
+            
+        case '.':
+            for (int i = 0; i < 8; i++) bits[i] = ~0u;
+            bits['\n' >> 5] &= ~(1u << ('\n' & 31));
+            return re_set_node(parser, bits);
+            
+        case '^':
+            parser->regex->has_begin = true;
+            return re_node(parser, RNODE_BEGIN, -1, -1);
+            
+        case '$':
+            return re_node(parser, RNODE_END, -1, -1);
+            
+        case '\\':
+            if (!*parser->p) {
+                parser->error = "Trailing backslash";
+                return -1;
+            }
+            c = *parser->p++;
+            if (re_class_escape(c, bits)) return re_set_node(parser, bits);
+            re_set_bit(bits, re_escape_char(c));
+            return re_set_node(parser, bits);
+            
+        case '*':
+        case '+':
+        case '?':
+            parser->error = "Nothing to repeat";
+            return -1;
+            
+        default:
+            re_set_bit(bits, (unsigned char)c);
+            return re_set_node(parser, bits);
+    }
+}
+
+static bool re_parse_count(const char** p, int* value) {
+    if (**p < '0' || **p > '9') return false;
+    
+    int result = 0;
+    while (**p >= '0' && **p <= '9') {
+        result = result * 10 + (**p - '0');
+        if (result > REGEX_MAX_REPEAT) result = REGEX_MAX_REPEAT + 1;
+        (*p)++;
+    }
+    *value = result;
+    return true;
+}
+
+// {m}, {m,} or {m,n}; anything else leaves the '{' as a literal
+static bool re_parse_braces(RegexParser* parser, int* min, int* max) {
+    const char* p = parser->p + 1;
+    if (!re_parse_count(&p, min)) return false;
+    
+    *max = *min;
+    if (*p == ',') {
+        p++;
+        if (!re_parse_count(&p, max)) *max = -1;
+    }
+    if (*p != '}') return false;
+    
+    parser->p = p + 1;
+    return true;
+}
+
+static int re_parse_repeat(RegexParser* parser) {
+    int atom = re_parse_atom(parser);
+    
+    while (atom >= 0) {
+        int min, max;
+        char c = *parser->p;
+        
+        if (c == '*') {
+            min = 0;
+            max = -1;
+            parser->p++;
+        } else if (c == '+') {
+            min = 1;
+            max = -1;
+            parser->p++;
+        } else if (c == '?') {
+            min = 0;
+            max = 1;
+            parser->p++;
+        } else if (c == '{' && re_parse_braces(parser, &min, &max)) {
+            if (min > REGEX_MAX_REPEAT || max > REGEX_MAX_REPEAT || (max >= 0 && max < min)) {
+                parser->error = "Invalid repetition count";
+                return -1;
+            }
+        } else {
+            break;
+        }
+        
+        // Lazy quantifiers find the same matches here
+        if (*parser->p == '?') parser->p++;
+        
+        int node = re_node(parser, RNODE_REPEAT, atom, -1);
+        if (node < 0) return -1;
+        parser->nodes[node].min = min;
+        parser->nodes[node].max = max;
+        atom = node;
+    }
+    
+    return atom;
+}
+
+static int re_parse_concat(RegexParser* parser) {
+    int result = -1;
+    
+    while (*parser->p && *parser->p != '|' && *parser->p != ')') {
+        int item = re_parse_repeat(parser);
+        if (item < 0) return -1;
+        result = result < 0 ? item : re_node(parser, RNODE_CONCAT, result, item);
+    }
+    
+    return result < 0 ? re_node(parser, RNODE_EMPTY, -1, -1) : result;
+}
+
+static int re_parse_alternation(RegexParser* parser) {
+    int left = re_parse_concat(parser);
+    
+    while (left >= 0 && *parser->p == '|') {
+        parser->p++;
+        int right = re_parse_concat(parser);
+        if (right < 0) return -1;
+        left = re_node(parser, RNODE_ALTERNATE, left, right);
+    }
+    
+    return left;
+}
+
+// ================ NFA CONSTRUCTION ================
+
+typedef struct {
+    int start;
+    int end;              // Epsilon state whose 'out' is still open
+} RegexFragment;
+
+static int re_state(RegexParser* parser, int op, int out, int out2, int set) {
+    Regex* regex = parser->regex;
+    if (parser->error) return -1;
+    if (regex->state_count >= REGEX_MAX_STATES) {
+        parser->error = "Pattern too large";
+        return -1;
+    }
+    
+    RegexState* state = &regex->states[regex->state_count];
+    state->op = (uint8_t)op;
+    state->out = out;
+    state->out2 = out2;
+    state->set = set;
+    return regex->state_count++;
+}
+
+static RegexFragment re_fragment(RegexParser* parser, int op, int set) {
+    RegexFragment fragment;
+    fragment.end = re_state(parser, RE_EPSILON, -1, -1, -1);
+    fragment.start = op == RE_EPSILON ? fragment.end : re_state(parser, op, fragment.end, -1, set);
+    return fragment;
+}
+
+// a then b
+static RegexFragment re_append(Regex* regex, RegexFragment a, RegexFragment b) {
+    if (a.start < 0) return b;
+    if (b.start < 0) return a;
+    
+    regex->states[a.end].out = b.start;
+    a.end = b.end;
+    return a;
+}
+
+static RegexFragment re_compile_node(RegexParser* parser, int index) {
+    RegexFragment none = {-1, -1};
+    if (parser->error || index < 0) return none;
+    
+    RegexNode node = parser->nodes[index];
+    Regex* regex = parser->regex;
+    
+    switch (node.kind) {
+        case RNODE_SET:
+            return re_fragment(parser, RE_CHAR, node.set);
+            
+        case RNODE_BEGIN:
+            return re_fragment(parser, RE_BEGIN, -1);
+            
+        case RNODE_END:
+            return re_fragment(parser, RE_END, -1);
+            
+        case RNODE_EMPTY:
+            return re_fragment(parser, RE_EPSILON, -1);
+            
+        case RNODE_CONCAT: {
+            RegexFragment a = re_compile_node(parser, node.left);
+            RegexFragment b = re_compile_node(parser, node.right);
+            if (parser->error) return none;
+            return re_append(regex, a, b);
+        }
+            
+        case RNODE_ALTERNATE: {
+            RegexFragment a = re_compile_node(parser, node.left);
+            RegexFragment b = re_compile_node(parser, node.right);
+            RegexFragment result = re_fragment(parser, RE_EPSILON, -1);
+            if (parser->error) return none;
+            
+            result.start = re_state(parser, RE_SPLIT, a.start, b.start, -1);
+            regex->states[a.end].out = result.end;
+            regex->states[b.end].out = result.end;
+            return result;
+        }
+            
+        case RNODE_REPEAT: {
+            RegexFragment result = none;
+            
+            // Required copies, then either a loop or optional copies
+            for (int i = 0; i < node.min && !parser->error; i++) {
+                result = re_append(regex, result, re_compile_node(parser, node.left));
+            }
+            
+            int optional = node.max < 0 ? 1 : node.max - node.min;
+            for (int i = 0; i < optional && !parser->error; i++) {
+                RegexFragment body = re_compile_node(parser, node.left);
+                RegexFragment skip = re_fragment(parser, RE_EPSILON, -1);
+                if (parser->error) return none;
+                
+                skip.start = re_state(parser, RE_SPLIT, body.start, skip.end, -1);
+                regex->states[body.end].out = node.max < 0 ? skip.start : skip.end;
+                result = re_append(regex, result, skip);
+            }
+            
+            if (result.start < 0) result = re_fragment(parser, RE_EPSILON, -1);
+            return parser->error ? none : result;
+        }
+            
+        default:
+            return none;
+    }
+}
+
+// Literal text every match starts with; true if it is the whole pattern
+static bool re_literal_prefix(const RegexParser* parser, int index, Regex* regex, size_t capacity) {
+    const RegexNode* node = &parser->nodes[index];
+    
+    if (node->kind == RNODE_CONCAT) {
+        return re_literal_prefix(parser, node->left, regex, capacity) &&
+               re_literal_prefix(parser, node->right, regex, capacity);
+    }
+    if (node->kind != RNODE_SET || regex->prefix_length >= capacity) return false;
+    
+    // Single-byte sets only
+    const uint32_t* bits = regex->sets[node->set];
+    int found = -1;
+    for (int c = 0; c < 256; c++) {
+        if (!re_has_bit(bits, c)) continue;
+        if (found >= 0) return false;
+        found = c;
+    }
+    if (found < 0) return false;
+    
+    regex->prefix[regex->prefix_length++] = (char)found;
+    return true;
+}
+
+Regex* regex_compile(const char* pattern, char* error, size_t error_size) {
+    if (!pattern) return NULL;
+    
+    RegexParser parser;
+    memset(&parser, 0, sizeof(parser));
+    parser.p = pattern;
+    parser.regex = (Regex*)calloc(1, sizeof(Regex));
+    if (!parser.regex) return NULL;
+    Regex* regex = parser.regex;
+    
+    int root = re_parse_alternation(&parser);
+    if (!parser.error && *parser.p == ')') parser.error = "Unmatched ')'";
+    
+    if (!parser.error) {
+        // Trimmed to size after compilation
+        regex->states = (RegexState*)malloc(REGEX_MAX_STATES * sizeof(RegexState));
+        if (!regex->states) parser.error = "Out of memory";
+    }
+    
+    if (!parser.error) {
+        RegexFragment fragment = re_compile_node(&parser, root);
+        int match = re_state(&parser, RE_MATCH, -1, -1, -1);
+        if (!parser.error) {
+            regex->states[fragment.end].out = match;
+            regex->start = fragment.start;
+        }
+    }
+    
+    if (!parser.error) {
+        regex->pattern = strdup(pattern);
+        regex->prefix = (char*)malloc(strlen(pattern) + 1);
+        if (!regex->pattern || !regex->prefix) parser.error = "Out of memory";
+    }
+    
+    if (!parser.error) {
+        bool whole = re_literal_prefix(&parser, root, regex, strlen(pattern));
+        regex->literal = whole && regex->prefix_length > 0;
+        regex->prefix[regex->prefix_length] = '\0';
+        
+        // Give back the unused part of the state array
+        RegexState* states = (RegexState*)realloc(regex->states, regex->state_count * sizeof(RegexState));
+        if (states) regex->states = states;
+    }
+    
+    free(parser.nodes);
+    
+    if (parser.error) {
+        if (error && error_size > 0) {
+            snprintf(error, error_size, "%s at offset %d", parser.error, (int)(parser.p - pattern));
+        }
+        regex_free(regex);
+        return NULL;
+    }
+    
+    return regex;
+}
+
+// ================ LAZY DFA ================
+// A DFA state is the sorted set of NFA states that consume input (CHAR),
+// test for the end (END) or accept (MATCH). Transitions are computed on
+// first use and remembered; when the cache is full every state except the
+// pinned start states is dropped and building resumes from scratch.
+
+typedef struct {
+    int* set;
+    int count;
+    uint32_t hash;
+    bool accepting;       // Contains MATCH
+    bool accepting_at_end; // Accepts if the text ends here ('$')
+    int next[256];        // -1: not computed yet
+} RegexDfaState;
+
+struct RegexDfa {
+    bool search;          // Every position may start a new match
+    RegexDfaState* states;
+    int count;
+    int pinned;           // States kept across flushes
+    int start;            // At the start of the text
+    int restart;          // Search mode: no match in progress (mid-text)
+    unsigned long flushes;
+    unsigned* marks;      // Per NFA state, == mark when already collected
+    unsigned mark;
+    int* stack;
+    int* buffer;
+    int* end_buffer;
+};
+
+// Collect the input-consuming states reachable from 'state' into 'out'
+static void re_closure(const Regex* regex, RegexDfa* dfa, int state, bool at_start, bool at_end, int* out, int* count) {
+    int top = 0;
+    
+    if (state < 0 || dfa->marks[state] == dfa->mark) return;
+    dfa->marks[state] = dfa->mark;
+    dfa->stack[top++] = state;
+    
+    while (top > 0) {
+        const RegexState* s = &regex->states[dfa->stack[--top]];
+        int follow[2] = {-1, -1};
+        
+        switch (s->op) {
+            case RE_CHAR:
+            case RE_MATCH:
+                out[(*count)++] = (int)(s - regex->states);
+                break;
+            case RE_END:
+                if (at_end) {
+                    follow[0] = s->out;
+                } else {
+                    out[(*count)++] = (int)(s - regex->states);
+                }
+                break;
+            case RE_BEGIN:
+                if (at_start) follow[0] = s->out;
+                break;
+            case RE_SPLIT:
+                follow[0] = s->out2;
+                follow[1] = s->out;
+                break;
+            default:
+                follow[0] = s->out;
+                break;
+        }
+        
+        for (int i = 0; i < 2; i++) {
+            int next = follow[i];
+            if (next >= 0 && dfa->marks[next] != dfa->mark) {
+                dfa->marks[next] = dfa->mark;
+                dfa->stack[top++] = next;
+            }
+        }
+    }
+}
+
+static void re_next_mark(RegexDfa* dfa, int state_count) {
+    if (++dfa->mark == 0) {
+        memset(dfa->marks, 0, state_count * sizeof(unsigned));
+        dfa->mark = 1;
+    }
+}
+
+static int re_compare_ints(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t re_hash_set(const int* set, int count) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < count; i++) {
+        hash = (hash ^ (uint32_t)set[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static void re_dfa_flush(RegexDfa* dfa) {
+    for (int i = dfa->pinned; i < dfa->count; i++) {
+        free(dfa->states[i].set);
+    }
+    dfa->count = dfa->pinned;
+    dfa->flushes++;
+    for (int i = 0; i < dfa->pinned; i++) {
+        memset(dfa->states[i].next, -1, sizeof(dfa->states[i].next));
+    }
+}
+
+// State for a sorted NFA set, created if new; -1 when out of memory
+static int re_dfa_state(const Regex* regex, RegexDfa* dfa, const int* set, int count) {
+    uint32_t hash = re_hash_set(set, count);
+    
+    for (int i = 0; i < dfa->count; i++) {
+        RegexDfaState* state = &dfa->states[i];
+        if (state->hash == hash && state->count == count &&
+            memcmp(state->set, set, count * sizeof(int)) == 0) {
+            return i;
+        }
+    }
+    
+    if (dfa->count >= REGEX_DFA_CACHE_STATES) re_dfa_flush(dfa);
+    
+    RegexDfaState* state = &dfa->states[dfa->count];
+    state->set = (int*)malloc((count ? count : 1) * sizeof(int));
+    if (!state->set) return -1;
+    memcpy(state->set, set, count * sizeof(int));
+    state->count = count;
+    state->hash = hash;
+    state->accepting = false;
+    state->accepting_at_end = false;
+    memset(state->next, -1, sizeof(state->next));
+    
+    for (int i = 0; i < count; i++) {
+        const RegexState* s = &regex->states[set[i]];
+        if (s->op == RE_MATCH) {
+            state->accepting = true;
+            state->accepting_at_end = true;
+        } else if (s->op == RE_END && !state->accepting_at_end) {
+            // Does passing this '$' reach MATCH?
+            int end_count = 0;
+            re_next_mark(dfa, regex->state_count);
+            re_closure(regex, dfa, s->out, false, true, dfa->end_buffer, &end_count);
+            for (int j = 0; j < end_count; j++) {
+                if (regex->states[dfa->end_buffer[j]].op == RE_MATCH) {
+                    state->accepting_at_end = true;
+                    break;
+                }
+            }
+        }
+    }
+    
+    return dfa->count++;
+}
+
+static RegexDfa* re_dfa_create(const Regex* regex, bool search) {
+    RegexDfa* dfa = (RegexDfa*)calloc(1, sizeof(RegexDfa));
+    if (!dfa) return NULL;
+    
+    size_t n = (size_t)regex->state_count;
+    dfa->search = search;
+    dfa->states = (RegexDfaState*)malloc(REGEX_DFA_CACHE_STATES * sizeof(RegexDfaState));
+    dfa->marks = (unsigned*)calloc(n, sizeof(unsigned));
+    dfa->stack = (int*)malloc(n * sizeof(int));
+    dfa->buffer = (int*)malloc(n * sizeof(int));
+    dfa->end_buffer = (int*)malloc(n * sizeof(int));
+    
+    bool ok = dfa->states && dfa->marks && dfa->stack && dfa->buffer && dfa->end_buffer;
+    
+    // Pinned: the start state, and in search mode the mid-text restart
+    for (int i = 0; ok && i < (search ? 2 : 1); i++) {
+        int count = 0;
+        re_next_mark(dfa, regex->state_count);
+        re_closure(regex, dfa, regex->start, i == 0, false, dfa->buffer, &count);
+        qsort(dfa->buffer, count, sizeof(int), re_compare_ints);
+        
+        int state = re_dfa_state(regex, dfa, dfa->buffer, count);
+        if (state < 0) ok = false;
+        if (i == 0) dfa->start = state;
+        else dfa->restart = state;
+    }
+    dfa->pinned = dfa->count;
+    
+    if (!ok) {
+        for (int i = 0; i < dfa->count; i++) free(dfa->states[i].set);
+        free(dfa->states);
+        free(dfa->marks);
+        free(dfa->stack);
+        free(dfa->buffer);
+        free(dfa->end_buffer);
+        free(dfa);
+        return NULL;
+    }
+    
+    return dfa;
+}
+
+static void re_dfa_destroy(RegexDfa* dfa) {
+    if (!dfa) return;
+    
+    for (int i = 0; i < dfa->count; i++) {
+        free(dfa->states[i].set);
+    }
+    free(dfa->states);
+    free(dfa->marks);
+    free(dfa->stack);
+    free(dfa->buffer);
+    free(dfa->end_buffer);
+    free(dfa);
+}
+
+// Transition on byte c; -1 when out of memory
+static int re_dfa_step(const Regex* regex, RegexDfa* dfa, int from, unsigned char c) {
+    int cached = dfa->states[from].next[c];
+    if (cached >= 0) return cached;
+    
+    const RegexDfaState* state = &dfa->states[from];
+    int count = 0;
+    re_next_mark(dfa, regex->state_count);
+    
+    for (int i = 0; i < state->count; i++) {
+        const RegexState* s = &regex->states[state->set[i]];
+        if (s->op == RE_CHAR && re_has_bit(regex->sets[s->set], c)) {
+            re_closure(regex, dfa, s->out, false, false, dfa->buffer, &count);
+        }
+    }
+    if (dfa->search) {
+        re_closure(regex, dfa, regex->start, false, false, dfa->buffer, &count);
+    }
+    qsort(dfa->buffer, count, sizeof(int), re_compare_ints);
+    
+    // A flush drops 'from' unless it is pinned
+    unsigned long flushes = dfa->flushes;
+    int next = re_dfa_state(regex, dfa, dfa->buffer, count);
+    if (next >= 0 && (from < dfa->pinned || dfa->flushes == flushes)) {
+        dfa->states[from].next[c] = next;
+    }
+    return next;
+}
+
+// ================ MATCHING ================
+
+bool regex_search(Regex* regex, const char* text, size_t length, size_t* match_end) {
+    if (!regex || (!text && length > 0)) return false;
+    
+    if (regex->literal) {
+        size_t position = str_find(text, length, regex->prefix, regex->prefix_length, 0);
+        if (position == STR_NOT_FOUND) return false;
+        if (match_end) *match_end = position + regex->prefix_length;
+        return true;
+    }
+    
+    if (!regex->search_dfa) {
+        regex->search_dfa = re_dfa_create(regex, true);
+        if (!regex->search_dfa) return false;
+    }
+    RegexDfa* dfa = regex->search_dfa;
+    
+    // Every match starts with the prefix: skip straight to it whenever
+    // no match is in progress
+    bool prefilter = regex->prefix_length > 0 && !regex->has_begin;
+    size_t position = 0;
+    int state = dfa->start;
+    
+    if (prefilter) {
+        position = str_find(text, length, regex->prefix, regex->prefix_length, 0);
+        if (position == STR_NOT_FOUND) return false;
+        if (position > 0) state = dfa->restart;
+    }
+    
+    while (state >= 0) {
+        if (dfa->states[state].accepting) {
+            if (match_end) *match_end = position;
+            return true;
+        }
+        if (position >= length) break;
+        
+        if (prefilter && state == dfa->restart) {
+            position = str_find(text, length, regex->prefix, regex->prefix_length, position);
+            if (position == STR_NOT_FOUND) return false;
+        }
+        
+        state = re_dfa_step(regex, dfa, state, (unsigned char)text[position++]);
+    }
+    
+    if (state >= 0 && dfa->states[state].accepting_at_end) {
+        if (match_end) *match_end = length;
+        return true;
+    }
+    return false;
+}
+
+bool regex_match(Regex* regex, const char* text, size_t length) {
+    if (!regex || (!text && length > 0)) return false;
+    
+    if (regex->literal) {
+        return length == regex->prefix_length && memcmp(text, regex->prefix, length) == 0;
+    }
+    
+    if (!regex->match_dfa) {
+        regex->match_dfa = re_dfa_create(regex, false);
+        if (!regex->match_dfa) return false;
+    }
+    RegexDfa* dfa = regex->match_dfa;
+    
+    int state = dfa->start;
+    for (size_t i = 0; i < length && state >= 0; i++) {
+        if (dfa->states[state].count == 0) return false;
+        state = re_dfa_step(regex, dfa, state, (unsigned char)text[i]);
+    }
+    
+    return state >= 0 && dfa->states[state].accepting_at_end;
+}
+
+void regex_free(Regex* regex) {
+    if (!regex) return;
+    
+    re_dfa_destroy(regex->search_dfa);
+    re_dfa_destroy(regex->match_dfa);
+    free(regex->pattern);
+    free(regex->states);
+    free(regex->sets);
+    free(regex->prefix);
+    free(regex);
+}
+
+// ================ PATTERN CACHE ================
+
+static uint32_t re_hash_pattern(const char* pattern) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char* p = (const unsigned char*)pattern; *p; p++) {
+        hash = (hash ^ *p) * 16777619u;
+    }
+    return hash;
+}
+
+void regex_cache_init(RegexCache* cache) {
+    memset(cache, 0, sizeof(RegexCache));
+}
+
+void regex_cache_clear(RegexCache* cache) {
+    if (!cache) return;
+    
+    for (int i = 0; i < cache->count; i++) {
+        regex_free(cache->entries[i].regex);
+    }
+    regex_cache_init(cache);
+}
+
+Regex* regex_cache_get(RegexCache* cache, const char* pattern, char* error, size_t error_size) {
+    if (!cache || !pattern) return NULL;
+    
+    uint32_t hash = re_hash_pattern(pattern);
+    for (int i = 0; i < cache->count; i++) {
+        RegexCacheEntry* entry = &cache->entries[i];
+        if (entry->hash == hash && strcmp(entry->regex->pattern, pattern) == 0) {
+            entry->last_use = ++cache->clock;
+            return entry->regex;
+        }
+    }
+    
+    Regex* regex = regex_compile(pattern, error, error_size);
+    if (!regex) return NULL;
+    
+    // Take a free slot, or evict the least recently used pattern
+    int slot = cache->count;
+    if (slot < REGEX_CACHE_SIZE) {
+        cache->count++;
+    } else {
+        slot = 0;
+        for (int i = 1; i < cache->count; i++) {
+            if (cache->entries[i].last_use < cache->entries[slot].last_use) slot = i;
+        }
+        regex_free(cache->entries[slot].regex);
+    }
+    
+    cache->entries[slot].regex = regex;
+    cache->entries[slot].hash = hash;
+    cache->entries[slot].last_use = ++cache->clock;
+    return regex;
+}
@@ -0,0 +1,79 @@
+#ifndef REGEX_H
+#define REGEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ================ REGULAR EXPRESSIONS ================
+// Byte-oriented regular expressions matched in linear time: the pattern
+// becomes a Thompson NFA, which is run as a DFA built lazily, one state
+// at a time, into a bounded cache. Supported syntax: literals, '.',
+// [...] and [^...] classes, \d \w \s \D \W \S and escaped
+// metacharacters, ( ) groups, '|', * + ? {m} {m,} {m,n}, ^ and $.
+
+#define REGEX_MAX_STATES 20000        // NFA size limit (bounds {m,n} expansion)
+#define REGEX_MAX_REPEAT 1000         // Largest count in {m,n}
+#define REGEX_DFA_CACHE_STATES 256    // DFA states kept before the cache is flushed
+#define REGEX_CACHE_SIZE 64           // Compiled patterns kept by a RegexCache
+
+typedef struct RegexDfa RegexDfa;
+
+typedef struct {
+    uint8_t op;
+    int out;
+    int out2;
+    int set;              // Byte class (CHAR states)
+} RegexState;
+
+typedef struct {
+    char* pattern;
+    RegexState* states;
+    int state_count;
+    int start;
+    uint32_t (*sets)[8];  // 256-bit byte classes
+    int set_count;
+    bool has_begin;       // Uses '^'
+    char* prefix;         // Literal every match starts with (prefilter)
+    size_t prefix_length;
+    bool literal;         // The whole pattern is the prefix
+    RegexDfa* search_dfa; // Built on demand
+    RegexDfa* match_dfa;
+} Regex;
+
+// Compile a pattern; on failure returns NULL and writes a message to
+// 'error' (if given)
+Regex* regex_compile(const char* pattern, char* error, size_t error_size);
+void regex_free(Regex* regex);
+
+// Does the pattern match somewhere in the text? The earliest end of a
+// match is stored in 'match_end' (if given).
+bool regex_search(Regex* regex, const char* text, size_t length, size_t* match_end);
+
+// Does the pattern match the whole text?
+bool regex_match(Regex* regex, const char* text, size_t length);
+
+// ================ PATTERN CACHE ================
+// Least-recently-used cache of compiled patterns, keyed by pattern text.
+// One cache per interpreter instance, so no locking is needed.
+
+typedef struct {
+    Regex* regex;
+    uint32_t hash;
+    unsigned long last_use;
+} RegexCacheEntry;
+
+typedef struct {
+    RegexCacheEntry entries[REGEX_CACHE_SIZE];
+    int count;
+    unsigned long clock;
+} RegexCache;
+
+void regex_cache_init(RegexCache* cache);
+void regex_cache_clear(RegexCache* cache);
+
+// Compiled pattern from the cache (compiled and cached on a miss). The
+// cache owns the result; it stays valid until evicted.
+Regex* regex_cache_get(RegexCache* cache, const char* pattern, char* error, size_t error_size);
+
+#endif // REGEX_H
@@ -0,0 +1,97 @@
+/**
+ * Region allocation for Topo Programming Language
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "region.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#define REGION_COMMIT_STEP ((size_t)1 << 20)
+#else
+#include <sys/mman.h>
+#endif
+
+Region* region_create(size_t cap) {
+    if (cap == 0) cap = REGION_DEFAULT_CAP;
+    
+    Region* region = (Region*)calloc(1, sizeof(Region));
+    if (!region) return NULL;
+    
+#if defined(_WIN32)
+    // Reserve now, commit as the region grows
+    region->base = (char*)VirtualAlloc(NULL, cap, MEM_RESERVE, PAGE_NOACCESS);
+    if (!region->base) {
+        free(region);
+        return NULL;
+    }
+#else
+    // Pages are only backed once touched, and come zeroed
+    void* map = mmap(NULL, cap, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (map == MAP_FAILED) {
+        free(region);
+        return NULL;
+    }
+    region->base = (char*)map;
+    region->committed = cap;
+#endif
+    
+    region->cap = cap;
+    return region;
+}
+
+void region_destroy(Region* region) {
+    if (!region) return;
+    
+#if defined(_WIN32)
+    VirtualFree(region->base, 0, MEM_RELEASE);
+#else
+    munmap(region->base, region->cap);
+#endif
+    free(region);
+}
+
+void* region_alloc(Region* region, size_t size) {
+    if (!region) return NULL;
+    
+    size_t start = (region->used + REGION_ALIGNMENT - 1) & ~(size_t)(REGION_ALIGNMENT - 1);
+    if (size > region->cap || start > region->cap - size) {
+        region->fallbacks++;
+        return NULL;
+    }
+    
+#if defined(_WIN32)
+    if (start + size > region->committed) {
+        size_t target = (start + size + REGION_COMMIT_STEP - 1) & ~(REGION_COMMIT_STEP - 1);
+        if (target > region->cap) target = region->cap;
+        if (!VirtualAlloc(region->base + region->committed, target - region->committed, MEM_COMMIT, PAGE_READWRITE)) {
+            region->fallbacks++;
+            return NULL;
+        }
+        region->committed = target;
+    }
+#endif
+    
+    // Memory is never reused, so it is still zero from the mapping
+    region->used = start + size;
+    return region->base + start;
+}
+
+char* region_strdup(Region* region, const char* text) {
+    if (!text) return NULL;
+    
+    size_t length = strlen(text);
+    char* copy = (char*)region_alloc(region, length + 1);
+    if (copy) memcpy(copy, text, length + 1);
+    return copy;
+}
+
+bool region_contains(const Region* region, const void* pointer) {
+    if (!region || !pointer) return false;
+    
+    const char* p = (const char*)pointer;
+    return p >= region->base && p < region->base + region->used;
+}
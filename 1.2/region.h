@@ -0,0 +1,35 @@
+#ifndef REGION_H
+#define REGION_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// ================ REGION ALLOCATION ================
+// Bump allocation from one block of reserved address space, for data that
+// lives until the end of the run. Nothing is freed individually: the whole
+// region goes at once, with a single unmap. Past the cap region_alloc
+// returns NULL, and callers fall back to the normal heap.
+
+#define REGION_DEFAULT_CAP ((size_t)256 << 20)  // Address space reserved by default
+#define REGION_ALIGNMENT 16
+
+typedef struct {
+    char* base;
+    size_t cap;           // Bytes reserved
+    size_t used;          // Bytes handed out
+    size_t committed;     // Bytes backed by memory (Windows commits on demand)
+    size_t fallbacks;     // Requests refused because the cap was reached
+} Region;
+
+// NULL if the address space cannot be reserved
+Region* region_create(size_t cap);
+void region_destroy(Region* region);
+
+// Zeroed memory, or NULL once the region is full
+void* region_alloc(Region* region, size_t size);
+char* region_strdup(Region* region, const char* text);
+
+// Was the pointer allocated from the region?
+bool region_contains(const Region* region, const void* pointer);
+
+#endif // REGION_H
@@ -0,0 +1,730 @@
+/**
+ * Sorting for Topo Programming Language
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "sort.h"
+
+#if !defined(_WIN32) && !defined(SORT_NO_THREADS)
+#include <pthread.h>
+#include <unistd.h>
+#define SORT_HAVE_THREADS 1
+#endif
+
+#define SORT_SIGN_BIT ((uint64_t)1 << 63)
+
+// ================ PATTERN-DEFEATING QUICKSORT ================
+
+typedef struct {
+    char* base;
+    size_t size;
+    SortCompare compare;
+    void* data;
+    char* temp;           // One element, for moves
+    char* pivot;          // One element, the current pivot
+} SortContext;
+
+static char* sort_at(const SortContext* ctx, size_t i) {
+    return ctx->base + i * ctx->size;
+}
+
+static bool sort_less(const SortContext* ctx, size_t i, size_t j) {
+    return ctx->compare(sort_at(ctx, i), sort_at(ctx, j), ctx->data) < 0;
+}
+
+static bool sort_less_than_pivot(const SortContext* ctx, size_t i) {
+    return ctx->compare(sort_at(ctx, i), ctx->pivot, ctx->data) < 0;
+}
+
+static bool sort_pivot_less_than(const SortContext* ctx, size_t i) {
+    return ctx->compare(ctx->pivot, sort_at(ctx, i), ctx->data) < 0;
+}
+
+// Element copy; pointer-sized elements (the common case) avoid the
+// variable-length memcpy call
+static void sort_copy(const SortContext* ctx, void* target, const void* source) {
+    if (ctx->size == sizeof(uint64_t)) {
+        uint64_t value;
+        memcpy(&value, source, sizeof(value));
+        memcpy(target, &value, sizeof(value));
+    } else {
+        memcpy(target, source, ctx->size);
+    }
+}
+
+static void sort_swap(SortContext* ctx, size_t i, size_t j) {
+    if (i == j) return;
+    sort_copy(ctx, ctx->temp, sort_at(ctx, i));
+    sort_copy(ctx, sort_at(ctx, i), sort_at(ctx, j));
+    sort_copy(ctx, sort_at(ctx, j), ctx->temp);
+}
+
+static void sort_insertion(SortContext* ctx, size_t begin, size_t end) {
+    for (size_t i = begin + 1; i < end; i++) {
+        if (!sort_less(ctx, i, i - 1)) continue;
+        
+        sort_copy(ctx, ctx->temp, sort_at(ctx, i));
+        size_t j = i;
+        do {
+            sort_copy(ctx, sort_at(ctx, j), sort_at(ctx, j - 1));
+            j--;
+        } while (j > begin && ctx->compare(ctx->temp, sort_at(ctx, j - 1), ctx->data) < 0);
+        sort_copy(ctx, sort_at(ctx, j), ctx->temp);
+    }
+}
+
+// Insertion sort that gives up after a few moves; true if it finished
+static bool sort_partial_insertion(SortContext* ctx, size_t begin, size_t end) {
+    size_t moves = 0;
+    
+    for (size_t i = begin + 1; i < end; i++) {
+        if (!sort_less(ctx, i, i - 1)) continue;
+        
+        sort_copy(ctx, ctx->temp, sort_at(ctx, i));
+        size_t j = i;
+        do {
+            sort_copy(ctx, sort_at(ctx, j), sort_at(ctx, j - 1));
+            j--;
+        } while (j > begin && ctx->compare(ctx->temp, sort_at(ctx, j - 1), ctx->data) < 0);
+        sort_copy(ctx, sort_at(ctx, j), ctx->temp);
+        
+        moves += i - j;
+        if (moves > 8) return false;
+    }
+    return true;
+}
+
+static void sort_sift_down(SortContext* ctx, size_t begin, size_t root, size_t count) {
+    for (;;) {
+        size_t child = 2 * root + 1;
+        if (child >= count) return;
+        if (child + 1 < count && sort_less(ctx, begin + child, begin + child + 1)) child++;
+        if (!sort_less(ctx, begin + root, begin + child)) return;
+        sort_swap(ctx, begin + root, begin + child);
+        root = child;
+    }
+}
+
+static void sort_heap(SortContext* ctx, size_t begin, size_t end) {
+    size_t count = end - begin;
+    for (size_t i = count / 2; i-- > 0;) {
+        sort_sift_down(ctx, begin, i, count);
+    }
+    for (size_t i = count; i-- > 1;) {
+        sort_swap(ctx, begin, begin + i);
+        sort_sift_down(ctx, begin, 0, i);
+    }
+}
+
+static void sort_two(SortContext* ctx, size_t a, size_t b) {
+    if (sort_less(ctx, b, a)) sort_swap(ctx, a, b);
+}
+
+static void sort_three(SortContext* ctx, size_t a, size_t b, size_t c) {
+    sort_two(ctx, a, b);
+    sort_two(ctx, b, c);
+    sort_two(ctx, a, b);
+}
+
+// Partition around the pivot at 'begin', equal elements to the right.
+// Returns the pivot's final position; 'already' is set when no element
+// had to move.
+static size_t sort_partition_right(SortContext* ctx, size_t begin, size_t end, bool* already) {
+    sort_copy(ctx, ctx->pivot, sort_at(ctx, begin));
+    size_t first = begin;
+    size_t last = end;
+    
+    // The median-of-three guarantees an element >= pivot on the right
+    while (sort_less_than_pivot(ctx, ++first));
+    
+    if (first - 1 == begin) {
+        while (first < last && !sort_less_than_pivot(ctx, --last));
+    } else {
+        while (!sort_less_than_pivot(ctx, --last));
+    }
+    
+    *already = first >= last;
+    
+    while (first < last) {
+        sort_swap(ctx, first, last);
+        while (sort_less_than_pivot(ctx, ++first));
+        while (!sort_less_than_pivot(ctx, --last));
+    }
+    
+    size_t pivot_position = first - 1;
+    sort_copy(ctx, sort_at(ctx, begin), sort_at(ctx, pivot_position));
+    sort_copy(ctx, sort_at(ctx, pivot_position), ctx->pivot);
+    return pivot_position;
+}
+
+// Partition with elements equal to the pivot on the left (used when the
+// pivot equals the element before the range: the whole left side is then
+// equal to it and needs no further sorting)
+static size_t sort_partition_left(SortContext* ctx, size_t begin, size_t end) {
+    sort_copy(ctx, ctx->pivot, sort_at(ctx, begin));
+    size_t first = begin;
+    size_t last = end;
+    
+    while (sort_pivot_less_than(ctx, --last));
+    
+    if (last + 1 == end) {
+        while (first < last && !sort_pivot_less_than(ctx, ++first));
+    } else {
+        while (!sort_pivot_less_than(ctx, ++first));
+    }
+    
+    while (first < last) {
+        sort_swap(ctx, first, last);
+        while (sort_pivot_less_than(ctx, --last));
+        while (!sort_pivot_less_than(ctx, ++first));
+    }
+    
+    sort_copy(ctx, sort_at(ctx, begin), sort_at(ctx, last));
+    sort_copy(ctx, sort_at(ctx, last), ctx->pivot);
+    return last;
+}
+
+static void sort_pdq(SortContext* ctx, size_t begin, size_t end, int bad_allowed, bool leftmost) {
+    for (;;) {
+        size_t size = end - begin;
+        if (size < SORT_INSERTION_LIMIT) {
+            sort_insertion(ctx, begin, end);
+            return;
+        }
+        
+        // Pivot to 'begin': median of three, or a ninther for long ranges
+        size_t half = size / 2;
+        if (size > SORT_NINTHER_LIMIT) {
+            sort_three(ctx, begin, begin + half, end - 1);
+            sort_three(ctx, begin + 1, begin + half - 1, end - 2);
+            sort_three(ctx, begin + 2, begin + half + 1, end - 3);
+            sort_three(ctx, begin + half - 1, begin + half, begin + half + 1);
+            sort_swap(ctx, begin, begin + half);
+        } else {
+            sort_three(ctx, begin + half, begin, end - 1);
+        }
+        
+        // Many equal elements: put them left and skip them
+        if (!leftmost && !sort_less(ctx, begin - 1, begin)) {
+            begin = sort_partition_left(ctx, begin, end) + 1;
+            continue;
+        }
+        
+        bool already = false;
+        size_t pivot = sort_partition_right(ctx, begin, end, &already);
+        size_t left_size = pivot - begin;
+        size_t right_size = end - (pivot + 1);
+        
+        if (left_size < size / 8 || right_size < size / 8) {
+            // Bad split: after too many, fall back to heapsort; otherwise
+            // shuffle some elements to break up the pattern
+            if (--bad_allowed == 0) {
+                sort_heap(ctx, begin, end);
+                return;
+            }
+            
+            if (left_size >= SORT_INSERTION_LIMIT) {
+                sort_swap(ctx, begin, begin + left_size / 4);
+                sort_swap(ctx, pivot - 1, pivot - left_size / 4);
+                if (left_size > SORT_NINTHER_LIMIT) {
+                    sort_swap(ctx, begin + 1, begin + (left_size / 4 + 1));
+                    sort_swap(ctx, begin + 2, begin + (left_size / 4 + 2));
+                    sort_swap(ctx, pivot - 2, pivot - (left_size / 4 + 1));
+                    sort_swap(ctx, pivot - 3, pivot - (left_size / 4 + 2));
+                }
+            }
+            if (right_size >= SORT_INSERTION_LIMIT) {
+                sort_swap(ctx, pivot + 1, pivot + (1 + right_size / 4));
+                sort_swap(ctx, end - 1, end - right_size / 4);
+                if (right_size > SORT_NINTHER_LIMIT) {
+                    sort_swap(ctx, pivot + 2, pivot + (2 + right_size / 4));
+                    sort_swap(ctx, pivot + 3, pivot + (3 + right_size / 4));
+                    sort_swap(ctx, end - 2, end - (1 + right_size / 4));
+                    sort_swap(ctx, end - 3, end - (2 + right_size / 4));
+                }
+            }
+        } else if (already &&
+                   sort_partial_insertion(ctx, begin, pivot) &&
+                   sort_partial_insertion(ctx, pivot + 1, end)) {
+            // Already sorted (or nearly)
+            return;
+        }
+        
+        // Recurse into the left side, loop on the right
+        sort_pdq(ctx, begin, pivot, bad_allowed, leftmost);
+        begin = pivot + 1;
+        leftmost = false;
+    }
+}
+
+static bool sort_context_init(SortContext* ctx, void* base, size_t size, SortCompare compare, void* data) {
+    ctx->base = (char*)base;
+    ctx->size = size;
+    ctx->compare = compare;
+    ctx->data = data;
+    ctx->temp = (char*)malloc(2 * size);
+    ctx->pivot = ctx->temp ? ctx->temp + size : NULL;
+    return ctx->temp != NULL;
+}
+
+static void sort_pdq_range(void* base, size_t count, size_t size, SortCompare compare, void* data) {
+    if (count < 2) return;
+    
+    SortContext ctx;
+    if (!sort_context_init(&ctx, base, size, compare, data)) return;
+    
+    int bad_allowed = 1;
+    for (size_t n = count; n > 1; n >>= 1) bad_allowed++;
+    
+    sort_pdq(&ctx, 0, count, bad_allowed, true);
+    free(ctx.temp);
+}
+
+// ================ RADIX SORT ================
+
+// LSD radix sort of unsigned keys, a byte per pass, carrying the optional
+// index array along. Passes where every key has the same byte are skipped.
+static void sort_radix(uint64_t* keys, uint64_t* scratch, size_t* index, size_t* index_scratch, size_t count) {
+    if (count < 2) return;
+    
+    // Sorted input costs one scan
+    size_t sorted = 1;
+    while (sorted < count && keys[sorted - 1] <= keys[sorted]) sorted++;
+    if (sorted == count) return;
+    
+    size_t (*counts)[256] = (size_t (*)[256])calloc(8, sizeof(*counts));
+    if (!counts) return;
+    
+    for (size_t i = 0; i < count; i++) {
+        uint64_t key = keys[i];
+        for (int d = 0; d < 8; d++) {
+            counts[d][(key >> (8 * d)) & 255]++;
+        }
+    }
+    
+    uint64_t* source = keys;
+    uint64_t* target = scratch;
+    size_t* index_source = index;
+    size_t* index_target = index_scratch;
+    
+    for (int d = 0; d < 8; d++) {
+        int shift = 8 * d;
+        if (counts[d][(source[0] >> shift) & 255] == count) continue;
+        
+        size_t offsets[256];
+        size_t total = 0;
+        for (int b = 0; b < 256; b++) {
+            offsets[b] = total;
+            total += counts[d][b];
+        }
+        
+        for (size_t i = 0; i < count; i++) {
+            size_t position = offsets[(source[i] >> shift) & 255]++;
+            target[position] = source[i];
+            if (index) index_target[position] = index_source[i];
+        }
+        
+        uint64_t* swap_keys = source;
+        source = target;
+        target = swap_keys;
+        size_t* swap_index = index_source;
+        index_source = index_target;
+        index_target = swap_index;
+    }
+    
+    if (source != keys) {
+        memcpy(keys, source, count * sizeof(uint64_t));
+        if (index) memcpy(index, index_source, count * sizeof(size_t));
+    }
+    free(counts);
+}
+
+// ================ PARALLEL SORT ================
+// The input is cut into one chunk per thread; chunks are sorted
+// concurrently, then merged pairwise, each round's merges running
+// concurrently too. Merges take from the left chunk on ties, so a stable
+// chunk sort gives a stable result.
+
+typedef void (*SortTask)(void* argument);
+
+static int sort_thread_count(size_t count) {
+#if defined(SORT_HAVE_THREADS)
+    if (count < SORT_PARALLEL_THRESHOLD) return 1;
+    
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t threads = cpus > 1 ? (size_t)cpus : 1;
+    if (threads > SORT_MAX_THREADS) threads = SORT_MAX_THREADS;
+    
+    // Keep chunks large enough to be worth a thread
+    size_t chunks = count / (SORT_PARALLEL_THRESHOLD / 4);
+    if (threads > chunks) threads = chunks;
+    return threads > 1 ? (int)threads : 1;
+#else
+    (void)count;
+    return 1;
+#endif
+}
+
+#if defined(SORT_HAVE_THREADS)
+typedef struct {
+    SortTask task;
+    void* argument;
+} SortThreadStart;
+
+static void* sort_thread_main(void* start) {
+    SortThreadStart* thread = (SortThreadStart*)start;
+    thread->task(thread->argument);
+    return NULL;
+}
+#endif
+
+// Run task(arguments[i]) for every i, concurrently where possible
+static void sort_run_tasks(SortTask task, void* arguments, size_t argument_size, int count) {
+    char* argument = (char*)arguments;
+    
+#if defined(SORT_HAVE_THREADS)
+    pthread_t threads[SORT_MAX_THREADS];
+    SortThreadStart starts[SORT_MAX_THREADS];
+    bool started[SORT_MAX_THREADS] = {false};
+    
+    // The calling thread takes the last task
+    for (int i = 0; i + 1 < count; i++) {
+        starts[i].task = task;
+        starts[i].argument = argument + i * argument_size;
+        started[i] = pthread_create(&threads[i], NULL, sort_thread_main, &starts[i]) == 0;
+        if (!started[i]) task(argument + i * argument_size);
+    }
+    if (count > 0) task(argument + (count - 1) * argument_size);
+    
+    for (int i = 0; i + 1 < count; i++) {
+        if (started[i]) pthread_join(threads[i], NULL);
+    }
+#else
+    for (int i = 0; i < count; i++) {
+        task(argument + i * argument_size);
+    }
+#endif
+}
+
+// --- generic values ---
+
+typedef struct {
+    char* base;
+    size_t count;
+    size_t size;
+    SortCompare compare;
+    void* data;
+} SortChunkTask;
+
+static void sort_chunk_task(void* argument) {
+    SortChunkTask* chunk = (SortChunkTask*)argument;
+    sort_pdq_range(chunk->base, chunk->count, chunk->size, chunk->compare, chunk->data);
+}
+
+typedef struct {
+    const char* source;
+    char* target;
+    size_t left;
+    size_t middle;
+    size_t right;
+    size_t size;
+    SortCompare compare;
+    void* data;
+} SortMergeTask;
+
+static void sort_merge_task(void* argument) {
+    SortMergeTask* merge = (SortMergeTask*)argument;
+    size_t size = merge->size;
+    size_t i = merge->left;
+    size_t j = merge->middle;
+    char* out = merge->target + merge->left * size;
+    
+    while (i < merge->middle && j < merge->right) {
+        const char* a = merge->source + i * size;
+        const char* b = merge->source + j * size;
+        if (merge->compare(b, a, merge->data) < 0) {
+            memcpy(out, b, size);
+            j++;
+        } else {
+            memcpy(out, a, size);
+            i++;
+        }
+        out += size;
+    }
+    memcpy(out, merge->source + i * size, (merge->middle - i) * size);
+    out += (merge->middle - i) * size;
+    memcpy(out, merge->source + j * size, (merge->right - j) * size);
+}
+
+// Chunk boundaries: bounds[0] = 0 ... bounds[threads] = count
+static void sort_chunk_bounds(size_t* bounds, size_t count, int threads) {
+    for (int i = 0; i <= threads; i++) {
+        bounds[i] = count * (size_t)i / (size_t)threads;
+    }
+}
+
+static bool sort_values_parallel(void* base, size_t count, size_t size, SortCompare compare, void* data, int threads) {
+    char* scratch = (char*)malloc(count * size);
+    if (!scratch) return false;
+    
+    size_t bounds[SORT_MAX_THREADS + 1];
+    sort_chunk_bounds(bounds, count, threads);
+    
+    SortChunkTask chunks[SORT_MAX_THREADS];
+    for (int i = 0; i < threads; i++) {
+        chunks[i].base = (char*)base + bounds[i] * size;
+        chunks[i].count = bounds[i + 1] - bounds[i];
+        chunks[i].size = size;
+        chunks[i].compare = compare;
+        chunks[i].data = data;
+    }
+    sort_run_tasks(sort_chunk_task, chunks, sizeof(SortChunkTask), threads);
+    
+    // Merge rounds, alternating between the input and the scratch buffer
+    char* source = (char*)base;
+    char* target = scratch;
+    for (int width = 1; width < threads; width *= 2) {
+        SortMergeTask merges[SORT_MAX_THREADS];
+        int merge_count = 0;
+        
+        for (int i = 0; i < threads; i += 2 * width) {
+            int middle = i + width < threads ? i + width : threads;
+            int right = i + 2 * width < threads ? i + 2 * width : threads;
+            SortMergeTask* merge = &merges[merge_count++];
+            merge->source = source;
+            merge->target = target;
+            merge->left = bounds[i];
+            merge->middle = bounds[middle];
+            merge->right = bounds[right];
+            merge->size = size;
+            merge->compare = compare;
+            merge->data = data;
+        }
+        sort_run_tasks(sort_merge_task, merges, sizeof(SortMergeTask), merge_count);
+        
+        char* swap = source;
+        source = target;
+        target = swap;
+    }
+    
+    if (source != (char*)base) memcpy(base, source, count * size);
+    free(scratch);
+    return true;
+}
+
+// --- integer keys ---
+
+typedef struct {
+    uint64_t* keys;
+    uint64_t* scratch;
+    size_t* index;
+    size_t* index_scratch;
+    size_t count;
+} SortRadixTask;
+
+static void sort_radix_task(void* argument) {
+    SortRadixTask* chunk = (SortRadixTask*)argument;
+    sort_radix(chunk->keys, chunk->scratch, chunk->index, chunk->index_scratch, chunk->count);
+}
+
+typedef struct {
+    const uint64_t* source;
+    uint64_t* target;
+    const size_t* index_source;
+    size_t* index_target;
+    size_t left;
+    size_t middle;
+    size_t right;
+} SortKeyMergeTask;
+
+static void sort_key_merge_task(void* argument) {
+    SortKeyMergeTask* merge = (SortKeyMergeTask*)argument;
+    size_t i = merge->left;
+    size_t j = merge->middle;
+    size_t out = merge->left;
+    
+    while (out < merge->right) {
+        size_t from;
+        if (j >= merge->right || (i < merge->middle && merge->source[i] <= merge->source[j])) {
+            from = i++;
+        } else {
+            from = j++;
+        }
+        merge->target[out] = merge->source[from];
+        if (merge->index_target) merge->index_target[out] = merge->index_source[from];
+        out++;
+    }
+}
+
+// Sort unsigned keys (and the index along with them), in parallel when large
+static void sort_keys(uint64_t* keys, uint64_t* scratch, size_t* index, size_t* index_scratch, size_t count) {
+    int threads = sort_thread_count(count);
+    if (threads <= 1) {
+        sort_radix(keys, scratch, index, index_scratch, count);
+        return;
+    }
+    
+    size_t bounds[SORT_MAX_THREADS + 1];
+    sort_chunk_bounds(bounds, count, threads);
+    
+    SortRadixTask chunks[SORT_MAX_THREADS];
+    for (int i = 0; i < threads; i++) {
+        chunks[i].keys = keys + bounds[i];
+        chunks[i].scratch = scratch + bounds[i];
+        chunks[i].index = index ? index + bounds[i] : NULL;
+        chunks[i].index_scratch = index ? index_scratch + bounds[i] : NULL;
+        chunks[i].count = bounds[i + 1] - bounds[i];
+    }
+    sort_run_tasks(sort_radix_task, chunks, sizeof(SortRadixTask), threads);
+    
+    uint64_t* source = keys;
+    uint64_t* target = scratch;
+    size_t* index_source = index;
+    size_t* index_target = index_scratch;
+    for (int width = 1; width < threads; width *= 2) {
+        SortKeyMergeTask merges[SORT_MAX_THREADS];
+        int merge_count = 0;
+        
+        for (int i = 0; i < threads; i += 2 * width) {
+            int middle = i + width < threads ? i + width : threads;
+            int right = i + 2 * width < threads ? i + 2 * width : threads;
+            SortKeyMergeTask* merge = &merges[merge_count++];
+            merge->source = source;
+            merge->target = target;
+            merge->index_source = index_source;
+            merge->index_target = index_target;
+            merge->left = bounds[i];
+            merge->middle = bounds[middle];
+            merge->right = bounds[right];
+        }
+        sort_run_tasks(sort_key_merge_task, merges, sizeof(SortKeyMergeTask), merge_count);
+        
+        uint64_t* swap_keys = source;
+        source = target;
+        target = swap_keys;
+        size_t* swap_index = index_source;
+        index_source = index_target;
+        index_target = swap_index;
+    }
+    
+    if (source != keys) {
+        memcpy(keys, source, count * sizeof(uint64_t));
+        if (index) memcpy(index, index_source, count * sizeof(size_t));
+    }
+}
+
+// ================ PUBLIC INTERFACE ================
+
+void sort_values(void* base, size_t count, size_t size, SortCompare compare, void* data) {
+    if (!base || count < 2 || size == 0 || !compare) return;
+    
+    int threads = sort_thread_count(count);
+    if (threads > 1 && sort_values_parallel(base, count, size, compare, data, threads)) return;
+    
+    sort_pdq_range(base, count, size, compare, data);
+}
+
+static int sort_compare_long(const void* a, const void* b, void* data) {
+    (void)data;
+    long x = *(const long*)a;
+    long y = *(const long*)b;
+    return (x > y) - (x < y);
+}
+
+static int sort_compare_key(const void* a, const void* b, void* data) {
+    (void)data;
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+int64_t sort_double_key(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    
+    // Negative numbers: flip every bit; others: set the sign bit. The
+    // result orders as unsigned; shift it to signed order.
+    bits = (bits & SORT_SIGN_BIT) ? ~bits : bits | SORT_SIGN_BIT;
+    return (int64_t)(bits ^ SORT_SIGN_BIT);
+}
+
+void sort_longs(long* values, size_t count) {
+    if (!values || count < 2) return;
+    
+    uint64_t* keys = count >= SORT_RADIX_MIN ? (uint64_t*)malloc(2 * count * sizeof(uint64_t)) : NULL;
+    if (!keys) {
+        sort_values(values, count, sizeof(long), sort_compare_long, NULL);
+        return;
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        keys[i] = (uint64_t)(int64_t)values[i] ^ SORT_SIGN_BIT;
+    }
+    sort_keys(keys, keys + count, NULL, NULL, count);
+    for (size_t i = 0; i < count; i++) {
+        values[i] = (long)(int64_t)(keys[i] ^ SORT_SIGN_BIT);
+    }
+    
+    free(keys);
+}
+
+void sort_doubles(double* values, size_t count) {
+    if (!values || count < 2) return;
+    
+    uint64_t* keys = (uint64_t*)malloc(2 * count * sizeof(uint64_t));
+    if (!keys) return;
+    
+    for (size_t i = 0; i < count; i++) {
+        keys[i] = (uint64_t)sort_double_key(values[i]) ^ SORT_SIGN_BIT;
+    }
+    
+    if (count >= SORT_RADIX_MIN) {
+        sort_keys(keys, keys + count, NULL, NULL, count);
+    } else {
+        sort_values(keys, count, sizeof(uint64_t), sort_compare_key, NULL);
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        uint64_t bits = keys[i];
+        bits = (bits & SORT_SIGN_BIT) ? bits ^ SORT_SIGN_BIT : ~bits;
+        memcpy(&values[i], &bits, sizeof(bits));
+    }
+    
+    free(keys);
+}
+
+bool sort_by_key(void* base, size_t count, size_t size, SortKey key, void* data) {
+    if (!base || count < 2 || size == 0 || !key) return true;
+    
+    uint64_t* keys = (uint64_t*)malloc(2 * count * sizeof(uint64_t));
+    size_t* index = (size_t*)malloc(2 * count * sizeof(size_t));
+    char* sorted = (char*)malloc(count * size);
+    
+    if (!keys || !index || !sorted) {
+        free(keys);
+        free(index);
+        free(sorted);
+        return false;
+    }
+    
+    // Keys once per element; the radix sort is stable
+    char* element = (char*)base;
+    for (size_t i = 0; i < count; i++) {
+        keys[i] = (uint64_t)key(element + i * size, data) ^ SORT_SIGN_BIT;
+        index[i] = i;
+    }
+    sort_keys(keys, keys + count, index, index + count, count);
+    
+    for (size_t i = 0; i < count; i++) {
+        memcpy(sorted + i * size, element + index[i] * size, size);
+    }
+    memcpy(base, sorted, count * size);
+    
+    free(keys);
+    free(index);
+    free(sorted);
+    return true;
+}
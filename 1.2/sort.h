@@ -0,0 +1,43 @@
+#ifndef SORT_H
+#define SORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ================ SORTING ================
+// Generic values are sorted with pattern-defeating quicksort (pdqsort):
+// quicksort with median-of-three/ninther pivots, insertion sort for short
+// ranges, a fast exit for already-sorted runs, and heapsort when the
+// partitions keep coming out unbalanced, so the worst case stays
+// O(n log n). Integers, doubles and precomputed integer keys go through
+// an LSD radix sort instead. Above SORT_PARALLEL_THRESHOLD elements the
+// input is sorted in chunks on several threads and merged.
+
+#define SORT_INSERTION_LIMIT 24          // Ranges below this use insertion sort
+#define SORT_NINTHER_LIMIT 128           // Ranges above this use a ninther pivot
+#define SORT_RADIX_MIN 256               // Shorter typed arrays use pdqsort
+#define SORT_PARALLEL_THRESHOLD 200000   // Elements before threads are used
+#define SORT_MAX_THREADS 8
+
+// Negative, zero or positive like strcmp; 'data' is passed through
+typedef int (*SortCompare)(const void* a, const void* b, void* data);
+
+// Sort key of an element, computed once per element
+typedef int64_t (*SortKey)(const void* element, void* data);
+
+// Generic sort (not stable)
+void sort_values(void* base, size_t count, size_t size, SortCompare compare, void* data);
+
+// Typed arrays. Doubles sort numerically, -0.0 before 0.0; NaNs go to
+// the end (or the front if their sign bit is set).
+void sort_longs(long* values, size_t count);
+void sort_doubles(double* values, size_t count);
+
+// Sort by a key extracted once per element (stable). False if out of memory.
+bool sort_by_key(void* base, size_t count, size_t size, SortKey key, void* data);
+
+// Order-preserving integer key for a double (for SortKey functions)
+int64_t sort_double_key(double value);
+
+#endif // SORT_H
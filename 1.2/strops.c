@@ -0,0 +1,243 @@
+/**
+ * String operations for Topo Programming Language
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include "strops.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// ================ SEARCH ================
+
+// Scalar search: memchr to the first byte, then compare the rest
+static size_t str_find_scalar(const char* text, size_t length, const char* needle, size_t needle_length, size_t from) {
+    const char* p = text + from;
+    const char* end = text + length;
+    
+    while ((size_t)(end - p) >= needle_length) {
+        p = (const char*)memchr(p, needle[0], (size_t)(end - p) - needle_length + 1);
+        if (!p) return STR_NOT_FOUND;
+        if (memcmp(p + 1, needle + 1, needle_length - 1) == 0) return (size_t)(p - text);
+        p++;
+    }
+    return STR_NOT_FOUND;
+}
+
+size_t str_find(const char* text, size_t length, const char* needle, size_t needle_length, size_t from) {
+    if (from > length || needle_length > length - from) return STR_NOT_FOUND;
+    if (needle_length == 0) return from;
+    
+    if (needle_length == 1) {
+        const char* p = (const char*)memchr(text + from, needle[0], length - from);
+        return p ? (size_t)(p - text) : STR_NOT_FOUND;
+    }
+    
+#if defined(__SSE2__)
+    // Candidates: positions whose first and last bytes both match
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[needle_length - 1]);
+    size_t i = from;
+    
+    while (i + needle_length + 15 <= length) {
+        __m128i block_first = _mm_loadu_si128((const __m128i*)(text + i));
+        __m128i block_last = _mm_loadu_si128((const __m128i*)(text + i + needle_length - 1));
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(block_first, first),
+                                                                  _mm_cmpeq_epi8(block_last, last)));
+        while (mask) {
+            size_t position = i + (size_t)__builtin_ctz(mask);
+            if (memcmp(text + position + 1, needle + 1, needle_length - 2) == 0) return position;
+            mask &= mask - 1;
+        }
+        i += 16;
+    }
+    return str_find_scalar(text, length, needle, needle_length, i);
+#else
+    return str_find_scalar(text, length, needle, needle_length, from);
+#endif
+}
+
+size_t str_count(const char* text, size_t length, const char* needle, size_t needle_length) {
+    if (needle_length == 0) return length + 1;
+    
+    size_t count = 0;
+    size_t position = str_find(text, length, needle, needle_length, 0);
+    while (position != STR_NOT_FOUND) {
+        count++;
+        position = str_find(text, length, needle, needle_length, position + needle_length);
+    }
+    return count;
+}
+
+// ================ BUILDING ================
+
+StrView* str_split(const char* text, size_t length, const char* separator, size_t separator_length, int* count) {
+    if (count) *count = 0;
+    if (separator_length == 0) return NULL;
+    
+    // Pieces are one more than the separators
+    size_t pieces = str_count(text, length, separator, separator_length) + 1;
+    StrView* views = (StrView*)malloc(pieces * sizeof(StrView));
+    if (!views) return NULL;
+    
+    size_t start = 0;
+    for (size_t i = 0; i < pieces; i++) {
+        size_t position = i + 1 < pieces ? str_find(text, length, separator, separator_length, start) : length;
+        views[i].data = text + start;
+        views[i].length = position - start;
+        start = position + separator_length;
+    }
+    
+    if (count) *count = (int)pieces;
+    return views;
+}
+
+char* str_replace(const char* text, size_t length, const char* old, size_t old_length,
+                  const char* replacement, size_t replacement_length, size_t* result_length) {
+    size_t matches = old_length ? str_count(text, length, old, old_length) : 0;
+    size_t total = length - matches * old_length + matches * replacement_length;
+    
+    char* result = (char*)malloc(total + 1);
+    if (!result) return NULL;
+    
+    char* out = result;
+    size_t start = 0;
+    for (size_t i = 0; i < matches; i++) {
+        size_t position = str_find(text, length, old, old_length, start);
+        memcpy(out, text + start, position - start);
+        out += position - start;
+        memcpy(out, replacement, replacement_length);
+        out += replacement_length;
+        start = position + old_length;
+    }
+    memcpy(out, text + start, length - start);
+    result[total] = '\0';
+    
+    if (result_length) *result_length = total;
+    return result;
+}
+
+char* str_join(const StrView* parts, int count, const char* separator, size_t separator_length, size_t* result_length) {
+    size_t total = count > 1 ? (size_t)(count - 1) * separator_length : 0;
+    for (int i = 0; i < count; i++) {
+        total += parts[i].length;
+    }
+    
+    char* result = (char*)malloc(total + 1);
+    if (!result) return NULL;
+    
+    char* out = result;
+    for (int i = 0; i < count; i++) {
+        if (i > 0) {
+            memcpy(out, separator, separator_length);
+            out += separator_length;
+        }
+        memcpy(out, parts[i].data, parts[i].length);
+        out += parts[i].length;
+    }
+    result[total] = '\0';
+    
+    if (result_length) *result_length = total;
+    return result;
+}
+
+// ================ BENCHMARK ================
+
+static size_t str_naive_count(const char* text, size_t length, const char* needle, size_t needle_length) {
+    size_t count = 0;
+    size_t i = 0;
+    while (i + needle_length <= length) {
+        size_t j = 0;
+        while (j < needle_length && text[i + j] == needle[j]) j++;
+        if (j == needle_length) {
+            count++;
+            i += needle_length;
+        } else {
+            i++;
+        }
+    }
+    return count;
+}
+
+// Byte-at-a-time split into views, the baseline for str_split
+static StrView* str_naive_split(const char* text, size_t length, char separator, int* count) {
+    int pieces = 1;
+    for (size_t i = 0; i < length; i++) {
+        if (text[i] == separator) pieces++;
+    }
+    
+    StrView* views = (StrView*)malloc(pieces * sizeof(StrView));
+    if (!views) return NULL;
+    
+    int piece = 0;
+    size_t start = 0;
+    for (size_t i = 0; i <= length; i++) {
+        if (i == length || text[i] == separator) {
+            views[piece].data = text + start;
+            views[piece].length = i - start;
+            piece++;
+            start = i + 1;
+        }
+    }
+    
+    *count = pieces;
+    return views;
+}
+
+static double str_seconds(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+void str_benchmark(const char* text, size_t length, const char* needle, size_t needle_length) {
+    if (needle_length == 0) return;
+    
+    // Repeat small inputs so the timings are measurable
+    int rounds = length ? (int)(200000000 / length) : 1;
+    if (rounds < 1) rounds = 1;
+    if (rounds > 100000) rounds = 100000;
+    double megabytes = (double)length * rounds / (1024.0 * 1024.0);
+    size_t naive = 0, fast = 0;
+    
+    // Read through a volatile so the loops cannot be hoisted out of the rounds
+    const char* volatile input = text;
+    
+    clock_t start = clock();
+    for (int r = 0; r < rounds; r++) naive += str_naive_count(input, length, needle, needle_length);
+    double naive_time = str_seconds(start);
+    
+    start = clock();
+    for (int r = 0; r < rounds; r++) fast += str_count(input, length, needle, needle_length);
+    double fast_time = str_seconds(start);
+    
+    printf("count    %10zu  naive %8.1f MB/s  str_count %8.1f MB/s\n", fast / rounds,
+           megabytes / (naive_time > 0 ? naive_time : 1e-9), megabytes / (fast_time > 0 ? fast_time : 1e-9));
+    if (naive != fast) printf("count mismatch: naive %zu, str_count %zu\n", naive / rounds, fast / rounds);
+    
+    naive = fast = 0;
+    start = clock();
+    for (int r = 0; r < rounds; r++) {
+        int count = 0;
+        StrView* lines = str_naive_split(input, length, '\n', &count);
+        naive += (size_t)count;
+        free(lines);
+    }
+    naive_time = str_seconds(start);
+    
+    start = clock();
+    for (int r = 0; r < rounds; r++) {
+        int count = 0;
+        StrView* lines = str_split(input, length, "\n", 1, &count);
+        fast += (size_t)count;
+        free(lines);
+    }
+    fast_time = str_seconds(start);
+    
+    printf("split    %10zu  naive %8.1f MB/s  str_split %8.1f MB/s\n", fast / rounds,
+           megabytes / (naive_time > 0 ? naive_time : 1e-9), megabytes / (fast_time > 0 ? fast_time : 1e-9));
+    if (naive != fast) printf("split mismatch: naive %zu, str_split %zu\n", naive / rounds, fast / rounds);
+}
@@ -0,0 +1,39 @@
+#ifndef STROPS_H
+#define STROPS_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// ================ STRING OPERATIONS ================
+// find/count/split/replace/join over (pointer, length) byte strings, so
+// the text need not be NUL-terminated. Searches test the needle's first
+// and last bytes at 16 positions at once with SSE2 and compare the rest
+// only where both match (memchr + memcmp without SSE2).
+
+#define STR_NOT_FOUND ((size_t)-1)
+
+typedef struct {
+    const char* data;
+    size_t length;
+} StrView;
+
+// First occurrence of the needle at or after 'from', STR_NOT_FOUND if none
+size_t str_find(const char* text, size_t length, const char* needle, size_t needle_length, size_t from);
+
+// Non-overlapping occurrences (length + 1 for an empty needle)
+size_t str_count(const char* text, size_t length, const char* needle, size_t needle_length);
+
+// Pieces between separators, as views into the text. The array is
+// allocated (caller frees); NULL for an empty separator.
+StrView* str_split(const char* text, size_t length, const char* separator, size_t separator_length, int* count);
+
+// New NUL-terminated strings in a single allocation sized up front
+// (caller frees). An empty 'old' leaves the text unchanged.
+char* str_replace(const char* text, size_t length, const char* old, size_t old_length,
+                  const char* replacement, size_t replacement_length, size_t* result_length);
+char* str_join(const StrView* parts, int count, const char* separator, size_t separator_length, size_t* result_length);
+
+// Time count and split against plain byte loops and print the results
+void str_benchmark(const char* text, size_t length, const char* needle, size_t needle_length);
+
+#endif // STROPS_H
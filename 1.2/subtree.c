@@ -0,0 +1,563 @@
+/**
+ * Subtree hashing and sharing for Topo Programming Language
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "subtree.h"
+#include "ast.h"
+#include "parser.h"
+#include "region.h"
+
+#if !defined(_WIN32) && !defined(SUBTREE_NO_THREADS)
+#include <pthread.h>
+#define SUBTREE_HAVE_THREADS 1
+#endif
+
+// ================ HASHING ================
+
+#define SUBTREE_SEED 0xcbf29ce484222325ULL
+
+static uint64_t subtree_mix(uint64_t hash, uint64_t value) {
+    hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+// FNV-1a, with NULL apart from every string
+static uint64_t subtree_string(const char* text) {
+    if (!text) return 1;
+    
+    uint64_t hash = SUBTREE_SEED;
+    for (const unsigned char* p = (const unsigned char*)text; *p; p++) {
+        hash = (hash ^ *p) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// Size of a subtree, and how much of it is not in the store
+typedef struct {
+    int nodes;
+    int owned;
+} SubtreeSize;
+
+static uint64_t subtree_walk(ASTNode** slot, bool share, SubtreeSize* size);
+static bool subtree_store_intern(ASTNode** slot, uint64_t hash, int owned);
+
+static uint64_t subtree_walk_list(ASTNode** head, bool share, SubtreeSize* size) {
+    uint64_t hash = 2;
+    
+    // A stored copy replaces only a tail, which leaves the chain as it is
+    for (ASTNode** slot = head; *slot; slot = &(*slot)->next) {
+        hash = subtree_mix(hash, subtree_walk(slot, share, size));
+    }
+    return hash;
+}
+
+// Hash the subtree at 'slot', children first, adding up its size in
+// 'total'. When sharing, each child has been through the store by the
+// time its parent is hashed, and then the subtree itself goes through it.
+static uint64_t subtree_walk(ASTNode** slot, bool share, SubtreeSize* total) {
+    ASTNode* node = *slot;
+    if (!node) return 0;
+    
+    // Stored subtrees are hashed, never changed
+    if (node->share != SHARE_NONE) share = false;
+    
+    SubtreeSize size = {1, node->share == SHARE_NONE};
+    uint64_t hash = subtree_mix(SUBTREE_SEED, (uint64_t)node->type);
+    hash = subtree_mix(hash, subtree_string(node->name));
+    
+    switch (node->type) {
+        case NODE_PROGRAM:
+        case NODE_BLOCK:
+            hash = subtree_mix(hash, subtree_walk_list(&node->block.statements, share, &size));
+            break;
+            
+        case NODE_VAR_DECL:
+        case NODE_CONST_DECL:
+            hash = subtree_mix(hash, (uint64_t)node->decl.data_type);
+            hash = subtree_mix(hash, node->decl.is_const);
+            hash = subtree_mix(hash, subtree_walk(&node->decl.value, share, &size));
+            break;
+            
+        case NODE_FUNC_DECL:
+            hash = subtree_mix(hash, (uint64_t)node->func.return_type);
+            for (const FunctionParam* param = node->func.params; param; param = param->next) {
+                hash = subtree_mix(hash, subtree_string(param->name));
+                hash = subtree_mix(hash, (uint64_t)param->type);
+            }
+            hash = subtree_mix(hash, subtree_walk(&node->func.body, share, &size));
+            hash = subtree_mix(hash, subtree_string(node->func.skimmed));
+            break;
+            
+        case NODE_IF_STMT:
+            // A dispatch table is built from the arms, so its presence is enough
+            hash = subtree_mix(hash, node->flow.dispatch != NULL);
+            hash = subtree_mix(hash, subtree_walk(&node->flow.condition, share, &size));
+            hash = subtree_mix(hash, subtree_walk(&node->flow.then_branch, share, &size));
+            hash = subtree_mix(hash, subtree_walk_list(&node->flow.elif_branches, share, &size));
+            hash = subtree_mix(hash, subtree_walk(&node->flow.else_branch, share, &size));
+            hash = subtree_mix(hash, subtree_walk(&node->flow.subject, share, &size));
+            break;
+            
+        case NODE_ELIF_STMT:
+        case NODE_WHILE_STMT:
+            hash = subtree_mix(hash, subtree_walk(&node->flow.condition, share, &size));
+            hash = subtree_mix(hash, subtree_walk(&node->flow.then_branch, share, &size));
+            break;
+            
+        case NODE_FOR_STMT:
+            hash = subtree_mix(hash, (uint64_t)node->loop.view);
+            hash = subtree_mix(hash, subtree_walk(&node->loop.iterable, share, &size));
+            hash = subtree_mix(hash, subtree_walk(&node->loop.body, share, &size));
+            break;
+            
+        case NODE_RETURN_STMT:
+            hash = subtree_mix(hash, subtree_walk(&node->ret.value, share, &size));
+            break;
+            
+        case NODE_EXPR_STMT:
+            hash = subtree_mix(hash, subtree_walk(&node->expr.binary.left, share, &size));
+            break;
+            
+        case NODE_FROM_IMPORT:
+            hash = subtree_mix(hash, node->import.import_all);
+            for (int i = 0; i < node->import.import_count; i++) {
+                hash = subtree_mix(hash, subtree_string(node->import.imports[i]));
+            }
+            break;
+            
+        case NODE_BINARY_EXPR:
+            hash = subtree_mix(hash, subtree_string(node->expr.binary.op));
+            hash = subtree_mix(hash, node->expr.binary.branch);
+            hash = subtree_mix(hash, subtree_walk(&node->expr.binary.left, share, &size));
+            hash = subtree_mix(hash, subtree_walk(&node->expr.binary.right, share, &size));
+            break;
+            
+        case NODE_UNARY_EXPR:
+            hash = subtree_mix(hash, subtree_string(node->expr.unary.op));
+            hash = subtree_mix(hash, subtree_walk(&node->expr.unary.operand, share, &size));
+            break;
+            
+        case NODE_LITERAL:
+            hash = subtree_mix(hash, (uint64_t)node->expr.literal.data_type);
+            switch (node->expr.literal.data_type) {
+                case TYPE_INT:
+                    hash = subtree_mix(hash, (uint64_t)node->expr.literal.value.int_val);
+                    break;
+                case TYPE_FLOAT: {
+                    uint64_t bits;
+                    memcpy(&bits, &node->expr.literal.value.float_val, sizeof(bits));
+                    hash = subtree_mix(hash, bits);
+                    break;
+                }
+                case TYPE_BOOL:
+                    hash = subtree_mix(hash, node->expr.literal.value.bool_val);
+                    break;
+                case TYPE_STRING:
+                    hash = subtree_mix(hash, subtree_string(node->expr.literal.value.string_val));
+                    break;
+                case TYPE_BIGINT:
+                    hash = subtree_mix(hash, subtree_string(node->expr.literal.value.bignum_val));
+                    break;
+                default:
+                    break;
+            }
+            break;
+            
+        case NODE_IDENTIFIER:
+            hash = subtree_mix(hash, subtree_string(node->expr.identifier.identifier));
+            break;
+            
+        case NODE_ASSIGNMENT:
+            hash = subtree_mix(hash, subtree_string(node->expr.assign.op));
+            hash = subtree_mix(hash, subtree_walk(&node->expr.assign.target, share, &size));
+            hash = subtree_mix(hash, subtree_walk(&node->expr.assign.value, share, &size));
+            break;
+            
+        case NODE_CALL_EXPR:
+            hash = subtree_mix(hash, subtree_walk(&node->expr.call.callee, share, &size));
+            hash = subtree_mix(hash, subtree_walk_list(&node->expr.call.arguments, share, &size));
+            break;
+            
+        case NODE_ARRAY_LITERAL:
+            hash = subtree_mix(hash, node->expr.array.no_escape);
+            hash = subtree_mix(hash, subtree_walk_list(&node->expr.array.elements, share, &size));
+            break;
+            
+        case NODE_DICT_LITERAL:
+            // The key table is built from the keys, so its presence is enough
+            hash = subtree_mix(hash, node->expr.dict.no_escape);
+            hash = subtree_mix(hash, node->expr.dict.phash != NULL);
+            for (int i = 0; i < node->expr.dict.pair_count; i++) {
+                hash = subtree_mix(hash, subtree_string(node->expr.dict.keys[i]));
+            }
+            hash = subtree_mix(hash, subtree_walk_list(&node->expr.dict.values, share, &size));
+            break;
+            
+        case NODE_MEMBER_ACCESS:
+            hash = subtree_mix(hash, subtree_string(node->expr.member.member));
+            hash = subtree_mix(hash, subtree_walk(&node->expr.member.object, share, &size));
+            break;
+            
+        case NODE_INDEX_ACCESS:
+            hash = subtree_mix(hash, node->expr.index.unchecked);
+            hash = subtree_mix(hash, subtree_walk(&node->expr.index.array, share, &size));
+            hash = subtree_mix(hash, subtree_walk(&node->expr.index.index, share, &size));
+            break;
+            
+        case NODE_SLICE_EXPR:
+            hash = subtree_mix(hash, subtree_walk(&node->expr.slice.object, share, &size));
+            hash = subtree_mix(hash, subtree_walk(&node->expr.slice.start, share, &size));
+            hash = subtree_mix(hash, subtree_walk(&node->expr.slice.end, share, &size));
+            break;
+            
+        case NODE_RANGE_EXPR:
+            hash = subtree_mix(hash, subtree_walk(&node->expr.range.start, share, &size));
+            hash = subtree_mix(hash, subtree_walk(&node->expr.range.end, share, &size));
+            hash = subtree_mix(hash, subtree_walk(&node->expr.range.step, share, &size));
+            break;
+            
+        default:
+            break;
+    }
+    
+    // Only a node without a successor can be swapped for a stored copy
+    if (share && size.nodes >= SUBTREE_MIN_NODES && !node->next &&
+        subtree_store_intern(slot, hash, size.owned)) {
+        size.owned = 0;
+    }
+    
+    total->nodes += size.nodes;
+    total->owned += size.owned;
+    return hash;
+}
+
+uint64_t subtree_hash(const ASTNode* node) {
+    ASTNode* root = (ASTNode*)node;
+    SubtreeSize size = {0, 0};
+    return subtree_walk(&root, false, &size);
+}
+
+// ================ EQUALITY ================
+// The same fields as the hash, compared exactly
+
+static bool same_string(const char* a, const char* b) {
+    if (!a || !b) return a == b;
+    return strcmp(a, b) == 0;
+}
+
+static bool same_list(const ASTNode* a, const ASTNode* b) {
+    for (; a && b; a = a->next, b = b->next) {
+        if (!subtree_equal(a, b)) return false;
+    }
+    return !a && !b;
+}
+
+static bool same_params(const FunctionParam* a, const FunctionParam* b) {
+    for (; a && b; a = a->next, b = b->next) {
+        if (!same_string(a->name, b->name) || a->type != b->type) return false;
+    }
+    return !a && !b;
+}
+
+bool subtree_equal(const ASTNode* a, const ASTNode* b) {
+    if (a == b) return true;
+    if (!a || !b) return false;
+    if (a->type != b->type || !same_string(a->name, b->name)) return false;
+    
+    switch (a->type) {
+        case NODE_PROGRAM:
+        case NODE_BLOCK:
+            return same_list(a->block.statements, b->block.statements);
+            
+        case NODE_VAR_DECL:
+        case NODE_CONST_DECL:
+            return a->decl.data_type == b->decl.data_type &&
+                   a->decl.is_const == b->decl.is_const &&
+                   subtree_equal(a->decl.value, b->decl.value);
+            
+        case NODE_FUNC_DECL:
+            return a->func.return_type == b->func.return_type &&
+                   same_params(a->func.params, b->func.params) &&
+                   subtree_equal(a->func.body, b->func.body) &&
+                   same_string(a->func.skimmed, b->func.skimmed);
+            
+        case NODE_IF_STMT:
+            return (a->flow.dispatch != NULL) == (b->flow.dispatch != NULL) &&
+                   subtree_equal(a->flow.condition, b->flow.condition) &&
+                   subtree_equal(a->flow.then_branch, b->flow.then_branch) &&
+                   same_list(a->flow.elif_branches, b->flow.elif_branches) &&
+                   subtree_equal(a->flow.else_branch, b->flow.else_branch) &&
+                   subtree_equal(a->flow.subject, b->flow.subject);
+            
+        case NODE_ELIF_STMT:
+        case NODE_WHILE_STMT:
+            return subtree_equal(a->flow.condition, b->flow.condition) &&
+                   subtree_equal(a->flow.then_branch, b->flow.then_branch);
+            
+        case NODE_FOR_STMT:
+            return a->loop.view == b->loop.view &&
+                   subtree_equal(a->loop.iterable, b->loop.iterable) &&
+                   subtree_equal(a->loop.body, b->loop.body);
+            
+        case NODE_RETURN_STMT:
+            return subtree_equal(a->ret.value, b->ret.value);
+            
+        case NODE_EXPR_STMT:
+            return subtree_equal(a->expr.binary.left, b->expr.binary.left);
+            
+        case NODE_FROM_IMPORT:
+            if (a->import.import_all != b->import.import_all ||
+                a->import.import_count != b->import.import_count) return false;
+            for (int i = 0; i < a->import.import_count; i++) {
+                if (!same_string(a->import.imports[i], b->import.imports[i])) return false;
+            }
+            return true;
+            
+        case NODE_BINARY_EXPR:
+            return same_string(a->expr.binary.op, b->expr.binary.op) &&
+                   a->expr.binary.branch == b->expr.binary.branch &&
+                   subtree_equal(a->expr.binary.left, b->expr.binary.left) &&
+                   subtree_equal(a->expr.binary.right, b->expr.binary.right);
+            
+        case NODE_UNARY_EXPR:
+            return same_string(a->expr.unary.op, b->expr.unary.op) &&
+                   subtree_equal(a->expr.unary.operand, b->expr.unary.operand);
+            
+        case NODE_LITERAL:
+            if (a->expr.literal.data_type != b->expr.literal.data_type) return false;
+            switch (a->expr.literal.data_type) {
+                case TYPE_INT:
+                    return a->expr.literal.value.int_val == b->expr.literal.value.int_val;
+                case TYPE_FLOAT:
+                    return memcmp(&a->expr.literal.value.float_val, &b->expr.literal.value.float_val,
+                                  sizeof(double)) == 0;
+                case TYPE_BOOL:
+                    return a->expr.literal.value.bool_val == b->expr.literal.value.bool_val;
+                case TYPE_STRING:
+                    return same_string(a->expr.literal.value.string_val, b->expr.literal.value.string_val);
+                case TYPE_BIGINT:
+                    return same_string(a->expr.literal.value.bignum_val, b->expr.literal.value.bignum_val);
+                default:
+                    return true;
+            }
+            
+        case NODE_IDENTIFIER:
+            return same_string(a->expr.identifier.identifier, b->expr.identifier.identifier);
+            
+        case NODE_ASSIGNMENT:
+            return same_string(a->expr.assign.op, b->expr.assign.op) &&
+                   subtree_equal(a->expr.assign.target, b->expr.assign.target) &&
+                   subtree_equal(a->expr.assign.value, b->expr.assign.value);
+            
+        case NODE_CALL_EXPR:
+            return subtree_equal(a->expr.call.callee, b->expr.call.callee) &&
+                   same_list(a->expr.call.arguments, b->expr.call.arguments);
+            
+        case NODE_ARRAY_LITERAL:
+            return a->expr.array.no_escape == b->expr.array.no_escape &&
+                   same_list(a->expr.array.elements, b->expr.array.elements);
+            
+        case NODE_DICT_LITERAL:
+            if (a->expr.dict.no_escape != b->expr.dict.no_escape ||
+                (a->expr.dict.phash != NULL) != (b->expr.dict.phash != NULL) ||
+                a->expr.dict.pair_count != b->expr.dict.pair_count) return false;
+            for (int i = 0; i < a->expr.dict.pair_count; i++) {
+                if (!same_string(a->expr.dict.keys[i], b->expr.dict.keys[i])) return false;
+            }
+            return same_list(a->expr.dict.values, b->expr.dict.values);
+            
+        case NODE_MEMBER_ACCESS:
+            return same_string(a->expr.member.member, b->expr.member.member) &&
+                   subtree_equal(a->expr.member.object, b->expr.member.object);
+            
+        case NODE_INDEX_ACCESS:
+            return a->expr.index.unchecked == b->expr.index.unchecked &&
+                   subtree_equal(a->expr.index.array, b->expr.index.array) &&
+                   subtree_equal(a->expr.index.index, b->expr.index.index);
+            
+        case NODE_SLICE_EXPR:
+            return subtree_equal(a->expr.slice.object, b->expr.slice.object) &&
+                   subtree_equal(a->expr.slice.start, b->expr.slice.start) &&
+                   subtree_equal(a->expr.slice.end, b->expr.slice.end);
+            
+        case NODE_RANGE_EXPR:
+            return subtree_equal(a->expr.range.start, b->expr.range.start) &&
+                   subtree_equal(a->expr.range.end, b->expr.range.end) &&
+                   subtree_equal(a->expr.range.step, b->expr.range.step);
+            
+        default:
+            return true;
+    }
+}
+
+// ================ STORE ================
+// An open-addressed table from hash to stored subtree, behind one lock.
+// A stored subtree is a heap copy whose own nodes are SHARE_INNER and
+// whose root is SHARE_ROOT; a child that was already stored is pointed
+// to, not copied, so a stored subtree refers only to roots stored before
+// it.
+
+typedef struct {
+    uint64_t hash;
+    ASTNode* node;      // NULL: free slot
+} SubtreeEntry;
+
+static SubtreeEntry* subtree_entries = NULL;
+static int subtree_capacity = 0;       // Power of two
+static ASTNode** subtree_roots = NULL; // In the order stored
+static int subtree_root_capacity = 0;
+static SubtreeStats subtree_totals = {0, 0, 0, 0};
+
+#if defined(SUBTREE_HAVE_THREADS)
+static pthread_mutex_t subtree_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void subtree_store_lock(void) {
+#if defined(SUBTREE_HAVE_THREADS)
+    pthread_mutex_lock(&subtree_lock);
+#endif
+}
+
+static void subtree_store_unlock(void) {
+#if defined(SUBTREE_HAVE_THREADS)
+    pthread_mutex_unlock(&subtree_lock);
+#endif
+}
+
+static bool subtree_store_grow(void) {
+    int capacity = subtree_capacity ? subtree_capacity * 2 : 1024;
+    SubtreeEntry* entries = (SubtreeEntry*)calloc((size_t)capacity, sizeof(SubtreeEntry));
+    if (!entries) return false;
+    
+    for (int i = 0; i < subtree_capacity; i++) {
+        if (!subtree_entries[i].node) continue;
+        int slot = (int)(subtree_entries[i].hash & (uint64_t)(capacity - 1));
+        while (entries[slot].node) slot = (slot + 1) & (capacity - 1);
+        entries[slot] = subtree_entries[i];
+    }
+    
+    free(subtree_entries);
+    subtree_entries = entries;
+    subtree_capacity = capacity;
+    return true;
+}
+
+static ASTNode* subtree_copy_child(const ASTNode* child) {
+    if (child && child->share == SHARE_ROOT) return (ASTNode*)child;
+    return copy_ast_node(child, subtree_copy_child);
+}
+
+static void subtree_mark_visitor(ASTNode** slot, void* data) {
+    if ((*slot)->share == SHARE_ROOT) return;
+    (*slot)->share = SHARE_INNER;
+    ast_for_each_child(*slot, subtree_mark_visitor, data);
+}
+
+// Swap the subtree at 'slot' for the stored copy, storing it first if
+// new; 'owned' of its nodes are not stored yet. False if it stays as is.
+static bool subtree_store_intern(ASTNode** slot, uint64_t hash, int owned) {
+    ASTNode* stored = NULL;
+    
+    subtree_store_lock();
+    
+    if (subtree_totals.subtrees * 2 >= subtree_capacity && !subtree_store_grow()) {
+        subtree_store_unlock();
+        return false;
+    }
+    if (subtree_totals.subtrees == subtree_root_capacity) {
+        int capacity = subtree_root_capacity ? subtree_root_capacity * 2 : 1024;
+        ASTNode** roots = (ASTNode**)realloc(subtree_roots, (size_t)capacity * sizeof(ASTNode*));
+        if (!roots) {
+            subtree_store_unlock();
+            return false;
+        }
+        subtree_roots = roots;
+        subtree_root_capacity = capacity;
+    }
+    
+    int index = (int)(hash & (uint64_t)(subtree_capacity - 1));
+    for (; subtree_entries[index].node; index = (index + 1) & (subtree_capacity - 1)) {
+        if (subtree_entries[index].hash == hash && subtree_equal(subtree_entries[index].node, *slot)) {
+            stored = subtree_entries[index].node;
+            subtree_totals.hits++;
+            subtree_totals.nodes_saved += owned;
+            break;
+        }
+    }
+    
+    if (!stored && subtree_totals.nodes + owned <= SUBTREE_MAX_NODES) {
+        // Stored copies live on the heap, whatever region the caller uses
+        Region* region = ast_use_region(NULL);
+        stored = copy_ast_node(*slot, subtree_copy_child);
+        ast_use_region(region);
+        
+        if (stored) {
+            ast_for_each_child(stored, subtree_mark_visitor, NULL);
+            stored->share = SHARE_ROOT;
+            subtree_entries[index].hash = hash;
+            subtree_entries[index].node = stored;
+            subtree_roots[subtree_totals.subtrees++] = stored;
+            subtree_totals.nodes += owned;
+        }
+    }
+    
+    subtree_store_unlock();
+    
+    if (!stored) return false;
+    
+    free_ast_node(*slot);
+    *slot = stored;
+    return true;
+}
+
+void subtree_share(ASTNode** root) {
+    if (!root || !*root) return;
+    
+    // Stored subtrees never change, so skimmed bodies are parsed first
+    parse_function_bodies(*root);
+    SubtreeSize size = {0, 0};
+    subtree_walk(root, true, &size);
+}
+
+SubtreeStats subtree_stats(void) {
+    subtree_store_lock();
+    SubtreeStats stats = subtree_totals;
+    subtree_store_unlock();
+    return stats;
+}
+
+// Hand the nodes of a stored subtree back, up to the other stored roots
+static void subtree_release_visitor(ASTNode** slot, void* data) {
+    if ((*slot)->share == SHARE_ROOT) return;
+    (*slot)->share = SHARE_NONE;
+    ast_for_each_child(*slot, subtree_release_visitor, data);
+}
+
+void subtree_store_clear(void) {
+    subtree_store_lock();
+    
+    for (int i = 0; i < subtree_totals.subtrees; i++) {
+        ast_for_each_child(subtree_roots[i], subtree_release_visitor, NULL);
+    }
+    
+    // Newest first: free_ast_node then stops at the older roots, still there
+    for (int i = subtree_totals.subtrees - 1; i >= 0; i--) {
+        subtree_roots[i]->share = SHARE_NONE;
+        free_ast_node(subtree_roots[i]);
+    }
+    
+    free(subtree_entries);
+    free(subtree_roots);
+    subtree_entries = NULL;
+    subtree_roots = NULL;
+    subtree_capacity = 0;
+    subtree_root_capacity = 0;
+    memset(&subtree_totals, 0, sizeof(subtree_totals));
+    
+    subtree_store_unlock();
+}
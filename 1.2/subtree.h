@@ -0,0 +1,45 @@
+#ifndef SUBTREE_H
+#define SUBTREE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ast.h"
+
+// ================ SUBTREE HASHING AND SHARING ================
+// A structural hash of a subtree covers everything that makes up its
+// meaning (node types, names, operators, literals, flags, children in
+// order) and nothing else: positions and addresses are left out, so the
+// same code hashes the same in every file and every run.
+//
+// The subtree store is process-wide and content-addressed. Sharing a
+// program hashes it bottom-up and replaces each subtree the store already
+// holds with the stored copy; larger subtrees it does not hold yet are
+// copied into it. Stored subtrees are shared by every AST that uses them:
+// they never change, free_ast_node leaves them, and their line and column
+// are those of the first copy seen. Share a program only once nothing is
+// going to change it.
+
+#define SUBTREE_MIN_NODES 8             // Smallest subtree worth storing
+#define SUBTREE_MAX_NODES 4000000       // Nodes the store holds at most
+
+typedef struct {
+    int subtrees;       // Subtrees held
+    long nodes;         // Nodes held
+    long hits;          // Subtrees replaced by a stored copy
+    long nodes_saved;   // Nodes in those subtrees
+} SubtreeStats;
+
+uint64_t subtree_hash(const ASTNode* node);
+bool subtree_equal(const ASTNode* a, const ASTNode* b);
+
+// Share the subtrees of '*root' through the store, once any skimmed
+// function bodies are parsed; the root itself may be replaced. Safe to
+// call from several threads at once.
+void subtree_share(ASTNode** root);
+
+SubtreeStats subtree_stats(void);
+
+// Free everything stored; no AST may still use it
+void subtree_store_clear(void);
+
+#endif // SUBTREE_H
@@ -0,0 +1,146 @@
+/**
+ * Token DFA generator for Topo Programming Language
+ *
+ * Builds the DFA that matches the keywords and symbols of tokens.def and
+ * writes it as C tables. Run it again whenever tokens.def changes:
+ *
+ *   gcc -o tokengen tokengen.c && ./tokengen > tokens_dfa.h
+ *
+ * The lexer checks at compile time that tokens_dfa.h matches tokens.def.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ================ SPECIFICATION ================
+
+static const char* const keywords[] = {
+#define TOKEN_KEYWORD(type, text, name) text,
+#include "tokens.def"
+};
+
+static const char* const symbols[] = {
+#define TOKEN_SYMBOL(text, type) text,
+#include "tokens.def"
+};
+
+#define KEYWORDS ((int)(sizeof(keywords) / sizeof(keywords[0])))
+#define SYMBOLS ((int)(sizeof(symbols) / sizeof(symbols[0])))
+#define ENTRIES (KEYWORDS + SYMBOLS)
+
+// ================ AUTOMATON ================
+// One trie over all entries with two start states: keywords are matched
+// against a whole identifier, symbols by longest match. Every entry has an
+// accepting state of its own, so no two states accept the same suffixes
+// and the trie is already the minimal DFA; what is left to shrink is the
+// alphabet, folded into classes of bytes with identical columns.
+
+#define MAX_STATES 256      // States are stored in a byte
+#define DEAD 0
+
+static int next[MAX_STATES][256];
+static int accept[MAX_STATES];     // Entry plus one, 0 for none
+static int state_count = 1;        // State 0 is the dead state
+
+static int add_state(void) {
+    if (state_count == MAX_STATES) {
+        fprintf(stderr, "tokengen: more than %d states\n", MAX_STATES);
+        exit(1);
+    }
+    return state_count++;
+}
+
+static void add_entry(int start, const char* text, int entry) {
+    if (!text[0]) {
+        fprintf(stderr, "tokengen: empty token text\n");
+        exit(1);
+    }
+
+    int state = start;
+    for (const unsigned char* p = (const unsigned char*)text; *p; p++) {
+        if (!next[state][*p]) next[state][*p] = add_state();
+        state = next[state][*p];
+    }
+
+    if (accept[state]) {
+        fprintf(stderr, "tokengen: '%s' is listed twice\n", text);
+        exit(1);
+    }
+    accept[state] = entry + 1;
+}
+
+static int byte_class[256];
+static int class_byte[256];        // A byte of each class
+static int class_count = 0;
+
+static int same_column(int a, int b) {
+    for (int s = 0; s < state_count; s++) {
+        if (next[s][a] != next[s][b]) return 0;
+    }
+    return 1;
+}
+
+// Byte 0 never starts or continues a token, so class 0 is the all-dead column
+static void build_classes(void) {
+    for (int c = 0; c < 256; c++) {
+        int k = 0;
+        while (k < class_count && !same_column(class_byte[k], c)) k++;
+        if (k == class_count) class_byte[class_count++] = c;
+        byte_class[c] = k;
+    }
+}
+
+// ================ OUTPUT ================
+
+int main(void) {
+    int keyword_start = add_state();
+    int symbol_start = add_state();
+
+    for (int i = 0; i < KEYWORDS; i++) add_entry(keyword_start, keywords[i], i);
+    for (int i = 0; i < SYMBOLS; i++) add_entry(symbol_start, symbols[i], KEYWORDS + i);
+
+    build_classes();
+
+    // Bytes of the texts, one separator each, and the terminator
+    size_t spec_size = 1;
+    for (int i = 0; i < KEYWORDS; i++) spec_size += strlen(keywords[i]) + 1;
+    for (int i = 0; i < SYMBOLS; i++) spec_size += strlen(symbols[i]) + 1;
+
+    printf("// Generated by tokengen from tokens.def; do not edit.\n");
+    printf("// %d keywords, %d symbols: %d states, %d byte classes\n\n", KEYWORDS, SYMBOLS, state_count, class_count);
+    printf("#define TOKEN_DFA_KEYWORDS %d\n", KEYWORDS);
+    printf("#define TOKEN_DFA_SYMBOLS %d\n", SYMBOLS);
+    printf("#define TOKEN_DFA_SPEC_SIZE %zu\n", spec_size);
+    printf("#define TOKEN_DFA_STATES %d\n", state_count);
+    printf("#define TOKEN_DFA_CLASSES %d\n", class_count);
+    printf("#define TOKEN_DFA_KEYWORD_START %d\n", keyword_start);
+    printf("#define TOKEN_DFA_SYMBOL_START %d\n\n", symbol_start);
+
+    printf("static const unsigned char token_dfa_class[256] = {");
+    for (int c = 0; c < 256; c++) {
+        printf("%s%d,", c % 16 ? " " : "\n    ", byte_class[c]);
+    }
+    printf("\n};\n\n");
+
+    printf("// Next state by state and byte class; 0 is the dead state\n");
+    printf("static const unsigned char token_dfa_next[TOKEN_DFA_STATES][TOKEN_DFA_CLASSES] = {\n");
+    for (int s = 0; s < state_count; s++) {
+        printf("    {");
+        for (int k = 0; k < class_count; k++) {
+            printf("%s%d", k ? ", " : "", next[s][class_byte[k]]);
+        }
+        printf("},\n");
+    }
+    printf("};\n\n");
+
+    printf("// Entry accepted in each state, plus one (keywords, then symbols, in\n");
+    printf("// the order of tokens.def); 0 for none\n");
+    printf("static const unsigned char token_dfa_accept[TOKEN_DFA_STATES] = {");
+    for (int s = 0; s < state_count; s++) {
+        printf("%s%d,", s % 16 ? " " : "\n    ", accept[s]);
+    }
+    printf("\n};\n");
+
+    return 0;
+}
@@ -0,0 +1,1305 @@
+/**
+ * Precompiled AST files for Topo Programming Language
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include "topoc.h"
+#include "ast.h"
+#include "parser.h"
+#include "phash.h"
+#include "dispatch.h"
+#include "sort.h"
+
+#if defined(_WIN32)
+#define TOPOC_NO_MMAP 1
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+static void topoc_error(char* error, size_t error_size, const char* message, const char* detail) {
+    if (error && error_size > 0) {
+        snprintf(error, error_size, "%s%s%s", message, detail ? ": " : "", detail ? detail : "");
+    }
+}
+
+// ================ WRITER ================
+
+typedef struct {
+    TopocNode* nodes;
+    uint32_t node_count;
+    uint32_t node_capacity;
+    
+    uint32_t* extra;
+    uint32_t extra_count;
+    uint32_t extra_capacity;
+    
+    uint32_t* offsets;          // Start of each string in 'bytes'
+    uint32_t string_count;
+    uint32_t offset_capacity;
+    char* bytes;
+    uint32_t byte_count;
+    uint32_t byte_capacity;
+    
+    uint32_t* buckets;          // String index + 1 by hash (0: empty)
+    uint32_t bucket_count;      // Power of two
+    
+    uint32_t* imports;          // Module names, for the header's import list
+    uint32_t import_count;
+    uint32_t import_capacity;
+    
+    unsigned char* positions;   // Encoded as the nodes are numbered
+    uint32_t position_bytes;
+    uint32_t position_capacity;
+    int line;                   // Position of the last node numbered
+    int column;
+    
+    bool failed;
+} TopocWriter;
+
+static bool topoc_reserve(TopocWriter* writer, void** items, uint32_t* capacity, uint32_t needed, size_t item_size) {
+    if (needed <= *capacity) return true;
+    
+    uint32_t grown = *capacity ? *capacity : 64;
+    while (grown < needed) grown *= 2;
+    
+    void* resized = realloc(*items, (size_t)grown * item_size);
+    if (!resized) {
+        writer->failed = true;
+        return false;
+    }
+    *items = resized;
+    *capacity = grown;
+    return true;
+}
+
+static void topoc_word(TopocWriter* writer, uint32_t word) {
+    if (!topoc_reserve(writer, (void**)&writer->extra, &writer->extra_capacity,
+                       writer->extra_count + 1, sizeof(uint32_t))) return;
+    writer->extra[writer->extra_count++] = word;
+}
+
+// A long as two words, low half first
+static void topoc_long(TopocWriter* writer, long value) {
+    uint64_t bits = (uint64_t)(int64_t)value;
+    topoc_word(writer, (uint32_t)bits);
+    topoc_word(writer, (uint32_t)(bits >> 32));
+}
+
+// Each node's position is one varint, 7 bits a byte, low bits first:
+//
+//   (column << 2) | line
+//
+// where 'line' is the line delta from the previous node when it is 0 to
+// 2, or 3 with the zigzagged delta in a second varint; and 'column' is the
+// zigzagged column delta on the same line, or the column itself (also
+// zigzagged) on a new one. Positions start from line 0, column 0.
+
+#define TOPOC_VARINT_MAX 10         // Bytes of a 64-bit varint
+
+static uint64_t topoc_zigzag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t topoc_unzigzag(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static void topoc_varint(TopocWriter* writer, uint64_t value) {
+    if (!topoc_reserve(writer, (void**)&writer->positions, &writer->position_capacity,
+                       writer->position_bytes + TOPOC_VARINT_MAX, 1)) return;
+    while (value >= 0x80) {
+        writer->positions[writer->position_bytes++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    writer->positions[writer->position_bytes++] = (unsigned char)value;
+}
+
+static void topoc_position(TopocWriter* writer, int line, int column) {
+    int64_t lines = (int64_t)line - writer->line;
+    uint64_t step = lines >= 0 && lines <= 2 ? (uint64_t)lines : 3;
+    uint64_t columns = lines == 0 ? topoc_zigzag((int64_t)column - writer->column) : topoc_zigzag(column);
+    
+    topoc_varint(writer, (columns << 2) | step);
+    if (step == 3) topoc_varint(writer, topoc_zigzag(lines));
+    
+    writer->line = line;
+    writer->column = column;
+}
+
+static uint32_t topoc_hash(const char* text) {
+    uint32_t hash = 2166136261u;
+    for (; *text; text++) {
+        hash = (hash ^ (unsigned char)*text) * 16777619u;
+    }
+    return hash;
+}
+
+static bool topoc_rehash(TopocWriter* writer) {
+    uint32_t count = writer->bucket_count ? writer->bucket_count * 2 : 1024;
+    uint32_t* buckets = (uint32_t*)calloc(count, sizeof(uint32_t));
+    if (!buckets) {
+        writer->failed = true;
+        return false;
+    }
+    
+    for (uint32_t i = 0; i < writer->string_count; i++) {
+        uint32_t slot = topoc_hash(writer->bytes + writer->offsets[i]) & (count - 1);
+        while (buckets[slot]) slot = (slot + 1) & (count - 1);
+        buckets[slot] = i + 1;
+    }
+    
+    free(writer->buckets);
+    writer->buckets = buckets;
+    writer->bucket_count = count;
+    return true;
+}
+
+// Each distinct string is stored once
+static uint32_t topoc_string(TopocWriter* writer, const char* text) {
+    if (!text) return 0;
+    
+    if (writer->string_count * 2 >= writer->bucket_count && !topoc_rehash(writer)) return 0;
+    
+    uint32_t slot = topoc_hash(text) & (writer->bucket_count - 1);
+    while (writer->buckets[slot]) {
+        uint32_t index = writer->buckets[slot] - 1;
+        if (strcmp(writer->bytes + writer->offsets[index], text) == 0) return index + 1;
+        slot = (slot + 1) & (writer->bucket_count - 1);
+    }
+    
+    uint32_t length = (uint32_t)strlen(text) + 1;
+    if (!topoc_reserve(writer, (void**)&writer->offsets, &writer->offset_capacity,
+                       writer->string_count + 1, sizeof(uint32_t)) ||
+        !topoc_reserve(writer, (void**)&writer->bytes, &writer->byte_capacity,
+                       writer->byte_count + length, 1)) return 0;
+    
+    memcpy(writer->bytes + writer->byte_count, text, length);
+    writer->offsets[writer->string_count] = writer->byte_count;
+    writer->byte_count += length;
+    writer->buckets[slot] = ++writer->string_count;
+    return writer->string_count;
+}
+
+static uint32_t topoc_node(TopocWriter* writer, const ASTNode* node);
+
+// A list is its head; the rest hang off each record's 'next'
+static uint32_t topoc_list(TopocWriter* writer, const ASTNode* head) {
+    uint32_t first = 0;
+    uint32_t previous = 0;
+    
+    for (const ASTNode* node = head; node; node = node->next) {
+        uint32_t id = topoc_node(writer, node);
+        if (previous) writer->nodes[previous - 1].next = id;
+        else first = id;
+        previous = id;
+    }
+    return first;
+}
+
+static void topoc_dispatch(TopocWriter* writer, const DispatchTable* table, TopocNode* record) {
+    record->flags |= TOPOC_NODE_DISPATCH;
+    record->extra = writer->extra_count + 1;
+    record->count = 0;
+    
+    switch (table->kind) {
+        case DISPATCH_DENSE:
+            for (int i = 0; i < table->range; i++) {
+                if (table->arms[i] < 0) continue;
+                topoc_long(writer, table->min_value + i);
+                topoc_word(writer, (uint32_t)table->arms[i]);
+                record->count++;
+            }
+            break;
+            
+        case DISPATCH_SORTED:
+            for (int i = 0; i < table->label_count; i++) {
+                topoc_long(writer, table->values[i]);
+                topoc_word(writer, (uint32_t)table->arms[i]);
+                record->count++;
+            }
+            break;
+            
+        case DISPATCH_HASHED:
+            record->flags |= TOPOC_NODE_STRINGS;
+            for (int i = 0; i < table->label_count; i++) {
+                uint32_t key = topoc_string(writer, table->keys[i]);
+                topoc_word(writer, key);
+                topoc_word(writer, (uint32_t)table->arms[i]);
+                record->count++;
+            }
+            break;
+    }
+}
+
+static uint32_t topoc_node(TopocWriter* writer, const ASTNode* node) {
+    if (!node || writer->failed) return 0;
+    
+    // Children are written first, so the record is filled in locally and
+    // stored at its index at the end
+    if (!topoc_reserve(writer, (void**)&writer->nodes, &writer->node_capacity,
+                       writer->node_count + 1, sizeof(TopocNode))) return 0;
+    uint32_t index = writer->node_count++;
+    topoc_position(writer, node->line, node->column);
+    
+    TopocNode record;
+    memset(&record, 0, sizeof(record));
+    record.type = (uint8_t)node->type;
+    record.name = topoc_string(writer, node->name);
+    
+    switch (node->type) {
+        case NODE_PROGRAM:
+        case NODE_BLOCK:
+            record.child[0] = topoc_list(writer, node->block.statements);
+            break;
+            
+        case NODE_VAR_DECL:
+        case NODE_CONST_DECL:
+            record.data_type = (uint8_t)node->decl.data_type;
+            if (node->decl.is_const) record.flags |= TOPOC_NODE_CONST;
+            record.child[0] = topoc_node(writer, node->decl.value);
+            break;
+            
+        case NODE_FUNC_DECL:
+            record.data_type = (uint8_t)node->func.return_type;
+            record.extra = writer->extra_count + 1;
+            for (const FunctionParam* param = node->func.params; param; param = param->next) {
+                uint32_t name = topoc_string(writer, param->name);
+                topoc_word(writer, name);
+                topoc_word(writer, (uint32_t)param->type);
+                record.count++;
+            }
+            record.child[0] = topoc_node(writer, node->func.body);
+            break;
+            
+        case NODE_IF_STMT:
+            record.child[0] = topoc_node(writer, node->flow.condition);
+            record.child[1] = topoc_node(writer, node->flow.then_branch);
+            record.child[2] = topoc_list(writer, node->flow.elif_branches);
+            record.child[3] = topoc_node(writer, node->flow.else_branch);
+            record.child[4] = topoc_node(writer, node->flow.subject);
+            if (node->flow.dispatch) topoc_dispatch(writer, node->flow.dispatch, &record);
+            break;
+            
+        case NODE_ELIF_STMT:
+        case NODE_WHILE_STMT:
+            record.child[0] = topoc_node(writer, node->flow.condition);
+            record.child[1] = topoc_node(writer, node->flow.then_branch);
+            break;
+            
+        case NODE_FOR_STMT:
+            record.view = (uint8_t)node->loop.view;
+            record.child[0] = topoc_node(writer, node->loop.iterable);
+            record.child[1] = topoc_node(writer, node->loop.body);
+            break;
+            
+        case NODE_RETURN_STMT:
+            record.child[0] = topoc_node(writer, node->ret.value);
+            break;
+            
+        case NODE_EXPR_STMT:
+            record.child[0] = topoc_node(writer, node->expr.binary.left);
+            break;
+            
+        case NODE_FROM_IMPORT:
+            if (node->import.import_all) record.flags |= TOPOC_NODE_IMPORT_ALL;
+            record.extra = writer->extra_count + 1;
+            for (int i = 0; i < node->import.import_count; i++) {
+                uint32_t name = topoc_string(writer, node->import.imports[i]);
+                topoc_word(writer, name);
+                record.count++;
+            }
+            if (record.name && topoc_reserve(writer, (void**)&writer->imports, &writer->import_capacity,
+                                             writer->import_count + 1, sizeof(uint32_t))) {
+                writer->imports[writer->import_count++] = record.name;
+            }
+            break;
+            
+        case NODE_BINARY_EXPR:
+            if (node->expr.binary.branch) record.flags |= TOPOC_NODE_BRANCH;
+            record.text = topoc_string(writer, node->expr.binary.op);
+            record.child[0] = topoc_node(writer, node->expr.binary.left);
+            record.child[1] = topoc_node(writer, node->expr.binary.right);
+            break;
+            
+        case NODE_UNARY_EXPR:
+            record.text = topoc_string(writer, node->expr.unary.op);
+            record.child[0] = topoc_node(writer, node->expr.unary.operand);
+            break;
+            
+        case NODE_LITERAL:
+            record.data_type = (uint8_t)node->expr.literal.data_type;
+            switch (node->expr.literal.data_type) {
+                case TYPE_INT:
+                    record.value = node->expr.literal.value.int_val;
+                    break;
+                case TYPE_FLOAT:
+                    memcpy(&record.value, &node->expr.literal.value.float_val, sizeof(double));
+                    break;
+                case TYPE_BOOL:
+                    record.value = node->expr.literal.value.bool_val ? 1 : 0;
+                    break;
+                case TYPE_STRING:
+                    record.text = topoc_string(writer, node->expr.literal.value.string_val);
+                    break;
+                case TYPE_BIGINT:
+                    record.text = topoc_string(writer, node->expr.literal.value.bignum_val);
+                    break;
+                default:
+                    break;
+            }
+            break;
+            
+        case NODE_IDENTIFIER:
+            record.text = topoc_string(writer, node->expr.identifier.identifier);
+            break;
+            
+        case NODE_ASSIGNMENT:
+            record.text = topoc_string(writer, node->expr.assign.op);
+            record.child[0] = topoc_node(writer, node->expr.assign.target);
+            record.child[1] = topoc_node(writer, node->expr.assign.value);
+            break;
+            
+        case NODE_CALL_EXPR:
+            record.count = (uint32_t)node->expr.call.arg_count;
+            record.child[0] = topoc_node(writer, node->expr.call.callee);
+            record.child[1] = topoc_list(writer, node->expr.call.arguments);
+            break;
+            
+        case NODE_ARRAY_LITERAL:
+            if (node->expr.array.no_escape) record.flags |= TOPOC_NODE_NO_ESCAPE;
+            record.count = (uint32_t)node->expr.array.element_count;
+            record.child[0] = topoc_list(writer, node->expr.array.elements);
+            break;
+            
+        case NODE_DICT_LITERAL:
+            if (node->expr.dict.no_escape) record.flags |= TOPOC_NODE_NO_ESCAPE;
+            if (node->expr.dict.phash) record.flags |= TOPOC_NODE_PHASH;
+            record.extra = writer->extra_count + 1;
+            record.count = (uint32_t)node->expr.dict.pair_count;
+            for (int i = 0; i < node->expr.dict.pair_count; i++) {
+                uint32_t key = topoc_string(writer, node->expr.dict.keys[i]);
+                topoc_word(writer, key);
+            }
+            record.child[0] = topoc_list(writer, node->expr.dict.values);
+            break;
+            
+        case NODE_MEMBER_ACCESS:
+            record.text = topoc_string(writer, node->expr.member.member);
+            record.child[0] = topoc_node(writer, node->expr.member.object);
+            break;
+            
+        case NODE_INDEX_ACCESS:
+            if (node->expr.index.unchecked) record.flags |= TOPOC_NODE_UNCHECKED;
+            record.child[0] = topoc_node(writer, node->expr.index.array);
+            record.child[1] = topoc_node(writer, node->expr.index.index);
+            break;
+            
+        case NODE_SLICE_EXPR:
+            record.child[0] = topoc_node(writer, node->expr.slice.object);
+            record.child[1] = topoc_node(writer, node->expr.slice.start);
+            record.child[2] = topoc_node(writer, node->expr.slice.end);
+            break;
+            
+        case NODE_RANGE_EXPR:
+            record.child[0] = topoc_node(writer, node->expr.range.start);
+            record.child[1] = topoc_node(writer, node->expr.range.end);
+            record.child[2] = topoc_node(writer, node->expr.range.step);
+            break;
+            
+        default:
+            break;
+    }
+    
+    if (writer->failed) return 0;
+    writer->nodes[index] = record;
+    return index + 1;
+}
+
+static void topoc_writer_free(TopocWriter* writer) {
+    free(writer->nodes);
+    free(writer->extra);
+    free(writer->offsets);
+    free(writer->bytes);
+    free(writer->buckets);
+    free(writer->imports);
+    free(writer->positions);
+}
+
+bool topoc_write(ASTNode* program, const char* path, bool optimized, char* error, size_t error_size) {
+    if (!program || program->type != NODE_PROGRAM) {
+        topoc_error(error, error_size, "not a program", NULL);
+        return false;
+    }
+    if (!parse_function_bodies(program)) {
+        topoc_error(error, error_size, "a function body does not parse", NULL);
+        return false;
+    }
+    
+    TopocWriter writer;
+    memset(&writer, 0, sizeof(writer));
+    
+    uint32_t root = topoc_node(&writer, program);
+    
+    // The import list goes after everything else in the extra words
+    uint32_t imports = writer.extra_count + 1;
+    for (uint32_t i = 0; i < writer.import_count; i++) {
+        topoc_word(&writer, writer.imports[i]);
+    }
+    
+    if (writer.failed || !root) {
+        topoc_writer_free(&writer);
+        topoc_error(error, error_size, "out of memory", NULL);
+        return false;
+    }
+    
+    TopocHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TOPOC_MAGIC, 4);
+    header.version = TOPOC_VERSION;
+    header.flags = optimized ? TOPOC_FILE_OPTIMIZED : 0;
+    header.node_count = writer.node_count;
+    header.root = root;
+    header.extra_count = writer.extra_count;
+    header.string_count = writer.string_count;
+    header.string_bytes = writer.byte_count;
+    header.imports = imports;
+    header.import_count = writer.import_count;
+    header.position_bytes = writer.position_bytes;
+    
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        topoc_writer_free(&writer);
+        topoc_error(error, error_size, "cannot create file", path);
+        return false;
+    }
+    
+    // The offset table ends with the total size, closing the last string
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(writer.nodes, sizeof(TopocNode), writer.node_count, file) == writer.node_count &&
+                   fwrite(writer.extra, sizeof(uint32_t), writer.extra_count, file) == writer.extra_count &&
+                   fwrite(writer.offsets, sizeof(uint32_t), writer.string_count, file) == writer.string_count &&
+                   fwrite(&writer.byte_count, sizeof(uint32_t), 1, file) == 1 &&
+                   fwrite(writer.bytes, 1, writer.byte_count, file) == writer.byte_count &&
+                   fwrite(writer.positions, 1, writer.position_bytes, file) == writer.position_bytes;
+    if (fclose(file) != 0) written = false;
+    
+    topoc_writer_free(&writer);
+    if (!written) {
+        topoc_error(error, error_size, "cannot write file", path);
+        return false;
+    }
+    return true;
+}
+
+// ================ MAPPING ================
+
+typedef struct {
+    const unsigned char* data;
+    size_t size;
+    bool mapped;                // Unmap, rather than free, when done
+    
+    const TopocHeader* header;
+    const TopocNode* nodes;
+    const uint32_t* extra;
+    const uint32_t* offsets;    // string_count + 1 entries
+    const char* bytes;
+    const unsigned char* positions;
+} TopocFile;
+
+static bool topoc_map(const char* path, TopocFile* file, char* error, size_t error_size) {
+    memset(file, 0, sizeof(*file));
+
+#if !defined(TOPOC_NO_MMAP)
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        topoc_error(error, error_size, "cannot open file", path);
+        return false;
+    }
+    
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(TopocHeader)) {
+        close(fd);
+        topoc_error(error, error_size, "not a .topoc file", path);
+        return false;
+    }
+    
+    void* map = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        topoc_error(error, error_size, "cannot map file", path);
+        return false;
+    }
+    
+    file->data = (const unsigned char*)map;
+    file->size = (size_t)info.st_size;
+    file->mapped = true;
+#else
+    FILE* stream = fopen(path, "rb");
+    if (!stream) {
+        topoc_error(error, error_size, "cannot open file", path);
+        return false;
+    }
+    
+    fseek(stream, 0, SEEK_END);
+    long size = ftell(stream);
+    fseek(stream, 0, SEEK_SET);
+    
+    unsigned char* data = size >= (long)sizeof(TopocHeader) ? (unsigned char*)malloc((size_t)size) : NULL;
+    if (!data || fread(data, 1, (size_t)size, stream) != (size_t)size) {
+        free(data);
+        fclose(stream);
+        topoc_error(error, error_size, "not a .topoc file", path);
+        return false;
+    }
+    fclose(stream);
+    
+    file->data = data;
+    file->size = (size_t)size;
+#endif
+
+    file->header = (const TopocHeader*)file->data;
+    return true;
+}
+
+static void topoc_unmap(TopocFile* file) {
+#if !defined(TOPOC_NO_MMAP)
+    if (file->mapped) munmap((void*)file->data, file->size);
+#else
+    free((void*)file->data);
+#endif
+    file->data = NULL;
+}
+
+// Check the header and lay the sections out over the file
+static bool topoc_sections(TopocFile* file, char* error, size_t error_size) {
+    const TopocHeader* header = file->header;
+    
+    if (memcmp(header->magic, TOPOC_MAGIC, 4) != 0) {
+        topoc_error(error, error_size, "not a .topoc file", NULL);
+        return false;
+    }
+    if (header->version != TOPOC_VERSION) {
+        topoc_error(error, error_size, "unsupported .topoc version", NULL);
+        return false;
+    }
+    
+    // 64-bit sums: none of the counts can overflow them
+    uint64_t nodes = sizeof(TopocHeader);
+    uint64_t extra = nodes + (uint64_t)header->node_count * sizeof(TopocNode);
+    uint64_t offsets = extra + (uint64_t)header->extra_count * sizeof(uint32_t);
+    uint64_t bytes = offsets + ((uint64_t)header->string_count + 1) * sizeof(uint32_t);
+    uint64_t positions = bytes + header->string_bytes;
+    uint64_t end = positions + header->position_bytes;
+    if (end != file->size) {
+        topoc_error(error, error_size, "truncated or oversized .topoc file", NULL);
+        return false;
+    }
+    
+    file->nodes = (const TopocNode*)(file->data + nodes);
+    file->extra = (const uint32_t*)(file->data + extra);
+    file->offsets = (const uint32_t*)(file->data + offsets);
+    file->bytes = (const char*)(file->data + bytes);
+    file->positions = file->data + positions;
+    
+    // Each string is non-empty in the table (it holds at least its NUL)
+    // and ends where the next one starts
+    if (file->offsets[0] != 0 || file->offsets[header->string_count] != header->string_bytes) {
+        topoc_error(error, error_size, "bad string table", NULL);
+        return false;
+    }
+    for (uint32_t i = 0; i < header->string_count; i++) {
+        uint32_t end = file->offsets[i + 1];
+        if (end <= file->offsets[i] || end > header->string_bytes || file->bytes[end - 1] != '\0') {
+            topoc_error(error, error_size, "bad string table", NULL);
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+// Read one varint; false if it runs past 'end' or over 64 bits
+static bool topoc_read_varint(const unsigned char** cursor, const unsigned char* end, uint64_t* value) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (*cursor == end) return false;
+        unsigned char byte = *(*cursor)++;
+        if (shift == 63 && byte > 1) return false;
+        result |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Decode the next position, in 64 bits so that a bad file cannot overflow
+static bool topoc_read_position(const unsigned char** cursor, const unsigned char* end, int64_t* line, int64_t* column) {
+    uint64_t value;
+    if (!topoc_read_varint(cursor, end, &value)) return false;
+    
+    int64_t columns = topoc_unzigzag(value >> 2);
+    int64_t lines = (int64_t)(value & 3);
+    if (lines == 3) {
+        uint64_t escaped;
+        if (!topoc_read_varint(cursor, end, &escaped)) return false;
+        lines = topoc_unzigzag(escaped);
+    }
+    
+    if ((value & 3) == 0) {
+        *column += columns;
+    } else {
+        *line += lines;
+        *column = columns;
+    }
+    return true;
+}
+
+static long topoc_read_long(const uint32_t* words) {
+    return (long)(int64_t)((uint64_t)words[0] | ((uint64_t)words[1] << 32));
+}
+
+// ================ VERIFIER ================
+// One pass over the records proves everything the loader relies on, so
+// that building the AST afterwards needs no checks at all:
+//   - every node, string and extra index is in range;
+//   - links point forward (the writer puts a node before its children and
+//     a list element before the next one) and every node but the first has
+//     exactly one owner, so the nodes form a single tree;
+//   - only list elements have a 'next', and slots, flags, data types and
+//     extra words a node type does not use are empty, while the slots it
+//     cannot do without (operands, callee, condition, body) are not;
+//   - the strings the optimizer compares (names, operators, identifiers,
+//     keys) and the text of string and bigint literals are present,
+//     counts match their lists, and dispatch labels are distinct and
+//     select an arm of their chain;
+//   - nesting stays within TOPOC_MAX_DEPTH, as the AST is walked
+//     recursively;
+//   - the position table holds one position per node and nothing more,
+//     and every line and column fits an int.
+
+typedef struct {
+    uint8_t slots;              // Child slots in use
+    uint8_t lists;              // Slots holding lists (bit per slot)
+    uint8_t required;           // Slots that may not be empty (bit per slot)
+    uint8_t flags;              // TOPOC_NODE_* allowed
+    bool typed;                 // Uses data_type
+    bool named;                 // Needs a name
+    bool text;                  // Needs text (operator, identifier, member)
+} TopocShape;
+
+// Indexed by NodeType; mirrors topoc_node
+static const TopocShape topoc_shapes[] = {
+    [NODE_PROGRAM]         = {1, 0x01, 0x00, 0, false, false, false},
+    [NODE_BLOCK]           = {1, 0x01, 0x00, 0, false, false, false},
+    [NODE_VAR_DECL]        = {1, 0x00, 0x00, TOPOC_NODE_CONST, true, true, false},
+    [NODE_CONST_DECL]      = {1, 0x00, 0x01, TOPOC_NODE_CONST, true, true, false},
+    [NODE_FUNC_DECL]       = {1, 0x00, 0x01, 0, true, true, false},
+    [NODE_IF_STMT]         = {5, 0x04, 0x03, TOPOC_NODE_DISPATCH | TOPOC_NODE_STRINGS, false, false, false},
+    [NODE_ELIF_STMT]       = {2, 0x00, 0x03, 0, false, false, false},
+    [NODE_ELSE_STMT]       = {0, 0x00, 0x00, 0, false, false, false},
+    [NODE_WHILE_STMT]      = {2, 0x00, 0x03, 0, false, false, false},
+    [NODE_FOR_STMT]        = {2, 0x00, 0x03, 0, false, true, false},
+    [NODE_RETURN_STMT]     = {1, 0x00, 0x00, 0, false, false, false},
+    [NODE_BREAK_STMT]      = {0, 0x00, 0x00, 0, false, false, false},
+    [NODE_CONTINUE_STMT]   = {0, 0x00, 0x00, 0, false, false, false},
+    [NODE_EXPR_STMT]       = {1, 0x00, 0x01, 0, false, false, false},
+    [NODE_FROM_IMPORT]     = {0, 0x00, 0x00, TOPOC_NODE_IMPORT_ALL, false, true, false},
+    [NODE_BINARY_EXPR]     = {2, 0x00, 0x03, TOPOC_NODE_BRANCH, false, false, true},
+    [NODE_UNARY_EXPR]      = {1, 0x00, 0x01, 0, false, false, true},
+    [NODE_LITERAL]         = {0, 0x00, 0x00, 0, true, false, false},
+    [NODE_IDENTIFIER]      = {0, 0x00, 0x00, 0, false, false, true},
+    [NODE_ASSIGNMENT]      = {2, 0x00, 0x03, 0, false, false, false},
+    [NODE_CALL_EXPR]       = {2, 0x02, 0x01, 0, false, false, false},
+    [NODE_ARRAY_LITERAL]   = {1, 0x01, 0x00, TOPOC_NODE_NO_ESCAPE, false, false, false},
+    [NODE_DICT_LITERAL]    = {1, 0x01, 0x00, TOPOC_NODE_NO_ESCAPE | TOPOC_NODE_PHASH, false, false, false},
+    [NODE_MEMBER_ACCESS]   = {1, 0x00, 0x01, 0, false, false, true},
+    [NODE_INDEX_ACCESS]    = {2, 0x00, 0x03, TOPOC_NODE_UNCHECKED, false, false, false},
+    [NODE_SLICE_EXPR]      = {3, 0x00, 0x01, 0, false, false, false},
+    [NODE_RANGE_EXPR]      = {3, 0x00, 0x00, 0, false, false, false},
+    [NODE_TYPE_ANNOTATION] = {0, 0x00, 0x00, 0, false, false, false},
+};
+
+#define TOPOC_OWNED 0x1         // Has its parent (or is the root)
+#define TOPOC_LISTED 0x2        // Is a list element, so may have a 'next'
+
+typedef struct {
+    const TopocFile* file;
+    unsigned char* state;       // TOPOC_OWNED | TOPOC_LISTED per node
+    uint32_t* depth;            // Nesting depth per node, set by its owner
+    uint32_t node;              // Record being checked
+    const char* problem;
+} TopocVerifier;
+
+static bool topoc_reject(TopocVerifier* verifier, const char* problem) {
+    if (!verifier->problem) verifier->problem = problem;
+    return false;
+}
+
+static bool topoc_string_ok(TopocVerifier* verifier, uint32_t id, bool required) {
+    if (id == 0) return !required || topoc_reject(verifier, "missing string");
+    return id <= verifier->file->header->string_count || topoc_reject(verifier, "string index out of range");
+}
+
+static bool topoc_extra_ok(TopocVerifier* verifier, uint32_t offset, uint64_t words) {
+    if (words == 0) return true;
+    return (offset != 0 && offset - 1 + words <= verifier->file->header->extra_count) ||
+           topoc_reject(verifier, "extra data out of range");
+}
+
+// Give 'id' its owner 'parent', one level deeper
+static bool topoc_own(TopocVerifier* verifier, uint32_t parent, uint32_t id, unsigned char state) {
+    if (id > verifier->file->header->node_count) return topoc_reject(verifier, "node index out of range");
+    if (id <= parent + 1) return topoc_reject(verifier, "backward node link");
+    if (verifier->state[id - 1]) return topoc_reject(verifier, "node has two parents");
+    
+    uint32_t depth = verifier->depth[verifier->node] + 1;
+    if (depth > TOPOC_MAX_DEPTH) return topoc_reject(verifier, "nesting too deep");
+    
+    verifier->state[id - 1] = state;
+    verifier->depth[id - 1] = depth;
+    return true;
+}
+
+// Own a list through its 'next' links; 'length' is its element count
+static bool topoc_own_list(TopocVerifier* verifier, uint32_t head, uint32_t* length) {
+    *length = 0;
+    
+    uint32_t owner = verifier->node;
+    for (uint32_t id = head; id; id = verifier->file->nodes[id - 1].next) {
+        if (!topoc_own(verifier, owner, id, TOPOC_OWNED | TOPOC_LISTED)) return false;
+        owner = id - 1;
+        (*length)++;
+    }
+    return true;
+}
+
+static int topoc_label_compare(const void* a, const void* b, void* data) {
+    const TopocFile* file = (const TopocFile*)data;
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return strcmp(file->bytes + file->offsets[x - 1], file->bytes + file->offsets[y - 1]);
+}
+
+// Two string ids may hold the same text, so labels are compared sorted
+static bool topoc_string_labels_distinct(TopocVerifier* verifier, const uint32_t* words, uint32_t count) {
+    uint32_t* ids = (uint32_t*)malloc(count * sizeof(uint32_t));
+    if (!ids) return topoc_reject(verifier, "out of memory");
+    for (uint32_t i = 0; i < count; i++) {
+        ids[i] = words[(size_t)i * 2];
+    }
+    sort_values(ids, count, sizeof(uint32_t), topoc_label_compare, (void*)verifier->file);
+    
+    bool distinct = true;
+    for (uint32_t i = 1; distinct && i < count; i++) {
+        distinct = topoc_label_compare(&ids[i - 1], &ids[i], (void*)verifier->file) != 0;
+    }
+    free(ids);
+    return distinct || topoc_reject(verifier, "duplicate dispatch label");
+}
+
+static bool topoc_verify_dispatch(TopocVerifier* verifier, const TopocNode* record, uint32_t arm_count) {
+    bool strings = (record->flags & TOPOC_NODE_STRINGS) != 0;
+    uint32_t width = strings ? 2 : 3;
+    
+    if (record->count == 0 || record->child[4] == 0) return topoc_reject(verifier, "incomplete dispatch table");
+    if (!topoc_extra_ok(verifier, record->extra, (uint64_t)record->count * width)) return false;
+    
+    // The writer stores integer labels in ascending order
+    const uint32_t* words = verifier->file->extra + (record->extra - 1);
+    for (uint32_t i = 0; i < record->count; i++) {
+        const uint32_t* label = words + (size_t)i * width;
+        if (label[width - 1] >= arm_count) return topoc_reject(verifier, "dispatch arm out of range");
+        if (strings && !topoc_string_ok(verifier, label[0], true)) return false;
+        if (!strings && i > 0 && topoc_read_long(label - width) >= topoc_read_long(label)) {
+            return topoc_reject(verifier, "duplicate dispatch label");
+        }
+    }
+    return !strings || topoc_string_labels_distinct(verifier, words, record->count);
+}
+
+static bool topoc_verify_node(TopocVerifier* verifier, uint32_t index) {
+    const TopocNode* record = &verifier->file->nodes[index];
+    verifier->node = index;
+    
+    if (record->type > NODE_TYPE_ANNOTATION) return topoc_reject(verifier, "bad node type");
+    if (!(verifier->state[index] & TOPOC_OWNED)) return topoc_reject(verifier, "unreachable node");
+    if (record->next && !(verifier->state[index] & TOPOC_LISTED)) return topoc_reject(verifier, "stray next link");
+    
+    const TopocShape* shape = &topoc_shapes[record->type];
+    if (record->flags & ~shape->flags) return topoc_reject(verifier, "bad node flags");
+    if (record->data_type > TYPE_ANY || (!shape->typed && record->data_type)) {
+        return topoc_reject(verifier, "bad data type");
+    }
+    if (record->view > VIEW_VALUES || (record->type != NODE_FOR_STMT && record->view)) {
+        return topoc_reject(verifier, "bad iteration view");
+    }
+    if (!topoc_string_ok(verifier, record->name, shape->named)) return false;
+    
+    // Compound assignments may have text; string and bignum literals need it
+    bool literal_text = record->type == NODE_LITERAL &&
+                        (record->data_type == TYPE_STRING || record->data_type == TYPE_BIGINT);
+    bool text_allowed = shape->text || literal_text || record->type == NODE_ASSIGNMENT;
+    if (record->text && !text_allowed) return topoc_reject(verifier, "unexpected text");
+    if (!topoc_string_ok(verifier, record->text, shape->text || literal_text)) return false;
+    
+    // Children
+    uint32_t lengths[5] = {0};
+    for (uint32_t slot = 0; slot < 5; slot++) {
+        uint32_t child = record->child[slot];
+        if (slot >= shape->slots) {
+            if (child) return topoc_reject(verifier, "unexpected child");
+        } else if (!child && (shape->required & (1u << slot))) {
+            return topoc_reject(verifier, "missing child");
+        } else if (shape->lists & (1u << slot)) {
+            if (!topoc_own_list(verifier, child, &lengths[slot])) return false;
+        } else if (child && !topoc_own(verifier, index, child, TOPOC_OWNED)) {
+            return false;
+        }
+    }
+    
+    // Counts and extra words
+    switch (record->type) {
+        case NODE_FUNC_DECL:
+            if (!topoc_extra_ok(verifier, record->extra, (uint64_t)record->count * 2)) return false;
+            for (uint32_t i = 0; i < record->count; i++) {
+                const uint32_t* param = verifier->file->extra + (record->extra - 1) + 2 * i;
+                if (!topoc_string_ok(verifier, param[0], true)) return false;
+                if (param[1] > TYPE_ANY) return topoc_reject(verifier, "bad parameter type");
+            }
+            return true;
+            
+        case NODE_FROM_IMPORT:
+            if (!topoc_extra_ok(verifier, record->extra, record->count)) return false;
+            for (uint32_t i = 0; i < record->count; i++) {
+                if (!topoc_string_ok(verifier, verifier->file->extra[record->extra - 1 + i], true)) return false;
+            }
+            return true;
+            
+        case NODE_DICT_LITERAL:
+            if (record->count != lengths[0]) return topoc_reject(verifier, "pair count does not match values");
+            if (!topoc_extra_ok(verifier, record->extra, record->count)) return false;
+            for (uint32_t i = 0; i < record->count; i++) {
+                if (!topoc_string_ok(verifier, verifier->file->extra[record->extra - 1 + i], true)) return false;
+            }
+            return true;
+            
+        case NODE_IF_STMT:
+            if (record->flags & TOPOC_NODE_DISPATCH) {
+                return topoc_verify_dispatch(verifier, record, 1 + lengths[2]);
+            }
+            if (record->child[4]) return topoc_reject(verifier, "subject without dispatch table");
+            break;
+            
+        case NODE_CALL_EXPR:
+            if (record->count != lengths[1]) return topoc_reject(verifier, "argument count does not match");
+            return record->extra == 0 || topoc_reject(verifier, "unexpected extra data");
+            
+        case NODE_ARRAY_LITERAL:
+            if (record->count != lengths[0]) return topoc_reject(verifier, "element count does not match");
+            return record->extra == 0 || topoc_reject(verifier, "unexpected extra data");
+            
+        default:
+            break;
+    }
+    
+    if (record->extra || record->count) return topoc_reject(verifier, "unexpected extra data");
+    return true;
+}
+
+// One position per node, filling the table exactly, each within an int
+static bool topoc_positions_ok(TopocVerifier* verifier) {
+    const TopocFile* file = verifier->file;
+    const unsigned char* cursor = file->positions;
+    const unsigned char* end = cursor + file->header->position_bytes;
+    int64_t line = 0;
+    int64_t column = 0;
+    
+    for (uint32_t i = 0; i < file->header->node_count; i++) {
+        if (!topoc_read_position(&cursor, end, &line, &column) ||
+            line < INT_MIN || line > INT_MAX || column < INT_MIN || column > INT_MAX) {
+            verifier->problem = "bad position table";
+            return false;
+        }
+    }
+    if (cursor != end) {
+        verifier->problem = "bad position table";
+        return false;
+    }
+    return true;
+}
+
+static bool topoc_verify_file(const TopocFile* file, char* error, size_t error_size) {
+    uint32_t count = file->header->node_count;
+    
+    // Links only go forward, so the program comes first
+    if (file->header->root != 1 || count == 0 || file->nodes[0].type != NODE_PROGRAM) {
+        topoc_error(error, error_size, "bad .topoc file", "no program node");
+        return false;
+    }
+    
+    TopocVerifier verifier;
+    verifier.file = file;
+    verifier.state = (unsigned char*)calloc(count, 1);
+    verifier.depth = (uint32_t*)calloc(count, sizeof(uint32_t));
+    verifier.node = 0;
+    verifier.problem = NULL;
+    
+    bool ok = verifier.state && verifier.depth;
+    if (!ok) {
+        topoc_error(error, error_size, "out of memory", NULL);
+    } else {
+        // A node's owner comes before it, so it has been seen by the time
+        // the node is checked
+        verifier.state[0] = TOPOC_OWNED;
+        for (uint32_t i = 0; ok && i < count; i++) {
+            ok = topoc_verify_node(&verifier, i);
+        }
+        
+        // The module list in the header
+        if (ok) {
+            verifier.node = count;
+            ok = topoc_extra_ok(&verifier, file->header->imports, file->header->import_count);
+        }
+        for (uint32_t i = 0; ok && i < file->header->import_count; i++) {
+            ok = topoc_string_ok(&verifier, file->extra[file->header->imports - 1 + i], true);
+        }
+        if (ok) ok = topoc_positions_ok(&verifier);
+        
+        if (!ok) {
+            char detail[96];
+            if (verifier.node < count) {
+                snprintf(detail, sizeof(detail), "node %u: %s", verifier.node + 1, verifier.problem);
+            } else {
+                snprintf(detail, sizeof(detail), "%s", verifier.problem);
+            }
+            topoc_error(error, error_size, "bad .topoc file", detail);
+        }
+    }
+    
+    free(verifier.state);
+    free(verifier.depth);
+    return ok;
+}
+
+// ================ LOADING ================
+// Runs only on verified files, so indices are used as they are. All
+// nodes are allocated up front and filled in by index; if memory runs
+// out part way, the links are all in place and the tree is freed whole.
+
+#define TOPOC_LINK(id) ((id) ? built[(id) - 1] : NULL)
+#define TOPOC_TEXT(id) ((id) ? file->bytes + file->offsets[(id) - 1] : NULL)
+
+static char* topoc_copy(const TopocFile* file, uint32_t id, bool* ok) {
+    if (!id) return NULL;
+    
+    char* copy = ast_strdup(TOPOC_TEXT(id));
+    if (!copy) *ok = false;
+    return copy;
+}
+
+// Rebuilt rather than stored: the tables hold addresses
+static DispatchTable* topoc_build_dispatch(const TopocFile* file, const TopocNode* record) {
+    bool strings = (record->flags & TOPOC_NODE_STRINGS) != 0;
+    uint32_t width = strings ? 2 : 3;
+    const uint32_t* words = file->extra + (record->extra - 1);
+    int count = (int)record->count;
+    
+    int* arms = (int*)malloc(count * sizeof(int));
+    long* values = strings ? NULL : (long*)malloc(count * sizeof(long));
+    char** keys = strings ? (char**)malloc(count * sizeof(char*)) : NULL;
+    
+    DispatchTable* table = NULL;
+    if (arms && (values || keys)) {
+        for (int i = 0; i < count; i++) {
+            const uint32_t* label = words + (size_t)i * width;
+            arms[i] = (int)label[width - 1];
+            if (strings) keys[i] = (char*)TOPOC_TEXT(label[0]);
+            else values[i] = topoc_read_long(label);
+        }
+        table = strings ? dispatch_build_string(keys, arms, count)
+                        : dispatch_build_int(values, arms, count);
+    }
+    
+    free(arms);
+    free(values);
+    free(keys);
+    return table;
+}
+
+// Copy a list of strings from the extra words (NULL if out of memory)
+static char** topoc_build_strings(const TopocFile* file, const TopocNode* record, bool* ok) {
+    if (record->count == 0) return NULL;
+    
+    char** strings = (char**)calloc(record->count, sizeof(char*));
+    if (!strings) {
+        *ok = false;
+        return NULL;
+    }
+    
+    const uint32_t* words = file->extra + (record->extra - 1);
+    for (uint32_t i = 0; i < record->count; i++) {
+        strings[i] = strdup(file->bytes + file->offsets[words[i] - 1]);
+        if (!strings[i]) *ok = false;
+    }
+    return strings;
+}
+
+static void topoc_build_node(const TopocFile* file, ASTNode** built, uint32_t index, bool* ok) {
+    const TopocNode* record = &file->nodes[index];
+    ASTNode* node = built[index];
+    
+    node->type = (NodeType)record->type;
+    node->name = topoc_copy(file, record->name, ok);
+    node->next = TOPOC_LINK(record->next);
+    
+    switch (node->type) {
+        case NODE_PROGRAM:
+        case NODE_BLOCK:
+            node->block.statements = TOPOC_LINK(record->child[0]);
+            break;
+            
+        case NODE_VAR_DECL:
+        case NODE_CONST_DECL:
+            node->decl.data_type = (DataType)record->data_type;
+            node->decl.is_const = (record->flags & TOPOC_NODE_CONST) != 0;
+            node->decl.value = TOPOC_LINK(record->child[0]);
+            break;
+            
+        case NODE_FUNC_DECL: {
+            node->func.return_type = (DataType)record->data_type;
+            node->func.body = TOPOC_LINK(record->child[0]);
+            
+            const uint32_t* words = file->extra + (record->extra - 1);
+            FunctionParam** tail = &node->func.params;
+            for (uint32_t i = 0; i < record->count; i++) {
+                *tail = create_function_param((char*)TOPOC_TEXT(words[2 * i]), (DataType)words[2 * i + 1]);
+                if (!*tail) {
+                    *ok = false;
+                    break;
+                }
+                tail = &(*tail)->next;
+            }
+            break;
+        }
+        
+        case NODE_IF_STMT:
+            node->flow.condition = TOPOC_LINK(record->child[0]);
+            node->flow.then_branch = TOPOC_LINK(record->child[1]);
+            node->flow.elif_branches = TOPOC_LINK(record->child[2]);
+            node->flow.else_branch = TOPOC_LINK(record->child[3]);
+            node->flow.subject = TOPOC_LINK(record->child[4]);
+            if (record->flags & TOPOC_NODE_DISPATCH) {
+                node->flow.dispatch = topoc_build_dispatch(file, record);
+            }
+            break;
+            
+        case NODE_ELIF_STMT:
+        case NODE_WHILE_STMT:
+            node->flow.condition = TOPOC_LINK(record->child[0]);
+            node->flow.then_branch = TOPOC_LINK(record->child[1]);
+            break;
+            
+        case NODE_FOR_STMT:
+            node->loop.view = (IterationView)record->view;
+            node->loop.iterable = TOPOC_LINK(record->child[0]);
+            node->loop.body = TOPOC_LINK(record->child[1]);
+            break;
+            
+        case NODE_RETURN_STMT:
+            node->ret.value = TOPOC_LINK(record->child[0]);
+            break;
+            
+        case NODE_EXPR_STMT:
+            node->expr.binary.left = TOPOC_LINK(record->child[0]);
+            break;
+            
+        case NODE_FROM_IMPORT:
+            node->import.import_all = (record->flags & TOPOC_NODE_IMPORT_ALL) != 0;
+            node->import.imports = topoc_build_strings(file, record, ok);
+            if (node->import.imports) node->import.import_count = (int)record->count;
+            break;
+            
+        case NODE_BINARY_EXPR:
+            node->expr.binary.branch = (record->flags & TOPOC_NODE_BRANCH) != 0;
+            node->expr.binary.op = topoc_copy(file, record->text, ok);
+            node->expr.binary.left = TOPOC_LINK(record->child[0]);
+            node->expr.binary.right = TOPOC_LINK(record->child[1]);
+            break;
+            
+        case NODE_UNARY_EXPR:
+            node->expr.unary.op = topoc_copy(file, record->text, ok);
+            node->expr.unary.operand = TOPOC_LINK(record->child[0]);
+            break;
+            
+        case NODE_LITERAL:
+            switch ((DataType)record->data_type) {
+                case TYPE_INT:
+                    node->expr.literal.value.int_val = (long)record->value;
+                    break;
+                case TYPE_FLOAT:
+                    memcpy(&node->expr.literal.value.float_val, &record->value, sizeof(double));
+                    break;
+                case TYPE_BOOL:
+                    node->expr.literal.value.bool_val = record->value != 0;
+                    break;
+                case TYPE_STRING:
+                case TYPE_BIGINT:
+                    // Shares the union slot with bignum_val
+                    node->expr.literal.value.string_val = topoc_copy(file, record->text, ok);
+                    break;
+                default:
+                    break;
+            }
+            node->expr.literal.data_type = (DataType)record->data_type;
+            break;
+            
+        case NODE_IDENTIFIER:
+            node->expr.identifier.identifier = topoc_copy(file, record->text, ok);
+            break;
+            
+        case NODE_ASSIGNMENT:
+            node->expr.assign.op = topoc_copy(file, record->text, ok);
+            node->expr.assign.target = TOPOC_LINK(record->child[0]);
+            node->expr.assign.value = TOPOC_LINK(record->child[1]);
+            break;
+            
+        case NODE_CALL_EXPR:
+            node->expr.call.arg_count = (int)record->count;
+            node->expr.call.callee = TOPOC_LINK(record->child[0]);
+            node->expr.call.arguments = TOPOC_LINK(record->child[1]);
+            break;
+            
+        case NODE_ARRAY_LITERAL:
+            node->expr.array.no_escape = (record->flags & TOPOC_NODE_NO_ESCAPE) != 0;
+            node->expr.array.element_count = (int)record->count;
+            node->expr.array.elements = TOPOC_LINK(record->child[0]);
+            break;
+            
+        case NODE_DICT_LITERAL:
+            node->expr.dict.no_escape = (record->flags & TOPOC_NODE_NO_ESCAPE) != 0;
+            node->expr.dict.values = TOPOC_LINK(record->child[0]);
+            node->expr.dict.keys = topoc_build_strings(file, record, ok);
+            if (node->expr.dict.keys) {
+                node->expr.dict.pair_count = (int)record->count;
+                if ((record->flags & TOPOC_NODE_PHASH) && *ok) {
+                    node->expr.dict.phash = phash_build(node->expr.dict.keys, node->expr.dict.pair_count);
+                }
+            }
+            break;
+            
+        case NODE_MEMBER_ACCESS:
+            node->expr.member.member = topoc_copy(file, record->text, ok);
+            node->expr.member.object = TOPOC_LINK(record->child[0]);
+            break;
+            
+        case NODE_INDEX_ACCESS:
+            node->expr.index.unchecked = (record->flags & TOPOC_NODE_UNCHECKED) != 0;
+            node->expr.index.array = TOPOC_LINK(record->child[0]);
+            node->expr.index.index = TOPOC_LINK(record->child[1]);
+            break;
+            
+        case NODE_SLICE_EXPR:
+            node->expr.slice.object = TOPOC_LINK(record->child[0]);
+            node->expr.slice.start = TOPOC_LINK(record->child[1]);
+            node->expr.slice.end = TOPOC_LINK(record->child[2]);
+            break;
+            
+        case NODE_RANGE_EXPR:
+            node->expr.range.start = TOPOC_LINK(record->child[0]);
+            node->expr.range.end = TOPOC_LINK(record->child[1]);
+            node->expr.range.step = TOPOC_LINK(record->child[2]);
+            break;
+            
+        default:
+            break;
+    }
+}
+
+static ASTNode* topoc_build(const TopocFile* file, char* error, size_t error_size) {
+    uint32_t count = file->header->node_count;
+    ASTNode** built = (ASTNode**)calloc(count, sizeof(ASTNode*));
+    bool ok = built != NULL;
+    
+    for (uint32_t i = 0; ok && i < count; i++) {
+        built[i] = ast_new_node();
+        if (!built[i]) ok = false;
+    }
+    
+    // Nothing is linked yet: free the nodes one by one
+    if (!ok) {
+        for (uint32_t i = 0; built && i < count; i++) {
+            free_ast_node(built[i]);
+        }
+        free(built);
+        topoc_error(error, error_size, "out of memory", NULL);
+        return NULL;
+    }
+    
+    // Positions decode in index order, alongside the records
+    const unsigned char* cursor = file->positions;
+    const unsigned char* end = cursor + file->header->position_bytes;
+    int64_t line = 0;
+    int64_t column = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        topoc_read_position(&cursor, end, &line, &column);
+        built[i]->line = (int)line;
+        built[i]->column = (int)column;
+        topoc_build_node(file, built, i, &ok);
+    }
+    
+    ASTNode* program = built[0];
+    free(built);
+    
+    if (!ok) {
+        free_ast_node(program);
+        topoc_error(error, error_size, "out of memory", NULL);
+        return NULL;
+    }
+    return program;
+}
+
+#undef TOPOC_LINK
+#undef TOPOC_TEXT
+
+ASTNode* topoc_load(const char* path, char* error, size_t error_size) {
+    TopocFile file;
+    if (!topoc_map(path, &file, error, error_size)) return NULL;
+    
+    ASTNode* program = NULL;
+    if (topoc_sections(&file, error, error_size) && topoc_verify_file(&file, error, error_size)) {
+        program = topoc_build(&file, error, error_size);
+    }
+    
+    topoc_unmap(&file);
+    return program;
+}
+
+bool topoc_verify(const char* path, char* error, size_t error_size) {
+    TopocFile file;
+    if (!topoc_map(path, &file, error, error_size)) return false;
+    
+    bool ok = topoc_sections(&file, error, error_size) && topoc_verify_file(&file, error, error_size);
+    
+    topoc_unmap(&file);
+    return ok;
+}
+
+bool topoc_is_file(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+    
+    char magic[4];
+    bool match = fread(magic, 1, 4, file) == 4 && memcmp(magic, TOPOC_MAGIC, 4) == 0;
+    fclose(file);
+    return match;
+}
@@ -0,0 +1,92 @@
+#ifndef TOPOC_H
+#define TOPOC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "ast.h"
+
+// ================ PRECOMPILED AST FILES (.topoc) ================
+// A parsed (and possibly optimized) program in a flat, versioned layout:
+//
+//   header | node records | extra words | string offsets | string bytes
+//          | positions
+//
+// Nodes refer to each other, to strings and to the extra words by index,
+// never by address, so the file is position-independent and is read in
+// place from a mapping. Every index is stored plus one, with 0 for none.
+// Records are in host byte order; a file from a host of the other order
+// fails the version check.
+//
+// Positions are kept out of the records: most nodes sit on the line of
+// the node before them or a line or two below, so the line and column of
+// each node, in index order, are stored as deltas from the previous node
+// in one varint (see topoc.c), usually a single byte rather than eight.
+
+#define TOPOC_MAGIC "TOPC"
+#define TOPOC_VERSION 2
+
+#define TOPOC_FILE_OPTIMIZED 0x1    // Written after optimize_program
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t flags;             // TOPOC_FILE_*
+    uint32_t node_count;
+    uint32_t root;              // Program node (index + 1)
+    uint32_t extra_count;       // 32-bit words
+    uint32_t string_count;
+    uint32_t string_bytes;
+    uint32_t imports;           // Module names imported (extra offset)
+    uint32_t import_count;
+    uint32_t position_bytes;
+    uint32_t reserved;          // Keeps the records 8-byte aligned
+} TopocHeader;
+
+// Node flags
+#define TOPOC_NODE_CONST        0x01    // decl.is_const
+#define TOPOC_NODE_BRANCH       0x02    // binary.branch
+#define TOPOC_NODE_NO_ESCAPE    0x04    // array/dict no_escape
+#define TOPOC_NODE_UNCHECKED    0x08    // index.unchecked
+#define TOPOC_NODE_IMPORT_ALL   0x10    // import.import_all
+#define TOPOC_NODE_PHASH        0x20    // dict: rebuild the key table
+#define TOPOC_NODE_DISPATCH     0x40    // if chain: extra holds its labels
+#define TOPOC_NODE_STRINGS      0x80    // ... and they are strings
+
+// One node. The meaning of child[] and extra follows the node type:
+// the children in the order ast_for_each_child visits them; extra for
+// parameters (name, type pairs), import names, dict keys and dispatch
+// labels (label, arm pairs; integer labels take two words).
+typedef struct {
+    uint8_t type;               // NodeType
+    uint8_t data_type;          // DataType of a declaration, literal or return
+    uint8_t flags;              // TOPOC_NODE_*
+    uint8_t view;               // IterationView of a for loop
+    uint32_t name;              // String
+    uint32_t next;              // Node
+    uint32_t child[5];          // Nodes
+    uint32_t text;              // String: operator, identifier, member, literal
+    uint32_t extra;             // Extra offset
+    uint32_t count;             // Elements, arguments, pairs, imports, labels
+    uint32_t reserved;
+    int64_t value;              // Integer, bool, or the bits of a double
+} TopocNode;
+
+// Write 'program' to 'path', parsing any skimmed function bodies first;
+// false with a message in 'error' on failure
+bool topoc_write(ASTNode* program, const char* path, bool optimized, char* error, size_t error_size);
+
+#define TOPOC_MAX_DEPTH 10000      // Deepest nesting a file may have
+
+// Map 'path', verify it and rebuild its program, or NULL with a message
+// in 'error'. Nodes come from the current AST region, if any.
+ASTNode* topoc_load(const char* path, char* error, size_t error_size);
+
+// Check a file once, without building anything. A file that passes
+// loads without any further checks.
+bool topoc_verify(const char* path, char* error, size_t error_size);
+
+// Does the file start with the .topoc magic?
+bool topoc_is_file(const char* path);
+
+#endif // TOPOC_H